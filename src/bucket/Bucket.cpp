@@ -8,6 +8,7 @@
 #include "util/asio.h"
 #include "bucket/Bucket.h"
 #include "bucket/BucketApplicator.h"
+#include "bucket/BucketInputIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketOutputIterator.h"
@@ -24,23 +25,33 @@
 #include "util/Logging.h"
 #include "util/TmpDir.h"
 #include "util/XDRStream.h"
+#include "util/types.h"
 #include "xdrpp/message.h"
 #include <Tracy.hpp>
+#include <atomic>
+#include <condition_variable>
 #include <fmt/format.h>
 #include <future>
+#include <mutex>
+#include <optional>
 
 namespace stellar
 {
 
-Bucket::Bucket(std::string const& filename, Hash const& hash)
-    : mFilename(filename), mHash(hash)
+Bucket::Bucket(std::string const& filename, Hash const& hash,
+               std::unique_ptr<BucketIndex const>&& index)
+    : mFilename(filename), mHash(hash), mIndex(std::move(index))
 {
     releaseAssert(filename.empty() || fs::exists(filename));
     if (!filename.empty())
     {
         CLOG_TRACE(Bucket, "Bucket::Bucket() created, file exists : {}",
                    mFilename);
-        mSize = fs::size(filename);
+        // The size of the XDR records, which is that of the file unless it
+        // is an XDR block file.
+        XDRInputMappedFileStream in;
+        in.open(filename);
+        mSize = in.size();
     }
 }
 
@@ -66,6 +77,85 @@ Bucket::getSize() const
     return mSize;
 }
 
+BucketIndex const*
+Bucket::getIndex() const
+{
+    return mIndex.get();
+}
+
+void
+Bucket::loadKeys(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
+                 std::vector<LedgerEntry>& result) const
+{
+    ZoneScoped;
+    if (mFilename.empty() || keys.empty())
+    {
+        return;
+    }
+
+    XDRInputMappedFileStream in;
+    in.open(mFilename, mIndex ? fs::MappedFile::Access::RANDOM
+                              : fs::MappedFile::Access::SEQUENTIAL);
+    LedgerEntryIdCmp cmp;
+    BucketEntry be;
+    auto found = [&](std::set<LedgerKey, LedgerEntryIdCmp>::iterator key) {
+        if (be.type() != DEADENTRY)
+        {
+            result.emplace_back(be.liveEntry());
+        }
+        return keys.erase(key);
+    };
+    auto entryKey = [&]() -> LedgerKey {
+        return be.type() == DEADENTRY ? be.deadEntry()
+                                      : LedgerEntryKey(be.liveEntry());
+    };
+
+    auto key = keys.begin();
+    if (mIndex)
+    {
+        while (key != keys.end())
+        {
+            auto offset = mIndex->lookup(*key);
+            bool hit = false;
+            if (offset)
+            {
+                // Entries are sorted, so scan the page until reaching or
+                // passing the key.
+                in.seek(*offset);
+                while (in.readOne(be))
+                {
+                    auto k = entryKey();
+                    if (!cmp(k, *key))
+                    {
+                        hit = !cmp(*key, k);
+                        break;
+                    }
+                }
+            }
+            key = hit ? found(key) : std::next(key);
+        }
+        return;
+    }
+
+    // No index: merge the sorted keys with the sorted bucket.
+    while (key != keys.end() && in.readOne(be))
+    {
+        if (be.type() == METAENTRY)
+        {
+            continue;
+        }
+        auto k = entryKey();
+        while (key != keys.end() && cmp(*key, k))
+        {
+            ++key;
+        }
+        if (key != keys.end() && !cmp(k, *key))
+        {
+            key = found(key);
+        }
+    }
+}
+
 bool
 Bucket::containsBucketIdentity(BucketEntry const& id) const
 {
@@ -160,7 +250,8 @@ Bucket::fresh(BucketManager& bucketManager, uint32_t protocolVersion,
 
     MergeCounters mc;
     BucketOutputIterator out(bucketManager.getTmpDir(), true, meta, mc, ctx,
-                             doFsync);
+                             doFsync, /*isPartition=*/false,
+                             bucketManager.getBucketFileBlockSize());
     for (auto const& e : entries)
     {
         out.put(e);
@@ -591,6 +682,179 @@ mergeCasesWithEqualKeys(MergeCounters& mc, BucketInputIterator& oi,
     ++ni;
 }
 
+static void
+mergeRange(BucketManager& bucketManager, MergeCounters& mc,
+           BucketInputIterator& oi, BucketInputIterator& ni,
+           BucketOutputIterator& out,
+           std::vector<BucketInputIterator>& shadowIterators,
+           uint32_t protocolVersion, bool keepShadowedLifecycleEntries)
+{
+    BucketEntryIdCmp cmp;
+    size_t iter = 0;
+
+    while (oi || ni)
+    {
+        // Check if the merge should be stopped every few entries
+        if (++iter >= 1000)
+        {
+            iter = 0;
+            if (bucketManager.isShutdown())
+            {
+                // Stop merging, as BucketManager is now shutdown
+                // This is safe as temp file has not been adopted yet,
+                // so it will be removed with the tmp dir
+                throw std::runtime_error(
+                    "Incomplete bucket merge due to BucketManager shutdown");
+            }
+        }
+
+        if (!mergeCasesWithDefaultAcceptance(cmp, mc, oi, ni, out,
+                                             shadowIterators, protocolVersion,
+                                             keepShadowedLifecycleEntries))
+        {
+            mergeCasesWithEqualKeys(mc, oi, ni, out, shadowIterators,
+                                    protocolVersion,
+                                    keepShadowedLifecycleEntries);
+        }
+    }
+}
+
+// A merge without shadows can be split into partitions by key range: the
+// output entries for a key only depend on the input entries for that key, so
+// the concatenation of the outputs of the partitions, in key order, is the
+// output of the whole merge. The keys that split the partitions are taken
+// from the index of the larger input. Returns no keys for a serial merge.
+static std::vector<LedgerKey>
+getMergePartitionKeys(BucketManager& bucketManager,
+                      std::shared_ptr<Bucket> const& oldBucket,
+                      std::shared_ptr<Bucket> const& newBucket,
+                      std::vector<std::shared_ptr<Bucket>> const& shadows)
+{
+    if (!shadows.empty())
+    {
+        return {};
+    }
+    auto n = bucketManager.getMergePartitionCount(oldBucket->getSize() +
+                                                  newBucket->getSize());
+    if (n < 2)
+    {
+        return {};
+    }
+    for (auto const& b : {oldBucket, newBucket})
+    {
+        if (!b->getFilename().empty() && !b->getIndex())
+        {
+            return {};
+        }
+    }
+    auto const& larger = oldBucket->getSize() >= newBucket->getSize()
+                             ? oldBucket
+                             : newBucket;
+    return larger->getIndex()->getPartitionKeys(n);
+}
+
+// Merges the partitions split by partitionKeys concurrently, each into its own
+// file: the calling thread and partitionKeys.size() tasks posted to worker
+// threads take partitions until none is left, so the merge completes even if
+// no worker thread is free. The partitions are then appended to out in order.
+static void
+mergePartitions(BucketManager& bucketManager,
+                std::shared_ptr<Bucket> const& oldBucket,
+                std::shared_ptr<Bucket> const& newBucket,
+                std::vector<LedgerKey> const& partitionKeys,
+                bool keepDeadEntries, BucketMetadata const& meta,
+                bool keepShadowedLifecycleEntries, MergeCounters& mc,
+                BucketOutputIterator& out, asio::io_context& ctx, bool doFsync)
+{
+    ZoneScoped;
+    struct Partitions
+    {
+        std::vector<LedgerKey> const mKeys;
+        std::vector<std::unique_ptr<BucketOutputIterator>> mOutputs;
+        std::vector<MergeCounters> mCounters;
+        std::atomic<size_t> mNext{0};
+
+        std::mutex mMutex;
+        std::condition_variable mDoneCV;
+        size_t mDone{0};
+        std::exception_ptr mError;
+
+        explicit Partitions(std::vector<LedgerKey> const& keys)
+            : mKeys(keys), mOutputs(keys.size() + 1), mCounters(keys.size() + 1)
+        {
+        }
+    };
+    auto parts = std::make_shared<Partitions>(partitionKeys);
+    size_t const n = partitionKeys.size() + 1;
+
+    // Tasks that only start once all partitions are taken return without
+    // touching anything but parts, so they may outlive this call.
+    auto run = [parts, n, &bucketManager, oldBucket, newBucket,
+                keepDeadEntries, meta, keepShadowedLifecycleEntries, &ctx,
+                doFsync]() {
+        for (size_t i = parts->mNext++; i < n; i = parts->mNext++)
+        {
+            try
+            {
+                std::optional<LedgerKey> begin, end;
+                if (i > 0)
+                {
+                    begin = parts->mKeys[i - 1];
+                }
+                if (i < n - 1)
+                {
+                    end = parts->mKeys[i];
+                }
+                BucketInputIterator oi(oldBucket);
+                BucketInputIterator ni(newBucket);
+                oi.restrictTo(begin, end);
+                ni.restrictTo(begin, end);
+                auto& partMc = parts->mCounters[i];
+                parts->mOutputs[i] = std::make_unique<BucketOutputIterator>(
+                    bucketManager.getTmpDir(), keepDeadEntries, meta, partMc,
+                    ctx, doFsync, /*isPartition=*/true);
+                std::vector<BucketInputIterator> noShadows;
+                mergeRange(bucketManager, partMc, oi, ni, *parts->mOutputs[i],
+                           noShadows, meta.ledgerVersion,
+                           keepShadowedLifecycleEntries);
+                parts->mOutputs[i]->closePartition();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(parts->mMutex);
+                if (!parts->mError)
+                {
+                    parts->mError = std::current_exception();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(parts->mMutex);
+                ++parts->mDone;
+            }
+            parts->mDoneCV.notify_all();
+        }
+    };
+    for (size_t i = 1; i < n; ++i)
+    {
+        bucketManager.postMergePartition(run);
+    }
+    run();
+    {
+        std::unique_lock<std::mutex> lock(parts->mMutex);
+        parts->mDoneCV.wait(lock, [&]() { return parts->mDone == n; });
+        if (parts->mError)
+        {
+            std::rethrow_exception(parts->mError);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        out.appendPartition(*parts->mOutputs[i]);
+        mc += parts->mCounters[i];
+    }
+}
+
 std::shared_ptr<Bucket>
 Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
               std::shared_ptr<Bucket> const& oldBucket,
@@ -623,35 +887,21 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
     BucketMetadata meta;
     meta.ledgerVersion = protocolVersion;
     BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries, meta,
-                             mc, ctx, doFsync);
-
-    BucketEntryIdCmp cmp;
-    size_t iter = 0;
+                             mc, ctx, doFsync, /*isPartition=*/false,
+                             bucketManager.getBucketFileBlockSize());
 
-    while (oi || ni)
+    auto partitionKeys = getMergePartitionKeys(bucketManager, oldBucket,
+                                               newBucket, shadows);
+    if (partitionKeys.empty())
     {
-        // Check if the merge should be stopped every few entries
-        if (++iter >= 1000)
-        {
-            iter = 0;
-            if (bucketManager.isShutdown())
-            {
-                // Stop merging, as BucketManager is now shutdown
-                // This is safe as temp file has not been adopted yet,
-                // so it will be removed with the tmp dir
-                throw std::runtime_error(
-                    "Incomplete bucket merge due to BucketManager shutdown");
-            }
-        }
-
-        if (!mergeCasesWithDefaultAcceptance(cmp, mc, oi, ni, out,
-                                             shadowIterators, protocolVersion,
-                                             keepShadowedLifecycleEntries))
-        {
-            mergeCasesWithEqualKeys(mc, oi, ni, out, shadowIterators,
-                                    protocolVersion,
-                                    keepShadowedLifecycleEntries);
-        }
+        mergeRange(bucketManager, mc, oi, ni, out, shadowIterators,
+                   protocolVersion, keepShadowedLifecycleEntries);
+    }
+    else
+    {
+        mergePartitions(bucketManager, oldBucket, newBucket, partitionKeys,
+                        keepDeadEntries, meta, keepShadowedLifecycleEntries, mc,
+                        out, ctx, doFsync);
     }
     if (countMergeEvents)
     {
@@ -4,11 +4,13 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "bucket/BucketIndex.h"
 #include "bucket/LedgerCmp.h"
 #include "crypto/Hex.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/XDRStream.h"
+#include <set>
 #include <string>
 
 namespace stellar
@@ -37,6 +39,7 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     std::string const mFilename;
     Hash const mHash;
     size_t mSize{0};
+    std::unique_ptr<BucketIndex const> const mIndex;
 
   public:
     // Create an empty bucket. The empty bucket has hash '000000...' and its
@@ -46,12 +49,24 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // Construct a bucket with a given filename and hash. Asserts that the file
     // exists, but does not check that the hash is the bucket's hash. Caller
     // needs to ensure that.
-    Bucket(std::string const& filename, Hash const& hash);
+    Bucket(std::string const& filename, Hash const& hash,
+           std::unique_ptr<BucketIndex const>&& index = nullptr);
 
     Hash const& getHash() const;
     std::string const& getFilename() const;
+    // The size of the bucket's XDR records, whatever the format of its file.
     size_t getSize() const;
 
+    // The point-lookup index of the bucket, or nullptr if it has none.
+    BucketIndex const* getIndex() const;
+
+    // Looks up keys in the bucket. Each key found is removed from keys and,
+    // unless the bucket holds a DEADENTRY for it, its entry is appended to
+    // result. Uses the bucket's index if it has one and scans the whole
+    // bucket otherwise.
+    void loadKeys(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
+                  std::vector<LedgerEntry>& result) const;
+
     // Returns true if a BucketEntry that is key-wise identical to the given
     // BucketEntry exists in the bucket. For testing.
     bool containsBucketIdentity(BucketEntry const& id) const;
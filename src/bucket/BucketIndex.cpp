@@ -0,0 +1,263 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "bucket/BucketIndex.h"
+#include "bucket/LedgerCmp.h"
+#include "crypto/Hex.h"
+#include "crypto/XDRHasher.h"
+#include "util/Fs.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/XDRStream.h"
+#include "util/siphash.h"
+#include "util/types.h"
+#include <Tracy.hpp>
+#include <algorithm>
+
+namespace stellar
+{
+
+namespace
+{
+// SipHash2,4 of the XDR of a key, keyed with the first 16 bytes of the bucket
+// hash. Unlike shortHash, this doesn't depend on the process, so bloom
+// filters can be saved.
+struct BloomHasher : XDRHasher<BloomHasher>
+{
+    SipHash24 state;
+    explicit BloomHasher(Hash const& bucketHash) : state(bucketHash.data())
+    {
+    }
+    void
+    hashBytes(unsigned char const* bytes, size_t size)
+    {
+        state.update(bytes, size);
+    }
+};
+
+LedgerKey
+bucketEntryKey(BucketEntry const& be)
+{
+    if (be.type() == DEADENTRY)
+    {
+        return be.deadEntry();
+    }
+    return LedgerEntryKey(be.liveEntry());
+}
+}
+
+BucketIndex::BucketIndex(Hash const& bucketHash, size_t pageSize)
+    : mBucketHash(bucketHash), mPageSize(pageSize)
+{
+    releaseAssert(pageSize > 0);
+}
+
+uint64_t
+BucketIndex::bloomHash(LedgerKey const& key) const
+{
+    BloomHasher hasher(mBucketHash);
+    xdr::archive(hasher, key);
+    hasher.flush();
+    return hasher.state.digest();
+}
+
+// The bits of a key are picked by double hashing, from the two halves of its
+// 64-bit hash.
+void
+BucketIndex::bloomAdd(uint64_t hash)
+{
+    uint64_t nBits = mBloomBits.size() * 64;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < mBloomHashes; ++i)
+    {
+        uint64_t bit = (hash + i * h2) % nBits;
+        mBloomBits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool
+BucketIndex::bloomTest(uint64_t hash) const
+{
+    uint64_t nBits = mBloomBits.size() * 64;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < mBloomHashes; ++i)
+    {
+        uint64_t bit = (hash + i * h2) % nBits;
+        if ((mBloomBits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<BucketIndex const>
+BucketIndex::createIndex(std::string const& filename, Hash const& bucketHash,
+                         size_t pageSize)
+{
+    ZoneScoped;
+    std::unique_ptr<BucketIndex> index(new BucketIndex(bucketHash, pageSize));
+
+    XDRInputMappedFileStream in;
+    in.open(filename);
+    std::vector<uint64_t> hashes;
+    BucketEntry be;
+    size_t pageStart = 0;
+    size_t pos = in.pos();
+    while (in.readOne(be))
+    {
+        if (be.type() != METAENTRY)
+        {
+            auto key = bucketEntryKey(be);
+            if (index->mPageKeys.empty() || pos >= pageStart + pageSize)
+            {
+                index->mPageKeys.emplace_back(key);
+                index->mPageOffsets.emplace_back(pos);
+                pageStart = pos;
+            }
+            hashes.emplace_back(index->bloomHash(key));
+        }
+        pos = in.pos();
+    }
+
+    size_t nWords = (hashes.size() * kBloomBitsPerKey + 63) / 64;
+    index->mBloomBits.assign(std::max<size_t>(nWords, 1), 0);
+    index->mBloomHashes = kBloomHashes;
+    for (auto h : hashes)
+    {
+        index->bloomAdd(h);
+    }
+
+    CLOG_DEBUG(Bucket, "Indexed bucket {}: {} entries in {} pages",
+               hexAbbrev(bucketHash), hashes.size(), index->mPageKeys.size());
+    return index;
+}
+
+std::unique_ptr<BucketIndex const>
+BucketIndex::load(std::string const& indexFilename, Hash const& bucketHash,
+                  size_t pageSize)
+{
+    ZoneScoped;
+    if (!fs::exists(indexFilename))
+    {
+        return nullptr;
+    }
+    std::unique_ptr<BucketIndex> index(new BucketIndex(bucketHash, pageSize));
+    try
+    {
+        XDRInputFileStream in;
+        in.open(indexFilename);
+        uint32_t version = 0;
+        Hash hash;
+        uint64_t savedPageSize = 0;
+        xdr::xvector<uint64_t> bloomBits;
+        uint64_t pageCount = 0;
+        if (!in.readOne(version) || version != kIndexVersion ||
+            !in.readOne(hash) || hash != bucketHash ||
+            !in.readOne(savedPageSize) || savedPageSize != pageSize ||
+            !in.readOne(index->mBloomHashes) || !in.readOne(bloomBits) ||
+            bloomBits.empty() || !in.readOne(pageCount))
+        {
+            return nullptr;
+        }
+        index->mBloomBits = std::move(bloomBits);
+        index->mPageKeys.resize(pageCount);
+        index->mPageOffsets.resize(pageCount);
+        for (size_t i = 0; i < pageCount; ++i)
+        {
+            if (!in.readOne(index->mPageKeys[i]) ||
+                !in.readOne(index->mPageOffsets[i]))
+            {
+                return nullptr;
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        CLOG_WARNING(Bucket, "Ignoring unreadable bucket index {}: {}",
+                     indexFilename, e.what());
+        return nullptr;
+    }
+    return index;
+}
+
+void
+BucketIndex::save(std::string const& indexFilename, asio::io_context& ctx,
+                  bool doFsync) const
+{
+    ZoneScoped;
+    XDROutputFileStream out(ctx, doFsync);
+    out.open(indexFilename);
+    out.writeOne(kIndexVersion);
+    out.writeOne(mBucketHash);
+    out.writeOne(static_cast<uint64_t>(mPageSize));
+    out.writeOne(mBloomHashes);
+    out.writeOne(xdr::xvector<uint64_t>(mBloomBits.begin(), mBloomBits.end()));
+    out.writeOne(static_cast<uint64_t>(mPageKeys.size()));
+    for (size_t i = 0; i < mPageKeys.size(); ++i)
+    {
+        out.writeOne(mPageKeys[i]);
+        out.writeOne(mPageOffsets[i]);
+    }
+    out.close();
+}
+
+std::string
+BucketIndex::indexFilename(std::string const& bucketFilename)
+{
+    return bucketFilename + ".index";
+}
+
+std::optional<size_t>
+BucketIndex::lookup(LedgerKey const& key) const
+{
+    if (mPageKeys.empty() || !bloomTest(bloomHash(key)))
+    {
+        return std::nullopt;
+    }
+    return getScanOffset(key);
+}
+
+std::optional<size_t>
+BucketIndex::getScanOffset(LedgerKey const& key) const
+{
+    auto it = std::upper_bound(mPageKeys.begin(), mPageKeys.end(), key,
+                               LedgerEntryIdCmp{});
+    if (it == mPageKeys.begin())
+    {
+        return std::nullopt;
+    }
+    return mPageOffsets[std::distance(mPageKeys.begin(), it) - 1];
+}
+
+std::vector<LedgerKey>
+BucketIndex::getPartitionKeys(size_t n) const
+{
+    std::vector<LedgerKey> keys;
+    size_t prev = 0;
+    for (size_t i = 1; i < n; ++i)
+    {
+        size_t page = i * mPageKeys.size() / n;
+        if (page > prev)
+        {
+            keys.emplace_back(mPageKeys[page]);
+            prev = page;
+        }
+    }
+    return keys;
+}
+
+size_t
+BucketIndex::getPageSize() const
+{
+    return mPageSize;
+}
+
+size_t
+BucketIndex::getPageCount() const
+{
+    return mPageKeys.size();
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace asio
+{
+class io_context;
+}
+
+namespace stellar
+{
+
+/**
+ * BucketIndex is an immutable point-lookup index over the entries of a bucket
+ * file, so that a handful of keys can be read from a bucket without scanning
+ * it. It has two parts:
+ *
+ *   - A page index: the file is cut into pages of about `pageSize` bytes
+ *     (always at entry boundaries) and the index holds the key of the first
+ *     entry of each page and the page's offset. Since the entries of a bucket
+ *     are sorted by key, an entry can only be in the last page whose first
+ *     key is not greater than its key.
+ *
+ *   - A bloom filter over all the keys of the bucket, so that most lookups of
+ *     keys that are not in the bucket don't touch the file at all. The bloom
+ *     filter is keyed with the bucket hash, so it is deterministic.
+ *
+ * The index is built when a bucket is adopted by the BucketManager and is
+ * stored next to the bucket file, as `<bucket file>.index`.
+ */
+class BucketIndex : public NonMovableOrCopyable
+{
+    Hash const mBucketHash;
+    size_t const mPageSize;
+
+    // First key and offset of each page, in file order.
+    std::vector<LedgerKey> mPageKeys;
+    std::vector<uint64_t> mPageOffsets;
+
+    std::vector<uint64_t> mBloomBits;
+    uint32_t mBloomHashes{0};
+
+    uint64_t bloomHash(LedgerKey const& key) const;
+    void bloomAdd(uint64_t hash);
+    bool bloomTest(uint64_t hash) const;
+
+    BucketIndex(Hash const& bucketHash, size_t pageSize);
+
+  public:
+    static constexpr uint32_t kIndexVersion = 1;
+
+    // Bits of the bloom filter per key; with kBloomHashes hashes the false
+    // positive rate is about 1%.
+    static constexpr uint32_t kBloomBitsPerKey = 10;
+    static constexpr uint32_t kBloomHashes = 7;
+
+    // Builds the index of the bucket file `filename`, whose hash is
+    // `bucketHash`, by reading it once.
+    static std::unique_ptr<BucketIndex const>
+    createIndex(std::string const& filename, Hash const& bucketHash,
+                size_t pageSize);
+
+    // Loads an index written by `save`. Returns nullptr if the index file
+    // doesn't exist or doesn't match `bucketHash` or `pageSize` (e.g. it was
+    // written with another BUCKET_INDEX_PAGE_SIZE).
+    static std::unique_ptr<BucketIndex const>
+    load(std::string const& indexFilename, Hash const& bucketHash,
+         size_t pageSize);
+
+    void save(std::string const& indexFilename, asio::io_context& ctx,
+              bool doFsync) const;
+
+    static std::string indexFilename(std::string const& bucketFilename);
+
+    // Returns the offset of the page that holds key if the bucket may hold
+    // it, or nullopt if the bucket doesn't hold it.
+    std::optional<size_t> lookup(LedgerKey const& key) const;
+
+    // Returns the offset of the page from which to scan for the first entry
+    // whose key is not less than key, or nullopt to scan from the start.
+    std::optional<size_t> getScanOffset(LedgerKey const& key) const;
+
+    // Returns up to n - 1 increasing keys, taken from the first keys of
+    // evenly spaced pages, that split the bucket into n parts of about the
+    // same size.
+    std::vector<LedgerKey> getPartitionKeys(size_t n) const;
+
+    size_t getPageSize() const;
+    size_t getPageCount() const;
+};
+}
@@ -4,10 +4,26 @@
 
 #include "bucket/BucketInputIterator.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
 #include <Tracy.hpp>
 
 namespace stellar
 {
+
+namespace
+{
+bool
+entryBefore(BucketEntry const& e, LedgerKey const& key)
+{
+    LedgerEntryIdCmp cmp;
+    if (e.type() == DEADENTRY)
+    {
+        return cmp(e.deadEntry(), key);
+    }
+    return cmp(e.liveEntry().data, key);
+}
+}
+
 /**
  * Helper class that reads from the file underlying a bucket, keeping the bucket
  * alive for the duration of its existence.
@@ -44,6 +60,10 @@ BucketInputIterator::loadEntry()
             {
                 Bucket::checkProtocolLegality(mEntry, mMetadata.ledgerVersion);
             }
+            if (mEnd && !entryBefore(mEntry, *mEnd))
+            {
+                mEntryPtr = nullptr;
+            }
         }
     }
     else
@@ -124,4 +144,34 @@ BucketInputIterator::operator++()
     }
     return *this;
 }
+
+void
+BucketInputIterator::restrictTo(std::optional<LedgerKey> const& begin,
+                                std::optional<LedgerKey> const& end)
+{
+    ZoneScoped;
+    mEnd = end;
+    if (!mEntryPtr)
+    {
+        return;
+    }
+    if (begin)
+    {
+        auto index = mBucket->getIndex();
+        auto offset = index ? index->getScanOffset(*begin) : std::nullopt;
+        if (offset)
+        {
+            mIn.seek(*offset);
+            loadEntry();
+        }
+        while (mEntryPtr && entryBefore(*mEntryPtr, *begin))
+        {
+            loadEntry();
+        }
+    }
+    if (mEntryPtr && mEnd && !entryBefore(*mEntryPtr, *mEnd))
+    {
+        mEntryPtr = nullptr;
+    }
+}
 }
@@ -9,6 +9,7 @@
 #include "xdr/Stellar-ledger.h"
 
 #include <memory>
+#include <optional>
 
 namespace stellar
 {
@@ -24,11 +25,12 @@ class BucketInputIterator
     // pointer. If
     // non-null, it points to mEntry.
     BucketEntry const* mEntryPtr{nullptr};
-    XDRInputFileStream mIn;
+    XDRInputMappedFileStream mIn;
     BucketEntry mEntry;
     bool mSeenMetadata{false};
     bool mSeenOtherEntries{false};
     BucketMetadata mMetadata;
+    std::optional<LedgerKey> mEnd;
     void loadEntry();
 
   public:
@@ -52,6 +54,13 @@ class BucketInputIterator
 
     BucketInputIterator& operator++();
 
+    // Restricts the iterator to the entries whose keys are in [begin, end),
+    // unset bounds being open. Must be called before advancing the iterator.
+    // Skips to begin through the bucket's index if it has one, and by reading
+    // through the bucket otherwise.
+    void restrictTo(std::optional<LedgerKey> const& begin,
+                    std::optional<LedgerKey> const& end);
+
     size_t pos();
     size_t size() const;
 };
@@ -36,6 +36,26 @@ BucketLevel::getHash() const
     return hsh.finish();
 }
 
+std::vector<LedgerEntry>
+BucketList::loadKeys(UnorderedSet<LedgerKey> const& inKeys) const
+{
+    ZoneScoped;
+    std::set<LedgerKey, LedgerEntryIdCmp> keys(inKeys.begin(), inKeys.end());
+    std::vector<LedgerEntry> result;
+    for (auto const& lev : mLevels)
+    {
+        for (auto const& bucket : {lev.getCurr(), lev.getSnap()})
+        {
+            if (keys.empty())
+            {
+                return result;
+            }
+            bucket->loadKeys(keys, result);
+        }
+    }
+    return result;
+}
+
 FutureBucket const&
 BucketLevel::getNext() const
 {
@@ -6,6 +6,7 @@
 
 #include "bucket/FutureBucket.h"
 #include "overlay/StellarXDR.h"
+#include "util/UnorderedSet.h"
 #include "xdrpp/message.h"
 #include <future>
 
@@ -402,6 +403,14 @@ class BucketList
     // of the concatenation of the hashes of the `curr` and `snap` buckets.
     Hash getHash() const;
 
+    // Loads the live entries for keys from the buckets, searching them from
+    // the newest (level 0 curr) to the oldest, so the first bucket that holds
+    // a key has its newest version; keys that are dead or in no bucket are
+    // left out. Buckets with a BucketIndex are searched through it, others
+    // are scanned. Note that the genesis ledger's root account is only in the
+    // buckets once a later ledger modifies it.
+    std::vector<LedgerEntry> loadKeys(UnorderedSet<LedgerKey> const& keys) const;
+
     // Restart any merges that might be running on background worker threads,
     // merging buckets between levels. This needs to be called after forcing a
     // BucketList to adopt a new state, either at application restart or when
@@ -7,6 +7,7 @@
 #include "bucket/Bucket.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
+#include <functional>
 #include <future>
 #include <map>
 #include <memory>
@@ -108,6 +109,18 @@ class BucketManager : NonMovableOrCopyable
 
     virtual medida::Timer& getMergeTimer() = 0;
 
+    // The number of partitions to split a merge of buckets of inputBytes
+    // bytes in all into, to be merged concurrently (see Bucket::merge); 1 for
+    // a serial merge.
+    virtual uint32_t getMergePartitionCount(size_t inputBytes) const = 0;
+
+    // The block size of the XDR block files that new buckets are written
+    // as (see XDRBlockFile.h); 0 to write them as plain XDR files.
+    virtual size_t getBucketFileBlockSize() const = 0;
+
+    // Runs f on a worker thread, for the partitions of partitioned merges.
+    virtual void postMergePartition(std::function<void()>&& f) = 0;
+
     // Reading and writing the merge counters is done in bulk, and takes a lock
     // briefly; this can be done from any thread.
     virtual MergeCounters readMergeCounters() = 0;
@@ -4,6 +4,7 @@
 
 #include "bucket/BucketManagerImpl.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketOutputIterator.h"
@@ -20,6 +21,7 @@
 #include "util/Logging.h"
 #include "util/TmpDir.h"
 #include "util/types.h"
+#include <algorithm>
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fstream>
@@ -134,7 +136,7 @@ bucketBasename(std::string const& bucketHexHash)
 bool
 isBucketFile(std::string const& name)
 {
-    static std::regex re("^bucket-[a-z0-9]{64}\\.xdr(\\.gz)?$");
+    static std::regex re("^bucket-[a-z0-9]{64}\\.xdr(\\.gz|\\.index)?$");
     return std::regex_match(name, re);
 };
 
@@ -248,6 +250,31 @@ BucketManagerImpl::getMergeTimer()
     return mBucketSnapMerge;
 }
 
+uint32_t
+BucketManagerImpl::getMergePartitionCount(size_t inputBytes) const
+{
+    auto const& cfg = mApp.getConfig();
+    if (cfg.BUCKET_MERGE_PARTITION_SIZE == 0 || cfg.BUCKET_INDEX_PAGE_SIZE == 0)
+    {
+        return 1;
+    }
+    auto n = inputBytes / cfg.BUCKET_MERGE_PARTITION_SIZE;
+    return static_cast<uint32_t>(std::clamp<size_t>(
+        n, 1, static_cast<size_t>(std::max(cfg.WORKER_THREADS, 1))));
+}
+
+size_t
+BucketManagerImpl::getBucketFileBlockSize() const
+{
+    return mApp.getConfig().BUCKET_FILE_BLOCK_SIZE;
+}
+
+void
+BucketManagerImpl::postMergePartition(std::function<void()>&& f)
+{
+    mApp.postOnBackgroundThread(std::move(f), "BucketMergePartition");
+}
+
 MergeCounters
 BucketManagerImpl::readMergeCounters()
 {
@@ -366,6 +393,16 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
 {
     ZoneScoped;
     releaseAssertOrThrow(mApp.getConfig().MODE_ENABLES_BUCKETLIST);
+
+    // Index the bucket before taking the lock: this reads the whole file, and
+    // usually runs on the worker thread of the merge that produced it.
+    std::unique_ptr<BucketIndex const> index;
+    auto pageSize = mApp.getConfig().BUCKET_INDEX_PAGE_SIZE;
+    if (pageSize > 0)
+    {
+        index = BucketIndex::createIndex(filename, hash, pageSize);
+    }
+
     std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
 
     if (mergeKey)
@@ -416,7 +453,13 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
             }
         }
 
-        b = std::make_shared<Bucket>(canonicalName, hash);
+        if (index)
+        {
+            index->save(BucketIndex::indexFilename(canonicalName),
+                        mApp.getClock().getIOContext(),
+                        !mApp.getConfig().DISABLE_XDR_FSYNC);
+        }
+        b = std::make_shared<Bucket>(canonicalName, hash, std::move(index));
         {
             mSharedBuckets.emplace(hash, b);
             mSharedBucketsSize.set_count(mSharedBuckets.size());
@@ -474,7 +517,21 @@ BucketManagerImpl::getBucketByHash(uint256 const& hash)
                    "BucketManager::getBucketByHash({}) found no bucket, making "
                    "new one",
                    binToHex(hash));
-        auto p = std::make_shared<Bucket>(canonicalName, hash);
+        std::unique_ptr<BucketIndex const> index;
+        auto pageSize = mApp.getConfig().BUCKET_INDEX_PAGE_SIZE;
+        if (pageSize > 0)
+        {
+            auto indexName = BucketIndex::indexFilename(canonicalName);
+            index = BucketIndex::load(indexName, hash, pageSize);
+            if (!index)
+            {
+                index = BucketIndex::createIndex(canonicalName, hash, pageSize);
+                index->save(indexName, mApp.getClock().getIOContext(),
+                            !mApp.getConfig().DISABLE_XDR_FSYNC);
+            }
+        }
+        auto p =
+            std::make_shared<Bucket>(canonicalName, hash, std::move(index));
         mSharedBuckets.emplace(hash, p);
         mSharedBucketsSize.set_count(mSharedBuckets.size());
         return p;
@@ -688,6 +745,8 @@ BucketManagerImpl::forgetUnreferencedBuckets()
                 std::remove(filename.c_str());
                 auto gzfilename = filename + ".gz";
                 std::remove(gzfilename.c_str());
+                auto indexfilename = BucketIndex::indexFilename(filename);
+                std::remove(indexfilename.c_str());
             }
 
             // Dropping this bucket means we'll no longer be able to
@@ -92,6 +92,9 @@ class BucketManagerImpl : public BucketManager
     std::string const& getBucketDir() const override;
     BucketList& getBucketList() override;
     medida::Timer& getMergeTimer() override;
+    uint32_t getMergePartitionCount(size_t inputBytes) const override;
+    size_t getBucketFileBlockSize() const override;
+    void postMergePartition(std::function<void()>&& f) override;
     MergeCounters readMergeCounters() override;
     void incrMergeCounters(MergeCounters const&) override;
     TmpDirManager& getTmpDirManager() override;
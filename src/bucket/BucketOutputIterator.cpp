@@ -39,9 +39,10 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
                                            bool keepDeadEntries,
                                            BucketMetadata const& meta,
                                            MergeCounters& mc,
-                                           asio::io_context& ctx, bool doFsync)
+                                           asio::io_context& ctx, bool doFsync,
+                                           bool isPartition, size_t blockSize)
     : mFilename(randomBucketName(tmpDir))
-    , mOut(ctx, doFsync)
+    , mOut(ctx, doFsync, isPartition ? 0 : blockSize)
     , mBuf(nullptr)
     , mKeepDeadEntries(keepDeadEntries)
     , mMeta(meta)
@@ -53,8 +54,9 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
     // Will throw if unable to open the file
     mOut.open(mFilename);
 
-    if (meta.ledgerVersion >=
-        Bucket::FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY)
+    if (!isPartition &&
+        meta.ledgerVersion >=
+            Bucket::FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY)
     {
         BucketEntry bme;
         bme.type(METAENTRY);
@@ -110,6 +112,56 @@ BucketOutputIterator::put(BucketEntry const& e)
     *mBuf = e;
 }
 
+void
+BucketOutputIterator::closePartition()
+{
+    ZoneScoped;
+    if (mBuf)
+    {
+        mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
+        mObjectsPut++;
+        mBuf.reset();
+    }
+    mOut.close();
+}
+
+void
+BucketOutputIterator::appendPartition(BucketOutputIterator& partition)
+{
+    ZoneScoped;
+    releaseAssert(!partition.mOut.isOpen());
+    if (mBuf)
+    {
+        mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
+        mObjectsPut++;
+        mBuf.reset();
+    }
+
+    std::ifstream in(partition.mFilename, std::ifstream::binary);
+    if (!in)
+    {
+        throw std::runtime_error("failed to open bucket partition " +
+                                 partition.mFilename);
+    }
+    std::vector<char> buf(fs::bufsz());
+    size_t copied = 0;
+    while (in)
+    {
+        in.read(buf.data(), buf.size());
+        auto n = static_cast<size_t>(in.gcount());
+        mOut.writeBytes(buf.data(), n, &mHasher, &mBytesPut);
+        copied += n;
+    }
+    if (copied != partition.mBytesPut)
+    {
+        throw std::runtime_error("short read of bucket partition " +
+                                 partition.mFilename);
+    }
+    mObjectsPut += partition.mObjectsPut;
+    in.close();
+    std::remove(partition.mFilename.c_str());
+}
+
 std::shared_ptr<Bucket>
 BucketOutputIterator::getBucket(BucketManager& bucketManager,
                                 MergeKey* mergeKey)
@@ -24,7 +24,7 @@ class BucketOutputIterator
 {
   protected:
     std::string mFilename;
-    XDROutputFileStream mOut;
+    XDROutputBlockFileStream mOut;
     BucketEntryIdCmp mCmp;
     std::unique_ptr<BucketEntry> mBuf;
     SHA256 mHasher;
@@ -43,12 +43,31 @@ class BucketOutputIterator
     // version new enough that it should _write_ the metadata to the stream in
     // the form of a METAENTRY; but that's not a thing the caller gets to decide
     // (or forget to do), it's handled automatically.
+    //
+    // The exception is the partitions of a partitioned merge (see
+    // Bucket::merge), constructed with `isPartition`: they hold a range of
+    // the entries of the bucket, without METAENTRY, and are appended to the
+    // output of the merge with appendPartition.
+    //
+    // With a nonzero `blockSize` the bucket is written as an XDR block file
+    // (see XDRBlockFile.h). Its hash is that of the plain XDR records either
+    // way. Partitions are always written as plain XDR files.
     BucketOutputIterator(std::string const& tmpDir, bool keepDeadEntries,
                          BucketMetadata const& meta, MergeCounters& mc,
-                         asio::io_context& ctx, bool doFsync);
+                         asio::io_context& ctx, bool doFsync,
+                         bool isPartition = false, size_t blockSize = 0);
 
     void put(BucketEntry const& e);
 
+    // Writes out the buffered entry and closes a partition.
+    void closePartition();
+
+    // Copies the entries of a closed partition, which must all follow the
+    // entries put so far, to the end of this bucket, and deletes the
+    // partition's file. The records are copied as they are, so the result is
+    // identical to putting the entries one by one.
+    void appendPartition(BucketOutputIterator& partition);
+
     std::shared_ptr<Bucket> getBucket(BucketManager& bucketManager,
                                       MergeKey* mergeKey = nullptr);
 };
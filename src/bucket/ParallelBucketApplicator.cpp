@@ -0,0 +1,567 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "bucket/ParallelBucketApplicator.h"
+#include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
+#include "bucket/BucketInputIterator.h"
+#include "bucket/LedgerCmp.h"
+#include "database/Database.h"
+#include "ledger/LedgerHashUtils.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/types.h"
+#include <Tracy.hpp>
+#include <fmt/format.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace stellar
+{
+
+namespace
+{
+// Reads buckets ordered newest first as one sorted sequence of entries, in
+// which each key appears once, with its entry from the newest bucket.
+class MergedBucketIterator
+{
+    std::vector<std::unique_ptr<BucketInputIterator>> mIters;
+    std::vector<size_t> mStartPos;
+    size_t mCurrent{0};
+    bool mValid{false};
+    uint64_t mShadowed{0};
+
+    void
+    findNext()
+    {
+        BucketEntryIdCmp cmp;
+        mValid = false;
+        for (size_t i = 0; i < mIters.size(); ++i)
+        {
+            // On equal keys the first (newest) iterator wins
+            if (*mIters[i] && (!mValid || cmp(**mIters[i], **mIters[mCurrent])))
+            {
+                mCurrent = i;
+                mValid = true;
+            }
+        }
+    }
+
+  public:
+    MergedBucketIterator(
+        std::vector<std::shared_ptr<Bucket const>> const& buckets,
+        std::optional<LedgerKey> const& begin,
+        std::optional<LedgerKey> const& end)
+    {
+        for (auto const& b : buckets)
+        {
+            mIters.emplace_back(std::make_unique<BucketInputIterator>(b));
+            if (begin || end)
+            {
+                mIters.back()->restrictTo(begin, end);
+            }
+            mStartPos.emplace_back(mIters.back()->pos());
+        }
+        findNext();
+    }
+
+    explicit operator bool() const
+    {
+        return mValid;
+    }
+
+    BucketEntry const&
+    operator*() const
+    {
+        return **mIters[mCurrent];
+    }
+
+    MergedBucketIterator&
+    operator++()
+    {
+        BucketEntryIdCmp cmp;
+        auto const& current = **mIters[mCurrent];
+        // Every bucket holds a key at most once, and no iterator is behind
+        // the current key, so older versions of it are the next entries of
+        // their buckets.
+        for (size_t i = 0; i < mIters.size(); ++i)
+        {
+            if (i != mCurrent && *mIters[i] && !cmp(current, **mIters[i]))
+            {
+                ++(*mIters[i]);
+                ++mShadowed;
+            }
+        }
+        ++(*mIters[mCurrent]);
+        findNext();
+        return *this;
+    }
+
+    // The number of older versions skipped so far.
+    uint64_t
+    getShadowed() const
+    {
+        return mShadowed;
+    }
+
+    uint64_t
+    getBytesRead()
+    {
+        uint64_t total = 0;
+        for (size_t i = 0; i < mIters.size(); ++i)
+        {
+            total += mIters[i]->pos() - mStartPos[i];
+        }
+        return total;
+    }
+};
+
+LedgerKey
+bucketEntryKey(BucketEntry const& be)
+{
+    if (be.type() == DEADENTRY)
+    {
+        return be.deadEntry();
+    }
+    return LedgerEntryKey(be.liveEntry());
+}
+
+LedgerEntryType
+bucketEntryType(BucketEntry const& be)
+{
+    if (be.type() == LIVEENTRY || be.type() == INITENTRY)
+    {
+        return be.liveEntry().data.type();
+    }
+    if (be.type() != DEADENTRY)
+    {
+        throw std::runtime_error(
+            "Malformed bucket: unexpected non-INIT/LIVE/DEAD entry.");
+    }
+    return be.deadEntry().type();
+}
+}
+
+struct ParallelBucketApplicator::State
+{
+    struct Batch
+    {
+        std::vector<LedgerEntry> mEntries;
+        std::vector<LedgerKey> mDeletedKeys;
+
+        size_t
+        size() const
+        {
+            return mEntries.size() + mDeletedKeys.size();
+        }
+    };
+
+    std::vector<std::shared_ptr<Bucket const>> const mBuckets;
+    uint32_t const mMaxProtocolVersion;
+    std::function<bool(LedgerEntryType)> const mFilter;
+
+    // Either the keys splitting the partitions, or nothing if partitions are
+    // split by key hash.
+    std::vector<LedgerKey> mPartitionKeys;
+    size_t mPartitionCount{1};
+    bool mHashPartitions{false};
+    bool mWriteOnWorkers{false};
+    uint64_t mTotalSize{0};
+
+    std::atomic<bool> mCancelled{false};
+    std::atomic<size_t> mRunning{0};
+    std::atomic<size_t> mFinished{0};
+    std::atomic<uint64_t> mEntriesRead{0};
+    std::atomic<uint64_t> mEntriesWritten{0};
+    std::atomic<uint64_t> mBytesRead{0};
+
+    mutable std::mutex mMutex;
+    std::condition_variable mPendingCV;
+    std::deque<Batch> mPending;
+    std::exception_ptr mError;
+
+    medida::Meter& mEntriesReadMeter;
+    medida::Meter& mEntriesShadowedMeter;
+    medida::Meter& mEntriesWrittenMeter;
+    medida::Timer& mBatchWriteTimer;
+
+    State(Application& app,
+          std::vector<std::shared_ptr<Bucket const>> const& buckets,
+          uint32_t maxProtocolVersion,
+          std::function<bool(LedgerEntryType)> filter)
+        : mBuckets(buckets)
+        , mMaxProtocolVersion(maxProtocolVersion)
+        , mFilter(filter)
+        , mEntriesReadMeter(app.getMetrics().NewMeter(
+              {"history", "bucket-apply", "entries-read"}, "entry"))
+        , mEntriesShadowedMeter(app.getMetrics().NewMeter(
+              {"history", "bucket-apply", "entries-shadowed"}, "entry"))
+        , mEntriesWrittenMeter(app.getMetrics().NewMeter(
+              {"history", "bucket-apply", "entries-written"}, "entry"))
+        , mBatchWriteTimer(app.getMetrics().NewTimer(
+              {"history", "bucket-apply", "batch-write"}))
+    {
+    }
+
+    // Batches handed over to the main thread wait in mPending; tasks stop
+    // producing while there are this many of them.
+    size_t
+    maxPendingBatches() const
+    {
+        return 2 * mPartitionCount;
+    }
+
+    void
+    fail(std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mError)
+            {
+                mError = error;
+            }
+            mCancelled = true;
+        }
+        mPendingCV.notify_all();
+    }
+
+    void
+    handOver(Batch&& batch)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mPendingCV.wait(lock, [&]() {
+            return mCancelled || mPending.size() < maxPendingBatches();
+        });
+        if (!mCancelled)
+        {
+            mPending.emplace_back(std::move(batch));
+        }
+    }
+
+    void
+    write(Batch const& batch, LedgerTxnRoot& root, soci::session& session)
+    {
+        ZoneScoped;
+        auto timer = mBatchWriteTimer.TimeScope();
+        soci::transaction tx(session);
+        root.writeEntriesOnSession(batch.mEntries, batch.mDeletedKeys,
+                                   session);
+        tx.commit();
+        mEntriesWrittenMeter.Mark(batch.size());
+        mEntriesWritten += batch.size();
+    }
+
+    void applyPartition(size_t partition, LedgerTxnRoot* root,
+                        soci::connection_pool* pool);
+};
+
+void
+ParallelBucketApplicator::State::applyPartition(size_t partition,
+                                                LedgerTxnRoot* root,
+                                                soci::connection_pool* pool)
+{
+    ZoneScoped;
+    try
+    {
+        std::unique_ptr<soci::session> session;
+        if (mWriteOnWorkers)
+        {
+            session = std::make_unique<soci::session>(*pool);
+        }
+
+        std::optional<LedgerKey> begin, end;
+        if (!mHashPartitions)
+        {
+            if (partition > 0)
+            {
+                begin = mPartitionKeys[partition - 1];
+            }
+            if (partition < mPartitionKeys.size())
+            {
+                end = mPartitionKeys[partition];
+            }
+        }
+
+        MergedBucketIterator iter(mBuckets, begin, end);
+        Batch batch;
+        // Changes only the root can write, when writing on this thread
+        Batch rootBatch;
+        uint64_t read = 0;
+        uint64_t shadowed = 0;
+        uint64_t bytesRead = 0;
+
+        auto reportProgress = [&]() {
+            mEntriesReadMeter.Mark(read);
+            mEntriesRead += read;
+            read = 0;
+            mEntriesShadowedMeter.Mark(iter.getShadowed() - shadowed);
+            shadowed = iter.getShadowed();
+            auto bytes = iter.getBytesRead();
+            mBytesRead += bytes - bytesRead;
+            bytesRead = bytes;
+        };
+        auto flush = [&]() {
+            reportProgress();
+            if (batch.size() == 0)
+            {
+                return;
+            }
+            if (mWriteOnWorkers)
+            {
+                write(batch, *root, *session);
+                batch = Batch();
+            }
+            else
+            {
+                handOver(std::move(batch));
+                batch = Batch();
+            }
+        };
+
+        for (; iter && !mCancelled; ++iter)
+        {
+            auto const& e = *iter;
+            if (++read > LEDGER_ENTRY_BATCH_COMMIT_SIZE)
+            {
+                reportProgress();
+            }
+            if (mHashPartitions &&
+                std::hash<LedgerKey>()(bucketEntryKey(e)) % mPartitionCount !=
+                    partition)
+            {
+                continue;
+            }
+            Bucket::checkProtocolLegality(e, mMaxProtocolVersion);
+            auto type = bucketEntryType(e);
+            if (!mFilter(type))
+            {
+                continue;
+            }
+
+            auto& b = (mWriteOnWorkers && type == SPEEDEX_CONFIG) ? rootBatch
+                                                                  : batch;
+            if (e.type() == DEADENTRY)
+            {
+                b.mDeletedKeys.emplace_back(e.deadEntry());
+            }
+            else
+            {
+                b.mEntries.emplace_back(e.liveEntry());
+            }
+            if (batch.size() > LEDGER_ENTRY_BATCH_COMMIT_SIZE)
+            {
+                flush();
+            }
+        }
+        if (!mCancelled)
+        {
+            flush();
+            if (rootBatch.size() != 0)
+            {
+                handOver(std::move(rootBatch));
+            }
+        }
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+
+    if (!mCancelled)
+    {
+        ++mFinished;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        --mRunning;
+    }
+}
+
+ParallelBucketApplicator::ParallelBucketApplicator(
+    Application& app, uint32_t maxProtocolVersion,
+    std::vector<std::shared_ptr<Bucket const>> const& buckets,
+    std::function<bool(LedgerEntryType)> filter, size_t partitions)
+    : mApp(app)
+    , mState(std::make_shared<State>(app, buckets, maxProtocolVersion, filter))
+{
+    releaseAssert(partitions > 0);
+    std::shared_ptr<Bucket const> largest;
+    for (auto const& b : buckets)
+    {
+        BucketInputIterator iter(b);
+        auto protocolVersion = iter.getMetadata().ledgerVersion;
+        if (protocolVersion > maxProtocolVersion)
+        {
+            throw std::runtime_error(fmt::format(
+                "bucket protocol version {} exceeds maxProtocolVersion {}",
+                protocolVersion, maxProtocolVersion));
+        }
+        mState->mTotalSize += b->getSize();
+        if (!largest || b->getSize() > largest->getSize())
+        {
+            largest = b;
+        }
+    }
+
+    if (partitions > 1)
+    {
+        if (largest && largest->getIndex())
+        {
+            mState->mPartitionKeys =
+                largest->getIndex()->getPartitionKeys(partitions);
+            mState->mPartitionCount = mState->mPartitionKeys.size() + 1;
+        }
+        else
+        {
+            mState->mHashPartitions = true;
+            mState->mPartitionCount = partitions;
+            // Every partition reads all the buckets
+            mState->mTotalSize *= partitions;
+        }
+    }
+
+    mState->mWriteOnWorkers = !app.getConfig().IN_MEMORY_LEDGER_STATE &&
+                              !app.getDatabase().isSqlite();
+}
+
+ParallelBucketApplicator::~ParallelBucketApplicator()
+{
+    cancel();
+}
+
+void
+ParallelBucketApplicator::start()
+{
+    ZoneScoped;
+    LedgerTxnRoot* root = nullptr;
+    soci::connection_pool* pool = nullptr;
+    if (mState->mWriteOnWorkers)
+    {
+        root = &dynamic_cast<LedgerTxnRoot&>(mApp.getLedgerTxnRoot());
+        // getPool creates the pool on first use, so call it here
+        pool = &mApp.getDatabase().getPool();
+    }
+
+    CLOG_INFO(Bucket,
+              "Applying {} buckets in {} partitions split by {}, writing on "
+              "{}",
+              mState->mBuckets.size(), mState->mPartitionCount,
+              mState->mHashPartitions ? "key hash" : "key range",
+              mState->mWriteOnWorkers ? "worker threads" : "the main thread");
+
+    mState->mRunning = mState->mPartitionCount;
+    for (size_t i = 0; i < mState->mPartitionCount; ++i)
+    {
+        mApp.postOnBackgroundThread(
+            [state = mState, i, root, pool]() {
+                state->applyPartition(i, root, pool);
+            },
+            "ParallelBucketApplicator");
+    }
+}
+
+void
+ParallelBucketApplicator::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mState->mMutex);
+        mState->mCancelled = true;
+    }
+    mState->mPendingCV.notify_all();
+}
+
+size_t
+ParallelBucketApplicator::applyPendingBatch()
+{
+    ZoneScoped;
+    State::Batch batch;
+    {
+        std::lock_guard<std::mutex> lock(mState->mMutex);
+        if (mState->mCancelled || mState->mPending.empty())
+        {
+            return 0;
+        }
+        batch = std::move(mState->mPending.front());
+        mState->mPending.pop_front();
+    }
+    mState->mPendingCV.notify_all();
+
+    auto timer = mState->mBatchWriteTimer.TimeScope();
+    LedgerTxn ltx(mApp.getLedgerTxnRoot(), false);
+    for (auto const& le : batch.mEntries)
+    {
+        ltx.createOrUpdateWithoutLoading(le);
+    }
+    for (auto const& key : batch.mDeletedKeys)
+    {
+        ltx.eraseWithoutLoading(key);
+    }
+    ltx.commit();
+    mState->mEntriesWrittenMeter.Mark(batch.size());
+    mState->mEntriesWritten += batch.size();
+    return batch.size();
+}
+
+bool
+ParallelBucketApplicator::isDone() const
+{
+    std::lock_guard<std::mutex> lock(mState->mMutex);
+    return mState->mRunning == 0 &&
+           (mState->mCancelled || mState->mPending.empty());
+}
+
+std::exception_ptr
+ParallelBucketApplicator::getError() const
+{
+    std::lock_guard<std::mutex> lock(mState->mMutex);
+    return mState->mError;
+}
+
+size_t
+ParallelBucketApplicator::getPartitionCount() const
+{
+    return mState->mPartitionCount;
+}
+
+size_t
+ParallelBucketApplicator::getFinishedPartitionCount() const
+{
+    return mState->mFinished;
+}
+
+uint64_t
+ParallelBucketApplicator::getEntriesRead() const
+{
+    return mState->mEntriesRead;
+}
+
+uint64_t
+ParallelBucketApplicator::getEntriesWritten() const
+{
+    return mState->mEntriesWritten;
+}
+
+uint64_t
+ParallelBucketApplicator::getBytesRead() const
+{
+    return mState->mBytesRead;
+}
+
+uint64_t
+ParallelBucketApplicator::getTotalSize() const
+{
+    return mState->mTotalSize;
+}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace stellar
+{
+
+class Application;
+class Bucket;
+
+// Applies a set of buckets to the ledger state at once, as an alternative to
+// applying them one at a time with BucketApplicator.
+//
+// The buckets are read through one merged iterator that yields each key once,
+// with its entry from the newest bucket holding it, so that every ledger entry
+// is written once no matter how many buckets hold versions of it. The key
+// space is cut into partitions that are read, deduplicated and written
+// concurrently, each by a task on a worker thread:
+//
+//   - If the largest bucket has an index, partitions are key ranges split at
+//     its page keys. As buckets are sorted by entry type first, most
+//     partitions hold entries of a single type, and each task only reads its
+//     own range of every bucket.
+//
+//   - Otherwise, partitions are the classes of key hashes modulo the number
+//     of partitions, and each task reads all the buckets.
+//
+// With a postgres database each task writes its partition in batches through
+// its own session from the connection pool. SQLite and the in-memory ledger
+// state can't take concurrent writes, so there the tasks only read and
+// deduplicate, and hand their batches over to the main thread, which applies
+// them with applyPendingBatch; so does SPEEDEX_CONFIG, which LedgerTxnRoot
+// keeps in memory.
+class ParallelBucketApplicator : public NonMovableOrCopyable
+{
+    struct State;
+
+    Application& mApp;
+    std::shared_ptr<State> mState;
+
+  public:
+    // buckets are ordered newest first.
+    ParallelBucketApplicator(
+        Application& app, uint32_t maxProtocolVersion,
+        std::vector<std::shared_ptr<Bucket const>> const& buckets,
+        std::function<bool(LedgerEntryType)> filter, size_t partitions);
+    ~ParallelBucketApplicator();
+
+    // Posts the partition tasks to worker threads.
+    void start();
+
+    // Stops the partition tasks after the batch they are writing.
+    void cancel();
+
+    // Applies one batch handed over to the main thread, if there is one, and
+    // returns the number of changes it held.
+    size_t applyPendingBatch();
+
+    // Whether all partition tasks have stopped and there's no batch left to
+    // apply on the main thread.
+    bool isDone() const;
+
+    // The first error a partition task failed with, if any.
+    std::exception_ptr getError() const;
+
+    size_t getPartitionCount() const;
+    size_t getFinishedPartitionCount() const;
+    uint64_t getEntriesRead() const;
+    uint64_t getEntriesWritten() const;
+
+    // The bytes of bucket files read so far, out of getTotalSize().
+    uint64_t getBytesRead() const;
+    uint64_t getTotalSize() const;
+};
+}
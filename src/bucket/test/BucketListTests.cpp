@@ -11,6 +11,7 @@
 // else.
 #include "util/asio.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
@@ -22,11 +23,15 @@
 #include "main/Config.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
+#include "util/Fs.h"
 #include "util/Math.h"
 #include "util/Timer.h"
+#include "util/UnorderedMap.h"
+#include "util/types.h"
 #include "xdrpp/autocheck.h"
 
 #include <deque>
+#include <optional>
 #include <sstream>
 
 using namespace stellar;
@@ -397,6 +402,119 @@ TEST_CASE("bucket tombstones mutually-annihilate init entries",
     });
 }
 
+TEST_CASE("bucket list point lookups", "[bucket][bucketlist][bucketindex]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    SECTION("with bucket indexes")
+    {
+        // small pages, so that buckets have many of them
+        cfg.BUCKET_INDEX_PAGE_SIZE = 256;
+    }
+    SECTION("without bucket indexes")
+    {
+        cfg.BUCKET_INDEX_PAGE_SIZE = 0;
+    }
+    Application::pointer app = createTestApplication(clock, cfg);
+    BucketList bl;
+
+    // the expected state: nullopt for deleted entries
+    UnorderedMap<LedgerKey, std::optional<LedgerEntry>> state;
+    std::vector<LedgerKey> created;
+    for (uint32_t i = 1; i < 130; ++i)
+    {
+        app->getClock().crank(false);
+        std::vector<LedgerEntry> init, live;
+        std::vector<LedgerKey> dead;
+        UnorderedSet<LedgerKey> batchKeys;
+
+        // update an entry and delete another, both from earlier ledgers
+        for (size_t j = 0; j < 2 && !created.empty(); ++j)
+        {
+            auto const& key = rand_element(created);
+            auto& entry = state.at(key);
+            if (!entry || !batchKeys.emplace(key).second)
+            {
+                continue;
+            }
+            if (j == 0)
+            {
+                entry->lastModifiedLedgerSeq = i;
+                live.emplace_back(*entry);
+            }
+            else
+            {
+                entry.reset();
+                dead.emplace_back(key);
+            }
+        }
+
+        for (auto& entry : LedgerTestUtils::generateValidLedgerEntries(8))
+        {
+            auto key = LedgerEntryKey(entry);
+            if (state.emplace(key, entry).second)
+            {
+                created.emplace_back(key);
+                init.emplace_back(entry);
+            }
+        }
+        bl.addBatch(*app, i, getAppLedgerVersion(app), init, live, dead);
+    }
+
+    UnorderedSet<LedgerKey> keys(created.begin(), created.end());
+    for (auto const& key :
+         LedgerTestUtils::generateValidLedgerKeysNoSpeedexConfig(10))
+    {
+        if (state.find(key) == state.end())
+        {
+            keys.emplace(key);
+        }
+    }
+
+    auto entries = bl.loadKeys(keys);
+    size_t nLive = 0;
+    for (auto const& kv : state)
+    {
+        nLive += kv.second ? 1 : 0;
+    }
+    REQUIRE(entries.size() == nLive);
+    for (auto const& entry : entries)
+    {
+        auto it = state.find(LedgerEntryKey(entry));
+        REQUIRE(it != state.end());
+        REQUIRE(it->second);
+        REQUIRE(*it->second == entry);
+    }
+
+    for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
+    {
+        auto const& lev = bl.getLevel(i);
+        for (auto const& b : {lev.getCurr(), lev.getSnap()})
+        {
+            if (b->getFilename().empty())
+            {
+                continue;
+            }
+            auto index = b->getIndex();
+            auto indexFile = BucketIndex::indexFilename(b->getFilename());
+            if (cfg.BUCKET_INDEX_PAGE_SIZE == 0)
+            {
+                REQUIRE(!index);
+                REQUIRE(!fs::exists(indexFile));
+            }
+            else
+            {
+                REQUIRE(index);
+                auto loaded = BucketIndex::load(indexFile, b->getHash(),
+                                                cfg.BUCKET_INDEX_PAGE_SIZE);
+                REQUIRE(loaded);
+                REQUIRE(loaded->getPageCount() == index->getPageCount());
+                REQUIRE(!BucketIndex::load(indexFile, b->getHash(), 512));
+            }
+        }
+    }
+}
+
 TEST_CASE("single entry bubbling up", "[bucket][bucketlist][bucketbubble]")
 {
     VirtualClock clock;
@@ -13,6 +13,7 @@
 #include "util/asio.h"
 #include "bucket/BucketTests.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketOutputIterator.h"
@@ -26,6 +27,9 @@
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/Timer.h"
+#include "util/UnorderedSet.h"
+#include "util/XDRStream.h"
+#include "util/types.h"
 
 using namespace stellar;
 
@@ -953,6 +957,175 @@ TEST_CASE("merging bucket entries with initentry with shadows",
     });
 }
 
+TEST_CASE("partitioned merges match serial merges", "[bucket][bucketindex]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0));
+    cfg.BUCKET_INDEX_PAGE_SIZE = 256;
+    cfg.BUCKET_MERGE_PARTITION_SIZE = 1024;
+    cfg.WORKER_THREADS = 4;
+    Application::pointer app = createTestApplication(clock, cfg);
+    Application::pointer serialApp =
+        createTestApplication(clock, getTestConfig(1));
+
+    bool keepDeadEntries = true;
+    SECTION("keeping dead entries")
+    {
+        keepDeadEntries = true;
+    }
+    SECTION("dropping dead entries")
+    {
+        keepDeadEntries = false;
+    }
+
+    // old holds 200 entries, new updates some, deletes some and adds others
+    UnorderedSet<LedgerKey> keys;
+    std::vector<LedgerEntry> oldLive, newInit, newLive;
+    std::vector<LedgerKey> newDead;
+    for (auto const& e : LedgerTestUtils::generateValidLedgerEntries(300))
+    {
+        if (!keys.emplace(LedgerEntryKey(e)).second)
+        {
+            continue;
+        }
+        if (oldLive.size() < 200)
+        {
+            oldLive.emplace_back(e);
+        }
+        else
+        {
+            newInit.emplace_back(e);
+        }
+    }
+    for (size_t i = 0; i + 1 < oldLive.size(); i += 3)
+    {
+        auto e = oldLive[i];
+        e.lastModifiedLedgerSeq++;
+        newLive.emplace_back(e);
+        newDead.emplace_back(LedgerEntryKey(oldLive[i + 1]));
+    }
+
+    auto merge = [&](Application& a) {
+        auto& bm = a.getBucketManager();
+        auto vers = getAppLedgerVersion(a);
+        auto oldBucket = Bucket::fresh(bm, vers, {}, oldLive, {},
+                                       /*countMergeEvents=*/true,
+                                       clock.getIOContext(), /*doFsync=*/true);
+        auto newBucket = Bucket::fresh(bm, vers, newInit, newLive, newDead,
+                                       /*countMergeEvents=*/true,
+                                       clock.getIOContext(), /*doFsync=*/true);
+        return Bucket::merge(bm, vers, oldBucket, newBucket, /*shadows=*/{},
+                             keepDeadEntries, /*countMergeEvents=*/true,
+                             clock.getIOContext(), /*doFsync=*/true);
+    };
+
+    auto& bm = app->getBucketManager();
+    REQUIRE(bm.getMergePartitionCount(16 * 1024) > 1);
+    REQUIRE(serialApp->getBucketManager().getMergePartitionCount(16 * 1024) ==
+            1);
+
+    auto partitioned = merge(*app);
+    auto serial = merge(*serialApp);
+    REQUIRE(partitioned->getHash() == serial->getHash());
+    REQUIRE(partitioned->getSize() == serial->getSize());
+    REQUIRE(fs::exists(partitioned->getFilename()));
+    REQUIRE(partitioned->getIndex());
+    REQUIRE(partitioned->getIndex()->getPageCount() > 1);
+
+    EntryCounts e(partitioned);
+    CHECK(e.nLive + e.nInit ==
+          oldLive.size() + newInit.size() - newDead.size());
+    CHECK(e.nDead == (keepDeadEntries ? newDead.size() : 0));
+}
+
+TEST_CASE("block file buckets match plain buckets", "[bucket][bucketindex]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0));
+    cfg.BUCKET_FILE_BLOCK_SIZE = 512;
+    cfg.BUCKET_INDEX_PAGE_SIZE = 256;
+    SECTION("serial merges")
+    {
+    }
+    SECTION("partitioned merges")
+    {
+        cfg.BUCKET_MERGE_PARTITION_SIZE = 1024;
+        cfg.WORKER_THREADS = 4;
+    }
+    Application::pointer app = createTestApplication(clock, cfg);
+    Config plainCfg(getTestConfig(1));
+    plainCfg.BUCKET_INDEX_PAGE_SIZE = 256;
+    Application::pointer plainApp = createTestApplication(clock, plainCfg);
+
+    std::vector<LedgerEntry> oldLive, newLive;
+    std::vector<LedgerKey> newDead;
+    UnorderedSet<LedgerKey> keys;
+    for (auto const& e : LedgerTestUtils::generateValidLedgerEntries(300))
+    {
+        if (keys.emplace(LedgerEntryKey(e)).second)
+        {
+            oldLive.emplace_back(e);
+        }
+    }
+    for (size_t i = 0; i + 1 < oldLive.size(); i += 3)
+    {
+        auto e = oldLive[i];
+        e.lastModifiedLedgerSeq++;
+        newLive.emplace_back(e);
+        newDead.emplace_back(LedgerEntryKey(oldLive[i + 1]));
+    }
+
+    auto merge = [&](Application& a) {
+        auto& bm = a.getBucketManager();
+        auto vers = getAppLedgerVersion(a);
+        auto oldBucket = Bucket::fresh(bm, vers, {}, oldLive, {},
+                                       /*countMergeEvents=*/true,
+                                       clock.getIOContext(), /*doFsync=*/true);
+        auto newBucket = Bucket::fresh(bm, vers, {}, newLive, newDead,
+                                       /*countMergeEvents=*/true,
+                                       clock.getIOContext(), /*doFsync=*/true);
+        return Bucket::merge(bm, vers, oldBucket, newBucket, /*shadows=*/{},
+                             /*keepDeadEntries=*/true,
+                             /*countMergeEvents=*/true, clock.getIOContext(),
+                             /*doFsync=*/true);
+    };
+
+    auto blocks = merge(*app);
+    auto plain = merge(*plainApp);
+    REQUIRE(blocks->getHash() == plain->getHash());
+    REQUIRE(blocks->getSize() == plain->getSize());
+    REQUIRE(blocks->getSize() == fs::size(plain->getFilename()));
+    REQUIRE(fs::size(blocks->getFilename()) < plain->getSize());
+    {
+        XDRInputMappedFileStream in;
+        in.open(blocks->getFilename());
+        REQUIRE(in.isBlockFile());
+    }
+
+    // Both buckets read the same, by scan and by index lookups
+    BucketInputIterator bi(blocks);
+    BucketInputIterator pi(plain);
+    for (; bi && pi; ++bi, ++pi)
+    {
+        REQUIRE(*bi == *pi);
+        REQUIRE(bi.pos() == pi.pos());
+    }
+    REQUIRE(!bi);
+    REQUIRE(!pi);
+
+    std::set<LedgerKey, LedgerEntryIdCmp> blockKeys, plainKeys;
+    for (auto const& e : oldLive)
+    {
+        blockKeys.emplace(LedgerEntryKey(e));
+        plainKeys.emplace(LedgerEntryKey(e));
+    }
+    std::vector<LedgerEntry> blockEntries, plainEntries;
+    blocks->loadKeys(blockKeys, blockEntries);
+    plain->loadKeys(plainKeys, plainEntries);
+    REQUIRE(blockEntries == plainEntries);
+    REQUIRE(blockEntries.size() == oldLive.size() - newDead.size());
+}
+
 TEST_CASE("bucket apply", "[bucket]")
 {
     VirtualClock clock;
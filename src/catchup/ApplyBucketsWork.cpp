@@ -7,6 +7,7 @@
 #include "bucket/BucketApplicator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
+#include "bucket/ParallelBucketApplicator.h"
 #include "catchup/CatchupManager.h"
 #include "crypto/Hex.h"
 #include "crypto/SecretKey.h"
@@ -15,9 +16,11 @@
 #include "invariant/InvariantManager.h"
 #include "ledger/LedgerTxn.h"
 #include "main/Application.h"
+#include "main/Config.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include <Tracy.hpp>
+#include <algorithm>
 #include <fmt/format.h>
 #include <medida/meter.h>
 #include <medida/metrics_registry.h>
@@ -57,6 +60,10 @@ ApplyBucketsWork::ApplyBucketsWork(
 {
 }
 
+ApplyBucketsWork::~ApplyBucketsWork()
+{
+}
+
 BucketLevel&
 ApplyBucketsWork::getBucketLevel(uint32_t level)
 {
@@ -128,6 +135,8 @@ ApplyBucketsWork::onReset()
     mCurrBucket.reset();
     mSnapApplicator.reset();
     mCurrApplicator.reset();
+    mParallelApplicator.reset();
+    mNewestBucket.reset();
 }
 
 void
@@ -170,6 +179,11 @@ ApplyBucketsWork::onRun()
 {
     ZoneScoped;
 
+    if (mApp.getConfig().BUCKET_APPLY_PARTITIONS > 0)
+    {
+        return runParallel();
+    }
+
     // Check if we're at the beginning of the new level
     if (isLevelComplete())
     {
@@ -224,6 +238,127 @@ ApplyBucketsWork::onRun()
     return State::WORK_SUCCESS;
 }
 
+void
+ApplyBucketsWork::startParallel()
+{
+    ZoneScoped;
+    // As in startLevel, the deepest buckets that the bucket list already
+    // holds are skipped, and all the buckets from the first one it doesn't
+    // hold up are applied.
+    std::vector<std::shared_ptr<Bucket const>> buckets;
+    bool applying = false;
+    for (uint32_t i = BucketList::kNumLevels; i-- > 0;)
+    {
+        auto& level = getBucketLevel(i);
+        HistoryStateBucket const& hsb = mApplyState.currentBuckets.at(i);
+        if (applying || hsb.snap != binToHex(level.getSnap()->getHash()))
+        {
+            buckets.emplace_back(getBucket(hsb.snap));
+            mNewestLevel = i;
+            mNewestIsCurr = false;
+            applying = true;
+        }
+        if (applying || hsb.curr != binToHex(level.getCurr()->getHash()))
+        {
+            buckets.emplace_back(getBucket(hsb.curr));
+            mNewestLevel = i;
+            mNewestIsCurr = true;
+            applying = true;
+        }
+    }
+    // ParallelBucketApplicator takes the newest bucket first
+    std::reverse(buckets.begin(), buckets.end());
+    mNewestBucket = buckets.empty() ? nullptr : buckets.front();
+
+    mParallelApplicator = std::make_unique<ParallelBucketApplicator>(
+        mApp, mMaxProtocolVersion, buckets, mEntryTypeFilter,
+        mApp.getConfig().BUCKET_APPLY_PARTITIONS);
+    mTotalBuckets = buckets.size();
+    mTotalSize = std::max<size_t>(mParallelApplicator->getTotalSize(), 1);
+    mBucketApplyStart.Mark(buckets.size());
+    mParallelStarted = mApp.getClock().now();
+    mParallelApplicator->start();
+}
+
+BasicWork::State
+ApplyBucketsWork::runParallel()
+{
+    ZoneScoped;
+    if (!mParallelApplicator)
+    {
+        startParallel();
+    }
+    auto& applicator = *mParallelApplicator;
+    auto applied = applicator.applyPendingBatch();
+    bool done = applied == 0 && applicator.isDone();
+
+    mAppliedEntries = applicator.getEntriesWritten();
+    mAppliedSize = std::min<size_t>(applicator.getBytesRead(), mTotalSize);
+    auto appliedSizeMb = mAppliedSize / 1024 / 1024;
+    if (appliedSizeMb > mLastAppliedSizeMb || done)
+    {
+        mLastAppliedSizeMb = appliedSizeMb;
+        auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+                         mApp.getClock().now() - mParallelStarted)
+                         .count() +
+                     1;
+        CLOG_INFO(Bucket,
+                  "Bucket-apply: {} entries written ({}/s), {} read ({}/s), "
+                  "in {}/{} ({}%), {}/{} partitions done",
+                  mAppliedEntries, mAppliedEntries * 1000000 / usecs,
+                  applicator.getEntriesRead(),
+                  applicator.getEntriesRead() * 1000000 / usecs,
+                  formatSize(mAppliedSize), formatSize(mTotalSize),
+                  (100 * mAppliedSize / mTotalSize),
+                  applicator.getFinishedPartitionCount(),
+                  applicator.getPartitionCount());
+    }
+
+    if (applied > 0)
+    {
+        return State::WORK_RUNNING;
+    }
+    if (!done)
+    {
+        setupWaitingCallback(std::chrono::milliseconds(100));
+        return State::WORK_WAITING;
+    }
+
+    if (auto error = applicator.getError())
+    {
+        try
+        {
+            std::rethrow_exception(error);
+        }
+        catch (std::exception const& e)
+        {
+            CLOG_ERROR(History, "ApplyBuckets : failed: {}", e.what());
+        }
+        return State::WORK_FAILURE;
+    }
+
+    // The partitions may have been written behind the root's caches
+    if (auto root = dynamic_cast<LedgerTxnRoot*>(&mApp.getLedgerTxnRoot()))
+    {
+        root->clearAllCaches();
+    }
+    if (mNewestBucket)
+    {
+        mApp.getInvariantManager().checkOnBucketApply(
+            mNewestBucket, mApplyState.currentLedger, mNewestLevel,
+            mNewestIsCurr, mEntryTypeFilter);
+    }
+    mAppliedBuckets = mTotalBuckets;
+    mBucketApplySuccess.Mark(mTotalBuckets);
+    mParallelApplicator.reset();
+    mNewestBucket.reset();
+
+    CLOG_INFO(History, "ApplyBuckets : done, restarting merges");
+    mApp.getBucketManager().assumeState(mApplyState, mMaxProtocolVersion);
+
+    return State::WORK_SUCCESS;
+}
+
 void
 ApplyBucketsWork::advance(std::string const& bucketName,
                           BucketApplicator& applicator)
@@ -273,6 +408,18 @@ ApplyBucketsWork::isLevelComplete()
     return !(mApplying) || !(mSnapApplicator || mCurrApplicator);
 }
 
+bool
+ApplyBucketsWork::onAbort()
+{
+    if (mParallelApplicator)
+    {
+        // The partition tasks stop after the batch they are writing
+        mParallelApplicator->cancel();
+        return mParallelApplicator->isDone();
+    }
+    return true;
+}
+
 void
 ApplyBucketsWork::onFailureRaise()
 {
@@ -18,6 +18,7 @@ namespace stellar
 class BucketLevel;
 class BucketList;
 class Bucket;
+class ParallelBucketApplicator;
 struct HistoryArchiveState;
 struct LedgerHeaderHistoryEntry;
 
@@ -42,6 +43,15 @@ class ApplyBucketsWork : public BasicWork
     std::unique_ptr<BucketApplicator> mSnapApplicator;
     std::unique_ptr<BucketApplicator> mCurrApplicator;
 
+    // Used instead of the applicators above with BUCKET_APPLY_PARTITIONS;
+    // the newest bucket it applies is checked against the database once all
+    // the buckets are applied, as the older ones may be shadowed.
+    std::unique_ptr<ParallelBucketApplicator> mParallelApplicator;
+    std::shared_ptr<Bucket const> mNewestBucket;
+    uint32_t mNewestLevel{0};
+    bool mNewestIsCurr{false};
+    VirtualClock::time_point mParallelStarted;
+
     medida::Meter& mBucketApplyStart;
     medida::Meter& mBucketApplySuccess;
     medida::Meter& mBucketApplyFailure;
@@ -52,6 +62,8 @@ class ApplyBucketsWork : public BasicWork
     BucketLevel& getBucketLevel(uint32_t level);
     void startLevel();
     bool isLevelComplete();
+    void startParallel();
+    BasicWork::State runParallel();
 
   public:
     ApplyBucketsWork(
@@ -63,18 +75,14 @@ class ApplyBucketsWork : public BasicWork
         std::map<std::string, std::shared_ptr<Bucket>> const& buckets,
         HistoryArchiveState const& applyState, uint32_t maxProtocolVersion,
         std::function<bool(LedgerEntryType)> onlyApply);
-    ~ApplyBucketsWork() = default;
+    ~ApplyBucketsWork();
 
     std::string getStatus() const override;
 
   protected:
     void onReset() override;
     BasicWork::State onRun() override;
-    bool
-    onAbort() override
-    {
-        return true;
-    };
+    bool onAbort() override;
     void onFailureRaise() override;
     void onFailureRetry() override;
 };
@@ -8,6 +8,7 @@
 #include "util/asio.h"
 #include "catchup/CatchupManagerImpl.h"
 #include "catchup/CatchupConfiguration.h"
+#include "herder/TxSetFrame.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "medida/meter.h"
@@ -382,6 +383,20 @@ CatchupManagerImpl::tryApplySyncingLedgers()
             break;
         }
 
+        // prefetch for the next buffered ledger while this one applies
+        auto next = std::next(it);
+        if (next != mSyncingLedgers.cend() &&
+            next->first == lcd.getLedgerSeq() + 1)
+        {
+            auto nextTxSet =
+                std::dynamic_pointer_cast<TxSetFrame>(next->second.getTxSet());
+            if (nextTxSet)
+            {
+                mApp.getLedgerManager().prefetchTxSet(
+                    next->second.getValue().txSetHash, *nextTxSet);
+            }
+        }
+
         mApp.getLedgerManager().closeLedger(lcd);
         CLOG_INFO(History, "Closed buffered ledger: {}",
                   LedgerManager::ledgerAbbrev(ledgerHeader));
@@ -86,6 +86,47 @@ hmacSha256(HmacSha256Key const& key, ByteSlice const& bin)
     return out;
 }
 
+HmacSha256::HmacSha256(HmacSha256Key const& key)
+{
+    if (crypto_auth_hmacsha256_init(&mState, key.key.data(),
+                                    key.key.size()) != 0)
+    {
+        throw CryptoError("error from crypto_auth_hmacsha256_init");
+    }
+}
+
+void
+HmacSha256::add(ByteSlice const& bin)
+{
+    ZoneScoped;
+    if (mFinished)
+    {
+        throw std::runtime_error("adding bytes to finished HmacSha256");
+    }
+    if (crypto_auth_hmacsha256_update(&mState, bin.data(), bin.size()) != 0)
+    {
+        throw CryptoError("error from crypto_auth_hmacsha256_update");
+    }
+}
+
+HmacSha256Mac
+HmacSha256::finish()
+{
+    HmacSha256Mac out;
+    static_assert(sizeof(out.mac) == crypto_auth_hmacsha256_BYTES,
+                  "unexpected crypto_auth_hmacsha256_BYTES");
+    if (mFinished)
+    {
+        throw std::runtime_error("finishing already-finished HmacSha256");
+    }
+    if (crypto_auth_hmacsha256_final(&mState, out.mac.data()) != 0)
+    {
+        throw CryptoError("error from crypto_auth_hmacsha256_final");
+    }
+    mFinished = true;
+    return out;
+}
+
 bool
 hmacSha256Verify(HmacSha256Mac const& hmac, HmacSha256Key const& key,
                  ByteSlice const& bin)
@@ -6,6 +6,7 @@
 
 #include "crypto/ByteSlice.h"
 #include "crypto/XDRHasher.h"
+#include "sodium/crypto_auth_hmacsha256.h"
 #include "sodium/crypto_hash_sha256.h"
 #include "xdr/Stellar-types.h"
 #include <memory>
@@ -59,6 +60,18 @@ xdrSha256(T const& t)
 // HMAC-SHA256 (keyed)
 HmacSha256Mac hmacSha256(HmacSha256Key const& key, ByteSlice const& bin);
 
+// HMAC-SHA256 in incremental mode, for inputs held in several pieces.
+class HmacSha256
+{
+    crypto_auth_hmacsha256_state mState;
+    bool mFinished{false};
+
+  public:
+    explicit HmacSha256(HmacSha256Key const& key);
+    void add(ByteSlice const& bin);
+    HmacSha256Mac finish();
+};
+
 // Use this rather than HMAC-output ==, to avoid timing leaks.
 bool hmacSha256Verify(HmacSha256Mac const& hmac, HmacSha256Key const& key,
                       ByteSlice const& bin);
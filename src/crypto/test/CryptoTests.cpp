@@ -254,6 +254,22 @@ TEST_CASE("HMAC test vector", "[crypto]")
     REQUIRE(hmacSha256Verify(v, k, s));
 }
 
+TEST_CASE("Stateful HMAC is identical to one-shot HMAC", "[crypto]")
+{
+    HmacSha256Key k;
+    k.key[0] = 'k';
+    k.key[1] = 'e';
+    k.key[2] = 'y';
+    std::string s = "The quick brown fox jumps over the lazy dog";
+    HmacSha256 h(k);
+    h.add(ByteSlice(s.data(), 10));
+    h.add(ByteSlice(s.data() + 10, 0));
+    h.add(ByteSlice(s.data() + 10, s.size() - 10));
+    auto v = h.finish();
+    REQUIRE(v.mac == hmacSha256(k, s).mac);
+    REQUIRE_THROWS(h.finish());
+}
+
 TEST_CASE("HKDF test vector", "[crypto]")
 {
     auto ikm = hexToBin("0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b");
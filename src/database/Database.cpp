@@ -288,7 +288,10 @@ Database::getAppSchemaVersion()
 medida::TimerContext
 Database::getInsertTimer(std::string const& entityName)
 {
-    mEntityTypes.insert(entityName);
+    {
+        std::lock_guard<std::mutex> lock(mEntityTypesMutex);
+        mEntityTypes.insert(entityName);
+    }
     mQueryMeter.Mark();
     return mApp.getMetrics()
         .NewTimer({"database", "insert", entityName})
@@ -298,7 +301,10 @@ Database::getInsertTimer(std::string const& entityName)
 medida::TimerContext
 Database::getSelectTimer(std::string const& entityName)
 {
-    mEntityTypes.insert(entityName);
+    {
+        std::lock_guard<std::mutex> lock(mEntityTypesMutex);
+        mEntityTypes.insert(entityName);
+    }
     mQueryMeter.Mark();
     return mApp.getMetrics()
         .NewTimer({"database", "select", entityName})
@@ -308,7 +314,10 @@ Database::getSelectTimer(std::string const& entityName)
 medida::TimerContext
 Database::getDeleteTimer(std::string const& entityName)
 {
-    mEntityTypes.insert(entityName);
+    {
+        std::lock_guard<std::mutex> lock(mEntityTypesMutex);
+        mEntityTypes.insert(entityName);
+    }
     mQueryMeter.Mark();
     return mApp.getMetrics()
         .NewTimer({"database", "delete", entityName})
@@ -318,7 +327,10 @@ Database::getDeleteTimer(std::string const& entityName)
 medida::TimerContext
 Database::getUpdateTimer(std::string const& entityName)
 {
-    mEntityTypes.insert(entityName);
+    {
+        std::lock_guard<std::mutex> lock(mEntityTypesMutex);
+        mEntityTypes.insert(entityName);
+    }
     mQueryMeter.Mark();
     return mApp.getMetrics()
         .NewTimer({"database", "update", entityName})
@@ -328,7 +340,10 @@ Database::getUpdateTimer(std::string const& entityName)
 medida::TimerContext
 Database::getUpsertTimer(std::string const& entityName)
 {
-    mEntityTypes.insert(entityName);
+    {
+        std::lock_guard<std::mutex> lock(mEntityTypesMutex);
+        mEntityTypes.insert(entityName);
+    }
     mQueryMeter.Mark();
     return mApp.getMetrics()
         .NewTimer({"database", "upsert", entityName})
@@ -506,6 +521,21 @@ Database::getPreparedStatement(std::string const& query)
     return sc;
 }
 
+StatementContext
+Database::getPreparedStatement(std::string const& query,
+                               soci::session& session)
+{
+    if (&session == &mSession)
+    {
+        return getPreparedStatement(query);
+    }
+    auto p = std::make_shared<soci::statement>(session);
+    p->alloc();
+    p->prepare(query);
+    StatementContext sc(p);
+    return sc;
+}
+
 std::shared_ptr<SQLLogContext>
 Database::captureAndLogSQL(std::string contextName)
 {
@@ -11,6 +11,7 @@
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
 #include <functional>
+#include <mutex>
 #include <set>
 #include <soci.h>
 #include <string>
@@ -95,6 +96,8 @@ class Database : NonMovableOrCopyable
     medida::Counter& mStatementsSize;
 
     std::set<std::string> mEntityTypes;
+    // the timers below may be acquired from worker threads
+    std::mutex mEntityTypesMutex;
 
     static bool gDriversRegistered;
     static void registerDrivers();
@@ -120,6 +123,12 @@ class Database : NonMovableOrCopyable
     // when the statement context is destroyed.
     StatementContext getPreparedStatement(std::string const& query);
 
+    // As above, but for a statement on `session`. Statements on sessions other
+    // than the main connection are prepared afresh and not cached, so this may
+    // be called from worker threads with their own sessions.
+    StatementContext getPreparedStatement(std::string const& query,
+                                          soci::session& session);
+
     // Purge all cached prepared statements, closing their handles with the
     // database.
     void clearPreparedStatementCache();
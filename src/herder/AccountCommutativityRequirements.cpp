@@ -179,7 +179,6 @@ bool
 AccountCommutativityRequirements::checkAccountHasSufficientBalance(AbstractLedgerTxn& ltx, LedgerTxnHeader& header) {
 	if (mCacheValid)
 	{
-		std::printf("result cached: %d\n", mCheckAccountResult);
 		return mCheckAccountResult;
 	}
 
@@ -196,11 +195,6 @@ AccountCommutativityRequirements::checkAccountHasSufficientBalance(AbstractLedge
 			setCachedAccountHasSufficientBalanceCheck(false);
 			return false;
 		}
-		std::printf("Asset: %s Requirement: %ld Current Balance %ld\n", 
-			assetToString(asset).c_str(), 
-			*amount, 
-			getAvailableBalance(header, ltx, mSourceAccount, asset));
-
 		if (*amount > getAvailableBalance(header, ltx, mSourceAccount, asset)) {
 			setCachedAccountHasSufficientBalanceCheck(false);
 			return false;
@@ -210,4 +204,21 @@ AccountCommutativityRequirements::checkAccountHasSufficientBalance(AbstractLedge
 	return true;
 }
 
+bool
+AccountCommutativityRequirements::checkDependsOn(UnorderedSet<AccountID> const& accounts) const
+{
+	if (accounts.count(mSourceAccount) != 0)
+	{
+		return true;
+	}
+	for (auto const& [asset, _] : mRequiredAssets)
+	{
+		if (asset.type() != ASSET_TYPE_NATIVE && accounts.count(getIssuer(asset)) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 } /* stellar */
\ No newline at end of file
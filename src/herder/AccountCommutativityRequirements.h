@@ -1,6 +1,8 @@
 #pragma once
 
+#include "crypto/SecretKey.h"
 #include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-transaction.h"
 #include "xdr/Stellar-ledger-entries.h"
@@ -33,7 +35,6 @@ class AccountCommutativityRequirements {
 	bool mCacheValid = false;
 
 	void setCachedAccountHasSufficientBalanceCheck(bool res);
-	void invalidateCachedCheck();
 
 #ifdef BUILD_TESTS
 public:
@@ -75,6 +76,13 @@ public:
 
 	bool checkAccountHasSufficientBalance(AbstractLedgerTxn& ltx, LedgerTxnHeader& header);
 
+	// The cached result of checkAccountHasSufficientBalance depends on the
+	// account, its trustlines, and the issuers of the required assets.
+	// Returns true if any of those are in accounts.
+	bool checkDependsOn(UnorderedSet<AccountID> const& accounts) const;
+
+	void invalidateCachedCheck();
+
 };
 
 
@@ -20,6 +20,7 @@
 namespace stellar
 {
 class Application;
+class ForkJoinPool;
 class XDROutputFileStream;
 
 /*
@@ -179,5 +180,9 @@ class Herder
                                                     bool fullKeys) = 0;
     virtual QuorumTracker::QuorumMap const&
     getCurrentlyTrackedQuorum() const = 0;
+
+    // Threads used by TxSetFrame to validate transaction sets; null unless
+    // TX_SET_VALIDATION_THREADS > 1.
+    virtual ForkJoinPool* getTxSetValidationWorkers() = 0;
 };
 }
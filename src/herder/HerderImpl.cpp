@@ -91,6 +91,11 @@ HerderImpl::HerderImpl(Application& app)
     auto ln = getSCP().getLocalNode();
     mPendingEnvelopes.addSCPQuorumSet(ln->getQuorumSetHash(),
                                       ln->getQuorumSet());
+    if (app.getConfig().TX_SET_VALIDATION_THREADS > 1)
+    {
+        mTxSetValidationWorkers = std::make_unique<ForkJoinPool>(
+            app.getConfig().TX_SET_VALIDATION_THREADS);
+    }
 }
 
 HerderImpl::~HerderImpl()
@@ -1084,8 +1089,9 @@ HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
     upperBoundCloseTimeOffset = nextCloseTime - lcl.header.scpValue.closeTime;
     lowerBoundCloseTimeOffset = upperBoundCloseTimeOffset;
 
-    auto removed = proposedSet->trimInvalid(mApp, lowerBoundCloseTimeOffset,
-                                            upperBoundCloseTimeOffset);
+    auto removed = proposedSet->trimInvalid(
+        mApp, lowerBoundCloseTimeOffset, upperBoundCloseTimeOffset,
+        mTransactionQueue.getCommutativityRequirements(*proposedSet));
     mTransactionQueue.ban(removed);
 
     proposedSet->surgePricingFilter(mApp);
@@ -1116,6 +1122,8 @@ HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
         return;
     }
 
+    mLedgerManager.prefetchTxSet(txSetHash, *proposedSet);
+
     auto newUpgrades = emptyUpgradeSteps;
 
     // see if we need to include some upgrades
@@ -1445,6 +1453,12 @@ HerderImpl::getCurrentlyTrackedQuorum() const
     return mPendingEnvelopes.getCurrentlyTrackedQuorum();
 }
 
+ForkJoinPool*
+HerderImpl::getTxSetValidationWorkers()
+{
+    return mTxSetValidationWorkers.get();
+}
+
 static Hash
 getQmapHash(QuorumTracker::QuorumMap const& qmap)
 {
@@ -1766,6 +1780,12 @@ HerderImpl::updateTransactionQueue(
     std::vector<TransactionFrameBasePtr> const& applied)
 {
     ZoneScoped;
+    // only balance checks that depend on what the last ledger changed need
+    // to be redone
+    mTransactionQueue.invalidateCommutativityChecks(
+        mLedgerManager.getLastClosedLedgerHeader().header,
+        mLedgerManager.getLastClosedLedgerChangedAccounts());
+
     // remove all these tx from mTransactionQueue
     mTransactionQueue.removeApplied(applied);
     mTransactionQueue.shift();
@@ -1779,7 +1799,8 @@ HerderImpl::updateTransactionQueue(
 
     auto removed = txSet->trimInvalid(
         mApp, 0,
-        getUpperBoundCloseTimeOffset(mApp, lhhe.header.scpValue.closeTime));
+        getUpperBoundCloseTimeOffset(mApp, lhhe.header.scpValue.closeTime),
+        mTransactionQueue.getCommutativityRequirements(*txSet));
     mTransactionQueue.ban(removed);
 
     mTransactionQueue.rebroadcast();
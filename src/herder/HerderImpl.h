@@ -9,6 +9,7 @@
 #include "herder/PendingEnvelopes.h"
 #include "herder/TransactionQueue.h"
 #include "herder/Upgrades.h"
+#include "util/ForkJoinPool.h"
 #include "util/Timer.h"
 #include "util/UnorderedMap.h"
 #include "util/XDROperators.h"
@@ -141,6 +142,8 @@ class HerderImpl : public Herder
                                                     bool fullKeys) override;
     QuorumTracker::QuorumMap const& getCurrentlyTrackedQuorum() const override;
 
+    ForkJoinPool* getTxSetValidationWorkers() override;
+
     virtual StellarValue
     makeStellarValue(Hash const& txSetHash, uint64_t closeTime,
                      xdr::xvector<UpgradeType, 6> const& upgrades,
@@ -190,6 +193,9 @@ class HerderImpl : public Herder
 
     PendingEnvelopes mPendingEnvelopes;
     Upgrades mUpgrades;
+
+    // null unless TX_SET_VALIDATION_THREADS > 1
+    std::unique_ptr<ForkJoinPool> mTxSetValidationWorkers;
     HerderSCPDriver mHerderSCPDriver;
 
     void herderOutOfSync();
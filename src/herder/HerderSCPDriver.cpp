@@ -667,6 +667,9 @@ HerderSCPDriver::combineCandidates(uint64_t slotIndex,
                 "No highest candidate transaction set found");
         }
         comp = *highest;
+
+        // the composite value is the likeliest to be externalized
+        mLedgerManager.prefetchTxSet(highest->txSetHash, *highestTxSet);
     }
     comp.upgrades.clear();
     for (auto const& upgrade : upgrades)
@@ -0,0 +1,267 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/ParallelTxSetValidator.h"
+#include "crypto/SecretKey.h"
+#include "herder/AccountCommutativityRequirements.h"
+#include "herder/TransactionCommutativityRequirements.h"
+#include "herder/TxSetCommutativityRequirements.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnHeader.h"
+#include "ledger/LedgerTxnShard.h"
+#include "util/ForkJoinPool.h"
+#include "util/UnorderedSet.h"
+
+#include <Tracy.hpp>
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace stellar
+{
+
+namespace
+{
+
+// One term of the sum of requirements of an account.
+struct Contribution
+{
+    AccountID mAccount;
+    Asset mAsset;
+    std::optional<int64_t> mAmount;
+};
+
+size_t
+bucketFor(AccountID const& account)
+{
+    return std::hash<AccountID>{}(account) %
+           ParallelTxSetValidator::NUM_BATCHES;
+}
+
+// the i-th of NUM_BATCHES contiguous ranges covering [0, size)
+std::pair<size_t, size_t>
+batchRange(size_t i, size_t size)
+{
+    auto const n = ParallelTxSetValidator::NUM_BATCHES;
+    return {size * i / n, size * (i + 1) / n};
+}
+}
+
+ParallelTxSetValidator::ParallelTxSetValidator(ForkJoinPool& workers)
+    : mWorkers(workers)
+{
+}
+
+std::optional<ParallelTxSetValidator::Result>
+ParallelTxSetValidator::validate(
+    std::vector<AccountTxs const*> const& queues, AbstractLedgerTxn& ltx,
+    uint64_t lowerBoundCloseTimeOffset, uint64_t upperBoundCloseTimeOffset,
+    TxSetCommutativityRequirements* knownRequirements)
+{
+    ZoneScoped;
+    size_t const numQueues = queues.size();
+
+    Result res;
+    res.mValidPrefix.assign(numQueues, 0);
+    res.mFundedPrefix.assign(numQueues, 0);
+
+    SharedLedgerTxnView view(ltx);
+    LedgerHeader const header = ltx.getHeader();
+    std::vector<std::unique_ptr<LedgerTxnShardRoot>> roots;
+    for (size_t i = 0; i < NUM_BATCHES; i++)
+    {
+        roots.push_back(std::make_unique<LedgerTxnShardRoot>(view, header));
+    }
+
+    // Returns false if some batch made a query the shard roots can't serve.
+    // Such queries may throw out of a batch, or be swallowed by the checks.
+    auto runBatches = [&](std::function<void(size_t)> const& fn) {
+        auto unsupported = [&]() {
+            for (auto const& root : roots)
+            {
+                if (root->mUnsupportedQuery)
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        try
+        {
+            mWorkers.parallelFor(NUM_BATCHES, fn);
+        }
+        catch (...)
+        {
+            if (unsupported())
+            {
+                return false;
+            }
+            throw;
+        }
+        return !unsupported();
+    };
+
+    // [batch][bucket]: the requirements, and the accounts to check, of the
+    // valid transactions of a batch of queues, in transaction set order
+    using PerBucket = std::vector<std::vector<Contribution>>;
+    using PerBucketAccounts = std::vector<std::vector<AccountID>>;
+    std::vector<PerBucket> contributions(NUM_BATCHES,
+                                         PerBucket(NUM_BATCHES));
+    std::vector<PerBucketAccounts> relevantAccounts(
+        NUM_BATCHES, PerBucketAccounts(NUM_BATCHES));
+
+    bool ok = runBatches([&](size_t batch) {
+        auto [begin, end] = batchRange(batch, numQueues);
+        if (begin == end)
+        {
+            return;
+        }
+        LedgerTxn ltxBatch(*roots[batch]);
+        auto& batchContributions = contributions[batch];
+        auto& batchAccounts = relevantAccounts[batch];
+        for (size_t q = begin; q < end; q++)
+        {
+            int64_t lastSeq = 0;
+            bool foundNoncommutative = false;
+            for (auto const& tx : *queues[q])
+            {
+                if (!tx->checkValid(ltxBatch, lastSeq,
+                                    lowerBoundCloseTimeOffset,
+                                    upperBoundCloseTimeOffset))
+                {
+                    break;
+                }
+                if (tx->isCommutativeTransaction())
+                {
+                    if (foundNoncommutative)
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    foundNoncommutative = true;
+                }
+                lastSeq = tx->getSeqNum();
+
+                auto reqs = tx->getCommutativityRequirements(ltxBatch);
+                if (!reqs)
+                {
+                    break;
+                }
+                for (auto const& [account, accountReqs] :
+                     reqs->getRequirements())
+                {
+                    for (auto const& [asset, amount] :
+                         accountReqs.getRequiredAssets())
+                    {
+                        batchContributions[bucketFor(account)].push_back(
+                            Contribution{account, asset, amount});
+                    }
+                }
+                for (auto const& account : tx->getRelevantAccounts())
+                {
+                    batchAccounts[bucketFor(account)].push_back(account);
+                }
+                res.mValidPrefix[q]++;
+            }
+        }
+    });
+    if (!ok)
+    {
+        return std::nullopt;
+    }
+
+    // As in checkOrTrim, requirements known in advance are only right if no
+    // transaction was dropped.
+    bool useKnownRequirements = knownRequirements != nullptr;
+    for (size_t q = 0; q < numQueues; q++)
+    {
+        if (res.mValidPrefix[q] != queues[q]->size())
+        {
+            useKnownRequirements = false;
+        }
+    }
+
+    std::vector<UnorderedSet<AccountID>> underfunded(NUM_BATCHES);
+    ok = runBatches([&](size_t bucket) {
+        // Reduce in batch order, so each account's requirements are summed
+        // in transaction set order, as serial validation does.
+        std::map<AccountID, AccountCommutativityRequirements> bucketReqs;
+        if (!useKnownRequirements)
+        {
+            for (auto const& batchContributions : contributions)
+            {
+                for (auto const& c : batchContributions[bucket])
+                {
+                    auto iter =
+                        bucketReqs.emplace(c.mAccount, c.mAccount).first;
+                    iter->second.addAssetRequirement(c.mAsset, c.mAmount);
+                }
+            }
+        }
+
+        UnorderedSet<AccountID> checked;
+        LedgerTxn ltxBucket(*roots[bucket]);
+        auto ltxHeader = ltxBucket.loadHeader();
+        for (auto const& batchAccounts : relevantAccounts)
+        {
+            for (auto const& account : batchAccounts[bucket])
+            {
+                if (!checked.insert(account).second)
+                {
+                    continue;
+                }
+                bool funded = true;
+                if (useKnownRequirements)
+                {
+                    funded =
+                        knownRequirements->checkAccountHasSufficientBalance(
+                            account, ltxBucket, ltxHeader);
+                }
+                else
+                {
+                    auto iter = bucketReqs.find(account);
+                    if (iter != bucketReqs.end())
+                    {
+                        funded = iter->second.checkAccountHasSufficientBalance(
+                            ltxBucket, ltxHeader);
+                    }
+                }
+                if (!funded)
+                {
+                    underfunded[bucket].insert(account);
+                }
+            }
+        }
+    });
+    if (!ok)
+    {
+        return std::nullopt;
+    }
+
+    for (size_t q = 0; q < numQueues; q++)
+    {
+        auto const& queue = *queues[q];
+        auto& funded = res.mFundedPrefix[q];
+        for (; funded < res.mValidPrefix[q]; funded++)
+        {
+            bool fundedTx = true;
+            for (auto const& account : queue[funded]->getRelevantAccounts())
+            {
+                if (underfunded[bucketFor(account)].count(account) != 0)
+                {
+                    fundedTx = false;
+                    break;
+                }
+            }
+            if (!fundedTx)
+            {
+                break;
+            }
+        }
+    }
+    return res;
+}
+}
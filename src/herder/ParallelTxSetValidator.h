@@ -0,0 +1,65 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrameBase.h"
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+class AbstractLedgerTxn;
+class ForkJoinPool;
+class TxSetCommutativityRequirements;
+
+// Runs the checks of TxSetFrame::checkOrTrim across a ForkJoinPool, with the
+// same outcome as the serial loop there.
+//
+//  - Per-transaction checks (checkValid, commutative-before-noncommutative,
+//    computing commutativity requirements) run per source account, in
+//    batches of accounts, each in its own LedgerTxn over a read-only view of
+//    ltx.
+//  - The requirements of the transactions that pass are summed per account,
+//    with accounts partitioned into buckets and each bucket reduced in
+//    transaction set order, and every account's balance is then checked
+//    within its bucket.
+//  - Which transactions to keep is decided serially from the per-account
+//    results.
+class ParallelTxSetValidator
+{
+    ForkJoinPool& mWorkers;
+
+  public:
+    static constexpr size_t NUM_BATCHES = 64;
+
+    using AccountTxs = std::deque<TransactionFrameBasePtr>;
+
+    struct Result
+    {
+        // for each queue, the number of leading transactions that pass the
+        // per-transaction checks
+        std::vector<size_t> mValidPrefix;
+        // for each queue, the number of those that also pass the balance
+        // checks
+        std::vector<size_t> mFundedPrefix;
+    };
+
+    explicit ParallelTxSetValidator(ForkJoinPool& workers);
+
+    // queues holds the transactions of each source account, in sequence
+    // number order; ltx must not have a child. knownRequirements is as in
+    // TxSetFrame::trimInvalid. Returns nullopt if the transactions made
+    // ledger queries that a read-only view can't serve, in which case the
+    // caller must validate serially.
+    std::optional<Result>
+    validate(std::vector<AccountTxs const*> const& queues,
+             AbstractLedgerTxn& ltx, uint64_t lowerBoundCloseTimeOffset,
+             uint64_t upperBoundCloseTimeOffset,
+             TxSetCommutativityRequirements* knownRequirements);
+};
+}
@@ -711,10 +711,56 @@ TransactionQueue::toTxSet(LedgerHeaderHistoryEntry const& lcl) const
     return result;
 }
 
+TxSetCommutativityRequirements*
+TransactionQueue::getCommutativityRequirements(TxSetFrame const& txSet)
+{
+    ZoneScoped;
+    auto const& lcl = mApp.getLedgerManager().getLastClosedLedgerHeader();
+    if (lcl.header.ledgerSeq != mCommutativityChecksLedger.ledgerSeq)
+    {
+        // not told what changed in between
+        mCommutativityRequirements.invalidateAllCachedChecks();
+        mCommutativityChecksLedger = lcl.header;
+    }
+
+    size_t queued = 0;
+    for (auto const& m : mAccountStates)
+    {
+        queued += m.second.mTransactions.size();
+    }
+    // txSet can only hold queued transactions, so this means it holds all of
+    // them
+    if (queued != txSet.sizeTx())
+    {
+        return nullptr;
+    }
+    return &mCommutativityRequirements;
+}
+
+void
+TransactionQueue::invalidateCommutativityChecks(
+    LedgerHeader const& lcl, UnorderedSet<AccountID> const& changed)
+{
+    ZoneScoped;
+    auto const& prev = mCommutativityChecksLedger;
+    if (lcl.ledgerSeq == prev.ledgerSeq + 1 &&
+        lcl.baseReserve == prev.baseReserve &&
+        lcl.ledgerVersion == prev.ledgerVersion)
+    {
+        mCommutativityRequirements.invalidateCachedChecks(changed);
+    }
+    else if (lcl.ledgerSeq != prev.ledgerSeq)
+    {
+        mCommutativityRequirements.invalidateAllCachedChecks();
+    }
+    mCommutativityChecksLedger = lcl;
+}
+
 void
 TransactionQueue::clearAll()
 {
     mAccountStates.clear();
+    mCommutativityRequirements = TxSetCommutativityRequirements();
     for (auto& b : mBannedTransactions)
     {
         b.clear();
@@ -143,6 +143,24 @@ class TransactionQueue
     std::shared_ptr<TxSetFrame>
     toTxSet(LedgerHeaderHistoryEntry const& lcl) const;
 
+    /**
+     * Returns the commutativity requirements of the queued transactions, for
+     * TxSetFrame::trimInvalid, if txSet holds every queued transaction (as it
+     * does when built by toTxSet and no transaction was skipped); nullptr
+     * otherwise.
+     */
+    TxSetCommutativityRequirements*
+    getCommutativityRequirements(TxSetFrame const& txSet);
+
+    /**
+     * Called once lcl has closed, with the accounts whose account or
+     * trustline entries it changed. Only the cached balance checks depending
+     * on those accounts are dropped, unless lcl does not directly follow the
+     * last ledger seen here or changed the reserve or protocol version.
+     */
+    void invalidateCommutativityChecks(LedgerHeader const& lcl,
+                                       UnorderedSet<AccountID> const& changed);
+
     struct ReplacedTransaction
     {
         TransactionFrameBasePtr mOld;
@@ -176,6 +194,9 @@ class TransactionQueue
 
     AccountStates mAccountStates;
     TxSetCommutativityRequirements mCommutativityRequirements;
+    // the ledger the cached checks in mCommutativityRequirements are valid as
+    // of
+    LedgerHeader mCommutativityChecksLedger{};
     BannedTransactions mBannedTransactions;
     uint32_t mLedgerVersion;
 
@@ -210,7 +210,37 @@ TxSetCommutativityRequirements::tryCleanAccountEntry(AccountID account)
 
 bool 
 TxSetCommutativityRequirements::checkAccountHasSufficientBalance(AccountID account, AbstractLedgerTxn& ltx, LedgerTxnHeader& header) {
-	return getRequirements(account).checkAccountHasSufficientBalance(ltx, header);
+	auto iter = mAccountRequirements.find(account);
+	if (iter == mAccountRequirements.end())
+	{
+		return true;
+	}
+	return iter -> second.checkAccountHasSufficientBalance(ltx, header);
+}
+
+void
+TxSetCommutativityRequirements::invalidateCachedChecks(UnorderedSet<AccountID> const& changed)
+{
+	if (changed.empty())
+	{
+		return;
+	}
+	for (auto& [_, reqs] : mAccountRequirements)
+	{
+		if (reqs.checkDependsOn(changed))
+		{
+			reqs.invalidateCachedCheck();
+		}
+	}
+}
+
+void
+TxSetCommutativityRequirements::invalidateAllCachedChecks()
+{
+	for (auto& [_, reqs] : mAccountRequirements)
+	{
+		reqs.invalidateCachedCheck();
+	}
 }
 
 #ifdef BUILD_TESTS
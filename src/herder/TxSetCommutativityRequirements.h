@@ -6,6 +6,7 @@
 
 #include <map>
 #include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
 #include "herder/AccountCommutativityRequirements.h"
 #include "util/XDROperators.h"
 #include <optional>
@@ -42,8 +43,17 @@ public:
 	// returns true if account has been removed from the map
 	bool tryCleanAccountEntry(AccountID account);
 
+	// Accounts without requirements trivially have sufficient balance.
+	// Results are cached per account until the account's requirements change,
+	// or until invalidated below.
 	bool checkAccountHasSufficientBalance(AccountID account, AbstractLedgerTxn& ltx, LedgerTxnHeader& header);
 
+	// Drops the cached checks of accounts whose inputs (the account, its
+	// trustlines, or the issuers of its required assets) are in changed.
+	void invalidateCachedChecks(UnorderedSet<AccountID> const& changed);
+
+	void invalidateAllCachedChecks();
+
 #ifdef BUILD_TESTS
 	std::optional<int64_t> getReq(AccountID account, Asset asset);
 #endif
@@ -8,6 +8,8 @@
 #include "crypto/Random.h"
 #include "crypto/SHA.h"
 #include "database/Database.h"
+#include "herder/Herder.h"
+#include "herder/ParallelTxSetValidator.h"
 #include "herder/SurgePricingUtils.h"
 #include "herder/TxSetCommutativityRequirements.h"
 #include "ledger/LedgerManager.h"
@@ -302,15 +304,67 @@ bool
 TxSetFrame::checkOrTrim(Application& app,
                         std::vector<TransactionFrameBasePtr>& trimmed,
                         bool justCheck, uint64_t lowerBoundCloseTimeOffset,
-                        uint64_t upperBoundCloseTimeOffset)
+                        uint64_t upperBoundCloseTimeOffset,
+                        TxSetCommutativityRequirements* knownRequirements)
 {
     ZoneScoped;
+    releaseAssert(!justCheck || !knownRequirements);
     LedgerTxn ltx(app.getLedgerTxnRoot());
 
     TxSetCommutativityRequirements reqs;
+    size_t numTrimmed = trimmed.size();
 
     auto accountTxMap = buildAccountTxQueues();
 
+    if (auto workers = app.getHerder().getTxSetValidationWorkers())
+    {
+        std::vector<AccountTransactionQueue const*> queues;
+        for (auto const& kv : accountTxMap)
+        {
+            queues.push_back(&kv.second);
+        }
+        auto res = ParallelTxSetValidator(*workers).validate(
+            queues, ltx, lowerBoundCloseTimeOffset, upperBoundCloseTimeOffset,
+            knownRequirements);
+        if (res)
+        {
+            // trim in the same order as below: invalid transactions first,
+            // then underfunded ones
+            for (auto const* prefix : {&res->mValidPrefix, &res->mFundedPrefix})
+            {
+                size_t i = 0;
+                for (auto& kv : accountTxMap)
+                {
+                    auto& txs = kv.second;
+                    auto keep = txs.begin() + (*prefix)[i++];
+                    if (keep == txs.end())
+                    {
+                        continue;
+                    }
+                    if (justCheck)
+                    {
+                        CLOG_DEBUG(Herder,
+                                   "Got bad txSet: {} invalid or underfunded "
+                                   "tx: {}",
+                                   hexAbbrev(mPreviousLedgerHash),
+                                   xdr_to_string((*keep)->getEnvelope(),
+                                                 "TransactionEnvelope"));
+                        return false;
+                    }
+                    for (auto iter = keep; iter != txs.end(); ++iter)
+                    {
+                        trimmed.emplace_back(*iter);
+                        removeTx(*iter);
+                    }
+                    txs.erase(keep, txs.end());
+                }
+            }
+            return true;
+        }
+        // otherwise the transactions need queries that only the serial
+        // checks below can make
+    }
+
     for (auto& kv : accountTxMap)
     {
         int64_t lastSeq = 0;
@@ -368,7 +422,13 @@ TxSetFrame::checkOrTrim(Application& app,
 
                 lastSeq = tx->getSeqNum();
 
-                auto res = reqs.validateAndAddTransaction(tx, ltx);
+                // knownRequirements already account for tx, but tx must still
+                // be able to compute them (e.g. its destinations can still
+                // receive commutative payments)
+                auto res =
+                    knownRequirements
+                        ? tx->getCommutativityRequirements(ltx).has_value()
+                        : reqs.validateAndAddTransaction(tx, ltx);
 
 
                 //Comparison:
@@ -403,9 +463,17 @@ TxSetFrame::checkOrTrim(Application& app,
         }
     }
 
-    auto header = ltx.loadHeader();
+    if (knownRequirements && trimmed.size() != numTrimmed)
+    {
+        // knownRequirements include the trimmed transactions, so would
+        // overstate what the remaining ones need
+        ltx.rollback();
+        return checkOrTrim(app, trimmed, justCheck, lowerBoundCloseTimeOffset,
+                           upperBoundCloseTimeOffset, nullptr);
+    }
 
-    std::printf("Begin TxSetFrame validity checks\n");
+    auto& requirements = knownRequirements ? *knownRequirements : reqs;
+    auto header = ltx.loadHeader();
 
     for (auto& [_, accountTxs] : accountTxMap)
     {
@@ -414,7 +482,7 @@ TxSetFrame::checkOrTrim(Application& app,
 
             auto relevantAccounts = (*iter)->getRelevantAccounts();
             for (auto acct : relevantAccounts) {
-                if (!reqs.checkAccountHasSufficientBalance(acct, ltx, header)) {
+                if (!requirements.checkAccountHasSufficientBalance(acct, ltx, header)) {
                     if (justCheck) {
                         CLOG_DEBUG(
                             Herder,
@@ -440,13 +508,14 @@ TxSetFrame::checkOrTrim(Application& app,
 
 std::vector<TransactionFrameBasePtr>
 TxSetFrame::trimInvalid(Application& app, uint64_t lowerBoundCloseTimeOffset,
-                        uint64_t upperBoundCloseTimeOffset)
+                        uint64_t upperBoundCloseTimeOffset,
+                        TxSetCommutativityRequirements* knownRequirements)
 {
     ZoneScoped;
     std::vector<TransactionFrameBasePtr> trimmed;
     sortForHash();
     checkOrTrim(app, trimmed, false, lowerBoundCloseTimeOffset,
-                upperBoundCloseTimeOffset);
+                upperBoundCloseTimeOffset, knownRequirements);
     return trimmed;
 }
 
@@ -493,7 +562,7 @@ TxSetFrame::checkValid(Application& app, uint64_t lowerBoundCloseTimeOffset,
 
     std::vector<TransactionFrameBasePtr> trimmed;
     bool valid = checkOrTrim(app, trimmed, true, lowerBoundCloseTimeOffset,
-                             upperBoundCloseTimeOffset);
+                             upperBoundCloseTimeOffset, nullptr);
     mValid = std::make_optional<std::pair<Hash, bool>>(lcl.hash, valid);
     return valid;
 }
@@ -15,6 +15,7 @@
 namespace stellar
 {
 class Application;
+class TxSetCommutativityRequirements;
 
 class TxSetFrame;
 typedef std::shared_ptr<TxSetFrame> TxSetFramePtr;
@@ -55,7 +56,8 @@ class TxSetFrame : public AbstractTxSetFrameForApply
     bool checkOrTrim(Application& app,
                      std::vector<TransactionFrameBasePtr>& trimmed,
                      bool justCheck, uint64_t lowerBoundCloseTimeOffset,
-                     uint64_t upperBoundCloseTimeOffset);
+                     uint64_t upperBoundCloseTimeOffset,
+                     TxSetCommutativityRequirements* knownRequirements);
 
     UnorderedMap<AccountID, AccountTransactionQueue> buildAccountTxQueues();
     friend struct SurgeCompare;
@@ -86,10 +88,15 @@ class TxSetFrame : public AbstractTxSetFrameForApply
                     uint64_t upperBoundCloseTimeOffset);
 
     // remove invalid transaction from this set and return those removed
-    // transactions
+    // transactions.
+    // knownRequirements, if set, must hold the commutativity requirements of
+    // exactly the transactions in this set (e.g. those maintained by the
+    // TransactionQueue); its cached balance checks are then reused instead of
+    // recomputing requirements and reloading every balance.
     std::vector<TransactionFrameBasePtr>
     trimInvalid(Application& app, uint64_t lowerBoundCloseTimeOffset,
-                uint64_t upperBoundCloseTimeOffset);
+                uint64_t upperBoundCloseTimeOffset,
+                TxSetCommutativityRequirements* knownRequirements = nullptr);
     void surgePricingFilter(Application& app);
 
     void removeTx(TransactionFrameBasePtr tx);
@@ -474,3 +474,83 @@ TEST_CASE("asset issuance limits", "[herder][txset][commutativity]")
     	}
     }
 }
+
+TEST_CASE("cached commutativity checks invalidation", "[txset][commutativity]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    const int64_t minBalance2 = app->getLedgerManager().getLastMinBalance(2);
+
+    auto issuer = root.create("issuer", 100000 + minBalance2);
+    issuer.setAssetIssuanceLimited();
+    auto asset = issuer.asset("ABCD");
+
+    auto source = root.create("source", 10000 + minBalance2);
+    source.changeTrust(asset, INT64_MAX);
+    issuer.pay(source, asset, 1000);
+
+    auto bystander = root.create("bystander", 10000 + minBalance2);
+    bystander.changeTrust(asset, INT64_MAX);
+
+    TxSetCommutativityRequirements reqs;
+
+    auto addTx = [&](TransactionFrameBasePtr tx) {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(reqs.validateAndAddTransaction(tx, ltx));
+    };
+    auto check = [&]() {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        auto header = ltx.loadHeader();
+        return reqs.checkAccountHasSufficientBalance(
+            source.getPublicKey(), ltx, header);
+    };
+
+    SECTION("native balance")
+    {
+        addTx(source.commutativeTx({payment(bystander, 5000)}));
+        REQUIRE(check());
+
+        source.pay(root, 8000);
+        // still cached
+        REQUIRE(check());
+
+        reqs.invalidateCachedChecks({bystander.getPublicKey()});
+        REQUIRE(check());
+
+        reqs.invalidateCachedChecks({source.getPublicKey()});
+        REQUIRE(!check());
+    }
+
+    SECTION("asset balance")
+    {
+        addTx(source.commutativeTx({payment(bystander, asset, 600)}));
+        REQUIRE(check());
+
+        source.pay(bystander, asset, 600);
+        REQUIRE(check());
+
+        // the cached check depends on the issuer too
+        reqs.invalidateCachedChecks({issuer.getPublicKey()});
+        REQUIRE(!check());
+    }
+
+    SECTION("invalidate all")
+    {
+        addTx(source.commutativeTx({payment(bystander, 5000)}));
+        REQUIRE(check());
+
+        source.pay(root, 8000);
+        reqs.invalidateAllCachedChecks();
+        REQUIRE(!check());
+    }
+
+    SECTION("accounts without requirements")
+    {
+        REQUIRE(check());
+    }
+}
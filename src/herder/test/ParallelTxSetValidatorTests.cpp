@@ -0,0 +1,132 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/ParallelTxSetValidator.h"
+#include "herder/TxSetFrame.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
+#include "speedex/test/TatonnementTestUtils.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "util/ForkJoinPool.h"
+
+#include <algorithm>
+#include <lib/catch.hpp>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("parallel tx set validation matches serial validation",
+          "[herder][txset]")
+{
+    Config cfg(getTestConfig());
+    cfg.LEDGER_PROTOCOL_VERSION = 17;
+    cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 1000;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    auto issuer = getIssuanceLimitedAccount(
+        root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+    auto assets = makeAssets(2, issuer);
+
+    size_t const numTraders = 12;
+    int64_t const nativeBalance = 1000000;
+    std::vector<TestAccount> traders;
+    for (size_t i = 0; i < numTraders; i++)
+    {
+        traders.push_back(root.create(
+            "trader" + std::to_string(i),
+            app->getLedgerManager().getLastMinBalance(10) + nativeBalance));
+        setNonIssuerTrustlines(traders.back(), assets);
+        fundTrader(traders.back(), issuer, assets, 100000);
+    }
+
+    // queues[i] holds the transactions of traders[i]
+    std::vector<ParallelTxSetValidator::AccountTxs> queues(numTraders);
+    for (size_t i = 0; i < numTraders; i++)
+    {
+        if (i == 7)
+        {
+            continue;
+        }
+        auto& dest = traders[(i + 1) % numTraders];
+        for (size_t j = 0; j < 3; j++)
+        {
+            queues[i].push_back(traders[i].commutativeTx(
+                {payment(dest, assets[j % 2], 100 + i), payment(dest, 1000)}));
+        }
+    }
+    // spends more than its balance over several transactions
+    for (size_t j = 0; j < 2; j++)
+    {
+        queues[1].push_back(
+            traders[1].commutativeTx({payment(traders[2], assets[1], 60000)}));
+    }
+    // sequence number gap
+    traders[3].nextSequenceNumber();
+    queues[3].push_back(
+        traders[3].commutativeTx({payment(traders[4], assets[0], 10)}));
+    // commutative transaction after a noncommutative one
+    queues[5].push_back(traders[5].tx({payment(traders[6], 10)}));
+    queues[5].push_back(
+        traders[5].commutativeTx({payment(traders[6], assets[1], 10)}));
+    // spends more than its balance in one transaction
+    queues[7].push_back(
+        traders[7].commutativeTx({payment(traders[8], assets[0], 200000)}));
+
+    auto txSet = std::make_shared<TxSetFrame>(
+        app->getLedgerManager().getLastClosedLedgerHeader().hash);
+    std::vector<ParallelTxSetValidator::AccountTxs const*> queuePtrs;
+    for (auto const& queue : queues)
+    {
+        queuePtrs.push_back(&queue);
+        for (auto const& tx : queue)
+        {
+            txSet->add(tx);
+        }
+    }
+
+    // serial
+    auto trimmed = txSet->trimInvalid(*app, 0, 0);
+    REQUIRE(!trimmed.empty());
+    std::vector<size_t> serialKept;
+    for (auto const& queue : queues)
+    {
+        size_t kept = 0;
+        for (auto const& tx : queue)
+        {
+            if (std::find(trimmed.begin(), trimmed.end(), tx) == trimmed.end())
+            {
+                kept++;
+            }
+        }
+        serialKept.push_back(kept);
+    }
+    REQUIRE(serialKept[0] == 3);
+    REQUIRE(serialKept[1] == 0);
+    REQUIRE(serialKept[3] == 3);
+    REQUIRE(serialKept[5] == 4);
+    REQUIRE(serialKept[7] == 0);
+
+    for (size_t numThreads : {1, 4})
+    {
+        ForkJoinPool workers(numThreads);
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        auto res =
+            ParallelTxSetValidator(workers).validate(queuePtrs, ltx, 0, 0,
+                                                     nullptr);
+        REQUIRE(res);
+        REQUIRE(res->mFundedPrefix == serialKept);
+        for (size_t i = 0; i < numTraders; i++)
+        {
+            REQUIRE(res->mFundedPrefix[i] <= res->mValidPrefix[i]);
+        }
+        REQUIRE(res->mValidPrefix[1] == queues[1].size());
+        REQUIRE(res->mValidPrefix[3] == 3);
+    }
+}
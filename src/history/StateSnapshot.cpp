@@ -20,6 +20,7 @@
 #include "util/Logging.h"
 #include "util/XDRStream.h"
 #include <Tracy.hpp>
+#include <fmt/format.h>
 
 namespace stellar
 {
@@ -128,6 +129,43 @@ StateSnapshot::writeHistoryBlocks() const
     return true;
 }
 
+std::shared_ptr<FileTransferInfo>
+StateSnapshot::getBucketFileToPublish(Bucket const& bucket)
+{
+    ZoneScoped;
+    XDRInputMappedFileStream in;
+    in.open(bucket.getFilename());
+    if (!in.isBlockFile())
+    {
+        return std::make_shared<FileTransferInfo>(bucket);
+    }
+
+    // Archives hold plain XDR files, so write the bucket out in that format
+    // into the snapshot directory, once per snapshot.
+    auto file = std::make_shared<FileTransferInfo>(
+        mSnapDir, HISTORY_FILE_TYPE_BUCKET, binToHex(bucket.getHash()));
+    auto path = file->localPath_nogz();
+    if (!fs::exists(path))
+    {
+        CLOG_DEBUG(History, "Writing bucket {} as a plain XDR file to {}",
+                   hexAbbrev(bucket.getHash()), path);
+        auto tmpPath = path + ".tmp";
+        XDROutputFileStream out(mApp.getClock().getIOContext(),
+                                !mApp.getConfig().DISABLE_XDR_FSYNC);
+        out.open(tmpPath);
+        in.readContents([&](char const* data, size_t size) {
+            out.writeBytes(data, size);
+        });
+        out.close();
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            throw std::runtime_error(
+                fmt::format("failed to rename {} to {}", tmpPath, path));
+        }
+    }
+    return file;
+}
+
 std::vector<std::shared_ptr<FileTransferInfo>>
 StateSnapshot::differingHASFiles(HistoryArchiveState const& other)
 {
@@ -149,7 +187,7 @@ StateSnapshot::differingHASFiles(HistoryArchiveState const& other)
     {
         auto b = mApp.getBucketManager().getBucketByHash(hexToBin256(hash));
         releaseAssert(b);
-        addIfExists(std::make_shared<FileTransferInfo>(*b));
+        addIfExists(getBucketFileToPublish(*b));
     }
 
     return files;
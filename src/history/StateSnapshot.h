@@ -15,6 +15,7 @@
 namespace stellar
 {
 
+class Bucket;
 class FileTransferInfo;
 
 struct StateSnapshot : public std::enable_shared_from_this<StateSnapshot>
@@ -29,6 +30,10 @@ struct StateSnapshot : public std::enable_shared_from_this<StateSnapshot>
 
     StateSnapshot(Application& app, HistoryArchiveState const& state);
     bool writeHistoryBlocks() const;
+
+    // The file to publish for a bucket: its own file, or a plain XDR copy
+    // written to the snapshot directory if it is an XDR block file.
+    std::shared_ptr<FileTransferInfo> getBucketFileToPublish(Bucket const& b);
     std::vector<std::shared_ptr<FileTransferInfo>>
     differingHASFiles(HistoryArchiveState const& other);
 };
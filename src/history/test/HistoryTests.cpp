@@ -8,6 +8,7 @@
 #include "history/FileTransferInfo.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/HistoryManager.h"
+#include "history/StateSnapshot.h"
 #include "history/test/HistoryTestsUtils.h"
 #include "historywork/GetHistoryArchiveStateWork.h"
 #include "historywork/GunzipFileWork.h"
@@ -23,6 +24,7 @@
 #include "test/test.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
+#include "util/XDRStream.h"
 #include "work/WorkScheduler.h"
 
 #include "historywork/BatchDownloadWork.h"
@@ -713,6 +715,97 @@ TEST_CASE("History catchup with different modes",
     }
 }
 
+TEST_CASE("History catchup with parallel bucket apply", "[history][catchup]")
+{
+    CatchupSimulation catchupSimulation{};
+    auto checkpointLedger = catchupSimulation.getLastCheckpointLedger(3);
+    catchupSimulation.ensureOfflineCatchupPossible(checkpointLedger);
+
+    std::vector<Config::TestDbMode> dbModes = {Config::TESTDB_IN_MEMORY_SQLITE,
+                                               Config::TESTDB_ON_DISK_SQLITE};
+#ifdef USE_POSTGRES
+    if (!force_sqlite)
+        dbModes.push_back(Config::TESTDB_POSTGRESQL);
+#endif
+
+    for (auto dbMode : dbModes)
+    {
+        for (uint32_t partitions : {1, 4})
+        {
+            auto app = catchupSimulation.createCatchupApplication(
+                std::numeric_limits<uint32_t>::max(), dbMode,
+                std::string("parallel apply, ") + dbModeName(dbMode) + ", " +
+                    std::to_string(partitions) + " partitions",
+                false, [partitions](Config& cfg) {
+                    cfg.BUCKET_APPLY_PARTITIONS = partitions;
+                });
+            // Test configs enable BucketListIsConsistentWithDatabase, which
+            // checks the applied state against the buckets.
+            REQUIRE(
+                catchupSimulation.catchupOffline(app, checkpointLedger, true));
+        }
+    }
+}
+
+namespace
+{
+class BlockFileHistoryConfigurator : public TmpDirHistoryConfigurator
+{
+  public:
+    Config&
+    configure(Config& cfg, bool writable) const override
+    {
+        TmpDirHistoryConfigurator::configure(cfg, writable);
+        cfg.BUCKET_FILE_BLOCK_SIZE = 1024;
+        return cfg;
+    }
+};
+}
+
+TEST_CASE("History catchup with block file buckets", "[history][catchup]")
+{
+    auto configurator = std::make_shared<BlockFileHistoryConfigurator>();
+    CatchupSimulation catchupSimulation{VirtualClock::VIRTUAL_TIME,
+                                        configurator};
+    auto checkpointLedger = catchupSimulation.getLastCheckpointLedger(3);
+    catchupSimulation.ensureOfflineCatchupPossible(checkpointLedger);
+
+    // The publisher keeps its buckets as block files, but publishes them as
+    // plain XDR files with the bucket hashes.
+    auto& app = catchupSimulation.getApp();
+    auto has = app.getLedgerManager().getLastClosedLedgerHAS();
+    auto snapshot = std::make_shared<StateSnapshot>(app, has);
+    bool sawBlockFile = false;
+    for (auto const& hash : has.allBuckets())
+    {
+        auto b = app.getBucketManager().getBucketByHash(hexToBin256(hash));
+        if (!b || b->getFilename().empty())
+        {
+            continue;
+        }
+        XDRInputMappedFileStream local;
+        local.open(b->getFilename());
+        sawBlockFile = sawBlockFile || local.isBlockFile();
+
+        auto published = snapshot->getBucketFileToPublish(*b);
+        XDRInputMappedFileStream in;
+        in.open(published->localPath_nogz());
+        REQUIRE(!in.isBlockFile());
+        SHA256 hasher;
+        in.readContents([&](char const* data, size_t size) {
+            hasher.add(ByteSlice(data, size));
+        });
+        REQUIRE(hasher.finish() == b->getHash());
+    }
+    REQUIRE(sawBlockFile);
+
+    auto catchupApp = catchupSimulation.createCatchupApplication(
+        std::numeric_limits<uint32_t>::max(), Config::TESTDB_ON_DISK_SQLITE,
+        "app");
+    REQUIRE(catchupSimulation.catchupOffline(catchupApp, checkpointLedger,
+                                             true));
+}
+
 TEST_CASE("History prefix catchup", "[history][catchup]")
 {
     CatchupSimulation catchupSimulation{};
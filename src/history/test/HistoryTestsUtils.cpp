@@ -682,10 +682,9 @@ CatchupSimulation::crankUntil(Application::pointer app,
 }
 
 Application::pointer
-CatchupSimulation::createCatchupApplication(uint32_t count,
-                                            Config::TestDbMode dbMode,
-                                            std::string const& appName,
-                                            bool publish)
+CatchupSimulation::createCatchupApplication(
+    uint32_t count, Config::TestDbMode dbMode, std::string const& appName,
+    bool publish, std::function<void(Config&)> const& configure)
 {
     CLOG_INFO(History, "****");
     CLOG_INFO(History, "**** Create app for catchup: '{}'", appName);
@@ -696,6 +695,10 @@ CatchupSimulation::createCatchupApplication(uint32_t count,
     mCfgs.back().CATCHUP_COMPLETE =
         count == std::numeric_limits<uint32_t>::max();
     mCfgs.back().CATCHUP_RECENT = count;
+    if (configure)
+    {
+        configure(mCfgs.back());
+    }
     mSpawnedAppsClocks.emplace_front();
     auto newApp = createTestApplication(
         mSpawnedAppsClocks.front(),
@@ -275,10 +275,11 @@ class CatchupSimulation
     std::vector<LedgerNumHashPair> getAllPublishedCheckpoints() const;
     LedgerNumHashPair getLastPublishedCheckpoint() const;
 
-    Application::pointer createCatchupApplication(uint32_t count,
-                                                  Config::TestDbMode dbMode,
-                                                  std::string const& appName,
-                                                  bool publish = false);
+    // configure, if set, may change the app's config before it is created.
+    Application::pointer createCatchupApplication(
+        uint32_t count, Config::TestDbMode dbMode, std::string const& appName,
+        bool publish = false,
+        std::function<void(Config&)> const& configure = nullptr);
     bool catchupOffline(Application::pointer app, uint32_t toLedger,
                         bool extraValidation = false);
     bool catchupOnline(Application::pointer app, uint32_t initLedger,
@@ -9,14 +9,13 @@
 #include "main/ErrorMessages.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
+#include "util/XDRStream.h"
 #include <fmt/format.h>
 
 #include <Tracy.hpp>
 #include <medida/meter.h>
 #include <medida/metrics_registry.h>
 
-#include <fstream>
-
 namespace stellar
 {
 
@@ -72,20 +71,13 @@ VerifyBucketWork::spawnVerifier()
                 CLOG_INFO(History, "Verifying bucket {}", binToHex(hash));
 
                 // ensure that the stream gets its own scope to avoid race with
-                // main thread
-                std::ifstream in(filename, std::ifstream::binary);
-                if (!in)
-                {
-                    throw std::runtime_error(
-                        fmt::format("Error opening file {}", filename));
-                }
-                in.exceptions(std::ios::badbit);
-                char buf[4096];
-                while (in)
-                {
-                    in.read(buf, sizeof(buf));
-                    hasher.add(ByteSlice(buf, in.gcount()));
-                }
+                // main thread. Bucket hashes are those of the XDR records, so
+                // local buckets written as XDR block files are decoded.
+                XDRInputMappedFileStream in;
+                in.open(filename);
+                in.readContents([&](char const* data, size_t size) {
+                    hasher.add(ByteSlice(data, size));
+                });
                 uint256 vHash = hasher.finish();
                 if (vHash == hash)
                 {
@@ -155,6 +155,12 @@ InMemoryLedgerTxnRoot::getPrefetchHitRate() const
     return 0.0;
 }
 
+std::map<LedgerEntryType, EntryCacheLookups>
+InMemoryLedgerTxnRoot::getEntryCacheLookups() const
+{
+    return {};
+}
+
 uint32_t
 InMemoryLedgerTxnRoot::prefetch(UnorderedSet<LedgerKey> const& keys)
 {
@@ -77,6 +77,8 @@ class InMemoryLedgerTxnRoot : public AbstractLedgerTxnParent
     void dropLiquidityPools() override;
     void dropSpeedexConfigs() override;
     double getPrefetchHitRate() const override;
+    std::map<LedgerEntryType, EntryCacheLookups>
+    getEntryCacheLookups() const override;
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
 
     std::shared_ptr<const LedgerEntry>
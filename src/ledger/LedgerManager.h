@@ -5,7 +5,9 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "catchup/CatchupManager.h"
+#include "crypto/SecretKey.h"
 #include "history/HistoryManager.h"
+#include "util/UnorderedSet.h"
 #include <memory>
 
 namespace stellar
@@ -13,6 +15,7 @@ namespace stellar
 
 class LedgerCloseData;
 class Database;
+class TxSetFrame;
 
 /**
  * LedgerManager maintains, in memory, a logical pair of ledgers:
@@ -90,6 +93,13 @@ class LedgerManager
     // `ledgerData`.
     virtual void valueExternalized(LedgerCloseData const& ledgerData) = 0;
 
+    // Called when `txSet` (with contents hash `txSetHash`) is likely to be
+    // applied by an upcoming ledger, to start loading the ledger entries it
+    // needs in the background. A hint only: does nothing unless
+    // BACKGROUND_TX_SET_PREFETCH is set.
+    virtual void prefetchTxSet(Hash const& txSetHash,
+                               TxSetFrame const& txSet) = 0;
+
     // Return the LCL header and (complete, immutable) hash.
     virtual LedgerHeaderHistoryEntry const&
     getLastClosedLedgerHeader() const = 0;
@@ -98,6 +108,11 @@ class LedgerManager
     // the database
     virtual HistoryArchiveState getLastClosedLedgerHAS() = 0;
 
+    // Return the accounts whose account or trustline entries were created,
+    // modified or deleted by the LCL.
+    virtual UnorderedSet<AccountID> const&
+    getLastClosedLedgerChangedAccounts() const = 0;
+
     // Return the sequence number of the LCL.
     virtual uint32_t getLastClosedLedgerNum() const = 0;
 
@@ -22,6 +22,8 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/LedgerTxnMemoryRoot.h"
+#include "ledger/ParallelCommutativeApply.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "main/ErrorMessages.h"
@@ -36,6 +38,7 @@
 #include "util/Logging.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
+#include "util/types.h"
 #include <fmt/format.h>
 
 #include "medida/buckets.h"
@@ -49,6 +52,8 @@
 #include "xdrpp/types.h"
 #include <Tracy.hpp>
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <numeric>
 #include <regex>
@@ -127,6 +132,12 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
           app.getMetrics().NewHistogram({"ledger", "operation", "count"}))
     , mPrefetchHitRate(
           app.getMetrics().NewHistogram({"ledger", "prefetch", "hit-rate"}))
+    , mSpeedexTatonnementRounds(app.getMetrics().NewHistogram(
+          {"ledger", "speedex", "tatonnement-rounds"}))
+    , mCommutativeApply(app.getMetrics().NewTimer(
+          {"ledger", "transaction", "commutative-apply"}))
+    , mCommutativeApplyFallback(app.getMetrics().NewMeter(
+          {"ledger", "transaction", "commutative-apply-fallback"}, "ledger"))
     , mLedgerClose(app.getMetrics().NewTimer({"ledger", "ledger", "close"}))
     , mLedgerAgeClosed(app.getMetrics().NewBuckets(
           {"ledger", "age", "closed"}, {5000.0, 7000.0, 10000.0, 20000.0}))
@@ -141,6 +152,21 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
 
 {
     setupLedgerCloseMetaStream();
+    if (app.getConfig().SPEEDEX_DEMAND_QUERY_THREADS > 1)
+    {
+        mSpeedexWorkers = std::make_unique<ForkJoinPool>(
+            app.getConfig().SPEEDEX_DEMAND_QUERY_THREADS);
+    }
+    if (app.getConfig().COMMUTATIVE_APPLY_THREADS > 1)
+    {
+        mCommutativeApplyWorkers = std::make_unique<ForkJoinPool>(
+            app.getConfig().COMMUTATIVE_APPLY_THREADS);
+    }
+    if (app.getConfig().BACKGROUND_TX_SET_PREFETCH &&
+        app.getConfig().PREFETCH_BATCH_SIZE > 0)
+    {
+        mTxSetPrefetcher = std::make_unique<TxSetPrefetcher>(app);
+    }
 }
 
 void
@@ -290,6 +316,17 @@ LedgerManagerImpl::loadLastKnownLedger(
             LedgerTxn ltx(mApp.getLedgerTxnRoot());
             ltx.loadHeader().current() = *currentLedger;
             ltx.commit();
+
+            if (mApp.getConfig().IN_MEMORY_LEDGER_STATE)
+            {
+                // The ledger state is only stored in the buckets
+                auto state =
+                    mApp.getBucketManager().loadCompleteLedgerState(has);
+                CLOG_INFO(Ledger, "Loaded {} ledger entries from buckets",
+                          state.size());
+                dynamic_cast<LedgerTxnMemoryRoot&>(mApp.getLedgerTxnRoot())
+                    .loadFromBuckets(state);
+            }
         }
         else
         {
@@ -414,6 +451,12 @@ LedgerManagerImpl::getLastClosedLedgerHAS()
     return has;
 }
 
+UnorderedSet<AccountID> const&
+LedgerManagerImpl::getLastClosedLedgerChangedAccounts() const
+{
+    return mLastClosedLedgerChangedAccounts;
+}
+
 uint32_t
 LedgerManagerImpl::getLastClosedLedgerNum() const
 {
@@ -457,6 +500,16 @@ LedgerManagerImpl::valueExternalized(LedgerCloseData const& ledgerData)
     FrameMark;
 }
 
+void
+LedgerManagerImpl::prefetchTxSet(Hash const& txSetHash,
+                                 TxSetFrame const& txSet)
+{
+    if (mTxSetPrefetcher)
+    {
+        mTxSetPrefetcher->start(txSetHash, txSet);
+    }
+}
+
 void
 LedgerManagerImpl::closeLedgerIf(LedgerCloseData const& ledgerData)
 {
@@ -609,6 +662,12 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         throw std::runtime_error("corrupt transaction set");
     }
 
+    if (mTxSetPrefetcher)
+    {
+        mTxSetPrefetcher->adopt(txSet->getContentsHash(),
+                                getLastClosedLedgerNum());
+    }
+
     auto const& sv = ledgerData.getValue();
     header.current().scpValue = sv;
 
@@ -1089,6 +1148,15 @@ LedgerManagerImpl::applyTransaction(
                mApp.getConfig().toShortString(tx->getSourceID()));
     tx->apply(mApp, ltx, tm);
 
+    recordTransactionResult(tx, tm, ltx, txResultSet, ledgerCloseMeta, index);
+}
+
+void
+LedgerManagerImpl::recordTransactionResult(
+    TransactionFrameBasePtr& tx, TransactionMeta& tm, AbstractLedgerTxn& ltx,
+    TransactionResultSet& txResultSet,
+    std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta, int& index)
+{
     TransactionResultPair results;
     results.transactionHash = tx->getContentsHash();
     results.result = tx->getResult();
@@ -1160,11 +1228,72 @@ LedgerManagerImpl::applyTransactions(
 
     prefetchTransactionData(commutativeTxs);
 
-    for (auto tx : commutativeTxs) {
-        applyTransaction(tx, ltx, txResultSet, ledgerCloseMeta, index);
+    // Parallel apply gives each transaction the meta of its own shard, which
+    // differs from what a serial apply would publish, so it is only used when
+    // no meta leaves this node.
+    bool appliedInParallel = false;
+    if (mCommutativeApplyWorkers && !commutativeTxs.empty() &&
+        !ledgerCloseMeta && !mApp.getConfig().MODE_STORES_HISTORY_MISC)
+    {
+        std::vector<TransactionMeta> metas;
+        std::vector<TransactionResult> results;
+        for (auto const& tx : commutativeTxs)
+        {
+            results.emplace_back(tx->getResult());
+        }
+        try
+        {
+            auto timer = mCommutativeApply.TimeScope();
+            ParallelCommutativeApply engine(mApp, *mCommutativeApplyWorkers);
+            engine.apply(commutativeTxs, ltx, metas);
+            appliedInParallel = true;
+        }
+        catch (std::runtime_error& e)
+        {
+            // ltx is unchanged; put back the results as they were before, so
+            // that the serial apply below starts from the same state.
+            CLOG_WARNING(Ledger,
+                         "Parallel commutative apply failed, applying "
+                         "serially: {}",
+                         e.what());
+            mCommutativeApplyFallback.Mark();
+            for (size_t i = 0; i < commutativeTxs.size(); i++)
+            {
+                commutativeTxs[i]->getResult() = results[i];
+            }
+        }
+        if (appliedInParallel)
+        {
+            for (size_t i = 0; i < commutativeTxs.size(); i++)
+            {
+                auto& tx = commutativeTxs[i];
+                CLOG_DEBUG(Tx, " tx#{} = {} ops={} txseq={} (@ {})", index,
+                           hexAbbrev(tx->getContentsHash()),
+                           tx->getNumOperations(), tx->getSeqNum(),
+                           mApp.getConfig().toShortString(tx->getSourceID()));
+                recordTransactionResult(tx, metas[i], ltx, txResultSet,
+                                        ledgerCloseMeta, index);
+            }
+        }
+    }
+    if (!appliedInParallel)
+    {
+        auto timer = mCommutativeApply.TimeScope();
+        for (auto tx : commutativeTxs)
+        {
+            applyTransaction(tx, ltx, txResultSet, ledgerCloseMeta, index);
+        }
     }
 
-    auto speedexRes = runSpeedex(ltx);
+    SpeedexRuntimeOptions speedexOptions;
+    speedexOptions.mDemandQueryWorkers = mSpeedexWorkers.get();
+    speedexOptions.mTatonnementWorkers = mSpeedexWorkers.get();
+    speedexOptions.mClearingWorkers = mSpeedexWorkers.get();
+    SpeedexRunStats speedexStats;
+    auto speedexRes = runSpeedex(ltx, speedexOptions, &speedexStats);
+    mSpeedexTatonnementRounds.Update(speedexStats.mTatonnementRounds);
+    TracyPlot("ledger.speedex.tatonnement-rounds",
+              static_cast<int64_t>(speedexStats.mTatonnementRounds));
 
     prefetchTransactionData(noncommutativeTxs);
 
@@ -1189,6 +1318,22 @@ LedgerManagerImpl::logTxApplyMetrics(AbstractLedgerTxn& ltx, size_t numTxs,
     // We lose a bit of precision here, as medida only accepts int64_t
     mPrefetchHitRate.Update(std::llround(hitRate));
     TracyPlot("ledger.prefetch.hit-rate", hitRate);
+
+    for (auto const& [let, lookups] :
+         mApp.getLedgerTxnRoot().getEntryCacheLookups())
+    {
+        // ACCOUNT -> account, CLAIMABLE_BALANCE -> claimable-balance
+        std::string type = xdr::xdr_traits<LedgerEntryType>::enum_name(let);
+        std::transform(type.begin(), type.end(), type.begin(), [](char c) {
+            return c == '_' ? '-' : static_cast<char>(std::tolower(c));
+        });
+        mApp.getMetrics()
+            .NewMeter({"ledger", "entry-cache", "hit-" + type}, "entry")
+            .Mark(lookups.hits);
+        mApp.getMetrics()
+            .NewMeter({"ledger", "entry-cache", "miss-" + type}, "entry")
+            .Mark(lookups.misses);
+    }
 }
 
 void
@@ -1230,6 +1375,38 @@ LedgerManagerImpl::transferLedgerEntriesToBucketList(AbstractLedgerTxn& ltx,
     std::vector<LedgerEntry> initEntries, liveEntries;
     std::vector<LedgerKey> deadEntries;
     ltx.getAllEntries(initEntries, liveEntries, deadEntries);
+
+    auto addChangedKey = [this](LedgerKey const& key) {
+        if (key.type() == ACCOUNT)
+        {
+            mLastClosedLedgerChangedAccounts.insert(key.account().accountID);
+        }
+        else if (key.type() == TRUSTLINE)
+        {
+            mLastClosedLedgerChangedAccounts.insert(key.trustLine().accountID);
+        }
+        if (mTxSetPrefetcher)
+        {
+            mTxSetPrefetcher->invalidate(key);
+        }
+    };
+    for (auto const& entry : initEntries)
+    {
+        addChangedKey(LedgerEntryKey(entry));
+    }
+    for (auto const& entry : liveEntries)
+    {
+        addChangedKey(LedgerEntryKey(entry));
+    }
+    for (auto const& key : deadEntries)
+    {
+        addChangedKey(key);
+    }
+    if (mTxSetPrefetcher)
+    {
+        mTxSetPrefetcher->ledgerClosed(ledgerSeq);
+    }
+
     if (mApp.getConfig().MODE_ENABLES_BUCKETLIST)
     {
         mApp.getBucketManager().addBatch(mApp, ledgerSeq, ledgerVers,
@@ -1247,6 +1424,7 @@ LedgerManagerImpl::ledgerClosed(AbstractLedgerTxn& ltx)
                "sealing ledger {} with version {}, sending to bucket list",
                ledgerSeq, ledgerVers);
 
+    mLastClosedLedgerChangedAccounts.clear();
     transferLedgerEntriesToBucketList(ltx, ledgerSeq, ledgerVers);
 
     ltx.unsealHeader([this](LedgerHeader& lh) {
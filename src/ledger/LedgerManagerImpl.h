@@ -7,8 +7,10 @@
 
 #include "history/HistoryManager.h"
 #include "ledger/LedgerManager.h"
+#include "ledger/TxSetPrefetcher.h"
 #include "main/PersistentState.h"
 #include "transactions/TransactionFrame.h"
+#include "util/ForkJoinPool.h"
 #include "util/XDRStream.h"
 #include "xdr/Stellar-ledger.h"
 #include <filesystem>
@@ -26,6 +28,7 @@ class Timer;
 class Counter;
 class Histogram;
 class Buckets;
+class Meter;
 }
 
 namespace stellar
@@ -52,6 +55,9 @@ class LedgerManagerImpl : public LedgerManager
     medida::Histogram& mTransactionCount;
     medida::Histogram& mOperationCount;
     medida::Histogram& mPrefetchHitRate;
+    medida::Histogram& mSpeedexTatonnementRounds;
+    medida::Timer& mCommutativeApply;
+    medida::Meter& mCommutativeApplyFallback;
     medida::Timer& mLedgerClose;
     medida::Buckets& mLedgerAgeClosed;
     medida::Counter& mLedgerAge;
@@ -63,6 +69,17 @@ class LedgerManagerImpl : public LedgerManager
 
     std::unique_ptr<LedgerCloseMeta> mNextMetaToEmit;
 
+    UnorderedSet<AccountID> mLastClosedLedgerChangedAccounts;
+
+    // null unless SPEEDEX_DEMAND_QUERY_THREADS > 1
+    std::unique_ptr<ForkJoinPool> mSpeedexWorkers;
+
+    // null unless COMMUTATIVE_APPLY_THREADS > 1
+    std::unique_ptr<ForkJoinPool> mCommutativeApplyWorkers;
+
+    // null unless BACKGROUND_TX_SET_PREFETCH and PREFETCH_BATCH_SIZE > 0
+    std::unique_ptr<TxSetPrefetcher> mTxSetPrefetcher;
+
     void
     processFeesSeqNums(std::vector<TransactionFrameBasePtr>& txs,
                        AbstractLedgerTxn& ltxOuter, int64_t baseFee,
@@ -76,6 +93,15 @@ class LedgerManagerImpl : public LedgerManager
                      std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta,
                      int& index);
 
+    // Records the result and meta of an applied transaction, and advances
+    // index.
+    void
+    recordTransactionResult(TransactionFrameBasePtr& tx, TransactionMeta& tm,
+                            AbstractLedgerTxn& ltx,
+                            TransactionResultSet& txResultSet,
+                            std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta,
+                            int& index);
+
     void
     applyTransactions(std::vector<TransactionFrameBasePtr>& commutativeTxs,
                       std::vector<TransactionFrameBasePtr>& noncommutativeTxs,
@@ -113,6 +139,9 @@ class LedgerManagerImpl : public LedgerManager
 
     void valueExternalized(LedgerCloseData const& ledgerData) override;
 
+    void prefetchTxSet(Hash const& txSetHash,
+                       TxSetFrame const& txSet) override;
+
     uint32_t getLastMaxTxSetSize() const override;
     uint32_t getLastMaxTxSetSizeOps() const override;
     int64_t getLastMinBalance(uint32_t ownerCount) const override;
@@ -132,6 +161,9 @@ class LedgerManagerImpl : public LedgerManager
 
     HistoryArchiveState getLastClosedLedgerHAS() override;
 
+    UnorderedSet<AccountID> const&
+    getLastClosedLedgerChangedAccounts() const override;
+
     Database& getDatabase() override;
 
     void startCatchup(CatchupConfiguration configuration,
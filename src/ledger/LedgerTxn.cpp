@@ -204,6 +204,29 @@ WorstBestOfferIterator::offerDescriptor() const
     return getImpl()->offerDescriptor();
 }
 
+// Adds a commutative balance delta (see
+// AbstractLedgerTxn::addCommutativeBalanceDelta) to an account or trustline
+static void
+applyCommutativeDelta(LedgerEntry& le, int64_t delta)
+{
+    int64_t* balance = nullptr;
+    switch (le.data.type())
+    {
+    case ACCOUNT:
+        balance = &le.data.account().balance;
+        break;
+    case TRUSTLINE:
+        balance = &le.data.trustLine().balance;
+        break;
+    default:
+        throw std::runtime_error("commutative delta on entry without balance");
+    }
+    if (!stellar::addBalance(*balance, delta))
+    {
+        throw std::runtime_error("commutative balance delta out of range");
+    }
+}
+
 // Implementation of AbstractLedgerTxn --------------------------------------
 AbstractLedgerTxn::~AbstractLedgerTxn()
 {
@@ -229,6 +252,7 @@ LedgerTxn::Impl::Impl(LedgerTxn& self, AbstractLedgerTxnParent& parent,
     , mShouldUpdateLastModified(shouldUpdateLastModified)
     , mIsSealed(false)
     , mConsistency(LedgerTxnConsistency::EXACT)
+    , mParentTakesDeltas(dynamic_cast<LedgerTxn*>(&parent) != nullptr)
 {
     mParent.addChild(self);
 }
@@ -377,6 +401,9 @@ LedgerTxn::Impl::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
             {
                 updateEntry(key, nullptr);
             }
+            // the child read key through getNewestVersion, so its version
+            // already includes any delta pending here
+            dropCommutativeDelta(key);
         }
 
         // We will show that the following update procedure leaves the self
@@ -460,6 +487,13 @@ LedgerTxn::Impl::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
         //gather speedex ioc offers
 
         mSpeedexIOCOrderbooks.commitChild(mChild -> getSpeedexIOCOffers());
+
+        // The child never has both an entry and a delta for the same key, so
+        // these are relative to the state just merged above.
+        for (auto const& [key, delta] : mChild->getCommutativeBalanceDeltas())
+        {
+            recordCommutativeBalanceDelta(key, delta);
+        }
     }
     catch (std::exception& e)
     {
@@ -505,6 +539,7 @@ LedgerTxn::Impl::create(LedgerTxn& self, InternalLedgerEntry const& entry)
     LedgerTxnEntry ltxe(impl);
 
     updateEntry(key, current);
+    dropCommutativeDelta(key);
     return ltxe;
 }
 
@@ -529,6 +564,7 @@ LedgerTxn::Impl::createOrUpdateWithoutLoading(LedgerTxn& self,
     }
 
     updateEntry(key, std::make_shared<InternalLedgerEntry>(entry));
+    dropCommutativeDelta(key);
 }
 
 void
@@ -593,6 +629,7 @@ LedgerTxn::Impl::erase(InternalLedgerKey const& key)
     updateEntry(key, nullptr, false);
     // Note: Cannot throw after this point because the entry will not be
     // deactivated in that case
+    dropCommutativeDelta(key);
 
     // C++14 requirements for exception safety of containers guarantee that
     // erase(iter) does not throw
@@ -620,6 +657,7 @@ LedgerTxn::Impl::eraseWithoutLoading(InternalLedgerKey const& key)
     updateEntry(key, nullptr, false, false);
     // Note: Cannot throw after this point because the entry will not be
     // deactivated in that case
+    dropCommutativeDelta(key);
 
     if (isActive)
     {
@@ -968,43 +1006,49 @@ LedgerTxn::Impl::getChanges()
     LedgerEntryChanges changes;
     changes.reserve(mEntry.size() * 2);
     maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
-        for (auto const& kv : entries)
-        {
-            auto const& key = kv.first;
-            auto const& entry = kv.second;
-
-            if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+        auto addChanges = [&](EntryMap const& recorded) {
+            for (auto const& kv : recorded)
             {
-                continue;
-            }
+                auto const& key = kv.first;
+                auto const& entry = kv.second;
 
-            auto previous = mParent.getNewestVersion(key);
-            if (previous)
-            {
-                changes.emplace_back(LEDGER_ENTRY_STATE);
-                changes.back().state() = previous->ledgerEntry();
+                if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+                {
+                    continue;
+                }
 
-                if (entry)
+                auto previous = mParent.getNewestVersion(key);
+                if (previous)
                 {
-                    changes.emplace_back(LEDGER_ENTRY_UPDATED);
-                    changes.back().updated() = entry->ledgerEntry();
+                    changes.emplace_back(LEDGER_ENTRY_STATE);
+                    changes.back().state() = previous->ledgerEntry();
+
+                    if (entry)
+                    {
+                        changes.emplace_back(LEDGER_ENTRY_UPDATED);
+                        changes.back().updated() = entry->ledgerEntry();
+                    }
+                    else
+                    {
+                        changes.emplace_back(LEDGER_ENTRY_REMOVED);
+                        changes.back().removed() = key.ledgerKey();
+                    }
                 }
                 else
                 {
-                    changes.emplace_back(LEDGER_ENTRY_REMOVED);
-                    changes.back().removed() = key.ledgerKey();
+                    // If !entry and !previous.entry then the entry was
+                    // created and erased in this LedgerTxn, in which case it
+                    // should not still be in this LedgerTxn
+                    releaseAssert(entry);
+                    changes.emplace_back(LEDGER_ENTRY_CREATED);
+                    changes.back().created() = entry->ledgerEntry();
                 }
             }
-            else
-            {
-                // If !entry and !previous.entry then the entry was created and
-                // erased in this LedgerTxn, in which case it should not still
-                // be in this LedgerTxn
-                releaseAssert(entry);
-                changes.emplace_back(LEDGER_ENTRY_CREATED);
-                changes.back().created() = entry->ledgerEntry();
-            }
-        }
+        };
+        addChanges(entries);
+        // Deltas are only left at this point if the parent takes them on
+        // commit; they are reported as the entries they will become.
+        addChanges(foldCommutativeDeltas());
     });
     return changes;
 }
@@ -1022,16 +1066,22 @@ LedgerTxn::Impl::getDelta()
     LedgerTxnDelta delta;
     delta.entry.reserve(mEntry.size());
     maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
-        for (auto const& kv : entries)
-        {
-            auto const& key = kv.first;
-            auto previous = mParent.getNewestVersion(key);
+        auto addDelta = [&](EntryMap const& recorded) {
+            for (auto const& kv : recorded)
+            {
+                auto const& key = kv.first;
+                auto previous = mParent.getNewestVersion(key);
 
-            // Deep copy is not required here because getDelta causes
-            // LedgerTxn to enter the sealed state, meaning subsequent
-            // modifications are impossible.
-            delta.entry[key] = {kv.second, previous};
-        }
+                // Deep copy is not required here because getDelta causes
+                // LedgerTxn to enter the sealed state, meaning subsequent
+                // modifications are impossible.
+                delta.entry[key] = {kv.second, previous};
+            }
+        };
+        addDelta(entries);
+        // Deltas are only left at this point if the parent takes them on
+        // commit; they are reported as the entries they will become.
+        addDelta(foldCommutativeDeltas());
         delta.header = {*mHeader, mParent.getHeader()};
     });
     return delta;
@@ -1159,6 +1209,13 @@ LedgerTxn::Impl::enumerateInflationWinners(
 std::vector<InflationWinner>
 LedgerTxn::Impl::getInflationWinners(size_t maxWinners, int64_t minVotes)
 {
+    // getDeltaVotes only looks at balances recorded in mEntry
+    if (!mCommutativeDeltas.empty())
+    {
+        throw std::runtime_error(
+            "inflation with pending commutative balance deltas");
+    }
+
     // Calculate vote changes relative to parent
     auto deltaVotes = getDeltaVotes();
 
@@ -1232,33 +1289,39 @@ LedgerTxn::Impl::getAllEntries(std::vector<LedgerEntry>& initEntries,
     resLive.reserve(mEntry.size());
     resDead.reserve(mEntry.size());
     maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
-        for (auto const& kv : entries)
-        {
-            auto const& key = kv.first;
-            auto const& entry = kv.second;
-
-            if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+        auto addEntries = [&](EntryMap const& recorded) {
+            for (auto const& kv : recorded)
             {
-                continue;
-            }
+                auto const& key = kv.first;
+                auto const& entry = kv.second;
 
-            if (entry)
-            {
-                auto previous = mParent.getNewestVersion(key);
-                if (previous)
+                if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
                 {
-                    resLive.emplace_back(entry->ledgerEntry());
+                    continue;
+                }
+
+                if (entry)
+                {
+                    auto previous = mParent.getNewestVersion(key);
+                    if (previous)
+                    {
+                        resLive.emplace_back(entry->ledgerEntry());
+                    }
+                    else
+                    {
+                        resInit.emplace_back(entry->ledgerEntry());
+                    }
                 }
                 else
                 {
-                    resInit.emplace_back(entry->ledgerEntry());
+                    resDead.emplace_back(key.ledgerKey());
                 }
             }
-            else
-            {
-                resDead.emplace_back(key.ledgerKey());
-            }
-        }
+        };
+        addEntries(entries);
+        // Deltas are only left at this point if the parent takes them on
+        // commit; they are reported as the entries they will become.
+        addEntries(foldCommutativeDeltas());
     });
     initEntries.swap(resInit);
     liveEntries.swap(resLive);
@@ -1279,7 +1342,20 @@ LedgerTxn::Impl::getNewestVersion(InternalLedgerKey const& key) const
     {
         return iter->second;
     }
-    return mParent.getNewestVersion(key);
+
+    auto newest = mParent.getNewestVersion(key);
+    if (newest && !mCommutativeDeltas.empty() &&
+        key.type() == InternalLedgerEntryType::LEDGER_ENTRY)
+    {
+        auto deltaIter = mCommutativeDeltas.find(key.ledgerKey());
+        if (deltaIter != mCommutativeDeltas.end())
+        {
+            auto folded = std::make_shared<InternalLedgerEntry>(*newest);
+            applyCommutativeDelta(folded->ledgerEntry(), deltaIter->second);
+            return folded;
+        }
+    }
+    return newest;
 }
 
 UnorderedMap<LedgerKey, LedgerEntry>
@@ -1423,6 +1499,7 @@ LedgerTxn::Impl::load(LedgerTxn& self, InternalLedgerKey const& key)
     // exception safety guarantee. Furthermore, ltxe will be destructed leading
     // to key being deactivated. This will leave LedgerTxn unmodified.
     updateEntry(key, current);
+    dropCommutativeDelta(key);
     return ltxe;
 }
 
@@ -1659,6 +1736,83 @@ LedgerTxn::Impl::getSpeedexIOCOffers() {
     return mSpeedexIOCOrderbooks;
 }
 
+void
+LedgerTxn::addCommutativeBalanceDelta(LedgerKey const& key, int64_t delta)
+{
+    getImpl()->addCommutativeBalanceDelta(key, delta);
+}
+
+void
+LedgerTxn::Impl::addCommutativeBalanceDelta(LedgerKey const& key,
+                                            int64_t delta)
+{
+    throwIfSealed();
+    throwIfChild();
+
+    bool hasBalance =
+        key.type() == ACCOUNT ||
+        (key.type() == TRUSTLINE &&
+         key.trustLine().asset.type() != ASSET_TYPE_POOL_SHARE);
+    if (!hasBalance)
+    {
+        throw std::runtime_error("commutative delta on entry without balance");
+    }
+
+    InternalLedgerKey internalKey(key);
+    if (mActive.find(internalKey) != mActive.end())
+    {
+        throw std::runtime_error("Key is active");
+    }
+
+    recordCommutativeBalanceDelta(key, delta);
+}
+
+void
+LedgerTxn::Impl::recordCommutativeBalanceDelta(LedgerKey const& key,
+                                               int64_t delta)
+{
+    // Already recorded here, so there is no copy to save by deferring
+    InternalLedgerKey internalKey(key);
+    auto iter = mEntry.find(internalKey);
+    if (iter != mEntry.end())
+    {
+        if (!iter->second)
+        {
+            throw std::runtime_error("Key does not exist");
+        }
+        auto current = std::make_shared<InternalLedgerEntry>(*iter->second);
+        applyCommutativeDelta(current->ledgerEntry(), delta);
+        updateEntry(internalKey, current);
+        return;
+    }
+
+    auto deltaIter = mCommutativeDeltas.find(key);
+    if (deltaIter == mCommutativeDeltas.end())
+    {
+        mCommutativeDeltas.emplace(key, delta);
+        return;
+    }
+    int64_t total;
+    if (__builtin_add_overflow(deltaIter->second, delta, &total))
+    {
+        throw std::runtime_error("commutative balance delta overflow");
+    }
+    deltaIter->second = total;
+}
+
+UnorderedMap<LedgerKey, int64_t> const&
+LedgerTxn::getCommutativeBalanceDeltas() const
+{
+    return getImpl()->getCommutativeBalanceDeltas();
+}
+
+UnorderedMap<LedgerKey, int64_t> const&
+LedgerTxn::Impl::getCommutativeBalanceDeltas() const
+{
+    throwIfChild();
+    return mCommutativeDeltas;
+}
+
 std::vector<LedgerTxnEntry>
 LedgerTxn::loadPoolShareTrustLinesByAccountAndAsset(AccountID const& account,
                                                     Asset const& asset)
@@ -1758,6 +1912,7 @@ LedgerTxn::Impl::rollback()
     mSnapshots.clear();
     mMultiOrderBook.clear();
     mSpeedexIOCOrderbooks.clear();
+    mCommutativeDeltas.clear();
     mActive.clear();
     mActiveHeader.reset();
     mIsSealed = true;
@@ -1883,6 +2038,18 @@ LedgerTxn::Impl::getPrefetchHitRate() const
     return mParent.getPrefetchHitRate();
 }
 
+std::map<LedgerEntryType, EntryCacheLookups>
+LedgerTxn::getEntryCacheLookups() const
+{
+    return getImpl()->getEntryCacheLookups();
+}
+
+std::map<LedgerEntryType, EntryCacheLookups>
+LedgerTxn::Impl::getEntryCacheLookups() const
+{
+    return mParent.getEntryCacheLookups();
+}
+
 uint32_t
 LedgerTxn::prefetch(UnorderedSet<LedgerKey> const& keys)
 {
@@ -1923,6 +2090,40 @@ LedgerTxn::Impl::maybeUpdateLastModified() const
     return entries;
 }
 
+LedgerTxn::Impl::EntryMap
+LedgerTxn::Impl::foldCommutativeDeltas() const
+{
+    EntryMap entries;
+    entries.reserve(mCommutativeDeltas.size());
+    for (auto const& [key, delta] : mCommutativeDeltas)
+    {
+        auto previous = mParent.getNewestVersion(key);
+        if (!previous)
+        {
+            throw std::runtime_error(
+                "commutative balance delta on missing entry");
+        }
+        auto entry = std::make_shared<InternalLedgerEntry>(*previous);
+        applyCommutativeDelta(entry->ledgerEntry(), delta);
+        if (mShouldUpdateLastModified)
+        {
+            entry->ledgerEntry().lastModifiedLedgerSeq = mHeader->ledgerSeq;
+        }
+        entries.emplace(key, entry);
+    }
+    return entries;
+}
+
+void
+LedgerTxn::Impl::dropCommutativeDelta(InternalLedgerKey const& key) noexcept
+{
+    if (!mCommutativeDeltas.empty() &&
+        key.type() == InternalLedgerEntryType::LEDGER_ENTRY)
+    {
+        mCommutativeDeltas.erase(key.ledgerKey());
+    }
+}
+
 void
 LedgerTxn::Impl::maybeUpdateLastModifiedThenInvokeThenSeal(
     std::function<void(EntryMap const&)> f)
@@ -1932,12 +2133,26 @@ LedgerTxn::Impl::maybeUpdateLastModifiedThenInvokeThenSeal(
         // Invokes throwIfChild and throwIfSealed
         auto entries = maybeUpdateLastModified();
 
+        // A parent that is not a LedgerTxn can't take deltas, so they become
+        // ordinary entries here (keys in mCommutativeDeltas are not in mEntry)
+        if (!mParentTakesDeltas)
+        {
+            for (auto& kv : foldCommutativeDeltas())
+            {
+                entries.emplace(kv.first, std::move(kv.second));
+            }
+        }
+
         f(entries);
 
         // For associative containers, swap does not throw unless the exception
         // is thrown by the swap of the Compare object (which is of type
         // std::less<LedgerKey>, so this should not throw when swapped)
         mEntry.swap(entries);
+        if (!mParentTakesDeltas)
+        {
+            mCommutativeDeltas.clear();
+        }
 
         // std::multiset<...>::clear does not throw
         // std::set<...>::clear does not throw
@@ -2275,13 +2490,15 @@ LedgerTxn::Impl::WorstBestOfferIteratorImpl::clone() const
 size_t const LedgerTxnRoot::Impl::MIN_BEST_OFFERS_BATCH_SIZE = 5;
 
 LedgerTxnRoot::LedgerTxnRoot(Database& db, size_t entryCacheSize,
-                             size_t prefetchBatchSize
+                             size_t prefetchBatchSize,
+                             bool entryCacheWriteThrough
 #ifdef BEST_OFFER_DEBUGGING
                              ,
                              bool bestOfferDebuggingEnabled
 #endif
                              )
-    : mImpl(std::make_unique<Impl>(db, entryCacheSize, prefetchBatchSize
+    : mImpl(std::make_unique<Impl>(db, entryCacheSize, prefetchBatchSize,
+                                   entryCacheWriteThrough
 #ifdef BEST_OFFER_DEBUGGING
                                    ,
                                    bestOfferDebuggingEnabled
@@ -2291,7 +2508,8 @@ LedgerTxnRoot::LedgerTxnRoot(Database& db, size_t entryCacheSize,
 }
 
 LedgerTxnRoot::Impl::Impl(Database& db, size_t entryCacheSize,
-                          size_t prefetchBatchSize
+                          size_t prefetchBatchSize,
+                          bool entryCacheWriteThrough
 #ifdef BEST_OFFER_DEBUGGING
                           ,
                           bool bestOfferDebuggingEnabled
@@ -2304,6 +2522,7 @@ LedgerTxnRoot::Impl::Impl(Database& db, size_t entryCacheSize,
     , mHeader(std::make_unique<LedgerHeader>())
     , mEntryCache(entryCacheSize)
     , mSnapshotCache(entryCacheSize)
+    , mEntryCacheWriteThrough(entryCacheWriteThrough)
     , mBulkLoadBatchSize(prefetchBatchSize)
     , mChild(nullptr)
 #ifdef BEST_OFFER_DEBUGGING
@@ -2430,91 +2649,100 @@ BulkLedgerEntryChangeAccumulator::accumulate(EntryIterator const& iter)
 void
 LedgerTxnRoot::Impl::bulkApply(BulkLedgerEntryChangeAccumulator& bleca,
                                size_t bufferThreshold,
-                               LedgerTxnConsistency cons)
+                               LedgerTxnConsistency cons,
+                               soci::session& session, bool updateCaches)
 {
+    auto writeThrough = [&](std::vector<EntryIterator>& entries) {
+        if (updateCaches && mEntryCacheWriteThrough)
+        {
+            writeThroughToCaches(entries);
+        }
+        entries.clear();
+    };
+
     auto& upsertAccounts = bleca.getAccountsToUpsert();
     if (upsertAccounts.size() > bufferThreshold)
     {
-        bulkUpsertAccounts(upsertAccounts);
-        upsertAccounts.clear();
+        bulkUpsertAccounts(upsertAccounts, session);
+        writeThrough(upsertAccounts);
     }
     auto& deleteAccounts = bleca.getAccountsToDelete();
     if (deleteAccounts.size() > bufferThreshold)
     {
-        bulkDeleteAccounts(deleteAccounts, cons);
-        deleteAccounts.clear();
+        bulkDeleteAccounts(deleteAccounts, cons, session);
+        writeThrough(deleteAccounts);
     }
     auto& upsertTrustLines = bleca.getTrustLinesToUpsert();
     if (upsertTrustLines.size() > bufferThreshold)
     {
-        bulkUpsertTrustLines(upsertTrustLines);
-        upsertTrustLines.clear();
+        bulkUpsertTrustLines(upsertTrustLines, session);
+        writeThrough(upsertTrustLines);
     }
     auto& deleteTrustLines = bleca.getTrustLinesToDelete();
     if (deleteTrustLines.size() > bufferThreshold)
     {
-        bulkDeleteTrustLines(deleteTrustLines, cons);
-        deleteTrustLines.clear();
+        bulkDeleteTrustLines(deleteTrustLines, cons, session);
+        writeThrough(deleteTrustLines);
     }
     auto& upsertOffers = bleca.getOffersToUpsert();
     if (upsertOffers.size() > bufferThreshold)
     {
-        bulkUpsertOffers(upsertOffers);
-        upsertOffers.clear();
+        bulkUpsertOffers(upsertOffers, session);
+        writeThrough(upsertOffers);
     }
     auto& deleteOffers = bleca.getOffersToDelete();
     if (deleteOffers.size() > bufferThreshold)
     {
-        bulkDeleteOffers(deleteOffers, cons);
-        deleteOffers.clear();
+        bulkDeleteOffers(deleteOffers, cons, session);
+        writeThrough(deleteOffers);
     }
     auto& upsertAccountData = bleca.getAccountDataToUpsert();
     if (upsertAccountData.size() > bufferThreshold)
     {
-        bulkUpsertAccountData(upsertAccountData);
-        upsertAccountData.clear();
+        bulkUpsertAccountData(upsertAccountData, session);
+        writeThrough(upsertAccountData);
     }
     auto& deleteAccountData = bleca.getAccountDataToDelete();
     if (deleteAccountData.size() > bufferThreshold)
     {
-        bulkDeleteAccountData(deleteAccountData, cons);
-        deleteAccountData.clear();
+        bulkDeleteAccountData(deleteAccountData, cons, session);
+        writeThrough(deleteAccountData);
     }
     auto& upsertClaimableBalance = bleca.getClaimableBalanceToUpsert();
     if (upsertClaimableBalance.size() > bufferThreshold)
     {
-        bulkUpsertClaimableBalance(upsertClaimableBalance);
-        upsertClaimableBalance.clear();
+        bulkUpsertClaimableBalance(upsertClaimableBalance, session);
+        writeThrough(upsertClaimableBalance);
     }
     auto& deleteClaimableBalance = bleca.getClaimableBalanceToDelete();
     if (deleteClaimableBalance.size() > bufferThreshold)
     {
-        bulkDeleteClaimableBalance(deleteClaimableBalance, cons);
-        deleteClaimableBalance.clear();
+        bulkDeleteClaimableBalance(deleteClaimableBalance, cons, session);
+        writeThrough(deleteClaimableBalance);
     }
     auto& upsertLiquidityPool = bleca.getLiquidityPoolToUpsert();
     if (upsertLiquidityPool.size() > bufferThreshold)
     {
-        bulkUpsertLiquidityPool(upsertLiquidityPool);
-        upsertLiquidityPool.clear();
+        bulkUpsertLiquidityPool(upsertLiquidityPool, session);
+        writeThrough(upsertLiquidityPool);
     }
     auto& deleteLiquidityPool = bleca.getLiquidityPoolToDelete();
     if (deleteLiquidityPool.size() > bufferThreshold)
     {
-        bulkDeleteLiquidityPool(deleteLiquidityPool, cons);
-        deleteLiquidityPool.clear();
+        bulkDeleteLiquidityPool(deleteLiquidityPool, cons, session);
+        writeThrough(deleteLiquidityPool);
     }
     auto& upsertSpeedexConfig = bleca.getSpeedexConfigToUpsert();
     if (upsertSpeedexConfig.size() > bufferThreshold)
     {
-        bulkUpsertSpeedexConfig(upsertSpeedexConfig);
-        upsertSpeedexConfig.clear();
+        bulkUpsertSpeedexConfig(upsertSpeedexConfig, session);
+        writeThrough(upsertSpeedexConfig);
     }
     auto& deleteSpeedexConfig = bleca.getSpeedexConfigToDelete();
     if (deleteSpeedexConfig.size() > bufferThreshold)
     {
-        bulkDeleteSpeedexConfig(deleteSpeedexConfig, cons);
-        deleteSpeedexConfig.clear();
+        bulkDeleteSpeedexConfig(deleteSpeedexConfig, cons, session);
+        writeThrough(deleteSpeedexConfig);
     }
 }
 
@@ -2537,7 +2765,8 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
             ++counter;
             size_t bufferThreshold =
                 (bool)iter ? LEDGER_ENTRY_BATCH_COMMIT_SIZE : 0;
-            bulkApply(bleca, bufferThreshold, cons);
+            bulkApply(bleca, bufferThreshold, cons, mDatabase.getSession(),
+                      true);
         }
 
         // FIXME: there is no medida histogram for this presently,
@@ -2566,8 +2795,11 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
 
     // Clearing the cache does not throw
     mBestOffers.clear();
-    mEntryCache.clear();
-    mSnapshotCache.clear();
+    if (!mEntryCacheWriteThrough)
+    {
+        mEntryCache.clear();
+        mSnapshotCache.clear();
+    }
 
     // std::unique_ptr<...>::reset does not throw
     mTransaction.reset();
@@ -2578,6 +2810,7 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
 
     mPrefetchHits = 0;
     mPrefetchMisses = 0;
+    mEntryCacheLookups.clear();
 }
 
 std::string
@@ -2656,8 +2889,9 @@ LedgerTxnRoot::Impl::deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const
 {
     using namespace soci;
     throwIfChild();
-    mEntryCache.clear();
-    mBestOffers.clear();
+    // The snapshot cache survives commits in write-through mode, so it has to
+    // go along with the others or it would serve the deleted entries.
+    clearAllCaches();
 
     for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
     {
@@ -2722,15 +2956,17 @@ LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
     ZoneScoped;
     uint32_t total = 0;
 
-    UnorderedSet<LedgerKey> accounts;
-    UnorderedSet<LedgerKey> offers;
-    UnorderedSet<LedgerKey> trustlines;
-    UnorderedSet<LedgerKey> data;
-    UnorderedSet<LedgerKey> claimablebalance;
-    UnorderedSet<LedgerKey> liquiditypool;
-    UnorderedSet<LedgerKey> speedexConfig;
+    UnorderedSet<LedgerKey> toLoad;
+    for (auto const& key : keys)
+    {
+        if (!mEntryCache.exists(key, false))
+        {
+            toLoad.insert(key);
+        }
+    }
 
-    auto cacheResult =
+    bulkLoadInBatches(
+        toLoad, mDatabase.getSession(),
         [&](UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
                 res) {
             for (auto const& item : res)
@@ -2738,91 +2974,247 @@ LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
                 putInEntryCache(item.first, item.second, LoadType::PREFETCH);
                 ++total;
             }
-        };
+        });
 
-    auto insertIfNotLoaded = [&](UnorderedSet<LedgerKey>& keys,
-                                 LedgerKey const& key) {
-        if (!mEntryCache.exists(key, false))
-        {
-            keys.insert(key);
-        }
-    };
+    return total;
+}
+
+void
+LedgerTxnRoot::Impl::bulkLoadInBatches(
+    UnorderedSet<LedgerKey> const& keys, soci::session& session,
+    std::function<void(UnorderedMap<LedgerKey, std::shared_ptr<
+                           LedgerEntry const>> const&)> const& onLoaded) const
+{
+    UnorderedSet<LedgerKey> accounts;
+    UnorderedSet<LedgerKey> offers;
+    UnorderedSet<LedgerKey> trustlines;
+    UnorderedSet<LedgerKey> data;
+    UnorderedSet<LedgerKey> claimablebalance;
+    UnorderedSet<LedgerKey> liquiditypool;
+    UnorderedSet<LedgerKey> speedexConfig;
 
     for (auto const& key : keys)
     {
         switch (key.type())
         {
         case ACCOUNT:
-            insertIfNotLoaded(accounts, key);
+            accounts.insert(key);
             if (accounts.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadAccounts(accounts));
+                onLoaded(bulkLoadAccounts(accounts, session));
                 accounts.clear();
             }
             break;
         case OFFER:
-            insertIfNotLoaded(offers, key);
+            offers.insert(key);
             if (offers.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadOffers(offers));
+                onLoaded(bulkLoadOffers(offers, session));
                 offers.clear();
             }
             break;
         case TRUSTLINE:
-            insertIfNotLoaded(trustlines, key);
+            trustlines.insert(key);
             if (trustlines.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadTrustLines(trustlines));
+                onLoaded(bulkLoadTrustLines(trustlines, session));
                 trustlines.clear();
             }
             break;
         case DATA:
-            insertIfNotLoaded(data, key);
+            data.insert(key);
             if (data.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadData(data));
+                onLoaded(bulkLoadData(data, session));
                 data.clear();
             }
             break;
         case CLAIMABLE_BALANCE:
-            insertIfNotLoaded(claimablebalance, key);
+            claimablebalance.insert(key);
             if (claimablebalance.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadClaimableBalance(claimablebalance));
+                onLoaded(bulkLoadClaimableBalance(claimablebalance, session));
                 claimablebalance.clear();
             }
             break;
         case LIQUIDITY_POOL:
-            insertIfNotLoaded(liquiditypool, key);
+            liquiditypool.insert(key);
             if (liquiditypool.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadLiquidityPool(liquiditypool));
+                onLoaded(bulkLoadLiquidityPool(liquiditypool, session));
                 liquiditypool.clear();
             }
             break;
         case SPEEDEX_CONFIG:
-            insertIfNotLoaded(speedexConfig, key);
+            speedexConfig.insert(key);
             if (speedexConfig.size() == mBulkLoadBatchSize)
             {
-                cacheResult(bulkLoadSpeedexConfig(speedexConfig));
+                onLoaded(bulkLoadSpeedexConfig(speedexConfig, session));
                 speedexConfig.clear();
             }
             break;
         }
     }
 
-    //  Prefetch whatever is remaining
-    cacheResult(bulkLoadAccounts(accounts));
-    cacheResult(bulkLoadOffers(offers));
-    cacheResult(bulkLoadTrustLines(trustlines));
-    cacheResult(bulkLoadData(data));
-    cacheResult(bulkLoadClaimableBalance(claimablebalance));
-    cacheResult(bulkLoadLiquidityPool(liquiditypool));
-    cacheResult(bulkLoadSpeedexConfig(speedexConfig));
+    //  Load whatever is remaining
+    onLoaded(bulkLoadAccounts(accounts, session));
+    onLoaded(bulkLoadOffers(offers, session));
+    onLoaded(bulkLoadTrustLines(trustlines, session));
+    onLoaded(bulkLoadData(data, session));
+    onLoaded(bulkLoadClaimableBalance(claimablebalance, session));
+    onLoaded(bulkLoadLiquidityPool(liquiditypool, session));
+    onLoaded(bulkLoadSpeedexConfig(speedexConfig, session));
+}
+
+UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
+LedgerTxnRoot::loadEntriesOnSession(UnorderedSet<LedgerKey> const& keys,
+                                    soci::session& session) const
+{
+    return mImpl->loadEntriesOnSession(keys, session);
+}
 
+UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
+LedgerTxnRoot::Impl::loadEntriesOnSession(UnorderedSet<LedgerKey> const& keys,
+                                          soci::session& session) const
+{
+    ZoneScoped;
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> entries;
+    bulkLoadInBatches(
+        keys, session,
+        [&](UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+                res) { entries.insert(res.begin(), res.end()); });
+    return entries;
+}
+
+uint32_t
+LedgerTxnRoot::addPrefetchedEntries(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const& entries)
+{
+    return mImpl->addPrefetchedEntries(entries);
+}
+
+uint32_t
+LedgerTxnRoot::Impl::addPrefetchedEntries(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const& entries)
+{
+    ZoneScoped;
+    uint32_t total = 0;
+    for (auto const& [key, entry] : entries)
+    {
+        if (!mEntryCache.exists(key, false))
+        {
+            putInEntryCache(key, entry, LoadType::PREFETCH);
+            ++total;
+        }
+    }
     return total;
 }
 
+namespace
+{
+// Iterates over entries held in a vector, so that the bulk operations can
+// write them outside of a commit.
+class EntryVectorIteratorImpl : public EntryIterator::AbstractImpl
+{
+    typedef std::vector<std::pair<InternalLedgerKey,
+                                  std::shared_ptr<InternalLedgerEntry>>>
+        EntryVector;
+    typedef EntryVector::const_iterator IteratorType;
+    IteratorType mIter;
+    IteratorType const mEnd;
+
+  public:
+    EntryVectorIteratorImpl(IteratorType const& begin, IteratorType const& end)
+        : mIter(begin), mEnd(end)
+    {
+    }
+
+    void
+    advance() override
+    {
+        ++mIter;
+    }
+
+    bool
+    atEnd() const override
+    {
+        return mIter == mEnd;
+    }
+
+    InternalLedgerEntry const&
+    entry() const override
+    {
+        return *(mIter->second);
+    }
+
+    bool
+    entryExists() const override
+    {
+        return (bool)(mIter->second);
+    }
+
+    InternalLedgerKey const&
+    key() const override
+    {
+        return mIter->first;
+    }
+
+    std::unique_ptr<EntryIterator::AbstractImpl>
+    clone() const override
+    {
+        return std::make_unique<EntryVectorIteratorImpl>(mIter, mEnd);
+    }
+};
+}
+
+void
+LedgerTxnRoot::writeEntriesOnSession(std::vector<LedgerEntry> const& entries,
+                                     std::vector<LedgerKey> const& deletedKeys,
+                                     soci::session& session)
+{
+    mImpl->writeEntriesOnSession(entries, deletedKeys, session);
+}
+
+void
+LedgerTxnRoot::Impl::writeEntriesOnSession(
+    std::vector<LedgerEntry> const& entries,
+    std::vector<LedgerKey> const& deletedKeys, soci::session& session)
+{
+    ZoneScoped;
+    std::vector<
+        std::pair<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry>>>
+        changes;
+    changes.reserve(entries.size() + deletedKeys.size());
+    for (auto const& le : entries)
+    {
+        // The current speedex config lives in the root, not in the database
+        releaseAssert(le.data.type() != SPEEDEX_CONFIG);
+        changes.emplace_back(LedgerEntryKey(le),
+                             std::make_shared<InternalLedgerEntry>(le));
+    }
+    for (auto const& key : deletedKeys)
+    {
+        releaseAssert(key.type() != SPEEDEX_CONFIG);
+        changes.emplace_back(key, nullptr);
+    }
+
+    BulkLedgerEntryChangeAccumulator bleca;
+    EntryIterator iter(
+        std::make_unique<EntryVectorIteratorImpl>(changes.cbegin(),
+                                                  changes.cend()));
+    for (; (bool)iter; ++iter)
+    {
+        bleca.accumulate(iter);
+    }
+    bulkApply(bleca, 0, LedgerTxnConsistency::EXTRA_DELETES, session, false);
+}
+
+void
+LedgerTxnRoot::clearAllCaches()
+{
+    mImpl->clearAllCaches();
+}
+
 double
 LedgerTxnRoot::getPrefetchHitRate() const
 {
@@ -2840,6 +3232,18 @@ LedgerTxnRoot::Impl::getPrefetchHitRate() const
            (mPrefetchMisses + mPrefetchHits);
 }
 
+std::map<LedgerEntryType, EntryCacheLookups>
+LedgerTxnRoot::getEntryCacheLookups() const
+{
+    return mImpl->getEntryCacheLookups();
+}
+
+std::map<LedgerEntryType, EntryCacheLookups>
+LedgerTxnRoot::Impl::getEntryCacheLookups() const
+{
+    return mEntryCacheLookups;
+}
+
 UnorderedMap<LedgerKey, LedgerEntry>
 LedgerTxnRoot::getAllOffers()
 {
@@ -3279,12 +3683,14 @@ LedgerTxnRoot::Impl::getNewestVersion(InternalLedgerKey const& gkey) const
     {
         std::string zoneTxt("hit");
         ZoneText(zoneTxt.c_str(), zoneTxt.size());
+        ++mEntryCacheLookups[key.type()].hits;
         return getFromEntryCache(key);
     }
     else
     {
         std::string zoneTxt("miss");
         ZoneText(zoneTxt.c_str(), zoneTxt.size());
+        ++mEntryCacheLookups[key.type()].misses;
         ++mPrefetchMisses;
     }
 
@@ -3462,6 +3868,7 @@ LedgerTxnRoot::Impl::rollbackChild()
     mChild = nullptr;
     mPrefetchHits = 0;
     mPrefetchMisses = 0;
+    mEntryCacheLookups.clear();
 }
 
 std::shared_ptr<InternalLedgerEntry const>
@@ -3521,6 +3928,27 @@ LedgerTxnRoot::Impl::putInEntryCache(
     }
 }
 
+void
+LedgerTxnRoot::Impl::writeThroughToCaches(
+    std::vector<EntryIterator> const& entries) const
+{
+    for (auto const& e : entries)
+    {
+        auto const& key = e.key().ledgerKey();
+        std::shared_ptr<LedgerEntry const> entry;
+        if (e.entryExists())
+        {
+            entry =
+                std::make_shared<LedgerEntry const>(e.entry().ledgerEntry());
+        }
+        // Committed entries count as prefetched: they are in the cache
+        // ahead of any load. Deleted entries are cached as null in both
+        // caches.
+        putInEntryCache(key, entry, LoadType::PREFETCH);
+        putInSnapshotCache(key, entry);
+    }
+}
+
 void
 LedgerTxnRoot::Impl::putInSnapshotCache(
     LedgerKey const& key, std::shared_ptr<LedgerEntry const> const& entry) const
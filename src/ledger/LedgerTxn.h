@@ -174,6 +174,11 @@
 //    accesses to a parent's entries when a child is open.
 //
 
+namespace soci
+{
+class session;
+}
+
 namespace stellar
 {
 
@@ -249,6 +254,13 @@ struct InflationWinner
     int64_t votes;
 };
 
+// Lookups of the LedgerTxnRoot entry cache for one LedgerEntryType.
+struct EntryCacheLookups
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
+
 class AbstractLedgerTxn;
 
 // LedgerTxnDelta represents the difference between a LedgerTxn and its
@@ -456,6 +468,12 @@ class AbstractLedgerTxnParent
     // (real or stub) root LedgerTxn.
     virtual double getPrefetchHitRate() const = 0;
 
+    // Return the entry cache hits and misses, by LedgerEntryType, since the
+    // root last committed or rolled back a child. Will throw when called on
+    // anything other than a (real or stub) root LedgerTxn.
+    virtual std::map<LedgerEntryType, EntryCacheLookups>
+    getEntryCacheLookups() const = 0;
+
     // Prefetch a set of ledger entries into memory, anticipating their use.
     // This is purely advisory and can be a no-op, or do any level of actual
     // work, while still being correct. Will throw when called on anything other
@@ -607,6 +625,29 @@ class AbstractLedgerTxn : public AbstractLedgerTxnParent
     getSpeedexIOCOffers() = 0;
 
     virtual void addSpeedexIOCOffer(AssetPair assetPair, const IOCOffer& offer) = 0;
+
+    // addCommutativeBalanceDelta adds delta to the balance of the account or
+    // (non pool share) trust line with the given key, which must exist,
+    // without loading it. Pending deltas are visible through
+    // getNewestVersion, are folded into the entry when it is next loaded,
+    // created or erased in this AbstractLedgerTxn, and are handed to the
+    // parent on commit if the parent is a LedgerTxn (or folded into the
+    // committed entries otherwise). This lets many commutative payments
+    // credit the same hot entry without each of them copying it through
+    // every nested LedgerTxn.
+    //
+    // The caller is responsible for checking that the new balance is valid
+    // for the entry (limits, liabilities); this only checks for overflow.
+    // Throws if the AbstractLedgerTxn is sealed, has a child, or if key is
+    // active.
+    virtual void addCommutativeBalanceDelta(LedgerKey const& key,
+                                            int64_t delta) = 0;
+
+    // Returns the deltas recorded by addCommutativeBalanceDelta that have not
+    // been folded into entries. Throws if the AbstractLedgerTxn has a child.
+    virtual UnorderedMap<LedgerKey, int64_t> const&
+    getCommutativeBalanceDeltas() const = 0;
+
     // Loads every pool share trust line owned by the specified account that
     // contains the specified asset. This function is built on top of load, so
     // it shares many properties with that function.
@@ -705,6 +746,11 @@ class LedgerTxn : public AbstractLedgerTxn
 
     void addSpeedexIOCOffer(AssetPair assetPair, const IOCOffer& offer) override;
 
+    void addCommutativeBalanceDelta(LedgerKey const& key,
+                                    int64_t delta) override;
+
+    UnorderedMap<LedgerKey, int64_t> const&
+    getCommutativeBalanceDeltas() const override;
 
     std::shared_ptr<const LedgerEntry>
     loadSnapshotEntry(LedgerKey const& key) const override;
@@ -749,6 +795,8 @@ class LedgerTxn : public AbstractLedgerTxn
     void dropLiquidityPools() override;
     void dropSpeedexConfigs() override;
     double getPrefetchHitRate() const override;
+    std::map<LedgerEntryType, EntryCacheLookups>
+    getEntryCacheLookups() const override;
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
 
     bool hasSponsorshipEntry() const override;
@@ -779,8 +827,12 @@ class LedgerTxnRoot : public AbstractLedgerTxnParent
     std::unique_ptr<Impl> const mImpl;
 
   public:
+    // With entryCacheWriteThrough, commitChild writes committed entries
+    // through to the entry cache instead of clearing it, so the cache keeps
+    // hot entries across ledgers.
     explicit LedgerTxnRoot(Database& db, size_t entryCacheSize,
-                           size_t prefetchBatchSize
+                           size_t prefetchBatchSize,
+                           bool entryCacheWriteThrough
 #ifdef BEST_OFFER_DEBUGGING
                            ,
                            bool bestOfferDebuggingEnabled
@@ -844,6 +896,37 @@ class LedgerTxnRoot : public AbstractLedgerTxnParent
 
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
     double getPrefetchHitRate() const override;
+    std::map<LedgerEntryType, EntryCacheLookups>
+    getEntryCacheLookups() const override;
+
+    // Loads the entries for keys through session, touching no caches, and
+    // maps missing entries to null. Safe to call from another thread with
+    // its own session; a commit running concurrently may or may not be
+    // visible in the result.
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
+    loadEntriesOnSession(UnorderedSet<LedgerKey> const& keys,
+                         soci::session& session) const;
+
+    // Puts entries loaded by loadEntriesOnSession, which the caller knows are
+    // still current, into the entry cache as if prefetched, unless already
+    // cached. Returns the number of entries added.
+    uint32_t addPrefetchedEntries(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries);
+
+    // Writes entries, and deletes the entries of deletedKeys if they exist,
+    // straight to the database through session, touching no caches. Meant for
+    // loading ledger state in bulk, e.g. applying buckets: it may be called
+    // from other threads with their own sessions for disjoint keys, as long
+    // as the root doesn't commit meanwhile, and clearAllCaches should be
+    // called once the writes are done. SPEEDEX_CONFIG entries, which the root
+    // keeps in memory, can only be written through a commit.
+    void writeEntriesOnSession(std::vector<LedgerEntry> const& entries,
+                               std::vector<LedgerKey> const& deletedKeys,
+                               soci::session& session);
+
+    // Drops all cached entries and offers.
+    void clearAllCaches();
 
 #ifdef BEST_OFFER_DEBUGGING
     bool bestOfferDebuggingEnabled() const override;
@@ -132,6 +132,7 @@ LedgerTxnRoot::Impl::loadInflationWinners(size_t maxWinners,
 class BulkUpsertAccountsOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<int64_t> mBalances;
     std::vector<int64_t> mSeqNums;
@@ -150,8 +151,9 @@ class BulkUpsertAccountsOperation : public DatabaseTypeSpecificOperation<void>
 
   public:
     BulkUpsertAccountsOperation(Database& DB,
-                                std::vector<EntryIterator> const& entries)
-        : mDB(DB)
+                                std::vector<EntryIterator> const& entries,
+                                soci::session& session)
+        : mDB(DB), mSession(session)
     {
         mAccountIDs.reserve(entries.size());
         mBalances.reserve(entries.size());
@@ -249,7 +251,7 @@ class BulkUpsertAccountsOperation : public DatabaseTypeSpecificOperation<void>
             "lastmodified = excluded.lastmodified, "
             "extension = excluded.extension, "
             "ledgerext = excluded.ledgerext";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mAccountIDs));
         st.exchange(soci::use(mBalances));
@@ -336,7 +338,7 @@ class BulkUpsertAccountsOperation : public DatabaseTypeSpecificOperation<void>
                           "lastmodified = excluded.lastmodified, "
                           "extension = excluded.extension, "
                           "ledgerext = excluded.ledgerext";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strBalances));
@@ -367,12 +369,14 @@ class BulkDeleteAccountsOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
 
   public:
     BulkDeleteAccountsOperation(Database& DB, LedgerTxnConsistency cons,
-                                std::vector<EntryIterator> const& entries)
-        : mDB(DB), mCons(cons)
+                                std::vector<EntryIterator> const& entries,
+                                soci::session& session)
+        : mDB(DB), mCons(cons), mSession(session)
     {
         for (auto const& e : entries)
         {
@@ -389,7 +393,7 @@ class BulkDeleteAccountsOperation : public DatabaseTypeSpecificOperation<void>
     doSociGenericOperation()
     {
         std::string sql = "DELETE FROM accounts WHERE accountid = :id";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mAccountIDs));
         st.define_and_bind();
@@ -420,7 +424,7 @@ class BulkDeleteAccountsOperation : public DatabaseTypeSpecificOperation<void>
         std::string sql =
             "WITH r AS (SELECT unnest(:ids::TEXT[])) "
             "DELETE FROM accounts WHERE accountid IN (SELECT * FROM r)";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.define_and_bind();
@@ -439,22 +443,23 @@ class BulkDeleteAccountsOperation : public DatabaseTypeSpecificOperation<void>
 
 void
 LedgerTxnRoot::Impl::bulkUpsertAccounts(
-    std::vector<EntryIterator> const& entries)
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertAccountsOperation op(mDatabase, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkUpsertAccountsOperation op(mDatabase, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
 LedgerTxnRoot::Impl::bulkDeleteAccounts(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteAccountsOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkDeleteAccountsOperation op(mDatabase, cons, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
@@ -499,6 +504,7 @@ class BulkLoadAccountsOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
 
     std::vector<LedgerEntry>
@@ -586,8 +592,9 @@ class BulkLoadAccountsOperation
     }
 
   public:
-    BulkLoadAccountsOperation(Database& db, UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+    BulkLoadAccountsOperation(Database& db, UnorderedSet<LedgerKey> const& keys,
+                              soci::session& session)
+        : mDb(db), mSession(session)
     {
         mAccountIDs.reserve(keys.size());
         for (auto const& k : keys)
@@ -614,7 +621,7 @@ class BulkLoadAccountsOperation
             " FROM accounts "
             "WHERE accountid IN carray(?, ?, 'char*')";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto be = prep.statement().get_backend();
         if (be == nullptr)
         {
@@ -645,7 +652,7 @@ class BulkLoadAccountsOperation
             " FROM accounts "
             "WHERE accountid IN (SELECT * FROM r)";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         return executeAndFetch(st);
@@ -654,15 +661,16 @@ class BulkLoadAccountsOperation
 };
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-LedgerTxnRoot::Impl::bulkLoadAccounts(UnorderedSet<LedgerKey> const& keys) const
+LedgerTxnRoot::Impl::bulkLoadAccounts(
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(keys.size()));
     if (!keys.empty())
     {
-        BulkLoadAccountsOperation op(mDatabase, keys);
+        BulkLoadAccountsOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
@@ -41,6 +41,7 @@ class BulkLoadClaimableBalanceOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mBalanceIDs;
 
     std::vector<LedgerEntry>
@@ -72,8 +73,9 @@ class BulkLoadClaimableBalanceOperation
 
   public:
     BulkLoadClaimableBalanceOperation(Database& db,
-                                      UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+                                      UnorderedSet<LedgerKey> const& keys,
+                                      soci::session& session)
+        : mDb(db), mSession(session)
     {
         mBalanceIDs.reserve(keys.size());
         for (auto const& k : keys)
@@ -99,7 +101,7 @@ class BulkLoadClaimableBalanceOperation
                           "FROM claimablebalance "
                           "WHERE balanceid IN r";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto be = prep.statement().get_backend();
         if (be == nullptr)
         {
@@ -127,7 +129,7 @@ class BulkLoadClaimableBalanceOperation
                           "FROM claimablebalance "
                           "WHERE balanceid IN (SELECT * from r)";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strBalanceIDs));
         return executeAndFetch(st);
@@ -137,13 +139,13 @@ class BulkLoadClaimableBalanceOperation
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
 LedgerTxnRoot::Impl::bulkLoadClaimableBalance(
-    UnorderedSet<LedgerKey> const& keys) const
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     if (!keys.empty())
     {
-        BulkLoadClaimableBalanceOperation op(mDatabase, keys);
+        BulkLoadClaimableBalanceOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
@@ -156,13 +158,14 @@ class BulkDeleteClaimableBalanceOperation
 {
     Database& mDb;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
     std::vector<std::string> mBalanceIDs;
 
   public:
     BulkDeleteClaimableBalanceOperation(
         Database& db, LedgerTxnConsistency cons,
-        std::vector<EntryIterator> const& entries)
-        : mDb(db), mCons(cons)
+        std::vector<EntryIterator> const& entries, soci::session& session)
+        : mDb(db), mCons(cons), mSession(session)
     {
         mBalanceIDs.reserve(entries.size());
         for (auto const& e : entries)
@@ -178,7 +181,7 @@ class BulkDeleteClaimableBalanceOperation
     doSociGenericOperation()
     {
         std::string sql = "DELETE FROM claimablebalance WHERE balanceid = :id";
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(mBalanceIDs));
         st.define_and_bind();
@@ -210,7 +213,7 @@ class BulkDeleteClaimableBalanceOperation
                           "DELETE FROM claimablebalance "
                           "WHERE balanceid IN (SELECT * FROM r)";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strBalanceIDs));
         st.define_and_bind();
@@ -229,16 +232,18 @@ class BulkDeleteClaimableBalanceOperation
 
 void
 LedgerTxnRoot::Impl::bulkDeleteClaimableBalance(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
-    BulkDeleteClaimableBalanceOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkDeleteClaimableBalanceOperation op(mDatabase, cons, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 class BulkUpsertClaimableBalanceOperation
     : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mBalanceIDs;
     std::vector<std::string> mClaimableBalanceEntrys;
     std::vector<int32_t> mLastModifieds;
@@ -256,8 +261,9 @@ class BulkUpsertClaimableBalanceOperation
 
   public:
     BulkUpsertClaimableBalanceOperation(
-        Database& Db, std::vector<EntryIterator> const& entryIter)
-        : mDb(Db)
+        Database& Db, std::vector<EntryIterator> const& entryIter,
+        soci::session& session)
+        : mDb(Db), mSession(session)
     {
         for (auto const& e : entryIter)
         {
@@ -278,7 +284,7 @@ class BulkUpsertClaimableBalanceOperation
                           "excluded.ledgerentry, lastmodified = "
                           "excluded.lastmodified";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mBalanceIDs));
         st.exchange(soci::use(mClaimableBalanceEntrys));
@@ -323,7 +329,7 @@ class BulkUpsertClaimableBalanceOperation
                           "excluded.ledgerentry, "
                           "lastmodified = excluded.lastmodified";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strBalanceIDs));
         st.exchange(soci::use(strClaimableBalanceEntry));
@@ -343,10 +349,10 @@ class BulkUpsertClaimableBalanceOperation
 
 void
 LedgerTxnRoot::Impl::bulkUpsertClaimableBalance(
-    std::vector<EntryIterator> const& entries)
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
-    BulkUpsertClaimableBalanceOperation op(mDatabase, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkUpsertClaimableBalanceOperation op(mDatabase, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
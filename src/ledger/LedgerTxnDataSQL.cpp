@@ -72,6 +72,7 @@ LedgerTxnRoot::Impl::loadData(LedgerKey const& key) const
 class BulkUpsertDataOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<std::string> mDataNames;
     std::vector<std::string> mDataValues;
@@ -97,8 +98,9 @@ class BulkUpsertDataOperation : public DatabaseTypeSpecificOperation<void>
 
   public:
     BulkUpsertDataOperation(Database& DB,
-                            std::vector<LedgerEntry> const& entries)
-        : mDB(DB)
+                            std::vector<LedgerEntry> const& entries,
+                            soci::session& session)
+        : mDB(DB), mSession(session)
     {
         for (auto const& e : entries)
         {
@@ -107,8 +109,9 @@ class BulkUpsertDataOperation : public DatabaseTypeSpecificOperation<void>
     }
 
     BulkUpsertDataOperation(Database& DB,
-                            std::vector<EntryIterator> const& entryIter)
-        : mDB(DB)
+                            std::vector<EntryIterator> const& entryIter,
+                            soci::session& session)
+        : mDB(DB), mSession(session)
     {
         for (auto const& e : entryIter)
         {
@@ -133,7 +136,7 @@ class BulkUpsertDataOperation : public DatabaseTypeSpecificOperation<void>
             "lastmodified = excluded.lastmodified, "
             "extension = excluded.extension, "
             "ledgerext = excluded.ledgerext";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mAccountIDs));
         st.exchange(soci::use(mDataNames));
@@ -189,7 +192,7 @@ class BulkUpsertDataOperation : public DatabaseTypeSpecificOperation<void>
             "lastmodified = excluded.lastmodified, "
             "extension = excluded.extension, "
             "ledgerext = excluded.ledgerext";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strDataNames));
@@ -214,13 +217,15 @@ class BulkDeleteDataOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<std::string> mDataNames;
 
   public:
     BulkDeleteDataOperation(Database& DB, LedgerTxnConsistency cons,
-                            std::vector<EntryIterator> const& entries)
-        : mDB(DB), mCons(cons)
+                            std::vector<EntryIterator> const& entries,
+                            soci::session& session)
+        : mDB(DB), mCons(cons), mSession(session)
     {
         for (auto const& e : entries)
         {
@@ -239,7 +244,7 @@ class BulkDeleteDataOperation : public DatabaseTypeSpecificOperation<void>
     {
         std::string sql = "DELETE FROM accountdata WHERE accountid = :id AND "
                           " dataname = :v1 ";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mAccountIDs));
         st.exchange(soci::use(mDataNames));
@@ -277,7 +282,7 @@ class BulkDeleteDataOperation : public DatabaseTypeSpecificOperation<void>
             " ) "
             "DELETE FROM accountdata WHERE (accountid, dataname) IN "
             "(SELECT * FROM r)";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strDataNames));
@@ -297,22 +302,23 @@ class BulkDeleteDataOperation : public DatabaseTypeSpecificOperation<void>
 
 void
 LedgerTxnRoot::Impl::bulkUpsertAccountData(
-    std::vector<EntryIterator> const& entries)
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertDataOperation op(mDatabase, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkUpsertDataOperation op(mDatabase, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
 LedgerTxnRoot::Impl::bulkDeleteAccountData(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteDataOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkDeleteDataOperation op(mDatabase, cons, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
@@ -350,6 +356,7 @@ class BulkLoadDataOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<std::string> mDataNames;
 
@@ -398,8 +405,9 @@ class BulkLoadDataOperation
     }
 
   public:
-    BulkLoadDataOperation(Database& db, UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+    BulkLoadDataOperation(Database& db, UnorderedSet<LedgerKey> const& keys,
+                          soci::session& session)
+        : mDb(db), mSession(session)
     {
         mAccountIDs.reserve(keys.size());
         mDataNames.reserve(keys.size());
@@ -438,7 +446,7 @@ class BulkLoadDataOperation
                           "ledgerext "
                           "FROM accountdata WHERE (accountid, dataname) IN r";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto be = prep.statement().get_backend();
         if (be == nullptr)
         {
@@ -473,7 +481,7 @@ class BulkLoadDataOperation
             "ledgerext "
             "FROM accountdata WHERE (accountid, dataname) IN (SELECT * FROM r)";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strDataNames));
@@ -483,15 +491,16 @@ class BulkLoadDataOperation
 };
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-LedgerTxnRoot::Impl::bulkLoadData(UnorderedSet<LedgerKey> const& keys) const
+LedgerTxnRoot::Impl::bulkLoadData(
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(keys.size()));
     if (!keys.empty())
     {
-        BulkLoadDataOperation op(mDatabase, keys);
+        BulkLoadDataOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
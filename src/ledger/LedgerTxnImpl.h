@@ -241,6 +241,16 @@ class LedgerTxn::Impl
 
     IOCOrderbookManager mSpeedexIOCOrderbooks;
 
+    // Balance changes recorded by addCommutativeBalanceDelta that are not
+    // yet folded into an entry. A key is never in both mEntry and
+    // mCommutativeDeltas: recording a key in mEntry folds its delta.
+    UnorderedMap<LedgerKey, int64_t> mCommutativeDeltas;
+
+    // A LedgerTxn parent takes over mCommutativeDeltas in commitChild. Any
+    // other parent only understands whole entries, so the deltas are folded
+    // into the committed entries instead.
+    bool const mParentTakesDeltas;
+
     // The WorstBestOfferMap is a cache which retains, for each asset pair, the
     // worst value (including possibly nullptr) returned from calling
     // loadBestOffer on this LedgerTxn. Each time we call loadBestOffer, we call
@@ -415,6 +425,22 @@ class LedgerTxn::Impl
     // maybeUpdateLastModified has the strong exception safety guarantee
     EntryMap maybeUpdateLastModified() const;
 
+    // foldCommutativeDeltas has the basic exception safety guarantee. It
+    // returns, for every key in mCommutativeDeltas, the newest version of the
+    // entry in the parent with the delta applied (and lastModifiedLedgerSeq
+    // updated, if mShouldUpdateLastModified).
+    EntryMap foldCommutativeDeltas() const;
+
+    // dropCommutativeDelta does not throw. It forgets the delta of key, once
+    // key has been recorded in mEntry (which already includes the delta) or
+    // blindly overwritten.
+    void dropCommutativeDelta(InternalLedgerKey const& key) noexcept;
+
+    // recordCommutativeBalanceDelta has the strong exception safety
+    // guarantee. It is addCommutativeBalanceDelta without the checks on the
+    // state of this LedgerTxn, for use by commitChild.
+    void recordCommutativeBalanceDelta(LedgerKey const& key, int64_t delta);
+
     // maybeUpdateLastModifiedThenInvokeThenSeal has the same exception safety
     // guarantee as f
     void maybeUpdateLastModifiedThenInvokeThenSeal(
@@ -570,6 +596,11 @@ class LedgerTxn::Impl
     IOCOrderbookManager& 
     getSpeedexIOCOffers();
 
+    // addCommutativeBalanceDelta has the strong exception safety guarantee.
+    void addCommutativeBalanceDelta(LedgerKey const& key, int64_t delta);
+
+    UnorderedMap<LedgerKey, int64_t> const& getCommutativeBalanceDeltas() const;
+
     std::shared_ptr<const LedgerEntry>
     loadSnapshotEntry(LedgerKey const& key) const;
 
@@ -642,6 +673,8 @@ class LedgerTxn::Impl
 
     double getPrefetchHitRate() const;
 
+    std::map<LedgerEntryType, EntryCacheLookups> getEntryCacheLookups() const;
+
     // hasSponsorshipEntry has the strong exception safety guarantee
     bool hasSponsorshipEntry() const;
 
@@ -759,6 +792,8 @@ class LedgerTxnRoot::Impl
     mutable BestOffers mBestOffers;
     mutable uint64_t mPrefetchHits{0};
     mutable uint64_t mPrefetchMisses{0};
+    mutable std::map<LedgerEntryType, EntryCacheLookups> mEntryCacheLookups;
+    bool const mEntryCacheWriteThrough;
 
     size_t mBulkLoadBatchSize;
     std::unique_ptr<soci::transaction> mTransaction;
@@ -768,8 +803,6 @@ class LedgerTxnRoot::Impl
     bool const mBestOfferDebuggingEnabled;
 #endif
 
-    void clearAllCaches() const;
-
     void throwIfChild() const;
 
     std::shared_ptr<LedgerEntry const> loadAccount(LedgerKey const& key) const;
@@ -804,30 +837,46 @@ class LedgerTxnRoot::Impl
     std::shared_ptr<LedgerEntry const>
     loadSpeedexConfig(LedgerKey const& key) const;
 
+    // Writes the buffered changes of each kind once there are more than
+    // bufferThreshold of them, through session. The written entries go to the
+    // entry cache if updateCaches is set and the cache is written through.
     void bulkApply(BulkLedgerEntryChangeAccumulator& bleca,
-                   size_t bufferThreshold, LedgerTxnConsistency cons);
-    void bulkUpsertAccounts(std::vector<EntryIterator> const& entries);
+                   size_t bufferThreshold, LedgerTxnConsistency cons,
+                   soci::session& session, bool updateCaches);
+    void bulkUpsertAccounts(std::vector<EntryIterator> const& entries,
+                            soci::session& session);
     void bulkDeleteAccounts(std::vector<EntryIterator> const& entries,
-                            LedgerTxnConsistency cons);
-    void bulkUpsertTrustLines(std::vector<EntryIterator> const& entries);
+                            LedgerTxnConsistency cons, soci::session& session);
+    void bulkUpsertTrustLines(std::vector<EntryIterator> const& entries,
+                              soci::session& session);
     void bulkDeleteTrustLines(std::vector<EntryIterator> const& entries,
-                              LedgerTxnConsistency cons);
-    void bulkUpsertOffers(std::vector<EntryIterator> const& entries);
+                              LedgerTxnConsistency cons,
+                              soci::session& session);
+    void bulkUpsertOffers(std::vector<EntryIterator> const& entries,
+                          soci::session& session);
     void bulkDeleteOffers(std::vector<EntryIterator> const& entries,
-                          LedgerTxnConsistency cons);
-    void bulkUpsertAccountData(std::vector<EntryIterator> const& entries);
+                          LedgerTxnConsistency cons, soci::session& session);
+    void bulkUpsertAccountData(std::vector<EntryIterator> const& entries,
+                               soci::session& session);
     void bulkDeleteAccountData(std::vector<EntryIterator> const& entries,
-                               LedgerTxnConsistency cons);
-    void bulkUpsertClaimableBalance(std::vector<EntryIterator> const& entries);
+                               LedgerTxnConsistency cons,
+                               soci::session& session);
+    void bulkUpsertClaimableBalance(std::vector<EntryIterator> const& entries,
+                                    soci::session& session);
     void bulkDeleteClaimableBalance(std::vector<EntryIterator> const& entries,
-                                    LedgerTxnConsistency cons);
-    void bulkUpsertLiquidityPool(std::vector<EntryIterator> const& entries);
+                                    LedgerTxnConsistency cons,
+                                    soci::session& session);
+    void bulkUpsertLiquidityPool(std::vector<EntryIterator> const& entries,
+                                 soci::session& session);
     void bulkDeleteLiquidityPool(std::vector<EntryIterator> const& entries,
-                                 LedgerTxnConsistency cons);
+                                 LedgerTxnConsistency cons,
+                                 soci::session& session);
 
-    void bulkUpsertSpeedexConfig(std::vector<EntryIterator> const& entries);
+    void bulkUpsertSpeedexConfig(std::vector<EntryIterator> const& entries,
+                                 soci::session& session);
     void bulkDeleteSpeedexConfig(std::vector<EntryIterator> const& entries,
-                                 LedgerTxnConsistency cons);
+                                 LedgerTxnConsistency cons,
+                                 soci::session& session);
 
     static std::string tableFromLedgerEntryType(LedgerEntryType let);
 
@@ -839,7 +888,9 @@ class LedgerTxnRoot::Impl
     //    database operations are SELECTs, which only populate the cache
     //    with fresh data from the DB.
     //
-    //  - On LedgerTxnRoot::commitChild, the cache is cleared.
+    //  - On LedgerTxnRoot::commitChild, the cache is cleared, or, with
+    //    mEntryCacheWriteThrough, every committed entry is written to the
+    //    cache along with the database.
     //
     //  - It is therefore always kept in exact correspondence with the
     //    database for the keyset that it has entries for. It's a precise
@@ -849,11 +900,13 @@ class LedgerTxnRoot::Impl
     void putInEntryCache(LedgerKey const& key,
                          std::shared_ptr<LedgerEntry const> const& entry,
                          LoadType type) const;
+    void writeThroughToCaches(std::vector<EntryIterator> const& entries) const;
 
     // The snapshot cache maintains a cache of entries as they appeared at
     // the start of the ledger transaction.
     // Cleared when commitChild is called (to ensure reads are from start
-    // of current transaction, not a past transaction).
+    // of current transaction, not a past transaction), unless committed
+    // entries are written through to it.
     std::shared_ptr<LedgerEntry const>
     getFromSnapshotCache(LedgerKey const& key) const;
     void putInSnapshotCache(LedgerKey const& key,
@@ -863,20 +916,36 @@ class LedgerTxnRoot::Impl
                                          Asset const& selling) const;
 
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadAccounts(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadAccounts(UnorderedSet<LedgerKey> const& keys,
+                     soci::session& session) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadTrustLines(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadTrustLines(UnorderedSet<LedgerKey> const& keys,
+                       soci::session& session) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadOffers(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadOffers(UnorderedSet<LedgerKey> const& keys,
+                   soci::session& session) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadData(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadData(UnorderedSet<LedgerKey> const& keys,
+                 soci::session& session) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadClaimableBalance(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadClaimableBalance(UnorderedSet<LedgerKey> const& keys,
+                             soci::session& session) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadLiquidityPool(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadLiquidityPool(UnorderedSet<LedgerKey> const& keys,
+                          soci::session& session) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-    bulkLoadSpeedexConfig(UnorderedSet<LedgerKey> const& keys) const;
+    bulkLoadSpeedexConfig(UnorderedSet<LedgerKey> const& keys,
+                          soci::session& session) const;
+
 
+    // Bulk loads keys through session, in batches of mBulkLoadBatchSize,
+    // passing each batch of results to onLoaded. Uses no state other than
+    // mDatabase, so it can run on a worker thread with its own session.
+    void bulkLoadInBatches(
+        UnorderedSet<LedgerKey> const& keys, soci::session& session,
+        std::function<void(UnorderedMap<LedgerKey, std::shared_ptr<
+                               LedgerEntry const>> const&)> const& onLoaded)
+        const;
 
     std::deque<LedgerEntry>::const_iterator
     loadNextBestOffersIntoCache(BestOffersEntryPtr cached, Asset const& buying,
@@ -889,7 +958,8 @@ class LedgerTxnRoot::Impl
 
   public:
     // Constructor has the strong exception safety guarantee
-    Impl(Database& db, size_t entryCacheSize, size_t prefetchBatchSize
+    Impl(Database& db, size_t entryCacheSize, size_t prefetchBatchSize,
+         bool entryCacheWriteThrough
 #ifdef BEST_OFFER_DEBUGGING
          ,
          bool bestOfferDebuggingEnabled
@@ -990,6 +1060,27 @@ class LedgerTxnRoot::Impl
 
     double getPrefetchHitRate() const;
 
+    std::map<LedgerEntryType, EntryCacheLookups> getEntryCacheLookups() const;
+
+    // loadEntriesOnSession is thread-safe
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
+    loadEntriesOnSession(UnorderedSet<LedgerKey> const& keys,
+                         soci::session& session) const;
+
+    // Puts entries that are not already cached into the entry cache, as
+    // prefetched. Returns the number of entries added.
+    uint32_t addPrefetchedEntries(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries);
+
+    // writeEntriesOnSession is thread-safe as long as the root doesn't
+    // commit meanwhile
+    void writeEntriesOnSession(std::vector<LedgerEntry> const& entries,
+                               std::vector<LedgerKey> const& deletedKeys,
+                               soci::session& session);
+
+    void clearAllCaches() const;
+
 #ifdef BEST_OFFER_DEBUGGING
     bool bestOfferDebuggingEnabled() const;
 
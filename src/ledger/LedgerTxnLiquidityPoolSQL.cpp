@@ -62,6 +62,7 @@ class BulkLoadLiquidityPoolOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mPoolAssets;
 
     std::vector<LedgerEntry>
@@ -92,8 +93,9 @@ class BulkLoadLiquidityPoolOperation
 
   public:
     BulkLoadLiquidityPoolOperation(Database& db,
-                                   UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+                                   UnorderedSet<LedgerKey> const& keys,
+                                   soci::session& session)
+        : mDb(db), mSession(session)
     {
         mPoolAssets.reserve(keys.size());
         for (auto const& k : keys)
@@ -119,7 +121,7 @@ class BulkLoadLiquidityPoolOperation
                           "FROM liquiditypool "
                           "WHERE poolasset IN r";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto be = prep.statement().get_backend();
         if (be == nullptr)
         {
@@ -147,7 +149,7 @@ class BulkLoadLiquidityPoolOperation
                           "FROM liquiditypool "
                           "WHERE poolasset IN (SELECT * from r)";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strPoolAssets));
         return executeAndFetch(st);
@@ -157,13 +159,13 @@ class BulkLoadLiquidityPoolOperation
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
 LedgerTxnRoot::Impl::bulkLoadLiquidityPool(
-    UnorderedSet<LedgerKey> const& keys) const
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     if (!keys.empty())
     {
-        BulkLoadLiquidityPoolOperation op(mDatabase, keys);
+        BulkLoadLiquidityPoolOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
@@ -176,12 +178,14 @@ class BulkDeleteLiquidityPoolOperation
 {
     Database& mDb;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
     std::vector<std::string> mPoolAssets;
 
   public:
     BulkDeleteLiquidityPoolOperation(Database& db, LedgerTxnConsistency cons,
-                                     std::vector<EntryIterator> const& entries)
-        : mDb(db), mCons(cons)
+                                     std::vector<EntryIterator> const& entries,
+                                     soci::session& session)
+        : mDb(db), mCons(cons), mSession(session)
     {
         mPoolAssets.reserve(entries.size());
         for (auto const& e : entries)
@@ -197,7 +201,7 @@ class BulkDeleteLiquidityPoolOperation
     doSociGenericOperation()
     {
         std::string sql = "DELETE FROM liquiditypool WHERE poolasset = :id";
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(mPoolAssets));
         st.define_and_bind();
@@ -229,7 +233,7 @@ class BulkDeleteLiquidityPoolOperation
                           "DELETE FROM liquiditypool "
                           "WHERE poolasset IN (SELECT * FROM r)";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strPoolAssets));
         st.define_and_bind();
@@ -248,16 +252,18 @@ class BulkDeleteLiquidityPoolOperation
 
 void
 LedgerTxnRoot::Impl::bulkDeleteLiquidityPool(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
-    BulkDeleteLiquidityPoolOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkDeleteLiquidityPoolOperation op(mDatabase, cons, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 class BulkUpsertLiquidityPoolOperation
     : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mPoolAssets;
     std::vector<std::string> mAssetAs;
     std::vector<std::string> mAssetBs;
@@ -281,8 +287,9 @@ class BulkUpsertLiquidityPoolOperation
 
   public:
     BulkUpsertLiquidityPoolOperation(
-        Database& Db, std::vector<EntryIterator> const& entryIter)
-        : mDb(Db)
+        Database& Db, std::vector<EntryIterator> const& entryIter,
+        soci::session& session)
+        : mDb(Db), mSession(session)
     {
         for (auto const& e : entryIter)
         {
@@ -305,7 +312,7 @@ class BulkUpsertLiquidityPoolOperation
             "ledgerentry = excluded.ledgerentry, "
             "lastmodified = excluded.lastmodified";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mPoolAssets));
         st.exchange(soci::use(mAssetAs));
@@ -357,7 +364,7 @@ class BulkUpsertLiquidityPoolOperation
             "ledgerentry = excluded.ledgerentry, "
             "lastmodified = excluded.lastmodified";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strPoolAssets));
         st.exchange(soci::use(strAssetAs));
@@ -379,10 +386,10 @@ class BulkUpsertLiquidityPoolOperation
 
 void
 LedgerTxnRoot::Impl::bulkUpsertLiquidityPool(
-    std::vector<EntryIterator> const& entries)
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
-    BulkUpsertLiquidityPoolOperation op(mDatabase, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkUpsertLiquidityPoolOperation op(mDatabase, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
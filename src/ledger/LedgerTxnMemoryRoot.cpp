@@ -0,0 +1,623 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTxnMemoryRoot.h"
+#include "crypto/KeyUtils.h"
+#include "database/Database.h"
+#include "ledger/LedgerRange.h"
+#include "transactions/TransactionUtils.h"
+#include "util/GlobalChecks.h"
+#include "util/UnorderedSet.h"
+#include "util/XDROperators.h"
+#include "util/types.h"
+
+#include <Tracy.hpp>
+#include <algorithm>
+#include <soci.h>
+
+namespace stellar
+{
+
+struct LedgerTxnMemoryRoot::State
+{
+    using EntryTable = UnorderedMap<LedgerKey, LedgerEntry>;
+    using OrderBook =
+        std::map<OfferDescriptor, LedgerKey, IsBetterOfferComparator>;
+    using KeysByAccount = UnorderedMap<AccountID, UnorderedSet<LedgerKey>>;
+
+    std::map<LedgerEntryType, EntryTable> mEntries;
+
+    // Indexes over mEntries: the offers of each asset pair, in order of
+    // isBetterOffer; the offers of each seller; and the pool share trust
+    // lines of each account.
+    UnorderedMap<AssetPair, OrderBook, AssetPairHash> mOrderBooks;
+    KeysByAccount mOffersBySeller;
+    KeysByAccount mPoolShareTrustLines;
+
+    EntryTable const&
+    table(LedgerEntryType let) const
+    {
+        static EntryTable const empty;
+        auto iter = mEntries.find(let);
+        return iter == mEntries.end() ? empty : iter->second;
+    }
+
+    LedgerEntry const*
+    find(LedgerKey const& key) const
+    {
+        auto const& entries = table(key.type());
+        auto iter = entries.find(key);
+        return iter == entries.end() ? nullptr : &iter->second;
+    }
+
+    void
+    put(LedgerKey const& key, LedgerEntry const& entry)
+    {
+        erase(key);
+        index(key, entry);
+        mEntries[key.type()].emplace(key, entry);
+    }
+
+    // Returns whether key existed.
+    bool
+    erase(LedgerKey const& key)
+    {
+        auto entriesIter = mEntries.find(key.type());
+        if (entriesIter == mEntries.end())
+        {
+            return false;
+        }
+        auto iter = entriesIter->second.find(key);
+        if (iter == entriesIter->second.end())
+        {
+            return false;
+        }
+        unindex(key, iter->second);
+        entriesIter->second.erase(iter);
+        return true;
+    }
+
+    template <typename Pred>
+    void
+    eraseIf(LedgerEntryType let, Pred pred)
+    {
+        auto entriesIter = mEntries.find(let);
+        if (entriesIter == mEntries.end())
+        {
+            return;
+        }
+        auto& entries = entriesIter->second;
+        for (auto iter = entries.begin(); iter != entries.end();)
+        {
+            if (pred(iter->second))
+            {
+                unindex(iter->first, iter->second);
+                iter = entries.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    void
+    clear(LedgerEntryType let)
+    {
+        mEntries.erase(let);
+        if (let == OFFER)
+        {
+            mOrderBooks.clear();
+            mOffersBySeller.clear();
+        }
+        else if (let == TRUSTLINE)
+        {
+            mPoolShareTrustLines.clear();
+        }
+    }
+
+  private:
+    static void
+    removeFrom(KeysByAccount& keys, AccountID const& account,
+               LedgerKey const& key)
+    {
+        auto iter = keys.find(account);
+        if (iter != keys.end())
+        {
+            iter->second.erase(key);
+            if (iter->second.empty())
+            {
+                keys.erase(iter);
+            }
+        }
+    }
+
+    void
+    index(LedgerKey const& key, LedgerEntry const& entry)
+    {
+        if (key.type() == OFFER)
+        {
+            auto const& oe = entry.data.offer();
+            mOrderBooks[{oe.buying, oe.selling}].emplace(
+                OfferDescriptor{oe.price, oe.offerID}, key);
+            mOffersBySeller[oe.sellerID].insert(key);
+        }
+        else if (key.type() == TRUSTLINE &&
+                 entry.data.trustLine().asset.type() == ASSET_TYPE_POOL_SHARE)
+        {
+            mPoolShareTrustLines[entry.data.trustLine().accountID].insert(key);
+        }
+    }
+
+    void
+    unindex(LedgerKey const& key, LedgerEntry const& entry)
+    {
+        if (key.type() == OFFER)
+        {
+            auto const& oe = entry.data.offer();
+            auto bookIter = mOrderBooks.find({oe.buying, oe.selling});
+            if (bookIter != mOrderBooks.end())
+            {
+                bookIter->second.erase(OfferDescriptor{oe.price, oe.offerID});
+                if (bookIter->second.empty())
+                {
+                    mOrderBooks.erase(bookIter);
+                }
+            }
+            removeFrom(mOffersBySeller, oe.sellerID, key);
+        }
+        else if (key.type() == TRUSTLINE &&
+                 entry.data.trustLine().asset.type() == ASSET_TYPE_POOL_SHARE)
+        {
+            removeFrom(mPoolShareTrustLines, entry.data.trustLine().accountID,
+                       key);
+        }
+    }
+};
+
+LedgerTxnMemoryRoot::LedgerTxnMemoryRoot(Database& db
+#ifdef BEST_OFFER_DEBUGGING
+                                         ,
+                                         bool bestOfferDebuggingEnabled
+#endif
+                                         )
+    : mDatabase(db)
+    , mState(std::make_unique<State>())
+    , mHeader(std::make_unique<LedgerHeader>())
+#ifdef BEST_OFFER_DEBUGGING
+    , mBestOfferDebuggingEnabled(bestOfferDebuggingEnabled)
+#endif
+{
+}
+
+LedgerTxnMemoryRoot::~LedgerTxnMemoryRoot()
+{
+}
+
+void
+LedgerTxnMemoryRoot::throwIfChild() const
+{
+    if (mChild)
+    {
+        throw std::runtime_error("LedgerTxnMemoryRoot has child");
+    }
+}
+
+void
+LedgerTxnMemoryRoot::loadFromBuckets(std::map<LedgerKey, LedgerEntry>& state)
+{
+    ZoneScoped;
+    throwIfChild();
+    mState = std::make_unique<State>();
+    // Move the entries out one node at a time, so the ledger is not held
+    // twice in memory.
+    while (!state.empty())
+    {
+        auto node = state.extract(state.begin());
+        mState->put(node.key(), node.mapped());
+    }
+}
+
+void
+LedgerTxnMemoryRoot::addChild(AbstractLedgerTxn& child)
+{
+    if (mChild)
+    {
+        throw std::runtime_error("LedgerTxnMemoryRoot already has child");
+    }
+    mTransaction = std::make_unique<soci::transaction>(mDatabase.getSession());
+    mChild = &child;
+}
+
+void
+LedgerTxnMemoryRoot::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
+{
+    ZoneScoped;
+    // Assignment of xdrpp objects does not have the strong exception safety
+    // guarantee, so use std::unique_ptr<...>::swap to achieve it
+    auto childHeader = std::make_unique<LedgerHeader>(mChild->getHeader());
+
+    try
+    {
+        for (; (bool)iter; ++iter)
+        {
+            // As in LedgerTxnRoot, only LEDGER_ENTRY are recorded
+            if (iter.key().type() != InternalLedgerEntryType::LEDGER_ENTRY)
+            {
+                continue;
+            }
+            auto const& key = iter.key().ledgerKey();
+            if (iter.entryExists())
+            {
+                mState->put(key, iter.entry().ledgerEntry());
+            }
+            else if (!mState->erase(key) &&
+                     cons == LedgerTxnConsistency::EXACT)
+            {
+                throw std::runtime_error("Could not delete ledger entry");
+            }
+        }
+
+        mDatabase.clearPreparedStatementCache();
+        mTransaction->commit();
+    }
+    catch (std::exception& e)
+    {
+        printErrorAndAbort("fatal error during commit to LedgerTxnMemoryRoot: ",
+                           e.what());
+    }
+    catch (...)
+    {
+        printErrorAndAbort(
+            "unknown fatal error during commit to LedgerTxnMemoryRoot");
+    }
+
+    // std::unique_ptr<...>::reset does not throw
+    mTransaction.reset();
+
+    // std::unique_ptr<...>::swap does not throw
+    mHeader.swap(childHeader);
+    mChild = nullptr;
+}
+
+void
+LedgerTxnMemoryRoot::rollbackChild()
+{
+    try
+    {
+        mTransaction->rollback();
+        mTransaction.reset();
+    }
+    catch (std::exception& e)
+    {
+        printErrorAndAbort(
+            "fatal error when rolling back child of LedgerTxnMemoryRoot: ",
+            e.what());
+    }
+    catch (...)
+    {
+        printErrorAndAbort("unknown fatal error when rolling back child of "
+                           "LedgerTxnMemoryRoot");
+    }
+
+    mChild = nullptr;
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+LedgerTxnMemoryRoot::getAllOffers()
+{
+    return mState->table(OFFER);
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnMemoryRoot::getBestOffer(Asset const& buying, Asset const& selling)
+{
+    auto bookIter = mState->mOrderBooks.find({buying, selling});
+    if (bookIter == mState->mOrderBooks.end())
+    {
+        return nullptr;
+    }
+    return std::make_shared<LedgerEntry const>(
+        *mState->find(bookIter->second.begin()->second));
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnMemoryRoot::getBestOffer(Asset const& buying, Asset const& selling,
+                                  OfferDescriptor const& worseThan)
+{
+    auto bookIter = mState->mOrderBooks.find({buying, selling});
+    if (bookIter == mState->mOrderBooks.end())
+    {
+        return nullptr;
+    }
+    auto iter = bookIter->second.upper_bound(worseThan);
+    if (iter == bookIter->second.end())
+    {
+        return nullptr;
+    }
+    return std::make_shared<LedgerEntry const>(*mState->find(iter->second));
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+LedgerTxnMemoryRoot::getOffersByAccountAndAsset(AccountID const& account,
+                                                Asset const& asset)
+{
+    UnorderedMap<LedgerKey, LedgerEntry> res;
+    auto iter = mState->mOffersBySeller.find(account);
+    if (iter != mState->mOffersBySeller.end())
+    {
+        for (auto const& key : iter->second)
+        {
+            auto const& le = *mState->find(key);
+            auto const& oe = le.data.offer();
+            if (oe.buying == asset || oe.selling == asset)
+            {
+                res.emplace(key, le);
+            }
+        }
+    }
+    return res;
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+LedgerTxnMemoryRoot::getPoolShareTrustLinesByAccountAndAsset(
+    AccountID const& account, Asset const& asset)
+{
+    UnorderedMap<LedgerKey, LedgerEntry> res;
+    auto iter = mState->mPoolShareTrustLines.find(account);
+    if (iter != mState->mPoolShareTrustLines.end())
+    {
+        for (auto const& key : iter->second)
+        {
+            auto const& tl = *mState->find(key);
+            auto pool = mState->find(
+                liquidityPoolKey(tl.data.trustLine().asset.liquidityPoolID()));
+            if (!pool)
+            {
+                continue;
+            }
+            auto const& params =
+                pool->data.liquidityPool().body.constantProduct().params;
+            if (params.assetA == asset || params.assetB == asset)
+            {
+                res.emplace(key, tl);
+            }
+        }
+    }
+    return res;
+}
+
+LedgerHeader const&
+LedgerTxnMemoryRoot::getHeader() const
+{
+    return *mHeader;
+}
+
+std::vector<InflationWinner>
+LedgerTxnMemoryRoot::getInflationWinners(size_t maxWinners, int64_t minBalance)
+{
+    // Same query as LedgerTxnRoot: sum the balances of at least 100 XLM by
+    // inflation destination, and order by votes then destination, both
+    // descending.
+    UnorderedMap<AccountID, int64_t> votes;
+    for (auto const& kv : mState->table(ACCOUNT))
+    {
+        auto const& ae = kv.second.data.account();
+        if (ae.inflationDest && ae.balance >= 1000000000)
+        {
+            votes[*ae.inflationDest] += ae.balance;
+        }
+    }
+
+    std::vector<std::pair<InflationWinner, std::string>> sorted;
+    sorted.reserve(votes.size());
+    for (auto const& kv : votes)
+    {
+        InflationWinner w;
+        w.accountID = kv.first;
+        w.votes = kv.second;
+        sorted.emplace_back(w, KeyUtils::toStrKey(kv.first));
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) {
+        if (a.first.votes != b.first.votes)
+        {
+            return a.first.votes > b.first.votes;
+        }
+        return a.second > b.second;
+    });
+
+    std::vector<InflationWinner> winners;
+    for (auto const& w : sorted)
+    {
+        if (winners.size() == maxWinners || w.first.votes < minBalance)
+        {
+            break;
+        }
+        winners.push_back(w.first);
+    }
+    return winners;
+}
+
+std::shared_ptr<InternalLedgerEntry const>
+LedgerTxnMemoryRoot::getNewestVersion(InternalLedgerKey const& gkey) const
+{
+    // As in LedgerTxnRoot, only LEDGER_ENTRY are recorded
+    if (gkey.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+    {
+        return nullptr;
+    }
+    auto entry = loadSnapshotEntry(gkey.ledgerKey());
+    if (!entry)
+    {
+        return nullptr;
+    }
+    return std::make_shared<InternalLedgerEntry const>(*entry);
+}
+
+std::shared_ptr<const LedgerEntry>
+LedgerTxnMemoryRoot::loadSnapshotEntry(LedgerKey const& key) const
+{
+    if (auto entry = mState->find(key))
+    {
+        return std::make_shared<LedgerEntry const>(*entry);
+    }
+    // LedgerTxnRoot serves a default speedex config until one is stored
+    if (key.type() == SPEEDEX_CONFIG)
+    {
+        LedgerEntry out;
+        out.data.type(SPEEDEX_CONFIG);
+        return std::make_shared<LedgerEntry const>(out);
+    }
+    return nullptr;
+}
+
+uint64_t
+LedgerTxnMemoryRoot::countObjects(LedgerEntryType let) const
+{
+    throwIfChild();
+    return mState->table(let).size();
+}
+
+uint64_t
+LedgerTxnMemoryRoot::countObjects(LedgerEntryType let,
+                                  LedgerRange const& ledgers) const
+{
+    throwIfChild();
+    uint64_t count = 0;
+    for (auto const& kv : mState->table(let))
+    {
+        auto lastModified = kv.second.lastModifiedLedgerSeq;
+        if (lastModified >= ledgers.mFirst && lastModified < ledgers.limit())
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void
+LedgerTxnMemoryRoot::deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const
+{
+    throwIfChild();
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        mState->eraseIf(static_cast<LedgerEntryType>(let),
+                        [&](LedgerEntry const& le) {
+                            return le.lastModifiedLedgerSeq >= ledger;
+                        });
+    }
+}
+
+void
+LedgerTxnMemoryRoot::dropAccounts()
+{
+    throwIfChild();
+    mState->clear(ACCOUNT);
+}
+
+void
+LedgerTxnMemoryRoot::dropData()
+{
+    throwIfChild();
+    mState->clear(DATA);
+}
+
+void
+LedgerTxnMemoryRoot::dropOffers()
+{
+    throwIfChild();
+    mState->clear(OFFER);
+}
+
+void
+LedgerTxnMemoryRoot::dropTrustLines()
+{
+    throwIfChild();
+    mState->clear(TRUSTLINE);
+}
+
+void
+LedgerTxnMemoryRoot::dropClaimableBalances()
+{
+    throwIfChild();
+    mState->clear(CLAIMABLE_BALANCE);
+}
+
+void
+LedgerTxnMemoryRoot::dropLiquidityPools()
+{
+    throwIfChild();
+    mState->clear(LIQUIDITY_POOL);
+}
+
+void
+LedgerTxnMemoryRoot::dropSpeedexConfigs()
+{
+    throwIfChild();
+    mState->clear(SPEEDEX_CONFIG);
+}
+
+double
+LedgerTxnMemoryRoot::getPrefetchHitRate() const
+{
+    return 0.0;
+}
+
+std::map<LedgerEntryType, EntryCacheLookups>
+LedgerTxnMemoryRoot::getEntryCacheLookups() const
+{
+    return {};
+}
+
+uint32_t
+LedgerTxnMemoryRoot::prefetch(UnorderedSet<LedgerKey> const& keys)
+{
+    // everything is already in memory
+    return 0;
+}
+
+#ifdef BUILD_TESTS
+void
+LedgerTxnMemoryRoot::resetForFuzzer()
+{
+    abort();
+}
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+bool
+LedgerTxnMemoryRoot::bestOfferDebuggingEnabled() const
+{
+    return mBestOfferDebuggingEnabled;
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnMemoryRoot::getBestOfferSlow(Asset const& buying,
+                                      Asset const& selling,
+                                      OfferDescriptor const* worseThan,
+                                      std::unordered_set<int64_t>& exclude)
+{
+    // Scans every offer rather than using the order book, to check it
+    std::shared_ptr<LedgerEntry const> best;
+    for (auto const& kv : mState->table(OFFER))
+    {
+        auto const& oe = kv.second.data.offer();
+        if (!(oe.buying == buying) || !(oe.selling == selling) ||
+            exclude.find(oe.offerID) != exclude.end())
+        {
+            continue;
+        }
+        if (worseThan && !isBetterOffer(*worseThan, kv.second))
+        {
+            continue;
+        }
+        if (!best || isBetterOffer(kv.second, *best))
+        {
+            best = std::make_shared<LedgerEntry const>(kv.second);
+        }
+    }
+    return best;
+}
+#endif
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTxn.h"
+#include "util/UnorderedMap.h"
+
+#include <map>
+#include <memory>
+
+namespace soci
+{
+class transaction;
+}
+
+namespace stellar
+{
+
+class Database;
+
+// The root of the ledger when IN_MEMORY_LEDGER_STATE is set: an alternative to
+// the SQL-backed LedgerTxnRoot that holds the whole live ledger state in
+// memory and never reads or writes the ledger entry tables.
+//
+// Entries are kept in one hash table per LedgerEntryType, next to the indexes
+// needed to answer the queries LedgerTxnRoot answers with SQL: the order book
+// of each asset pair, the offers of each seller and the pool share trust lines
+// of each account. The state is built from the BucketList on startup
+// (loadFromBuckets), so it is only as durable as the BucketList and the last
+// closed ledger, whose header and HAS are still stored in the database.
+//
+// The database still holds the other tables (ledger headers, history,
+// persistent state), so, like LedgerTxnRoot, the root holds a database
+// transaction while it has a child and commits it with the child.
+class LedgerTxnMemoryRoot : public AbstractLedgerTxnParent
+{
+    struct State;
+
+    Database& mDatabase;
+    std::unique_ptr<State> mState;
+    std::unique_ptr<LedgerHeader> mHeader;
+    std::unique_ptr<soci::transaction> mTransaction;
+    AbstractLedgerTxn* mChild{nullptr};
+
+#ifdef BEST_OFFER_DEBUGGING
+    bool const mBestOfferDebuggingEnabled;
+#endif
+
+    void throwIfChild() const;
+
+  public:
+    LedgerTxnMemoryRoot(Database& db
+#ifdef BEST_OFFER_DEBUGGING
+                        ,
+                        bool bestOfferDebuggingEnabled
+#endif
+    );
+    virtual ~LedgerTxnMemoryRoot();
+
+    // Replaces the ledger state with state, the live entries of the
+    // BucketList (as from BucketManager::loadCompleteLedgerState), which is
+    // emptied as the entries are moved out.
+    void loadFromBuckets(std::map<LedgerKey, LedgerEntry>& state);
+
+    void addChild(AbstractLedgerTxn& child) override;
+    void commitChild(EntryIterator iter, LedgerTxnConsistency cons) override;
+    void rollbackChild() override;
+
+    UnorderedMap<LedgerKey, LedgerEntry> getAllOffers() override;
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling) override;
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling,
+                 OfferDescriptor const& worseThan) override;
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getOffersByAccountAndAsset(AccountID const& account,
+                               Asset const& asset) override;
+
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getPoolShareTrustLinesByAccountAndAsset(AccountID const& account,
+                                            Asset const& asset) override;
+
+    LedgerHeader const& getHeader() const override;
+
+    std::vector<InflationWinner>
+    getInflationWinners(size_t maxWinners, int64_t minBalance) override;
+
+    std::shared_ptr<InternalLedgerEntry const>
+    getNewestVersion(InternalLedgerKey const& key) const override;
+
+    std::shared_ptr<const LedgerEntry>
+    loadSnapshotEntry(LedgerKey const& key) const override;
+
+    uint64_t countObjects(LedgerEntryType let) const override;
+    uint64_t countObjects(LedgerEntryType let,
+                          LedgerRange const& ledgers) const override;
+
+    void deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const override;
+
+    void dropAccounts() override;
+    void dropData() override;
+    void dropOffers() override;
+    void dropTrustLines() override;
+    void dropClaimableBalances() override;
+    void dropLiquidityPools() override;
+    void dropSpeedexConfigs() override;
+    double getPrefetchHitRate() const override;
+    std::map<LedgerEntryType, EntryCacheLookups>
+    getEntryCacheLookups() const override;
+    uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+
+#ifdef BUILD_TESTS
+    void resetForFuzzer() override;
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+    bool bestOfferDebuggingEnabled() const override;
+
+    std::shared_ptr<LedgerEntry const>
+    getBestOfferSlow(Asset const& buying, Asset const& selling,
+                     OfferDescriptor const* worseThan,
+                     std::unordered_set<int64_t>& exclude) override;
+#endif
+};
+}
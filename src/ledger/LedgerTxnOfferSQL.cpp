@@ -325,6 +325,7 @@ LedgerTxnRoot::Impl::loadOffers(StatementContext& prep) const
 class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
+    soci::session& mSession;
     std::vector<std::string> mSellerIDs;
     std::vector<int64_t> mOfferIDs;
     std::vector<std::string> mSellingAssets;
@@ -369,8 +370,9 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
 
   public:
     BulkUpsertOffersOperation(Database& DB,
-                              std::vector<LedgerEntry> const& entries)
-        : mDB(DB)
+                              std::vector<LedgerEntry> const& entries,
+                              soci::session& session)
+        : mDB(DB), mSession(session)
     {
         mSellerIDs.reserve(entries.size());
         mOfferIDs.reserve(entries.size());
@@ -392,8 +394,9 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
     }
 
     BulkUpsertOffersOperation(Database& DB,
-                              std::vector<EntryIterator> const& entries)
-        : mDB(DB)
+                              std::vector<EntryIterator> const& entries,
+                              soci::session& session)
+        : mDB(DB), mSession(session)
     {
         mSellerIDs.reserve(entries.size());
         mOfferIDs.reserve(entries.size());
@@ -439,7 +442,7 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
             "lastmodified = excluded.lastmodified, "
             "extension = excluded.extension, "
             "ledgerext = excluded.ledgerext";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mSellerIDs));
         st.exchange(soci::use(mOfferIDs));
@@ -527,7 +530,7 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
             "lastmodified = excluded.lastmodified, "
             "extension = excluded.extension, "
             "ledgerext = excluded.ledgerext";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strSellerIDs));
         st.exchange(soci::use(strOfferIDs));
@@ -558,12 +561,14 @@ class BulkDeleteOffersOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
     std::vector<int64_t> mOfferIDs;
 
   public:
     BulkDeleteOffersOperation(Database& DB, LedgerTxnConsistency cons,
-                              std::vector<EntryIterator> const& entries)
-        : mDB(DB), mCons(cons)
+                              std::vector<EntryIterator> const& entries,
+                              soci::session& session)
+        : mDB(DB), mCons(cons), mSession(session)
     {
         for (auto const& e : entries)
         {
@@ -580,7 +585,7 @@ class BulkDeleteOffersOperation : public DatabaseTypeSpecificOperation<void>
     doSociGenericOperation()
     {
         std::string sql = "DELETE FROM offers WHERE offerid = :id";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mOfferIDs));
         st.define_and_bind();
@@ -613,7 +618,7 @@ class BulkDeleteOffersOperation : public DatabaseTypeSpecificOperation<void>
                           ") "
                           "DELETE FROM offers WHERE "
                           "offerid IN (SELECT * FROM r)";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strOfferIDs));
         st.define_and_bind();
@@ -631,22 +636,24 @@ class BulkDeleteOffersOperation : public DatabaseTypeSpecificOperation<void>
 };
 
 void
-LedgerTxnRoot::Impl::bulkUpsertOffers(std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::bulkUpsertOffers(
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertOffersOperation op(mDatabase, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkUpsertOffersOperation op(mDatabase, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
-LedgerTxnRoot::Impl::bulkDeleteOffers(std::vector<EntryIterator> const& entries,
-                                      LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::bulkDeleteOffers(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteOffersOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkDeleteOffersOperation op(mDatabase, cons, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
@@ -693,6 +700,7 @@ class BulkLoadOffersOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<int64_t> mOfferIDs;
     UnorderedSet<LedgerKey> mKeys;
 
@@ -755,8 +763,9 @@ class BulkLoadOffersOperation
     }
 
   public:
-    BulkLoadOffersOperation(Database& db, UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+    BulkLoadOffersOperation(Database& db, UnorderedSet<LedgerKey> const& keys,
+                            soci::session& session)
+        : mDb(db), mSession(session)
     {
         mOfferIDs.reserve(keys.size());
         for (auto const& k : keys)
@@ -778,7 +787,7 @@ class BulkLoadOffersOperation
             "ledgerext "
             "FROM offers WHERE offerid IN carray(?, ?, 'int64')";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto be = prep.statement().get_backend();
         if (be == nullptr)
         {
@@ -807,7 +816,7 @@ class BulkLoadOffersOperation
             "amount, pricen, priced, flags, lastmodified, extension, "
             "ledgerext "
             "FROM offers WHERE offerid IN (SELECT * FROM r)";
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strOfferIDs));
         return executeAndFetch(st);
@@ -816,15 +825,16 @@ class BulkLoadOffersOperation
 };
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
-LedgerTxnRoot::Impl::bulkLoadOffers(UnorderedSet<LedgerKey> const& keys) const
+LedgerTxnRoot::Impl::bulkLoadOffers(
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(keys.size()));
     if (!keys.empty())
     {
-        BulkLoadOffersOperation op(mDatabase, keys);
+        BulkLoadOffersOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
@@ -0,0 +1,251 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTxnShard.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace stellar
+{
+
+SharedLedgerTxnView::SharedLedgerTxnView(AbstractLedgerTxn& parent)
+    : mParent(parent)
+{
+}
+
+std::shared_ptr<InternalLedgerEntry const>
+SharedLedgerTxnView::getNewestVersion(InternalLedgerKey const& key) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mParent.getNewestVersion(key);
+}
+
+std::shared_ptr<LedgerEntry const>
+SharedLedgerTxnView::loadSnapshotEntry(LedgerKey const& key) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mParent.loadSnapshotEntry(key);
+}
+
+LedgerTxnShardRoot::LedgerTxnShardRoot(SharedLedgerTxnView const& view,
+                                       LedgerHeader const& header)
+    : mView(view), mHeader(header)
+{
+}
+
+void
+LedgerTxnShardRoot::unsupported(char const* what) const
+{
+    // TransactionFrame turns exceptions thrown while applying operations
+    // into txINTERNAL_ERROR, so this is also reported after the fact
+    mUnsupportedQuery = what;
+    throw std::runtime_error(std::string("unsupported in a LedgerTxn shard: ") +
+                             what);
+}
+
+void
+LedgerTxnShardRoot::addChild(AbstractLedgerTxn& child)
+{
+    if (mChild)
+    {
+        throw std::runtime_error("shard root already has a child");
+    }
+    mChild = &child;
+}
+
+void
+LedgerTxnShardRoot::commitChild(EntryIterator iter, LedgerTxnConsistency cons)
+{
+    if (!(mChild->getHeader() == mHeader))
+    {
+        unsupported("ledger header modification");
+    }
+    for (; (bool)iter; ++iter)
+    {
+        std::shared_ptr<InternalLedgerEntry const> entry;
+        if (iter.entryExists())
+        {
+            entry = std::make_shared<InternalLedgerEntry>(iter.entry());
+        }
+        mChanges.push_back(Change{iter.key(), entry});
+    }
+    mIOCOffers.commitChild(mChild->getSpeedexIOCOffers());
+    mChild = nullptr;
+}
+
+void
+LedgerTxnShardRoot::rollbackChild()
+{
+    mChild = nullptr;
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+LedgerTxnShardRoot::getAllOffers()
+{
+    unsupported("getAllOffers");
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnShardRoot::getBestOffer(Asset const& buying, Asset const& selling)
+{
+    unsupported("getBestOffer");
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnShardRoot::getBestOffer(Asset const& buying, Asset const& selling,
+                                 OfferDescriptor const& worseThan)
+{
+    unsupported("getBestOffer");
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+LedgerTxnShardRoot::getOffersByAccountAndAsset(AccountID const& account,
+                                               Asset const& asset)
+{
+    unsupported("getOffersByAccountAndAsset");
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+LedgerTxnShardRoot::getPoolShareTrustLinesByAccountAndAsset(
+    AccountID const& account, Asset const& asset)
+{
+    unsupported("getPoolShareTrustLinesByAccountAndAsset");
+}
+
+LedgerHeader const&
+LedgerTxnShardRoot::getHeader() const
+{
+    return mHeader;
+}
+
+std::vector<InflationWinner>
+LedgerTxnShardRoot::getInflationWinners(size_t maxWinners, int64_t minBalance)
+{
+    unsupported("getInflationWinners");
+}
+
+std::shared_ptr<InternalLedgerEntry const>
+LedgerTxnShardRoot::getNewestVersion(InternalLedgerKey const& key) const
+{
+    auto iter = mReadCache.find(key);
+    if (iter != mReadCache.end())
+    {
+        return iter->second;
+    }
+    auto entry = mView.getNewestVersion(key);
+    mReadCache.emplace(key, entry);
+    return entry;
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnShardRoot::loadSnapshotEntry(LedgerKey const& key) const
+{
+    return mView.loadSnapshotEntry(key);
+}
+
+uint64_t
+LedgerTxnShardRoot::countObjects(LedgerEntryType let) const
+{
+    unsupported("countObjects");
+}
+
+uint64_t
+LedgerTxnShardRoot::countObjects(LedgerEntryType let,
+                                 LedgerRange const& ledgers) const
+{
+    unsupported("countObjects");
+}
+
+void
+LedgerTxnShardRoot::deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const
+{
+    unsupported("deleteObjectsModifiedOnOrAfterLedger");
+}
+
+void
+LedgerTxnShardRoot::dropAccounts()
+{
+    unsupported("dropAccounts");
+}
+
+void
+LedgerTxnShardRoot::dropData()
+{
+    unsupported("dropData");
+}
+
+void
+LedgerTxnShardRoot::dropOffers()
+{
+    unsupported("dropOffers");
+}
+
+void
+LedgerTxnShardRoot::dropTrustLines()
+{
+    unsupported("dropTrustLines");
+}
+
+void
+LedgerTxnShardRoot::dropClaimableBalances()
+{
+    unsupported("dropClaimableBalances");
+}
+
+void
+LedgerTxnShardRoot::dropLiquidityPools()
+{
+    unsupported("dropLiquidityPools");
+}
+
+void
+LedgerTxnShardRoot::dropSpeedexConfigs()
+{
+    unsupported("dropSpeedexConfigs");
+}
+
+double
+LedgerTxnShardRoot::getPrefetchHitRate() const
+{
+    return 0.0;
+}
+
+std::map<LedgerEntryType, EntryCacheLookups>
+LedgerTxnShardRoot::getEntryCacheLookups() const
+{
+    return {};
+}
+
+uint32_t
+LedgerTxnShardRoot::prefetch(UnorderedSet<LedgerKey> const& keys)
+{
+    return 0;
+}
+
+#ifdef BUILD_TESTS
+void
+LedgerTxnShardRoot::resetForFuzzer()
+{
+    abort();
+}
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+bool
+LedgerTxnShardRoot::bestOfferDebuggingEnabled() const
+{
+    return false;
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnShardRoot::getBestOfferSlow(Asset const& buying, Asset const& selling,
+                                     OfferDescriptor const* worseThan,
+                                     std::unordered_set<int64_t>& exclude)
+{
+    unsupported("getBestOfferSlow");
+}
+#endif
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTxn.h"
+#include "util/UnorderedMap.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stellar
+{
+
+// Read access to a LedgerTxn shared by several LedgerTxnShardRoots, each used
+// from its own thread. Reads of a LedgerTxn (and of LedgerTxnRoot below it)
+// fill caches, so they are serialized. The LedgerTxn must not be modified
+// while shards read it.
+class SharedLedgerTxnView
+{
+    AbstractLedgerTxn& mParent;
+    mutable std::mutex mMutex;
+
+  public:
+    explicit SharedLedgerTxnView(AbstractLedgerTxn& parent);
+
+    std::shared_ptr<InternalLedgerEntry const>
+    getNewestVersion(InternalLedgerKey const& key) const;
+
+    std::shared_ptr<LedgerEntry const>
+    loadSnapshotEntry(LedgerKey const& key) const;
+};
+
+// The root of a LedgerTxn run on another thread. Serves reads from a
+// SharedLedgerTxnView (caching them), and keeps what its child commits
+// instead of writing it anywhere. Queries that payments, speedex offers and
+// transaction validation never make (offers, inflation, bulk operations)
+// throw, and set mUnsupportedQuery, since callers may swallow the exception.
+class LedgerTxnShardRoot : public AbstractLedgerTxnParent
+{
+    SharedLedgerTxnView const& mView;
+    LedgerHeader const mHeader;
+
+    mutable UnorderedMap<InternalLedgerKey,
+                         std::shared_ptr<InternalLedgerEntry const>>
+        mReadCache;
+
+    AbstractLedgerTxn* mChild{nullptr};
+
+    [[noreturn]] void unsupported(char const* what) const;
+
+  public:
+    struct Change
+    {
+        InternalLedgerKey mKey;
+        // null if erased
+        std::shared_ptr<InternalLedgerEntry const> mEntry;
+    };
+
+    std::vector<Change> mChanges;
+    IOCOrderbookManager mIOCOffers;
+
+    mutable char const* mUnsupportedQuery{nullptr};
+
+    LedgerTxnShardRoot(SharedLedgerTxnView const& view,
+                       LedgerHeader const& header);
+
+    void addChild(AbstractLedgerTxn& child) override;
+    void commitChild(EntryIterator iter, LedgerTxnConsistency cons) override;
+    void rollbackChild() override;
+
+    UnorderedMap<LedgerKey, LedgerEntry> getAllOffers() override;
+
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling) override;
+
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling,
+                 OfferDescriptor const& worseThan) override;
+
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getOffersByAccountAndAsset(AccountID const& account,
+                               Asset const& asset) override;
+
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getPoolShareTrustLinesByAccountAndAsset(AccountID const& account,
+                                            Asset const& asset) override;
+
+    LedgerHeader const& getHeader() const override;
+
+    std::vector<InflationWinner>
+    getInflationWinners(size_t maxWinners, int64_t minBalance) override;
+
+    std::shared_ptr<InternalLedgerEntry const>
+    getNewestVersion(InternalLedgerKey const& key) const override;
+
+    std::shared_ptr<LedgerEntry const>
+    loadSnapshotEntry(LedgerKey const& key) const override;
+
+    uint64_t countObjects(LedgerEntryType let) const override;
+    uint64_t countObjects(LedgerEntryType let,
+                          LedgerRange const& ledgers) const override;
+
+    void deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const override;
+
+    void dropAccounts() override;
+    void dropData() override;
+    void dropOffers() override;
+    void dropTrustLines() override;
+    void dropClaimableBalances() override;
+    void dropLiquidityPools() override;
+    void dropSpeedexConfigs() override;
+
+    double getPrefetchHitRate() const override;
+    std::map<LedgerEntryType, EntryCacheLookups>
+    getEntryCacheLookups() const override;
+    uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+
+#ifdef BUILD_TESTS
+    void resetForFuzzer() override;
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+    bool bestOfferDebuggingEnabled() const override;
+
+    std::shared_ptr<LedgerEntry const>
+    getBestOfferSlow(Asset const& buying, Asset const& selling,
+                     OfferDescriptor const* worseThan,
+                     std::unordered_set<int64_t>& exclude) override;
+#endif
+};
+}
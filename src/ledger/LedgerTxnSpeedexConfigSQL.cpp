@@ -34,11 +34,13 @@ class BulkLoadSpeedexConfigOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
 
   public:
     BulkLoadSpeedexConfigOperation(Database& db,
-                                   UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+                                   UnorderedSet<LedgerKey> const& keys,
+                                   soci::session& session)
+        : mDb(db), mSession(session)
     {
     }
 
@@ -60,13 +62,13 @@ class BulkLoadSpeedexConfigOperation
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
 LedgerTxnRoot::Impl::bulkLoadSpeedexConfig(
-    UnorderedSet<LedgerKey> const& keys) const
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     if (!keys.empty())
     {
-        BulkLoadSpeedexConfigOperation op(mDatabase, keys);
+        BulkLoadSpeedexConfigOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
@@ -79,11 +81,13 @@ class BulkDeleteSpeedexConfigOperation
 {
     Database& mDb;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
 
   public:
     BulkDeleteSpeedexConfigOperation(Database& db, LedgerTxnConsistency cons,
-                                     std::vector<EntryIterator> const& entries)
-        : mDb(db), mCons(cons)
+                                     std::vector<EntryIterator> const& entries,
+                                     soci::session& session)
+        : mDb(db), mCons(cons), mSession(session)
     {
     }
 
@@ -108,10 +112,11 @@ class BulkDeleteSpeedexConfigOperation
 
 void
 LedgerTxnRoot::Impl::bulkDeleteSpeedexConfig (
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
-    BulkDeleteSpeedexConfigOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkDeleteSpeedexConfigOperation op(mDatabase, cons, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
     if (entries.size() > 0) {
         currentSpeedexConfig = getDefaultSpeedexConfig();
     }
@@ -121,11 +126,13 @@ class BulkUpsertSpeedexConfigOperation
     : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDb;
+    soci::session& mSession;
 
   public:
     BulkUpsertSpeedexConfigOperation(
-        Database& Db, std::vector<EntryIterator> const& entryIter)
-        : mDb(Db)
+        Database& Db, std::vector<EntryIterator> const& entryIter,
+        soci::session& session)
+        : mDb(Db), mSession(session)
     {
     }
 
@@ -151,10 +158,10 @@ class BulkUpsertSpeedexConfigOperation
 
 void
 LedgerTxnRoot::Impl::bulkUpsertSpeedexConfig(
-    std::vector<EntryIterator> const& entries)
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
-    BulkUpsertSpeedexConfigOperation op(mDatabase, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+    BulkUpsertSpeedexConfigOperation op(mDatabase, entries, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
     for (auto const& entry : entries) {
         currentSpeedexConfig = entry.entry().ledgerEntry();
     }
@@ -122,6 +122,7 @@ LedgerTxnRoot::Impl::loadPoolShareTrustLinesByAccountAndAsset(
 class BulkUpsertTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<std::string> mAssets;
     std::vector<std::string> mTrustLineEntries;
@@ -130,8 +131,9 @@ class BulkUpsertTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
   public:
     BulkUpsertTrustLinesOperation(Database& DB,
                                   std::vector<EntryIterator> const& entries,
-                                  uint32_t ledgerVersion)
-        : mDB(DB)
+                                  uint32_t ledgerVersion,
+                                  soci::session& session)
+        : mDB(DB), mSession(session)
     {
         mAccountIDs.reserve(entries.size());
         mAssets.reserve(entries.size());
@@ -168,7 +170,7 @@ class BulkUpsertTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
                           ") ON CONFLICT (accountid, asset) DO UPDATE SET "
                           "ledgerentry = excluded.ledgerentry, "
                           "lastmodified = excluded.lastmodified";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mAccountIDs));
         st.exchange(soci::use(mAssets));
@@ -216,7 +218,7 @@ class BulkUpsertTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
                           "ON CONFLICT (accountid, asset) DO UPDATE SET "
                           "ledgerentry = excluded.ledgerentry, "
                           "lastmodified = excluded.lastmodified";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strAssets));
@@ -239,14 +241,16 @@ class BulkDeleteTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
     LedgerTxnConsistency mCons;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<std::string> mAssets;
 
   public:
     BulkDeleteTrustLinesOperation(Database& DB, LedgerTxnConsistency cons,
                                   std::vector<EntryIterator> const& entries,
-                                  uint32_t ledgerVersion)
-        : mDB(DB), mCons(cons)
+                                  uint32_t ledgerVersion,
+                                  soci::session& session)
+        : mDB(DB), mCons(cons), mSession(session)
     {
         mAccountIDs.reserve(entries.size());
         mAssets.reserve(entries.size());
@@ -270,7 +274,7 @@ class BulkDeleteTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
     {
         std::string sql = "DELETE FROM trustlines WHERE accountid = :id "
                           "AND asset = :v1";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(mAccountIDs));
         st.exchange(soci::use(mAssets));
@@ -306,7 +310,7 @@ class BulkDeleteTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
                           ") "
                           "DELETE FROM trustlines WHERE "
                           "(accountid, asset) IN (SELECT * FROM r)";
-        auto prep = mDB.getPreparedStatement(sql);
+        auto prep = mDB.getPreparedStatement(sql, mSession);
         soci::statement& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strAssets));
@@ -326,24 +330,25 @@ class BulkDeleteTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
 
 void
 LedgerTxnRoot::Impl::bulkUpsertTrustLines(
-    std::vector<EntryIterator> const& entries)
+    std::vector<EntryIterator> const& entries, soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
     BulkUpsertTrustLinesOperation op(mDatabase, entries,
-                                     mHeader->ledgerVersion);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+                                     mHeader->ledgerVersion, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
 LedgerTxnRoot::Impl::bulkDeleteTrustLines(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons,
+    soci::session& session)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
     BulkDeleteTrustLinesOperation op(mDatabase, cons, entries,
-                                     mHeader->ledgerVersion);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
+                                     mHeader->ledgerVersion, session);
+    stellar::doDatabaseTypeSpecificOperation(session, op);
 }
 
 void
@@ -369,6 +374,7 @@ class BulkLoadTrustLinesOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
     Database& mDb;
+    soci::session& mSession;
     std::vector<std::string> mAccountIDs;
     std::vector<std::string> mAssets;
 
@@ -404,8 +410,9 @@ class BulkLoadTrustLinesOperation
 
   public:
     BulkLoadTrustLinesOperation(Database& db,
-                                UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+                                UnorderedSet<LedgerKey> const& keys,
+                                soci::session& session)
+        : mDb(db), mSession(session)
     {
         mAccountIDs.reserve(keys.size());
         mAssets.reserve(keys.size());
@@ -447,7 +454,7 @@ class BulkLoadTrustLinesOperation
                           ") SELECT accountid, asset, ledgerentry "
                           "FROM trustlines WHERE (accountid, asset) IN r";
 
-        auto prep = mDb.getPreparedStatement(sql);
+        auto prep = mDb.getPreparedStatement(sql, mSession);
         auto be = prep.statement().get_backend();
         if (be == nullptr)
         {
@@ -482,7 +489,8 @@ class BulkLoadTrustLinesOperation
             "ledgerentry "
             " FROM trustlines "
             "WHERE (accountid, asset) IN (SELECT * "
-            "FROM r)");
+            "FROM r)",
+            mSession);
         auto& st = prep.statement();
         st.exchange(soci::use(strAccountIDs));
         st.exchange(soci::use(strAssets));
@@ -493,15 +501,15 @@ class BulkLoadTrustLinesOperation
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
 LedgerTxnRoot::Impl::bulkLoadTrustLines(
-    UnorderedSet<LedgerKey> const& keys) const
+    UnorderedSet<LedgerKey> const& keys, soci::session& session) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(keys.size()));
     if (!keys.empty())
     {
-        BulkLoadTrustLinesOperation op(mDatabase, keys);
+        BulkLoadTrustLinesOperation op(mDatabase, keys, session);
         return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+            keys, stellar::doDatabaseTypeSpecificOperation(session, op));
     }
     else
     {
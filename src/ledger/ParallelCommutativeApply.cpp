@@ -0,0 +1,275 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/ParallelCommutativeApply.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnShard.h"
+#include "main/Application.h"
+#include "speedex/IOCOrderbookManager.h"
+#include "transactions/TransactionUtils.h"
+#include "util/ForkJoinPool.h"
+#include "util/GlobalChecks.h"
+#include "util/UnorderedMap.h"
+#include "util/XDROperators.h"
+
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include <Tracy.hpp>
+#include <memory>
+#include <stdexcept>
+
+namespace stellar
+{
+
+namespace
+{
+
+bool
+hasBalance(InternalLedgerEntry const& entry)
+{
+    if (entry.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+    {
+        return false;
+    }
+    auto type = entry.ledgerEntry().data.type();
+    return type == ACCOUNT || type == TRUSTLINE;
+}
+
+// entry must satisfy hasBalance
+int64_t&
+balanceOf(LedgerEntry& le)
+{
+    return le.data.type() == ACCOUNT ? le.data.account().balance
+                                     : le.data.trustLine().balance;
+}
+
+int64_t
+balanceOf(LedgerEntry const& le)
+{
+    return balanceOf(const_cast<LedgerEntry&>(le));
+}
+
+// Whether le's balance and buying liabilities fit under its limit (INT64_MAX
+// for accounts), as getMaxAmountReceive(header, le) >= 0 would say, without
+// overflowing. Each shard only checked its own credits against the limit, so
+// several of them together can go past it, where a serial apply would have
+// failed some of the credits instead.
+bool
+withinReceiveLimit(LedgerTxnHeader const& header, LedgerEntry const& le)
+{
+    __int128 limit = le.data.type() == ACCOUNT ? INT64_MAX
+                                               : le.data.trustLine().limit;
+    __int128 used = balanceOf(le);
+    if (header.current().ledgerVersion >= 10)
+    {
+        used += getBuyingLiabilities(header, le);
+    }
+    return used <= limit;
+}
+
+// Accumulates the changes of every shard to one entry.
+struct MergedChange
+{
+    InternalLedgerKey mKey;
+    // as of the start of the phase; null if it did not exist
+    std::shared_ptr<InternalLedgerEntry const> mBase;
+
+    // the value to write back (modulo the balance); null to erase
+    std::shared_ptr<InternalLedgerEntry const> mEntry;
+    size_t mNumShards{0};
+
+    // only set for entries that exist before and after, and have a balance
+    bool mBalanceOnly{true};
+    bool mHasOtherChanges{false};
+    __int128 mBalanceDelta{0};
+};
+
+void
+mergeChange(MergedChange& merged, LedgerTxnShardRoot::Change const& change)
+{
+    merged.mNumShards++;
+
+    if (!merged.mBase || !change.mEntry || !hasBalance(*merged.mBase))
+    {
+        // creations, deletions and other entry types can't be combined
+        if (merged.mNumShards > 1)
+        {
+            throw std::runtime_error(
+                "conflicting parallel commutative updates to a ledger entry");
+        }
+        merged.mBalanceOnly = false;
+        merged.mEntry = change.mEntry;
+        return;
+    }
+    if (!merged.mBalanceOnly)
+    {
+        throw std::runtime_error(
+            "conflicting parallel commutative updates to a ledger entry");
+    }
+
+    auto const& base = merged.mBase->ledgerEntry();
+    auto current = change.mEntry->ledgerEntry();
+
+    merged.mBalanceDelta += balanceOf(current) - balanceOf(base);
+
+    // what is left once the balance (and lastModifiedLedgerSeq) is undone
+    balanceOf(current) = balanceOf(base);
+    current.lastModifiedLedgerSeq = base.lastModifiedLedgerSeq;
+    if (!(current == base))
+    {
+        if (merged.mHasOtherChanges)
+        {
+            throw std::runtime_error(
+                "conflicting parallel commutative updates to a ledger entry");
+        }
+        merged.mHasOtherChanges = true;
+        merged.mEntry = change.mEntry;
+    }
+    else if (!merged.mEntry)
+    {
+        merged.mEntry = change.mEntry;
+    }
+}
+}
+
+ParallelCommutativeApply::ParallelCommutativeApply(Application& app,
+                                                   ForkJoinPool& workers)
+    : mApp(app)
+    , mWorkers(workers)
+    , mTransactionApply(
+          app.getMetrics().NewTimer({"ledger", "transaction", "apply"}))
+{
+}
+
+size_t
+ParallelCommutativeApply::shardFor(TransactionFrameBase const& tx)
+{
+    // source account keys are uniformly distributed, and (unlike std::hash)
+    // their bytes are the same on every platform
+    auto source = tx.getSourceID();
+    auto const& key = source.ed25519();
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefix); i++)
+    {
+        prefix = (prefix << 8) | key[i];
+    }
+    return prefix % NUM_SHARDS;
+}
+
+void
+ParallelCommutativeApply::apply(std::vector<TransactionFrameBasePtr> const& txs,
+                                AbstractLedgerTxn& ltx,
+                                std::vector<TransactionMeta>& metas)
+{
+    ZoneScoped;
+
+    std::vector<std::vector<size_t>> shardTxs(NUM_SHARDS);
+    for (size_t i = 0; i < txs.size(); i++)
+    {
+        releaseAssert(txs[i]->isCommutativeTransaction());
+        shardTxs[shardFor(*txs[i])].push_back(i);
+    }
+
+    metas.assign(txs.size(), TransactionMeta(2));
+
+    SharedLedgerTxnView view(ltx);
+    LedgerHeader const header = ltx.getHeader();
+
+    std::vector<std::unique_ptr<LedgerTxnShardRoot>> roots;
+    for (size_t shard = 0; shard < NUM_SHARDS; shard++)
+    {
+        roots.push_back(std::make_unique<LedgerTxnShardRoot>(view, header));
+    }
+
+    mWorkers.parallelFor(NUM_SHARDS, [&](size_t shard) {
+        if (shardTxs[shard].empty())
+        {
+            return;
+        }
+        LedgerTxn ltxShard(*roots[shard]);
+        for (auto txIdx : shardTxs[shard])
+        {
+            auto txTime = mTransactionApply.TimeScope();
+            txs[txIdx]->apply(mApp, ltxShard, metas[txIdx]);
+        }
+        ltxShard.commit();
+    });
+
+    for (auto const& root : roots)
+    {
+        if (root->mUnsupportedQuery)
+        {
+            throw std::runtime_error(
+                std::string("unsupported during parallel commutative apply: ") +
+                root->mUnsupportedQuery);
+        }
+    }
+
+    // Merge in shard order (and, within a shard, commit order), so that the
+    // result does not depend on scheduling.
+    UnorderedMap<InternalLedgerKey, size_t> mergedIndex;
+    std::vector<MergedChange> merged;
+    for (auto const& root : roots)
+    {
+        for (auto const& change : root->mChanges)
+        {
+            auto iter = mergedIndex.find(change.mKey);
+            if (iter == mergedIndex.end())
+            {
+                iter = mergedIndex.emplace(change.mKey, merged.size()).first;
+                merged.push_back(MergedChange{
+                    change.mKey, view.getNewestVersion(change.mKey)});
+            }
+            mergeChange(merged[iter->second], change);
+        }
+    }
+
+    // Nothing above touched ltx, so failures so far leave it unchanged.
+    LedgerTxn ltxMerge(ltx);
+    for (auto& change : merged)
+    {
+        if (!change.mEntry)
+        {
+            if (change.mBase)
+            {
+                ltxMerge.erase(change.mKey);
+            }
+            continue;
+        }
+
+        auto entry = *change.mEntry;
+        if (change.mBalanceOnly)
+        {
+            __int128 total = change.mBalanceDelta +
+                             balanceOf(change.mBase->ledgerEntry());
+            if (total < 0 || total > INT64_MAX)
+            {
+                throw std::runtime_error(
+                    "parallel commutative apply balance out of range");
+            }
+            balanceOf(entry.ledgerEntry()) = static_cast<int64_t>(total);
+            if (change.mBalanceDelta > 0 &&
+                !withinReceiveLimit(ltxMerge.loadHeader(), entry.ledgerEntry()))
+            {
+                throw std::runtime_error(
+                    "parallel commutative apply credits exceed a limit");
+            }
+        }
+
+        if (change.mBase)
+        {
+            ltxMerge.load(change.mKey).currentGeneralized() = entry;
+        }
+        else
+        {
+            ltxMerge.create(entry);
+        }
+    }
+    for (auto const& root : roots)
+    {
+        ltxMerge.getSpeedexIOCOffers().commitChild(root->mIOCOffers);
+    }
+    ltxMerge.commit();
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrameBase.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <vector>
+
+namespace medida
+{
+class Timer;
+}
+
+namespace stellar
+{
+
+class AbstractLedgerTxn;
+class Application;
+class ForkJoinPool;
+
+// Applies the commutative phase of a transaction set (payments and
+// CreateSpeedexIOCOffer, see TxSetCommutativityRequirements) across a
+// ForkJoinPool.
+//
+// Transactions are sharded by source account into NUM_SHARDS shards (a
+// constant, so results never depend on the number of threads). Each shard
+// applies its transactions, in transaction set order, in its own LedgerTxn
+// over a read-only view of ltx as of the start of the phase. Shards are then
+// merged into ltx in shard order:
+//
+//  - an entry modified by one shard takes that shard's value;
+//  - an account or trustline modified by several shards takes the sum of
+//    their balance deltas, plus the other changes of at most one of them;
+//  - anything else modified by several shards is an error;
+//  - speedex IOC offers of all shards are added to ltx's orderbooks.
+//
+// The commutativity requirements (every debit is covered by the starting
+// balance, and commutative trustlines can't hit their limits) make every
+// transaction's result, and so the merged state, the same as a serial apply.
+// Merges that would break them (an entry changed in conflicting ways, or
+// credits past a limit) throw, and the caller applies the transactions
+// serially instead. Transaction meta is not the same as a serial apply: each
+// transaction's meta shows the entries as seen by its shard, without the
+// changes made by other shards, so callers that publish meta must not use
+// this.
+class ParallelCommutativeApply
+{
+    Application& mApp;
+    ForkJoinPool& mWorkers;
+    medida::Timer& mTransactionApply;
+
+  public:
+    static constexpr size_t NUM_SHARDS = 64;
+
+    ParallelCommutativeApply(Application& app, ForkJoinPool& workers);
+
+    // Applies every transaction in txs (which must all be commutative) to
+    // ltx, which must not have a child. metas[i] receives the meta of
+    // txs[i]. Throws if the shards can't be merged; ltx is then unchanged.
+    void apply(std::vector<TransactionFrameBasePtr> const& txs,
+               AbstractLedgerTxn& ltx, std::vector<TransactionMeta>& metas);
+
+    static size_t shardFor(TransactionFrameBase const& tx);
+};
+}
@@ -0,0 +1,196 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/TxSetPrefetcher.h"
+#include "database/Database.h"
+#include "herder/TxSetFrame.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
+#include "util/Logging.h"
+#include "util/UnorderedMap.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include <Tracy.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <soci.h>
+
+namespace stellar
+{
+
+struct TxSetPrefetcher::Job
+{
+    Hash const mTxSetHash;
+    std::atomic<bool> mCancelled{false};
+
+    std::mutex mMutex;
+    std::condition_variable mDoneCV;
+    bool mDone{false};
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> mEntries;
+
+    explicit Job(Hash const& txSetHash) : mTxSetHash(txSetHash)
+    {
+    }
+};
+
+TxSetPrefetcher::TxSetPrefetcher(Application& app)
+    : mApp(app)
+    , mAdopted(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "background-adopted"}, "entry"))
+    , mDropped(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "background-invalidated"}, "entry"))
+{
+}
+
+TxSetPrefetcher::~TxSetPrefetcher()
+{
+    discard();
+}
+
+void
+TxSetPrefetcher::discard()
+{
+    if (mJob)
+    {
+        mJob->mCancelled = true;
+        mJob.reset();
+    }
+    mInvalidated.clear();
+}
+
+void
+TxSetPrefetcher::start(Hash const& txSetHash, TxSetFrame const& txSet)
+{
+    ZoneScoped;
+    if (mJob && mJob->mTxSetHash == txSetHash)
+    {
+        return;
+    }
+    discard();
+
+    auto root = dynamic_cast<LedgerTxnRoot*>(&mApp.getLedgerTxnRoot());
+    if (!root || !mApp.getDatabase().canUsePool())
+    {
+        return;
+    }
+
+    UnorderedSet<LedgerKey> keys;
+    for (auto const& tx : txSet.mTransactions)
+    {
+        tx->insertKeysForFeeProcessing(keys);
+        tx->insertKeysForTxApply(keys);
+    }
+    if (keys.empty())
+    {
+        return;
+    }
+
+    mJob = std::make_shared<Job>(txSetHash);
+    mInvalidatedThrough = mApp.getLedgerManager().getLastClosedLedgerNum();
+
+    // getPool creates the pool on first use, so call it here
+    auto& pool = mApp.getDatabase().getPool();
+    mApp.postOnBackgroundThread(
+        [job = mJob, keys = std::move(keys), root, &pool]() {
+            if (job->mCancelled)
+            {
+                std::lock_guard<std::mutex> lock(job->mMutex);
+                job->mDone = true;
+                job->mDoneCV.notify_all();
+                return;
+            }
+            UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> entries;
+            try
+            {
+                soci::session session(pool);
+                soci::transaction tx(session);
+                entries = root->loadEntriesOnSession(keys, session);
+            }
+            catch (std::exception& e)
+            {
+                CLOG_WARNING(Ledger, "Background prefetch failed: {}",
+                             e.what());
+                entries.clear();
+            }
+            {
+                std::lock_guard<std::mutex> lock(job->mMutex);
+                job->mEntries = std::move(entries);
+                job->mDone = true;
+            }
+            job->mDoneCV.notify_all();
+        },
+        "TxSetPrefetcher");
+}
+
+void
+TxSetPrefetcher::invalidate(LedgerKey const& key)
+{
+    if (mJob)
+    {
+        mInvalidated.insert(key);
+    }
+}
+
+void
+TxSetPrefetcher::ledgerClosed(uint32_t ledgerSeq)
+{
+    if (!mJob)
+    {
+        return;
+    }
+    if (ledgerSeq == mInvalidatedThrough + 1)
+    {
+        mInvalidatedThrough = ledgerSeq;
+    }
+    else
+    {
+        discard();
+    }
+}
+
+void
+TxSetPrefetcher::adopt(Hash const& txSetHash, uint32_t lastClosedLedgerSeq)
+{
+    ZoneScoped;
+    if (!mJob)
+    {
+        return;
+    }
+    if (mJob->mTxSetHash == txSetHash &&
+        mInvalidatedThrough == lastClosedLedgerSeq)
+    {
+        // Don't wait for a load still in progress: the synchronous prefetch
+        // is no slower than waiting would be.
+        std::unique_lock<std::mutex> lock(mJob->mMutex, std::try_to_lock);
+        if (lock.owns_lock() && mJob->mDone)
+        {
+            auto& entries = mJob->mEntries;
+            size_t dropped = 0;
+            for (auto const& key : mInvalidated)
+            {
+                dropped += entries.erase(key);
+            }
+            auto& root = dynamic_cast<LedgerTxnRoot&>(mApp.getLedgerTxnRoot());
+            mAdopted.Mark(root.addPrefetchedEntries(entries));
+            mDropped.Mark(dropped);
+        }
+    }
+    discard();
+}
+
+#ifdef BUILD_TESTS
+void
+TxSetPrefetcher::waitUntilLoaded()
+{
+    if (mJob)
+    {
+        std::unique_lock<std::mutex> lock(mJob->mMutex);
+        mJob->mDoneCV.wait(lock, [&]() { return mJob->mDone; });
+    }
+}
+#endif
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/UnorderedSet.h"
+#include "xdr/Stellar-ledger-entries.h"
+#include "xdr/Stellar-types.h"
+
+#include <memory>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+
+class Application;
+class TxSetFrame;
+
+// Prefetches, in the background, the ledger entries that a candidate
+// transaction set for the next ledger will load, so that the SQL bulk loads
+// of LedgerManagerImpl's prefetch are off the ledger close critical path.
+//
+// start() collects the keys of a transaction set and bulk loads them on a
+// background thread, through a session from the database connection pool,
+// into a staging area. When the next ledger starts applying, adopt() moves
+// the staged entries into the LedgerTxnRoot entry cache if that ledger
+// applies the same transaction set and the load has finished; the
+// synchronous prefetch then only loads what is still missing.
+//
+// The background load may or may not see the writes of any ledger that
+// closes after start(), so every key written by such a ledger is dropped
+// from the staged entries. LedgerManagerImpl reports those keys, ledger by
+// ledger; if a ledger's keys go unreported (e.g. the ledger state was reset
+// by catchup), the staged entries are discarded.
+//
+// All methods are called from the main thread.
+class TxSetPrefetcher
+{
+    struct Job;
+
+    Application& mApp;
+    std::shared_ptr<Job> mJob;
+
+    // keys written by the ledgers closed since mJob started
+    UnorderedSet<LedgerKey> mInvalidated;
+    // the last ledger whose writes are in mInvalidated
+    uint32_t mInvalidatedThrough{0};
+
+    medida::Meter& mAdopted;
+    medida::Meter& mDropped;
+
+    void discard();
+
+  public:
+    explicit TxSetPrefetcher(Application& app);
+    ~TxSetPrefetcher();
+
+    // Starts prefetching for txSet, a candidate for the ledger after the
+    // last closed ledger, replacing any prefetch for another transaction
+    // set. Does nothing if the database can't be read from another thread or
+    // the ledger state is not in the database.
+    void start(Hash const& txSetHash, TxSetFrame const& txSet);
+
+    // Records that the ledger being closed writes key.
+    void invalidate(LedgerKey const& key);
+
+    // Records that all writes of ledgerSeq have been reported.
+    void ledgerClosed(uint32_t ledgerSeq);
+
+    // Called as ledger lastClosedLedgerSeq + 1 starts applying txSetHash.
+    // Adopts the staged entries if they are for txSetHash and ready, and
+    // ends the current prefetch either way.
+    void adopt(Hash const& txSetHash, uint32_t lastClosedLedgerSeq);
+
+#ifdef BUILD_TESTS
+    // Blocks until the background load of the current prefetch, if any, is
+    // done.
+    void waitUntilLoaded();
+#endif
+};
+}
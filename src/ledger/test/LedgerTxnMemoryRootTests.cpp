@@ -0,0 +1,100 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketManager.h"
+#include "database/Database.h"
+#include "history/HistoryArchive.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnMemoryRoot.h"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "util/XDROperators.h"
+
+#include <lib/catch.hpp>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("in-memory ledger state", "[ledger][memoryroot]")
+{
+    Config cfg(getTestConfig());
+    cfg.IN_MEMORY_LEDGER_STATE = true;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& lm = app->getLedgerManager();
+    auto& root = dynamic_cast<LedgerTxnMemoryRoot&>(app->getLedgerTxnRoot());
+
+    auto rootAccount = TestAccount::createRoot(*app);
+    auto sk1 = getAccount("a1");
+    auto sk2 = getAccount("a2");
+    auto balance = lm.getLastMinBalance(2) + 10000000;
+    closeLedgerOn(*app, 2, 1, 1, 2022,
+                  {rootAccount.tx({createAccount(sk1.getPublicKey(), balance),
+                                   createAccount(sk2.getPublicKey(), balance)})});
+
+    TestAccount a2(*app, sk2);
+    auto native = makeNativeAsset();
+    auto usd = makeAsset(sk2, "USD");
+    closeLedgerOn(*app, 3, 2, 1, 2022,
+                  {a2.tx({manageOffer(0, usd, native, Price{2, 1}, 100),
+                          manageOffer(0, usd, native, Price{1, 1}, 100)})});
+
+    auto checkState = [&]() {
+        REQUIRE(root.countObjects(ACCOUNT) == 3);
+        REQUIRE(root.countObjects(OFFER) == 2);
+        REQUIRE(root.countObjects(OFFER, LedgerRange(3, 1)) == 2);
+
+        auto best = root.getBestOffer(native, usd);
+        REQUIRE(best);
+        REQUIRE(best->data.offer().price == Price{1, 1});
+        auto next = root.getBestOffer(
+            native, usd,
+            OfferDescriptor{best->data.offer().price,
+                            best->data.offer().offerID});
+        REQUIRE(next);
+        REQUIRE(next->data.offer().price == Price{2, 1});
+        REQUIRE(!root.getBestOffer(usd, native));
+
+        REQUIRE(root.getOffersByAccountAndAsset(sk2.getPublicKey(), usd)
+                    .size() == 2);
+        REQUIRE(root.getOffersByAccountAndAsset(sk1.getPublicKey(), usd)
+                    .empty());
+    };
+    checkState();
+
+    // nothing went to the ledger entry tables
+    uint64_t sqlAccounts = 1;
+    app->getDatabase().getSession() << "SELECT COUNT(*) FROM accounts;",
+        soci::into(sqlAccounts);
+    REQUIRE(sqlAccounts == 0);
+
+    SECTION("matches the buckets")
+    {
+        auto state = app->getBucketManager().loadCompleteLedgerState(
+            lm.getLastClosedLedgerHAS());
+        for (auto const& kv : state)
+        {
+            auto entry = root.loadSnapshotEntry(kv.first);
+            REQUIRE(entry);
+            REQUIRE(*entry == kv.second);
+        }
+
+        root.loadFromBuckets(state);
+        REQUIRE(state.empty());
+        checkState();
+    }
+
+    SECTION("delete modified since")
+    {
+        root.deleteObjectsModifiedOnOrAfterLedger(3);
+        REQUIRE(root.countObjects(OFFER) == 0);
+        REQUIRE(!root.getBestOffer(native, usd));
+        // a2 was last modified by its offers
+        REQUIRE(root.countObjects(ACCOUNT) == 2);
+    }
+}
@@ -1440,6 +1440,151 @@ TEST_CASE("LedgerTxn loadWithoutRecord", "[ledgertxn]")
     }
 }
 
+TEST_CASE("LedgerTxn addCommutativeBalanceDelta", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+
+    LedgerEntry le;
+    le.lastModifiedLedgerSeq = 1;
+    le.data.type(ACCOUNT);
+    le.data.account() = LedgerTestUtils::generateValidAccountEntry();
+    le.data.account().balance = 1000;
+    LedgerKey key = LedgerEntryKey(le);
+
+    auto withBalance = [&](int64_t balance) {
+        auto res = le;
+        res.data.account().balance = balance;
+        return res;
+    };
+    auto balanceOf = [&](AbstractLedgerTxn& ltx) {
+        return ltx.getNewestVersion(key)->ledgerEntry().data.account().balance;
+    };
+
+    LedgerTxn ltx1(app->getLedgerTxnRoot());
+    REQUIRE(ltx1.create(le));
+
+    SECTION("fails with children")
+    {
+        LedgerTxn ltx2(ltx1);
+        REQUIRE_THROWS_AS(ltx1.addCommutativeBalanceDelta(key, 5),
+                          std::runtime_error);
+    }
+
+    SECTION("fails if active")
+    {
+        LedgerTxn ltx2(ltx1);
+        auto entry = ltx2.load(key);
+        REQUIRE_THROWS_AS(ltx2.addCommutativeBalanceDelta(key, 5),
+                          std::runtime_error);
+    }
+
+    SECTION("fails for entries without a balance")
+    {
+        LedgerTxn ltx2(ltx1);
+        LedgerKey offerKey(OFFER);
+        offerKey.offer().sellerID = le.data.account().accountID;
+        REQUIRE_THROWS_AS(ltx2.addCommutativeBalanceDelta(offerKey, 5),
+                          std::runtime_error);
+    }
+
+    SECTION("folded directly into an entry recorded here")
+    {
+        REQUIRE_NOTHROW(ltx1.addCommutativeBalanceDelta(key, 5));
+        REQUIRE(ltx1.getCommutativeBalanceDeltas().empty());
+        REQUIRE(balanceOf(ltx1) == 1005);
+    }
+
+    SECTION("visible to children and folded on load")
+    {
+        LedgerTxn ltx2(ltx1);
+        ltx2.addCommutativeBalanceDelta(key, 5);
+        ltx2.addCommutativeBalanceDelta(key, 7);
+        REQUIRE(ltx2.getCommutativeBalanceDeltas().at(key) == 12);
+
+        {
+            LedgerTxn ltx3(ltx2);
+            REQUIRE(balanceOf(ltx3) == 1012);
+            REQUIRE(ltx3.loadWithoutRecord(key).current() ==
+                    withBalance(1012));
+        }
+
+        ltx2.load(key);
+        REQUIRE(ltx2.getCommutativeBalanceDeltas().empty());
+        REQUIRE(balanceOf(ltx2) == 1012);
+    }
+
+    SECTION("passed to a LedgerTxn parent on commit")
+    {
+        {
+            LedgerTxn ltx2(ltx1);
+            {
+                LedgerTxn ltx3(ltx2);
+                ltx3.addCommutativeBalanceDelta(key, 5);
+                auto changes = ltx3.getChanges();
+                REQUIRE(changes.size() == 2);
+                REQUIRE(changes[0].state() == le);
+                REQUIRE(changes[1].updated().data.account().balance == 1005);
+                ltx3.commit();
+            }
+            ltx2.addCommutativeBalanceDelta(key, 7);
+            REQUIRE(ltx2.getCommutativeBalanceDeltas().at(key) == 12);
+            REQUIRE(balanceOf(ltx2) == 1012);
+            ltx2.commit();
+        }
+        // ltx1 already records the entry, so the delta is folded into it
+        REQUIRE(ltx1.getCommutativeBalanceDeltas().empty());
+        REQUIRE(balanceOf(ltx1) == 1012);
+    }
+
+    SECTION("parent delta dropped once a child commits the loaded entry")
+    {
+        {
+            LedgerTxn ltx2(ltx1);
+            ltx2.addCommutativeBalanceDelta(key, 5);
+            {
+                LedgerTxn ltx3(ltx2);
+                ltx3.load(key);
+                ltx3.addCommutativeBalanceDelta(key, 7);
+                ltx3.commit();
+            }
+            REQUIRE(ltx2.getCommutativeBalanceDeltas().empty());
+            REQUIRE(balanceOf(ltx2) == 1012);
+        }
+        REQUIRE(balanceOf(ltx1) == 1000);
+    }
+
+    SECTION("folded on commit to the root")
+    {
+        ltx1.commit();
+        {
+            LedgerTxn ltx2(app->getLedgerTxnRoot());
+            ltx2.addCommutativeBalanceDelta(key, 5);
+            ltx2.commit();
+        }
+        LedgerTxn ltx2(app->getLedgerTxnRoot());
+        REQUIRE(balanceOf(ltx2) == 1005);
+    }
+
+    SECTION("overflow")
+    {
+        LedgerTxn ltx2(ltx1);
+        ltx2.addCommutativeBalanceDelta(key, INT64_MAX);
+        REQUIRE_THROWS_AS(ltx2.addCommutativeBalanceDelta(key, 1),
+                          std::runtime_error);
+        REQUIRE(ltx2.getCommutativeBalanceDeltas().at(key) == INT64_MAX);
+    }
+
+    SECTION("dropped on rollback")
+    {
+        {
+            LedgerTxn ltx2(ltx1);
+            ltx2.addCommutativeBalanceDelta(key, 5);
+        }
+        REQUIRE(balanceOf(ltx1) == 1000);
+    }
+}
+
 static void
 applyLedgerTxnUpdates(
     AbstractLedgerTxn& ltx,
@@ -2538,6 +2683,106 @@ TEST_CASE("LedgerTxnRoot prefetch", "[ledgertxn]")
 #endif
 }
 
+TEST_CASE("LedgerTxnRoot entry cache write-through", "[ledgertxn]")
+{
+    auto runTest = [&](Config::TestDbMode mode, bool writeThrough) {
+        VirtualClock clock;
+        auto cfg = getTestConfig(0, mode);
+        cfg.ENTRY_CACHE_WRITE_THROUGH = writeThrough;
+        auto app = createTestApplication(clock, cfg);
+        auto& root = app->getLedgerTxnRoot();
+
+        LedgerEntry le;
+        le.lastModifiedLedgerSeq = 1;
+        le.data.type(ACCOUNT);
+        le.data.account() = LedgerTestUtils::generateValidAccountEntry();
+        le.data.account().balance = 1000;
+        auto key = LedgerEntryKey(le);
+
+        auto expectLookup = [&](bool hit) {
+            auto lookups = root.getEntryCacheLookups();
+            REQUIRE(lookups.size() == 1);
+            REQUIRE(lookups[ACCOUNT].hits == (hit ? 1 : 0));
+            REQUIRE(lookups[ACCOUNT].misses == (hit ? 0 : 1));
+        };
+
+        {
+            LedgerTxn ltx(root);
+            ltx.create(le);
+            ltx.commit();
+        }
+        REQUIRE(root.getEntryCacheLookups().empty());
+
+        {
+            LedgerTxn ltx(root);
+            {
+                auto entry = ltx.load(key);
+                REQUIRE(entry.current().data.account().balance == 1000);
+                expectLookup(writeThrough);
+                entry.current().data.account().balance = 2000;
+            }
+            ltx.commit();
+        }
+
+        {
+            LedgerTxn ltx(root);
+            REQUIRE(ltx.loadSnapshotEntry(key)->data.account().balance ==
+                    2000);
+            {
+                auto entry = ltx.load(key);
+                REQUIRE(entry.current().data.account().balance == 2000);
+                expectLookup(writeThrough);
+                entry.erase();
+            }
+            ltx.commit();
+        }
+
+        {
+            LedgerTxn ltx(root);
+            REQUIRE(!ltx.loadSnapshotEntry(key));
+            REQUIRE(!ltx.load(key));
+            expectLookup(writeThrough);
+        }
+
+        // Rolling back ledgers must not leave the entry in any cache.
+        le.lastModifiedLedgerSeq = 5;
+        {
+            LedgerTxn ltx(root);
+            ltx.create(le);
+            ltx.commit();
+        }
+        {
+            LedgerTxn ltx(root);
+            REQUIRE(ltx.loadSnapshotEntry(key));
+        }
+        root.deleteObjectsModifiedOnOrAfterLedger(5);
+        {
+            LedgerTxn ltx(root);
+            REQUIRE(!ltx.loadSnapshotEntry(key));
+            REQUIRE(!ltx.load(key));
+        }
+    };
+
+    SECTION("default")
+    {
+        SECTION("write-through")
+        {
+            runTest(Config::TESTDB_DEFAULT, true);
+        }
+        SECTION("cleared on commit")
+        {
+            runTest(Config::TESTDB_DEFAULT, false);
+        }
+    }
+
+#ifdef USE_POSTGRES
+    SECTION("postgresql")
+    {
+        runTest(Config::TESTDB_POSTGRESQL, true);
+    }
+#endif
+}
+
 TEST_CASE("Create performance benchmark", "[!hide][createbench]")
 {
     auto runTest = [&](Config::TestDbMode mode, bool loading) {
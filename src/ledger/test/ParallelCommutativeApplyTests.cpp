@@ -0,0 +1,160 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnEntry.h"
+#include "ledger/ParallelCommutativeApply.h"
+#include "main/Application.h"
+#include "speedex/test/TatonnementTestUtils.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "transactions/TransactionUtils.h"
+#include "util/ForkJoinPool.h"
+
+#include <lib/catch.hpp>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("parallel commutative apply matches serial apply", "[ledger]")
+{
+    Config cfg(getTestConfig());
+    cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    auto issuer = getIssuanceLimitedAccount(
+        root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+    auto assets = makeAssets(2, issuer);
+
+    size_t const numTraders = 12;
+    std::vector<TestAccount> traders;
+    for (size_t i = 0; i < numTraders; i++)
+    {
+        traders.push_back(root.create(
+            "trader" + std::to_string(i),
+            app->getLedgerManager().getLastMinBalance(10) + 1000000));
+        setNonIssuerTrustlines(traders.back(), assets);
+        fundTrader(traders.back(), issuer, assets, 100000);
+    }
+
+    // every trader pays a few others (so several shards credit the same
+    // destinations), and sends several transactions itself
+    std::vector<TransactionFrameBasePtr> txs;
+    for (size_t round = 0; round < 3; round++)
+    {
+        for (size_t i = 0; i < numTraders; i++)
+        {
+            auto& dest = traders[(i + 1 + round) % numTraders];
+            txs.push_back(traders[i].commutativeTx(
+                {payment(dest, assets[round % 2], 100 + i),
+                 payment(dest, 1000 * (round + 1))}));
+        }
+    }
+
+    auto collectState = [&](AbstractLedgerTxn& ltx) {
+        std::vector<LedgerEntry> entries;
+        for (auto& trader : traders)
+        {
+            entries.push_back(
+                ltx.load(accountKey(trader.getPublicKey())).current());
+            for (auto const& asset : assets)
+            {
+                entries.push_back(
+                    ltx.load(trustlineKey(trader.getPublicKey(), asset))
+                        .current());
+            }
+        }
+        return entries;
+    };
+
+    std::vector<TransactionResult> serialResults;
+    std::vector<LedgerEntry> serialState;
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (auto const& tx : txs)
+        {
+            TransactionMeta meta(2);
+            REQUIRE(tx->apply(*app, ltx, meta));
+            serialResults.push_back(tx->getResult());
+        }
+        serialState = collectState(ltx);
+    }
+
+    for (size_t numThreads : {1, 4})
+    {
+        ForkJoinPool workers(numThreads);
+        ParallelCommutativeApply engine(*app, workers);
+
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        std::vector<TransactionMeta> metas;
+        engine.apply(txs, ltx, metas);
+
+        REQUIRE(metas.size() == txs.size());
+        for (size_t i = 0; i < txs.size(); i++)
+        {
+            REQUIRE(txs[i]->getResult() == serialResults[i]);
+        }
+        REQUIRE(collectState(ltx) == serialState);
+    }
+}
+
+TEST_CASE("parallel commutative apply rejects credits past a limit",
+          "[ledger]")
+{
+    Config cfg(getTestConfig());
+    cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    auto issuer = getIssuanceLimitedAccount(
+        root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+    auto assets = makeAssets(1, issuer);
+    auto const& asset = assets[0];
+
+    auto minBalance = app->getLedgerManager().getLastMinBalance(10);
+    auto dest = root.create("dest", minBalance);
+    dest.changeTrust(asset, 1000);
+
+    // two senders whose payments land in different shards (shards only
+    // depend on the source account, so probe with a dummy sequence number)
+    auto shardOf = [&](TestAccount& account) {
+        return ParallelCommutativeApply::shardFor(
+            *account.commutativeTx({payment(dest, asset, 600)}, 1));
+    };
+    std::vector<TestAccount> senders;
+    for (size_t i = 0; senders.size() < 2; i++)
+    {
+        auto sender =
+            root.create("sender" + std::to_string(i), minBalance + 1000000);
+        if (senders.empty() || shardOf(sender) != shardOf(senders[0]))
+        {
+            setNonIssuerTrustlines(sender, assets);
+            fundTrader(sender, issuer, assets, 100000);
+            senders.push_back(sender);
+        }
+    }
+
+    // each payment fits under the limit on its own, but not both together
+    std::vector<TransactionFrameBasePtr> txs;
+    for (auto& sender : senders)
+    {
+        txs.push_back(sender.commutativeTx({payment(dest, asset, 600)}));
+    }
+
+    ForkJoinPool workers(4);
+    ParallelCommutativeApply engine(*app, workers);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+    std::vector<TransactionMeta> metas;
+    REQUIRE_THROWS_AS(engine.apply(txs, ltx, metas), std::runtime_error);
+    REQUIRE(ltx.load(trustlineKey(dest.getPublicKey(), asset))
+                .current()
+                .data.trustLine()
+                .balance == 0);
+}
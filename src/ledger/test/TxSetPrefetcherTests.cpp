@@ -0,0 +1,79 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SecretKey.h"
+#include "herder/TxSetFrame.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/TxSetPrefetcher.h"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "transactions/TransactionUtils.h"
+
+#include <lib/catch.hpp>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("background tx set prefetch", "[ledger][prefetch]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(
+        clock, getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    auto& lm = app->getLedgerManager();
+    auto& root = dynamic_cast<LedgerTxnRoot&>(app->getLedgerTxnRoot());
+
+    auto rootAccount = TestAccount::createRoot(*app);
+    auto a1 = rootAccount.create("a1", lm.getLastMinBalance(1));
+    auto a2 = rootAccount.create("a2", lm.getLastMinBalance(1));
+    auto k1 = accountKey(a1.getPublicKey());
+    auto k2 = accountKey(a2.getPublicKey());
+
+    TxSetFrame txSet(lm.getLastClosedLedgerHeader().hash);
+    txSet.add(a1.tx({payment(a2, 100)}));
+    auto hash = txSet.getContentsHash();
+    uint32_t lcl = lm.getLastClosedLedgerNum();
+
+    // committing a LedgerTxn clears the entry cache
+    LedgerTxn(root).commit();
+
+    TxSetPrefetcher prefetcher(*app);
+    prefetcher.start(hash, txSet);
+    prefetcher.waitUntilLoaded();
+
+    auto cacheHit = [&](LedgerKey const& key) {
+        LedgerTxn ltx(root);
+        ltx.getNewestVersion(key);
+        return root.getEntryCacheLookups()[ACCOUNT].hits == 1;
+    };
+
+    SECTION("adopted")
+    {
+        prefetcher.adopt(hash, lcl);
+        REQUIRE(cacheHit(k1));
+        REQUIRE(cacheHit(k2));
+    }
+    SECTION("different tx set")
+    {
+        prefetcher.adopt(HashUtils::random(), lcl);
+        REQUIRE(!cacheHit(k1));
+    }
+    SECTION("written keys are dropped")
+    {
+        prefetcher.invalidate(k1);
+        prefetcher.ledgerClosed(lcl + 1);
+        prefetcher.adopt(hash, lcl + 1);
+        REQUIRE(!cacheHit(k1));
+        REQUIRE(cacheHit(k2));
+    }
+    SECTION("unreported ledger")
+    {
+        prefetcher.ledgerClosed(lcl + 2);
+        prefetcher.adopt(hash, lcl + 2);
+        REQUIRE(!cacheHit(k2));
+    }
+}
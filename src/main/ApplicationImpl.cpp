@@ -34,6 +34,7 @@
 #include "ledger/InMemoryLedgerTxnRoot.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnMemoryRoot.h"
 #include "main/ApplicationUtils.h"
 #include "main/CommandHandler.h"
 #include "main/ExternalQueue.h"
@@ -154,11 +155,24 @@ maybeRebuildLedger(Application& app, bool applyBuckets)
             toRebuild.emplace(t);
         }
     }
-    if (toRebuild.empty())
+    if (toRebuild.empty() && !app.getConfig().IN_MEMORY_LEDGER_STATE)
     {
         return;
     }
 
+    if (app.getConfig().IN_MEMORY_LEDGER_STATE)
+    {
+        // The ledger tables are neither read nor kept up to date while the
+        // ledger state is in memory, where it is rebuilt from the buckets on
+        // every start; flag them all so they get rebuilt if the node is run
+        // from the database again.
+        for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+        {
+            ps.setRebuildForType(static_cast<LedgerEntryType>(let));
+        }
+        return;
+    }
+
     if (!app.getConfig().MODE_USES_IN_MEMORY_LEDGER)
     {
         app.getDatabase().clearPreparedStatementCache();
@@ -262,6 +276,16 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
     {
         resetLedgerState();
     }
+    else if (getConfig().IN_MEMORY_LEDGER_STATE)
+    {
+        mLedgerTxnRoot = std::make_unique<LedgerTxnMemoryRoot>(
+            *mDatabase
+#ifdef BEST_OFFER_DEBUGGING
+            ,
+            mConfig.BEST_OFFER_DEBUGGING_ENABLED
+#endif
+        );
+    }
     else
     {
         if (mConfig.ENTRY_CACHE_SIZE < 20000)
@@ -272,7 +296,8 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
                         mConfig.ENTRY_CACHE_SIZE);
         }
         mLedgerTxnRoot = std::make_unique<LedgerTxnRoot>(
-            *mDatabase, mConfig.ENTRY_CACHE_SIZE, mConfig.PREFETCH_BATCH_SIZE
+            *mDatabase, mConfig.ENTRY_CACHE_SIZE, mConfig.PREFETCH_BATCH_SIZE,
+            mConfig.ENTRY_CACHE_WRITE_THROUGH
 #ifdef BEST_OFFER_DEBUGGING
             ,
             mConfig.BEST_OFFER_DEBUGGING_ENABLED
@@ -643,6 +668,22 @@ ApplicationImpl::validateAndLogConfig()
             "and RUN_STANDALONE is not set");
     }
 
+    if (mConfig.IN_MEMORY_LEDGER_STATE)
+    {
+        if (mConfig.isInMemoryMode())
+        {
+            throw std::invalid_argument(
+                "IN_MEMORY_LEDGER_STATE is set together with in-memory mode");
+        }
+        if (!mConfig.MODE_ENABLES_BUCKETLIST ||
+            !mConfig.MODE_STORES_HISTORY_LEDGERHEADERS)
+        {
+            throw std::invalid_argument(
+                "IN_MEMORY_LEDGER_STATE is set, but the bucket list or "
+                "ledger headers are not stored");
+        }
+    }
+
     if (getHistoryArchiveManager().hasAnyWritableHistoryArchive())
     {
         if (!mConfig.modeStoresAllHistory())
@@ -20,8 +20,11 @@
 #include "main/dumpxdr.h"
 #include "overlay/OverlayManager.h"
 #include "scp/QuorumSetUtils.h"
+#include "speedex/sim_utils.h"
+#include "speedex/speedex.h"
 #include "src/catchup/simulation/TxSimApplyTransactionsWork.h"
 #include "src/transactions/simulation/TxSimScaleBucketlistWork.h"
+#include "util/ForkJoinPool.h"
 #include "util/Logging.h"
 #include "util/types.h"
 #include "work/WorkScheduler.h"
@@ -36,8 +39,10 @@
 #endif
 
 #include <fmt/format.h>
+#include <fstream>
 #include <iostream>
 #include <lib/clara.hpp>
+#include <lib/json/json.h>
 #include <optional>
 
 namespace stellar
@@ -1601,14 +1606,19 @@ runGenFuzz(CommandLineArgs const& args)
 #endif
 
 int
-runSpeedexSim(CommandLineArgs const& args) {
+runSpeedexSimulation(CommandLineArgs const& args)
+{
     std::string fileName;
+    std::string outputFile;
+    uint32_t threads = 1;
+
+    auto threadsParser = clara::Opt{threads, "THREADS"}["--threads"](
+        "threads for demand queries, Tatonnement and clearing (default 1)");
 
     return runWithHelp(
-        args,
-        {fileNameParser(fileName)},
+        args, {fileNameParser(fileName), outputFileParser(outputFile),
+               threadsParser},
         [&] {
-
             std::printf("loading from %s\n", fileName.c_str());
 
             SpeedexSimulation sim;
@@ -1631,8 +1641,67 @@ runSpeedexSim(CommandLineArgs const& args) {
                 xdr::xdr_from_opaque(v, sim);
             }
 
-            std::printf("read file");
+            std::unique_ptr<ForkJoinPool> workers;
+            SpeedexRuntimeOptions options;
+            if (threads > 1)
+            {
+                workers = std::make_unique<ForkJoinPool>(threads);
+                options.mDemandQueryWorkers = workers.get();
+                options.mTatonnementWorkers = workers.get();
+                options.mClearingWorkers = workers.get();
+            }
+
+            SpeedexSimStats stats;
+            runSpeedexSim(sim, options, &stats);
+
+            auto content = stats.toJson().toStyledString();
+            if (outputFile.empty())
+            {
+                std::cout << content;
+            }
+            else
+            {
+                std::ofstream out{};
+                out.exceptions(std::ios::failbit | std::ios::badbit);
+                out.open(outputFile);
+                out.write(content.c_str(), content.size());
+            }
+            return 0;
+        });
+}
+
+int
+runGenSpeedexSim(CommandLineArgs const& args)
+{
+    std::string fileName;
+    SpeedexSimGenParams params;
 
+    return runWithHelp(
+        args,
+        {fileNameParser(fileName),
+         clara::Opt{params.mNumAssets, "N"}["--assets"]("number of assets"),
+         clara::Opt{params.mOffersPerPair, "N"}["--offers-per-pair"](
+             "offers per ordered asset pair"),
+         clara::Opt{params.mPriceDispersion, "D"}["--price-dispersion"](
+             "limit prices are within a factor e^D of the exchange rate"),
+         clara::Opt{params.mMaxOfferAmount, "AMOUNT"}["--max-amount"](
+             "maximum offer amount"),
+         clara::Opt{params.mAmmReserve, "AMOUNT"}["--amm-reserve"](
+             "add a pool for every pair with this reserve (0 for none)"),
+         clara::Opt{params.mSeed, "SEED"}["--seed"]("random seed")},
+        [&] {
+            auto sim = generateSpeedexSim(params);
+            auto bytes = xdr::xdr_to_opaque(sim);
+
+            std::ofstream out{};
+            out.exceptions(std::ios::failbit | std::ios::badbit);
+            out.open(fileName, std::ios::binary);
+            out.write(reinterpret_cast<char const*>(bytes.data()),
+                      bytes.size());
+
+            std::printf("wrote %zu offers over %zu assets to %s\n",
+                        sim.offers.size(), sim.config.assets.size(),
+                        fileName.c_str());
             return 0;
         });
 }
@@ -1681,8 +1750,10 @@ handleCommandLine(int argc, char* const* argv)
           "add signature to transaction envelope, then quit",
           runSignTransaction},
          {"speedex",
-          "speedex simulation",
-           runSpeedexSim},
+          "run a speedex batch from a simulation file, print stats as JSON",
+          runSpeedexSimulation},
+         {"gen-speedex-sim", "generate a synthetic speedex simulation file",
+          runGenSpeedexSim},
          {"upgrade-db", "upgrade database schema to current version",
           runUpgradeDB},
 #ifdef BUILD_TESTS
@@ -200,13 +200,23 @@ Config::Config() : NODE_SEED(SecretKey::random())
     //
     // Worst case = 10 concurrent merges + 1 quorum intersection calculation.
     WORKER_THREADS = 11;
+    SPEEDEX_DEMAND_QUERY_THREADS = 1;
+    COMMUTATIVE_APPLY_THREADS = 1;
+    TX_SET_VALIDATION_THREADS = 1;
     MAX_CONCURRENT_SUBPROCESSES = 16;
     NODE_IS_VALIDATOR = false;
     QUORUM_INTERSECTION_CHECKER = true;
     DATABASE = SecretValue{"sqlite3://:memory:"};
 
     ENTRY_CACHE_SIZE = 100000;
+    ENTRY_CACHE_WRITE_THROUGH = false;
     PREFETCH_BATCH_SIZE = 1000;
+    BACKGROUND_TX_SET_PREFETCH = false;
+    IN_MEMORY_LEDGER_STATE = false;
+    BUCKET_INDEX_PAGE_SIZE = 0;
+    BUCKET_MERGE_PARTITION_SIZE = 0;
+    BUCKET_APPLY_PARTITIONS = 0;
+    BUCKET_FILE_BLOCK_SIZE = 0;
 
 #ifdef BUILD_TESTS
     TEST_CASES_ENABLED = false;
@@ -1061,6 +1071,18 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 WORKER_THREADS = readInt<int>(item, 1, 1000);
             }
+            else if (item.first == "SPEEDEX_DEMAND_QUERY_THREADS")
+            {
+                SPEEDEX_DEMAND_QUERY_THREADS = readInt<uint32_t>(item, 1, 256);
+            }
+            else if (item.first == "COMMUTATIVE_APPLY_THREADS")
+            {
+                COMMUTATIVE_APPLY_THREADS = readInt<uint32_t>(item, 1, 256);
+            }
+            else if (item.first == "TX_SET_VALIDATION_THREADS")
+            {
+                TX_SET_VALIDATION_THREADS = readInt<uint32_t>(item, 1, 256);
+            }
             else if (item.first == "MAX_CONCURRENT_SUBPROCESSES")
             {
                 MAX_CONCURRENT_SUBPROCESSES = readInt<size_t>(item, 1);
@@ -1137,10 +1159,38 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 ENTRY_CACHE_SIZE = readInt<uint32_t>(item);
             }
+            else if (item.first == "ENTRY_CACHE_WRITE_THROUGH")
+            {
+                ENTRY_CACHE_WRITE_THROUGH = readBool(item);
+            }
             else if (item.first == "PREFETCH_BATCH_SIZE")
             {
                 PREFETCH_BATCH_SIZE = readInt<uint32_t>(item);
             }
+            else if (item.first == "BACKGROUND_TX_SET_PREFETCH")
+            {
+                BACKGROUND_TX_SET_PREFETCH = readBool(item);
+            }
+            else if (item.first == "IN_MEMORY_LEDGER_STATE")
+            {
+                IN_MEMORY_LEDGER_STATE = readBool(item);
+            }
+            else if (item.first == "BUCKET_INDEX_PAGE_SIZE")
+            {
+                BUCKET_INDEX_PAGE_SIZE = readInt<uint32_t>(item);
+            }
+            else if (item.first == "BUCKET_MERGE_PARTITION_SIZE")
+            {
+                BUCKET_MERGE_PARTITION_SIZE = readInt<uint32_t>(item);
+            }
+            else if (item.first == "BUCKET_APPLY_PARTITIONS")
+            {
+                BUCKET_APPLY_PARTITIONS = readInt<uint32_t>(item);
+            }
+            else if (item.first == "BUCKET_FILE_BLOCK_SIZE")
+            {
+                BUCKET_FILE_BLOCK_SIZE = readInt<uint32_t>(item);
+            }
             else if (item.first == "MAXIMUM_LEDGER_CLOSETIME_DRIFT")
             {
                 MAXIMUM_LEDGER_CLOSETIME_DRIFT = readInt<int64_t>(item, 0);
@@ -379,6 +379,19 @@ class Config : public std::enable_shared_from_this<Config>
     // thread-management config
     int WORKER_THREADS;
 
+    // Number of threads (including the main thread) used to evaluate
+    // speedex demand queries during ledger close. 1 means serial.
+    uint32_t SPEEDEX_DEMAND_QUERY_THREADS;
+
+    // Number of threads (including the main thread) used to apply
+    // commutative transactions during ledger close. 1 means serial. Ignored
+    // for ledgers whose transaction meta is streamed or stored.
+    uint32_t COMMUTATIVE_APPLY_THREADS;
+
+    // Number of threads (including the main thread) used to validate
+    // transaction sets. 1 means serial.
+    uint32_t TX_SET_VALIDATION_THREADS;
+
     // process-management config
     size_t MAX_CONCURRENT_SUBPROCESSES;
 
@@ -410,12 +423,52 @@ class Config : public std::enable_shared_from_this<Config>
     // - ENTRY_CACHE_SIZE controls the maximum number of LedgerEntry objects
     //   that will be stored in the cache
     size_t ENTRY_CACHE_SIZE;
+    // - ENTRY_CACHE_WRITE_THROUGH makes ledger close write committed entries
+    //   to the cache instead of clearing it, so that the cache keeps the
+    //   working set across ledgers. ENTRY_CACHE_SIZE should then be sized to
+    //   hold the working set, possibly millions of entries.
+    bool ENTRY_CACHE_WRITE_THROUGH;
 
     // Data layer prefetcher configuration
     // - PREFETCH_BATCH_SIZE determines how many records we'll prefetch per
     // SQL load. Note that it should be significantly smaller than size of
     // the entry cache
     size_t PREFETCH_BATCH_SIZE;
+    // - BACKGROUND_TX_SET_PREFETCH starts prefetching for a transaction set
+    // on a background thread as soon as it is a likely candidate for the next
+    // ledger (proposed, combined from nominated candidates, or buffered
+    // during catchup). Needs a database that worker threads can connect to.
+    bool BACKGROUND_TX_SET_PREFETCH;
+
+    // Keep the whole live ledger state in memory, in LedgerTxnMemoryRoot,
+    // instead of in the database's ledger entry tables. The state is rebuilt
+    // from the BucketList on startup. Unlike MODE_USES_IN_MEMORY_LEDGER, the
+    // node keeps its state across restarts, so this is usable by validators;
+    // it needs the BucketList and ledger headers stored in the database.
+    bool IN_MEMORY_LEDGER_STATE;
+
+    // Size in bytes of the pages of the point-lookup index (see BucketIndex)
+    // kept next to each bucket file, so that BucketList::loadKeys can read
+    // ledger entries without scanning buckets. 0 disables the indexes.
+    uint32_t BUCKET_INDEX_PAGE_SIZE;
+
+    // Merges of buckets totalling at least twice this many bytes are split
+    // into partitions of about this size, merged concurrently on up to
+    // WORKER_THREADS threads. Needs BUCKET_INDEX_PAGE_SIZE, to split the
+    // buckets. 0 disables partitioned merges.
+    uint32_t BUCKET_MERGE_PARTITION_SIZE;
+
+    // If non-zero, ApplyBucketsWork applies all the buckets it has to apply
+    // at once, writing each ledger entry once, in up to this many partitions
+    // applied concurrently (see ParallelBucketApplicator). 0 applies the
+    // buckets one at a time.
+    uint32_t BUCKET_APPLY_PARTITIONS;
+
+    // If non-zero, new buckets are written as XDR block files (see
+    // XDRBlockFile.h) of blocks of about this many bytes of XDR records,
+    // compressed separately. Buckets are published as plain XDR files
+    // either way. 0 writes them as plain XDR files.
+    uint32_t BUCKET_FILE_BLOCK_SIZE;
 
 #ifdef BUILD_TESTS
     // If set to true, the application will be aware this run is for a test
@@ -45,9 +45,9 @@ using namespace std::placeholders;
 namespace stellar
 {
 
-template <typename T>
+template <typename T, typename Stream>
 void
-dumpstream(XDRInputFileStream& in, bool compact)
+dumpstream(Stream& in, bool compact)
 {
     T tmp;
     cereal::JSONOutputArchive archive(
@@ -76,7 +76,10 @@ dumpXdrStream(std::string const& filename, bool compact)
         }
         else if (sm[1] == "bucket")
         {
-            dumpstream<BucketEntry>(in, compact);
+            // Local bucket files may be XDR block files
+            XDRInputMappedFileStream bucketIn;
+            bucketIn.open(filename);
+            dumpstream<BucketEntry>(bucketIn, compact);
         }
         else if (sm[1] == "transactions")
         {
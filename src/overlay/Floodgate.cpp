@@ -114,13 +114,18 @@ Floodgate::broadcast(StellarMessage const& msg, bool force)
     auto peers = mApp.getOverlayManager().getAuthenticatedPeers();
 
     bool broadcasted = false;
-    std::shared_ptr<StellarMessage> smsg =
-        std::make_shared<StellarMessage>(msg);
+    // Serialize the message once for all peers; each of them only computes
+    // its own sequence and MAC over the shared bytes.
+    std::shared_ptr<SerializedStellarMessage const> smsg;
     for (auto peer : peers)
     {
         releaseAssert(peer.second->isAuthenticated());
         if (peersTold.insert(peer.second->toString()).second)
         {
+            if (!smsg)
+            {
+                smsg = std::make_shared<SerializedStellarMessage const>(msg);
+            }
             mSendFromBroadcast.Mark();
             std::weak_ptr<Peer> weak(
                 std::static_pointer_cast<Peer>(peer.second));
@@ -129,7 +134,7 @@ Floodgate::broadcast(StellarMessage const& msg, bool force)
                     auto strong = weak.lock();
                     if (strong)
                     {
-                        strong->sendMessage(*smsg, log);
+                        strong->sendMessage(smsg, log);
                     }
                 },
                 fmt::format("broadcast to {}", peer.second->toString()));
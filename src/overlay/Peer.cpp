@@ -392,10 +392,9 @@ Peer::msgSummary(StellarMessage const& msg)
     return "UNKNOWN";
 }
 
-void
-Peer::sendMessage(StellarMessage const& msg, bool log)
+bool
+Peer::beginSendMessage(StellarMessage const& msg)
 {
-    ZoneScoped;
     CLOG_TRACE(Overlay, "send: {} to : {}", msgSummary(msg),
                mApp.getConfig().toShortString(mPeerID));
 
@@ -411,7 +410,7 @@ Peer::sendMessage(StellarMessage const& msg, bool log)
         sendQueueIsOverloaded())
     {
         getOverlayMetrics().mMessageDrop.Mark();
-        return;
+        return false;
     }
 
     switch (msg.type())
@@ -462,6 +461,17 @@ Peer::sendMessage(StellarMessage const& msg, bool log)
         getOverlayMetrics().mSendSurveyResponseMeter.Mark();
         break;
     };
+    return true;
+}
+
+void
+Peer::sendMessage(StellarMessage const& msg, bool log)
+{
+    ZoneScoped;
+    if (!beginSendMessage(msg))
+    {
+        return;
+    }
 
     AuthenticatedMessage amsg;
     amsg.v0().message = msg;
@@ -481,6 +491,39 @@ Peer::sendMessage(StellarMessage const& msg, bool log)
     this->sendMessage(std::move(xdrBytes));
 }
 
+void
+Peer::sendMessage(std::shared_ptr<SerializedStellarMessage const> msg,
+                  bool log)
+{
+    ZoneScoped;
+    if (!beginSendMessage(msg->mMessage))
+    {
+        return;
+    }
+
+    auto type = msg->mMessage.type();
+    bool authenticated = type != HELLO && type != ERROR_MSG;
+    FramedMessage framed(authenticated ? mSendMacSeq : 0, std::move(msg));
+    if (authenticated)
+    {
+        // The MAC covers the XDR of the sequence and the message, which are
+        // the end of the header and the shared body.
+        ZoneNamedN(hmacZone, "message HMAC", true);
+        HmacSha256 hmac(mSendMacKey);
+        hmac.add(ByteSlice(framed.mHeader.data() + 8, 8));
+        hmac.add(framed.mBody->mBytes);
+        framed.mMac = hmac.finish();
+        ++mSendMacSeq;
+    }
+    sendFramedMessage(std::move(framed));
+}
+
+void
+Peer::sendFramedMessage(FramedMessage&& msg)
+{
+    this->sendMessage(msg.toMsg());
+}
+
 void
 Peer::recvMessage(xdr::msg_ptr const& msg)
 {
@@ -1317,4 +1360,50 @@ Peer::PeerMetrics::PeerMetrics(VirtualClock::time_point connectedTime)
     , mConnectedTime(connectedTime)
 {
 }
+
+SerializedStellarMessage::SerializedStellarMessage(StellarMessage const& msg)
+    : mMessage(msg), mBytes(xdr::xdr_to_opaque(msg))
+{
+}
+
+Peer::FramedMessage::FramedMessage(
+    uint64_t sequence, std::shared_ptr<SerializedStellarMessage const> body)
+    : mBody(std::move(body))
+{
+    // Record mark (the size of the rest, with the last-fragment bit set),
+    // then the union discriminant 0 and the sequence, all big-endian.
+    size_t payload = size() - 4;
+    releaseAssert(payload < 0x80000000);
+    uint32_t mark = static_cast<uint32_t>(payload) | 0x80000000;
+    for (int i = 0; i < 4; ++i)
+    {
+        mHeader[i] = static_cast<uint8_t>(mark >> (24 - 8 * i));
+        mHeader[4 + i] = 0;
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        mHeader[8 + i] = static_cast<uint8_t>(sequence >> (56 - 8 * i));
+    }
+}
+
+size_t
+Peer::FramedMessage::size() const
+{
+    return HEADER_SIZE + mBody->mBytes.size() + mMac.mac.size();
+}
+
+xdr::msg_ptr
+Peer::FramedMessage::toMsg() const
+{
+    ZoneScoped;
+    auto const& body = mBody->mBytes;
+    auto m = xdr::message_t::alloc(size() - 4);
+    char* d = m->raw_data();
+    std::memcpy(d, mHeader.data(), HEADER_SIZE);
+    d += HEADER_SIZE;
+    std::memcpy(d, body.data(), body.size());
+    d += body.size();
+    std::memcpy(d, mMac.mac.data(), mMac.mac.size());
+    return m;
+}
 }
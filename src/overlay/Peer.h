@@ -11,6 +11,7 @@
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
 #include "xdrpp/message.h"
+#include <array>
 
 namespace medida
 {
@@ -27,6 +28,16 @@ class Application;
 class LoopbackPeer;
 struct OverlayMetrics;
 
+// A StellarMessage along with its XDR, serialized once so that it can be
+// sent to many peers without serializing it again for each of them.
+struct SerializedStellarMessage
+{
+    explicit SerializedStellarMessage(StellarMessage const& msg);
+
+    StellarMessage const mMessage;
+    xdr::opaque_vec<> const mBytes;
+};
+
 // Peer class represents a connected peer (either inbound or outbound)
 //
 // Connection steps:
@@ -103,6 +114,28 @@ class Peer : public std::enable_shared_from_this<Peer>,
         VirtualClock::time_point mConnectedTime;
     };
 
+    // The wire form of an AuthenticatedMessage, in three pieces so that its
+    // StellarMessage body can be shared with other peers: the record mark,
+    // version and sequence; the body; and the MAC.
+    struct FramedMessage
+    {
+        static constexpr size_t HEADER_SIZE = 16;
+
+        FramedMessage(uint64_t sequence,
+                      std::shared_ptr<SerializedStellarMessage const> body);
+
+        std::array<uint8_t, HEADER_SIZE> mHeader;
+        std::shared_ptr<SerializedStellarMessage const> mBody;
+        HmacSha256Mac mMac;
+
+        // Size on the wire, record mark included.
+        size_t size() const;
+
+        // Copies the pieces into a single message, as xdr::xdr_to_msg would
+        // have serialized the AuthenticatedMessage.
+        xdr::msg_ptr toMsg() const;
+    };
+
     struct TimestampedMessage
     {
         VirtualClock::time_point mEnqueuedTime;
@@ -110,6 +143,8 @@ class Peer : public std::enable_shared_from_this<Peer>,
         VirtualClock::time_point mCompletedTime;
         void recordWriteTiming(OverlayMetrics& metrics);
         xdr::msg_ptr mMessage;
+        // Set instead of mMessage for messages sent in pieces.
+        std::unique_ptr<FramedMessage> mFramedMessage;
     };
 
   protected:
@@ -180,6 +215,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void sendPeers();
     void sendError(ErrorCode error, std::string const& message);
 
+    // Logs and meters an outgoing message. Returns false if it should be
+    // dropped instead, to shed load.
+    bool beginSendMessage(StellarMessage const& msg);
+
     // NB: This is a move-argument because the write-buffer has to travel
     // with the write-request through the async IO system, and we might have
     // several queued at once. We have carefully arranged this to not copy
@@ -188,6 +227,12 @@ class Peer : public std::enable_shared_from_this<Peer>,
     // messages somewhere else. The async write request will point _into_
     // this owned buffer. This is really the best we can do.
     virtual void sendMessage(xdr::msg_ptr&& xdrBytes) = 0;
+
+    // Sends a message whose body may be shared with other peers. Transports
+    // that can write it in pieces override this; by default it is copied
+    // into a single message.
+    virtual void sendFramedMessage(FramedMessage&& msg);
+
     virtual void
     connected()
     {
@@ -226,6 +271,11 @@ class Peer : public std::enable_shared_from_this<Peer>,
 
     void sendMessage(StellarMessage const& msg, bool log = true);
 
+    // Same as above, but reuses the XDR of msg instead of serializing it
+    // again: only the sequence and MAC are computed for this peer.
+    void sendMessage(std::shared_ptr<SerializedStellarMessage const> msg,
+                     bool log = true);
+
     PeerRole
     getRole() const
     {
@@ -144,8 +144,29 @@ TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
     assertThreadIsMain();
 
     TimestampedMessage msg;
-    msg.mEnqueuedTime = mApp.getClock().now();
     msg.mMessage = std::move(xdrBytes);
+    enqueueMessage(std::move(msg));
+}
+
+void
+TCPPeer::sendFramedMessage(FramedMessage&& framed)
+{
+    if (shouldAbort())
+    {
+        return;
+    }
+
+    assertThreadIsMain();
+
+    TimestampedMessage msg;
+    msg.mFramedMessage = std::make_unique<FramedMessage>(std::move(framed));
+    enqueueMessage(std::move(msg));
+}
+
+void
+TCPPeer::enqueueMessage(TimestampedMessage&& msg)
+{
+    msg.mEnqueuedTime = mApp.getClock().now();
     mWriteQueue.emplace_back(std::move(msg));
 
     if (!mWriting)
@@ -241,11 +262,14 @@ TCPPeer::messageSender()
     // Take a snapshot of the contents of mWriteQueue into mWriteBuffers, in
     // terms of asio::const_buffers pointing into the elements of mWriteQueue,
     // and then issue a single multi-buffer ("scatter-gather") async_write that
-    // covers the whole snapshot. We'll get called back when the batch is
-    // completed, at which point we'll clear mWriteBuffers and remove the entire
-    // snapshot worth of corresponding messages from mWriteQueue (though it may
-    // have grown a bit in the meantime -- we remove only a prefix).
+    // covers the whole snapshot. Framed messages contribute one buffer per
+    // piece, so that a body shared between peers is written from the one
+    // copy. We'll get called back when the batch is completed, at which point
+    // we'll clear mWriteBuffers and remove the entire snapshot worth of
+    // corresponding messages from mWriteQueue (though it may have grown a bit
+    // in the meantime -- we remove only a prefix).
     releaseAssert(mWriteBuffers.empty());
+    releaseAssert(mWriteBufferMessages == 0);
     auto now = mApp.getClock().now();
     size_t expected_length = 0;
     size_t maxQueueSize = mApp.getConfig().MAX_BATCH_WRITE_COUNT;
@@ -254,8 +278,22 @@ TCPPeer::messageSender()
     for (auto& tsm : mWriteQueue)
     {
         tsm.mIssuedTime = now;
-        size_t sz = tsm.mMessage->raw_size();
-        mWriteBuffers.emplace_back(tsm.mMessage->raw_data(), sz);
+        size_t sz;
+        if (tsm.mFramedMessage)
+        {
+            auto const& fm = *tsm.mFramedMessage;
+            auto const& body = fm.mBody->mBytes;
+            mWriteBuffers.emplace_back(fm.mHeader.data(), fm.mHeader.size());
+            mWriteBuffers.emplace_back(body.data(), body.size());
+            mWriteBuffers.emplace_back(fm.mMac.mac.data(), fm.mMac.mac.size());
+            sz = fm.size();
+        }
+        else
+        {
+            sz = tsm.mMessage->raw_size();
+            mWriteBuffers.emplace_back(tsm.mMessage->raw_data(), sz);
+        }
+        ++mWriteBufferMessages;
         expected_length += sz;
         mEnqueueTimeOfLastWrite = tsm.mEnqueuedTime;
         // check if we reached any limit
@@ -266,7 +304,7 @@ TCPPeer::messageSender()
     }
 
     CLOG_DEBUG(Overlay, "messageSender {} - b:{} n:{}/{}", toString(),
-               expected_length, mWriteBuffers.size(), mWriteQueue.size());
+               expected_length, mWriteBufferMessages, mWriteQueue.size());
     getOverlayMetrics().mAsyncWrite.Mark();
     auto self = static_pointer_cast<TCPPeer>(shared_from_this());
     asio::async_write(*(mSocket.get()), mWriteBuffers,
@@ -280,7 +318,7 @@ TCPPeer::messageSender()
                               return;
                           }
                           self->writeHandler(ec, length,
-                                             self->mWriteBuffers.size());
+                                             self->mWriteBufferMessages);
 
                           // Walk through a _prefix_ of the write queue
                           // _corresponding_ to the write buffers we just sent.
@@ -290,13 +328,14 @@ TCPPeer::messageSender()
                           // queue.
                           auto now = self->mApp.getClock().now();
                           auto i = self->mWriteQueue.begin();
-                          while (!self->mWriteBuffers.empty())
+                          for (; self->mWriteBufferMessages > 0;
+                               --self->mWriteBufferMessages)
                           {
                               i->mCompletedTime = now;
                               i->recordWriteTiming(self->getOverlayMetrics());
                               ++i;
-                              self->mWriteBuffers.pop_back();
                           }
+                          self->mWriteBuffers.clear();
 
                           // Erase the messages from the write queue that we
                           // just forgot about the buffers for.
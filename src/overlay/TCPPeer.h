@@ -32,6 +32,9 @@ class TCPPeer : public Peer
     std::vector<uint8_t> mIncomingBody;
 
     std::vector<asio::const_buffer> mWriteBuffers;
+    // Number of messages at the front of mWriteQueue that mWriteBuffers
+    // point into.
+    size_t mWriteBufferMessages{0};
     std::deque<TimestampedMessage> mWriteQueue;
     bool mWriting{false};
     bool mDelayedShutdown{false};
@@ -39,6 +42,8 @@ class TCPPeer : public Peer
 
     void recvMessage();
     void sendMessage(xdr::msg_ptr&& xdrBytes) override;
+    void sendFramedMessage(FramedMessage&& msg) override;
+    void enqueueMessage(TimestampedMessage&& msg);
 
     void messageSender();
 
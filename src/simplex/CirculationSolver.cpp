@@ -0,0 +1,216 @@
+#include "simplex/CirculationSolver.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace stellar {
+
+constexpr static int64_t INF_DISTANCE = std::numeric_limits<int64_t>::max();
+constexpr static uint32_t NO_LEVEL = std::numeric_limits<uint32_t>::max();
+
+CirculationSolver::CirculationSolver(size_t numNodes)
+	: mArcs()
+	, mAdjacency(numNodes + 2) // plus source and sink
+	, mEdgeArcs()
+	, mNumNodes(numNodes)
+	, mSolved(false)
+	{}
+
+uint32_t
+CirculationSolver::addArcPair(uint32_t from, uint32_t to, int32_t cost, int128_t capacity)
+{
+	uint32_t idx = mArcs.size();
+	mArcs.push_back(Arc {
+		.mTo = to,
+		.mCost = cost,
+		.mResidual = capacity
+	});
+	mArcs.push_back(Arc {
+		.mTo = from,
+		.mCost = -cost,
+		.mResidual = 0
+	});
+	mAdjacency[from].push_back(idx);
+	mAdjacency[to].push_back(idx + 1);
+	return idx;
+}
+
+size_t
+CirculationSolver::addEdge(size_t from, size_t to, int128_t capacity)
+{
+	if (mSolved) {
+		throw std::logic_error("already solved");
+	}
+	if (from >= mNumNodes || to >= mNumNodes || from == to) {
+		throw std::runtime_error("invalid edge");
+	}
+	if (capacity <= 0) {
+		throw std::runtime_error("can't have nonpositive upper bound");
+	}
+	mEdgeArcs.push_back(addArcPair(from, to, 1, capacity));
+	return mEdgeArcs.size() - 1;
+}
+
+int64_t
+CirculationSolver::reducedCost(uint32_t from, Arc const& arc) const
+{
+	return arc.mCost + mPotentials[from] - mPotentials[arc.mTo];
+}
+
+bool
+CirculationSolver::updatePotentials(uint32_t source, uint32_t sink)
+{
+	std::vector<int64_t> distances(mAdjacency.size(), INF_DISTANCE);
+
+	using QueueEntry = std::pair<int64_t, uint32_t>;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+	distances[source] = 0;
+	queue.push({0, source});
+
+	while (!queue.empty()) {
+		auto [dist, node] = queue.top();
+		queue.pop();
+		if (dist > distances[node]) {
+			continue;
+		}
+		for (auto arcIdx : mAdjacency[node]) {
+			auto const& arc = mArcs[arcIdx];
+			if (arc.mResidual <= 0) {
+				continue;
+			}
+			int64_t candidate = dist + reducedCost(node, arc);
+			if (candidate < distances[arc.mTo]) {
+				distances[arc.mTo] = candidate;
+				queue.push({candidate, arc.mTo});
+			}
+		}
+	}
+
+	if (distances[sink] == INF_DISTANCE) {
+		return false;
+	}
+
+	// Capping at the sink's distance keeps every residual reduced cost
+	// nonnegative, and zeroes the reduced cost along shortest paths.
+	for (size_t i = 0; i < mPotentials.size(); i++) {
+		mPotentials[i] += std::min(distances[i], distances[sink]);
+	}
+	return true;
+}
+
+bool
+CirculationSolver::buildLevels(uint32_t source, uint32_t sink)
+{
+	std::fill(mLevels.begin(), mLevels.end(), NO_LEVEL);
+	std::fill(mNextArc.begin(), mNextArc.end(), 0);
+
+	std::queue<uint32_t> queue;
+	mLevels[source] = 0;
+	queue.push(source);
+
+	while (!queue.empty()) {
+		auto node = queue.front();
+		queue.pop();
+		for (auto arcIdx : mAdjacency[node]) {
+			auto const& arc = mArcs[arcIdx];
+			if (arc.mResidual > 0 && mLevels[arc.mTo] == NO_LEVEL && reducedCost(node, arc) == 0) {
+				mLevels[arc.mTo] = mLevels[node] + 1;
+				queue.push(arc.mTo);
+			}
+		}
+	}
+	return mLevels[sink] != NO_LEVEL;
+}
+
+CirculationSolver::int128_t
+CirculationSolver::augment(uint32_t node, uint32_t sink, int128_t limit)
+{
+	if (node == sink) {
+		return limit;
+	}
+	auto const& adjacent = mAdjacency[node];
+	for (auto& i = mNextArc[node]; i < adjacent.size(); i++) {
+		auto arcIdx = adjacent[i];
+		auto& arc = mArcs[arcIdx];
+		if (arc.mResidual <= 0
+			|| mLevels[arc.mTo] != mLevels[node] + 1
+			|| reducedCost(node, arc) != 0) {
+			continue;
+		}
+		int128_t pushed = augment(arc.mTo, sink, std::min(limit, arc.mResidual));
+		if (pushed > 0) {
+			arc.mResidual -= pushed;
+			mArcs[arcIdx ^ 1].mResidual += pushed;
+			return pushed;
+		}
+	}
+	return 0;
+}
+
+void
+CirculationSolver::solve()
+{
+	if (mSolved) {
+		throw std::logic_error("already solved");
+	}
+	mSolved = true;
+
+	const uint32_t source = mNumNodes;
+	const uint32_t sink = mNumNodes + 1;
+
+	// (flow out) - (flow in), with every edge saturated
+	std::vector<int128_t> imbalances(mNumNodes, 0);
+	for (auto arcIdx : mEdgeArcs) {
+		auto const& forward = mArcs[arcIdx];
+		auto const& reverse = mArcs[arcIdx ^ 1];
+		imbalances[reverse.mTo] += forward.mResidual;
+		imbalances[forward.mTo] -= forward.mResidual;
+	}
+
+	// Removing flow from edge (i, j) lowers i's imbalance and raises j's,
+	// so removals flow from nodes with surplus outflow to nodes with
+	// surplus inflow, along edge directions.
+	int128_t toRoute = 0;
+	for (size_t i = 0; i < mNumNodes; i++) {
+		if (imbalances[i] > 0) {
+			addArcPair(source, i, 0, imbalances[i]);
+			toRoute += imbalances[i];
+		} else if (imbalances[i] < 0) {
+			addArcPair(i, sink, 0, -imbalances[i]);
+		}
+	}
+
+	mPotentials.assign(mAdjacency.size(), 0);
+	mLevels.resize(mAdjacency.size());
+	mNextArc.resize(mAdjacency.size());
+
+	while (toRoute > 0) {
+		// removing all flow is always feasible
+		if (!updatePotentials(source, sink)) {
+			throw std::logic_error("circulation infeasible");
+		}
+		while (toRoute > 0 && buildLevels(source, sink)) {
+			while (int128_t pushed = augment(source, sink, toRoute)) {
+				toRoute -= pushed;
+			}
+		}
+	}
+}
+
+CirculationSolver::int128_t
+CirculationSolver::getFlow(size_t edgeId) const
+{
+	if (!mSolved) {
+		throw std::logic_error("not yet solved");
+	}
+	// flow removed from an edge is the flow on its (removal) arc, so what
+	// remains is exactly the arc's residual capacity
+	return mArcs[mEdgeArcs.at(edgeId)].mResidual;
+}
+
+} /* stellar */
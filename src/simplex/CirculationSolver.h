@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace stellar {
+
+/*
+Maximum volume circulation on a sparse directed graph.
+
+Maximizes Sum_e f_e subject to 0 <= f_e <= capacity_e and, at every node,
+(flow out) == (flow in).  This is the same problem as the
+TradeMaximizingSolver tableau (nodes are assets, edges are trading pairs),
+solved as a network flow instead of with a dense simplex.
+
+Every edge starts saturated.  The solver then finds the cheapest flow to
+remove (cost 1 per unit per edge) that fixes every node's imbalance.  That
+is a min-cost flow with unit costs, solved primal-dual: Dijkstra (with
+potentials) for shortest distances, then a Dinic blocking flow on the
+zero-reduced-cost arcs, repeated until every imbalance is routed.
+
+All arithmetic is exact, and edges are processed in insertion order, so the
+result is deterministic.  The optimal volume is unique, but an optimal flow
+need not be, so flows can differ from the simplex's on instances with ties.
+*/
+class CirculationSolver {
+
+	using int128_t = __int128_t;
+
+	struct Arc {
+		uint32_t mTo;
+		int32_t mCost;
+		int128_t mResidual;
+	};
+
+	// arcs 2k and 2k+1 are a forward/reverse pair
+	std::vector<Arc> mArcs;
+	std::vector<std::vector<uint32_t>> mAdjacency;
+
+	// forward arc index of each edge, in insertion order
+	std::vector<uint32_t> mEdgeArcs;
+
+	const size_t mNumNodes;
+
+	bool mSolved;
+
+	// scratch space for the min-cost flow
+	std::vector<int64_t> mPotentials;
+	std::vector<uint32_t> mLevels;
+	std::vector<size_t> mNextArc;
+
+	uint32_t addArcPair(uint32_t from, uint32_t to, int32_t cost, int128_t capacity);
+
+	bool updatePotentials(uint32_t source, uint32_t sink);
+	bool buildLevels(uint32_t source, uint32_t sink);
+	int128_t augment(uint32_t node, uint32_t sink, int128_t limit);
+
+	int64_t reducedCost(uint32_t from, Arc const& arc) const;
+
+public:
+
+	CirculationSolver(size_t numNodes);
+
+	// returns the id of the new edge
+	size_t addEdge(size_t from, size_t to, int128_t capacity);
+
+	void solve();
+
+	int128_t getFlow(size_t edgeId) const;
+};
+
+} /* stellar */
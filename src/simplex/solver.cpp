@@ -82,8 +82,8 @@ TradeMaximizingSolver::printTableau() const
 
 size_t 
 TradeMaximizingSolver::assetPairToVarIndex(AssetPair assetPair) const {
-	auto sellIdx = mIndexMap.at(assetPair.selling);
-	auto buyIdx = mIndexMap.at(assetPair.buying);
+	auto sellIdx = mRegistry.getIndex(assetPair.selling);
+	auto buyIdx = mRegistry.getIndex(assetPair.buying);
 	return indexPairToVarIndex(sellIdx, buyIdx);
 }
 
@@ -105,15 +105,23 @@ TradeMaximizingSolver::throwIfUnsolved() const
 }
 
 TradeMaximizingSolver::TradeMaximizingSolver(std::vector<Asset> assets) 
-	: mSolved(false) 
+	: TradeMaximizingSolver(SpeedexAssetRegistry(assets))
+{}
+
+TradeMaximizingSolver::TradeMaximizingSolver(SpeedexAssetRegistry const& registry) 
+	: TradeMaximizingSolver(registry, Engine::DENSE_SIMPLEX)
+{}
+
+TradeMaximizingSolver::TradeMaximizingSolver(SpeedexAssetRegistry const& registry, Engine engine) 
+	: mEngine(engine)
+	, mRegistry(registry)
+	, mSolved(false) 
 {
-	size_t idx = 0;
-	for (auto asset : assets) {
-		mIndexMap[asset] = idx;
-	//	mReverseIndexMap[idx] = asset;
-		idx++;
+	mNumAssets = mRegistry.size();
+	if (mEngine == Engine::NETWORK_FLOW) {
+		mFlowSolver = std::make_unique<CirculationSolver>(mNumAssets);
+		return;
 	}
-	mNumAssets = idx;
 	auto nVars = numVars();
 	size_t numRows = mNumAssets + 1; // last one is objective
 	mCoefficients.resize(numRows);
@@ -151,6 +159,12 @@ TradeMaximizingSolver::TradeMaximizingSolver(std::vector<Asset> assets)
 void
 TradeMaximizingSolver::doSolve() {
 	throwIfSolved();
+	if (mEngine == Engine::NETWORK_FLOW) {
+		mFlowSolver->solve();
+		constructFlowSolution();
+		mSolved = true;
+		return;
+	}
 	while(doPivot()) {}
 	constructSolution();
 	mSolved = true;
@@ -158,11 +172,22 @@ TradeMaximizingSolver::doSolve() {
 
 void 
 TradeMaximizingSolver::setUpperBound(AssetPair const& assetPair, int128_t upperBound)
+{
+	setUpperBound(mRegistry.getIndex(assetPair.selling), mRegistry.getIndex(assetPair.buying), upperBound);
+}
+
+void 
+TradeMaximizingSolver::setUpperBound(size_t sellIdx, size_t buyIdx, int128_t upperBound)
 {
 	throwIfSolved();
-	auto yIdx = assetPairToVarIndex(assetPair);
+	auto yIdx = indexPairToVarIndex(sellIdx, buyIdx);
 	auto eIdx = yIdx + numYijVars();
 
+	AssetPair assetPair {
+		.selling = mRegistry.getAsset(sellIdx),
+		.buying = mRegistry.getAsset(buyIdx)
+	};
+
 	if (mAssetPairToRowMap.find(assetPair) != mAssetPairToRowMap.end()) {
 		throw std::runtime_error("can't double-set upper bound");
 	}
@@ -171,6 +196,11 @@ TradeMaximizingSolver::setUpperBound(AssetPair const& assetPair, int128_t upperB
 		throw std::runtime_error("can't have nonpositive upper bound");
 	}
 
+	if (mEngine == Engine::NETWORK_FLOW) {
+		mAssetPairToRowMap[assetPair] = mFlowSolver->addEdge(sellIdx, buyIdx, upperBound);
+		return;
+	}
+
 	auto rowIdx = mCoefficients.size();
 	mCoefficients.emplace_back();
 
@@ -186,8 +216,8 @@ TradeMaximizingSolver::setUpperBound(AssetPair const& assetPair, int128_t upperB
 	mActiveCols[yIdx] = true;
 	mActiveCols[eIdx] = true;
 
-	auto sellAssetSlack = numYijEijVars() + mIndexMap[assetPair.selling];
-	auto buyAssetSlack = numYijEijVars() + mIndexMap[assetPair.buying];
+	auto sellAssetSlack = numYijEijVars() + sellIdx;
+	auto buyAssetSlack = numYijEijVars() + buyIdx;
 
 	mActiveCols[sellAssetSlack] = true;
 	mActiveCols[buyAssetSlack] = true;
@@ -305,7 +335,13 @@ TradeMaximizingSolver::multiplyRow(size_t rowIdx, int8_t coefficient) {
 TradeMaximizingSolver::int128_t 
 TradeMaximizingSolver::getRowResult(AssetPair const& assetPair) const {
 	throwIfUnsolved();
-	auto pair = std::make_pair(mIndexMap.at(assetPair.selling), mIndexMap.at(assetPair.buying));
+	return getRowResult(mRegistry.getIndex(assetPair.selling), mRegistry.getIndex(assetPair.buying));
+}
+
+TradeMaximizingSolver::int128_t 
+TradeMaximizingSolver::getRowResult(size_t sellIdx, size_t buyIdx) const {
+	throwIfUnsolved();
+	std::pair<size_t, size_t> pair(sellIdx, buyIdx);
 	if (debugPrints)
 		std::printf("query for pair %lu %lu\n", pair.first, pair.second);
 	return mSolutionMap.at(pair);
@@ -416,6 +452,22 @@ TradeMaximizingSolver::constructSolution()
 	}
 }
 
+void
+TradeMaximizingSolver::constructFlowSolution()
+{
+	for (size_t i = 0; i < mNumAssets; i++) {
+		for (size_t j = 0; j < mNumAssets; j++) {
+			if (i != j) {
+				mSolutionMap[{i, j}] = 0;
+			}
+		}
+	}
+	for (auto const& [assetPair, edgeId] : mAssetPairToRowMap) {
+		std::pair<size_t, size_t> pair(mRegistry.getIndex(assetPair.selling), mRegistry.getIndex(assetPair.buying));
+		mSolutionMap[pair] = mFlowSolver->getFlow(edgeId);
+	}
+}
+
 void
 TradeMaximizingSolver::printSolution() const
 {
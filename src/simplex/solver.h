@@ -7,7 +7,12 @@
 
 #include "ledger/LedgerHashUtils.h"
 
+#include "speedex/SpeedexAssetRegistry.h"
+
+#include "simplex/CirculationSolver.h"
+
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 
@@ -17,8 +22,26 @@ namespace stellar {
 
 class TradeMaximizingSolver {
 
+public:
+
+	enum class Engine {
+		// dense int8 tableau; memory grows as O(n^4) in the number of assets
+		DENSE_SIMPLEX,
+		// sparse CirculationSolver; same optimal objective, but flows can
+		// differ from DENSE_SIMPLEX's when the optimum is not unique
+		NETWORK_FLOW
+	};
+
+private:
+
 	size_t mNumAssets;
 
+	Engine mEngine;
+
+	// only for Engine::NETWORK_FLOW.  mAssetPairToRowMap then maps to
+	// CirculationSolver edge ids, and the tableau is unused.
+	std::unique_ptr<CirculationSolver> mFlowSolver;
+
 	using int128_t = __int128_t;
 	using Row = std::pair<std::vector<int8_t>, int128_t>;
 
@@ -27,7 +50,7 @@ class TradeMaximizingSolver {
 	using row_idx_t = size_t;
 	using col_idx_t = size_t;
 
-	UnorderedMap<Asset, size_t> mIndexMap; // asset to number
+	SpeedexAssetRegistry mRegistry; // asset to number
 
 	UnorderedMap<AssetPair, row_idx_t, AssetPairHash> mAssetPairToRowMap;
 
@@ -72,22 +95,36 @@ class TradeMaximizingSolver {
 	bool isBasisCol(size_t colIdx) const;
 
 	void constructSolution();
+	void constructFlowSolution();
 
 	void printRow(size_t idx) const;
 	void printTableau() const;
 
 public:
 
+	// Both use DENSE_SIMPLEX.  Pair flows feed the batch solution, so
+	// switching engines changes clearing results wherever the optimum is not
+	// unique; NETWORK_FLOW therefore has to be asked for explicitly.
 	TradeMaximizingSolver(std::vector<Asset> assets);
+	TradeMaximizingSolver(SpeedexAssetRegistry const& registry);
+
+	TradeMaximizingSolver(SpeedexAssetRegistry const& registry, Engine engine);
+
+	// Largest batch the dense tableau handles in reasonable memory.
+	constexpr static size_t DENSE_SIMPLEX_MAX_ASSETS = 20;
 
 	TradeMaximizingSolver(const TradeMaximizingSolver&) = delete;
 	TradeMaximizingSolver& operator=(const TradeMaximizingSolver&) = delete;
 
 	void setUpperBound(AssetPair const& assetPair, int128_t upperBound);
+	// indices from the SpeedexAssetRegistry
+	void setUpperBound(size_t sellIdx, size_t buyIdx, int128_t upperBound);
 
 	void doSolve();
 
 	int128_t getRowResult(AssetPair const& assetPair) const;
+	// indices from the SpeedexAssetRegistry
+	int128_t getRowResult(size_t sellIdx, size_t buyIdx) const;
 
 	UnorderedMap<AssetPair, int128_t, AssetPairHash> getSolution() const;
 
@@ -9,6 +9,12 @@
 
 #include "simplex/solver.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <utility>
+
 using namespace stellar;
 using namespace stellar::txtest;
 
@@ -244,3 +250,197 @@ TEST_CASE("simplex 3 asset", "[simplex]")
 	}
 }
 
+
+static std::vector<Asset> makeSimplexAssets(size_t numAssets)
+{
+	std::vector<Asset> assets;
+	for (auto i = 0u; i < numAssets; i++) {
+		assets.emplace_back(makeSimplexAsset("issuer", fmt::format("A{}", i)));
+	}
+	return assets;
+}
+
+static int128_t
+totalVolume(TradeMaximizingSolver const& solver, size_t numAssets)
+{
+	int128_t obj = 0;
+	for (size_t i = 0; i < numAssets; i++) {
+		for (size_t j = 0; j < numAssets; j++) {
+			if (i != j) {
+				obj += solver.getRowResult(i, j);
+			}
+		}
+	}
+	return obj;
+}
+
+static void
+checkPairFlowsMatch(TradeMaximizingSolver const& dense, TradeMaximizingSolver const& flow, size_t numAssets)
+{
+	for (size_t i = 0; i < numAssets; i++) {
+		for (size_t j = 0; j < numAssets; j++) {
+			if (i != j) {
+				REQUIRE(flow.getRowResult(i, j) == dense.getRowResult(i, j));
+			}
+		}
+	}
+}
+
+TEST_CASE("network flow engine matches simplex", "[simplex]")
+{
+	std::mt19937_64 gen(0);
+
+	SECTION("random instances have the same volume")
+	{
+		// optima here are generally not unique, so only the volume and the
+		// constraints can be compared
+		for (size_t trial = 0; trial < 50; trial++) {
+			size_t numAssets = 2 + trial % 7;
+			auto assets = makeSimplexAssets(numAssets);
+			SpeedexAssetRegistry registry(assets);
+
+			TradeMaximizingSolver dense(registry, TradeMaximizingSolver::Engine::DENSE_SIMPLEX);
+			TradeMaximizingSolver flow(registry, TradeMaximizingSolver::Engine::NETWORK_FLOW);
+
+			std::vector<std::vector<int128_t>> bounds(numAssets, std::vector<int128_t>(numAssets, 0));
+
+			for (size_t i = 0; i < numAssets; i++) {
+				for (size_t j = 0; j < numAssets; j++) {
+					if (i != j && gen() % 3 != 0) {
+						bounds[i][j] = ((int128_t) (1 + gen() % 1000000)) << 32;
+						dense.setUpperBound(i, j, bounds[i][j]);
+						flow.setUpperBound(i, j, bounds[i][j]);
+					}
+				}
+			}
+
+			dense.doSolve();
+			flow.doSolve();
+
+			checkAllAssetConstraints(dense, assets);
+			checkAllAssetConstraints(flow, assets);
+			for (size_t i = 0; i < numAssets; i++) {
+				for (size_t j = 0; j < numAssets; j++) {
+					if (i != j) {
+						REQUIRE(flow.getRowResult(i, j) >= 0);
+						REQUIRE(flow.getRowResult(i, j) <= bounds[i][j]);
+					}
+				}
+			}
+			REQUIRE(totalVolume(flow, numAssets) == totalVolume(dense, numAssets));
+			REQUIRE(flow.getSolution().size() <= numAssets * (numAssets - 1));
+		}
+	}
+
+	SECTION("unique optimum has the same pair flows")
+	{
+		// trading pairs along a random tree: the only cycles are 2-cycles,
+		// so each pair's flow is forced to the smaller of its two bounds
+		for (size_t trial = 0; trial < 50; trial++) {
+			size_t numAssets = 2 + trial % 15;
+			auto assets = makeSimplexAssets(numAssets);
+			SpeedexAssetRegistry registry(assets);
+
+			TradeMaximizingSolver dense(registry, TradeMaximizingSolver::Engine::DENSE_SIMPLEX);
+			TradeMaximizingSolver flow(registry, TradeMaximizingSolver::Engine::NETWORK_FLOW);
+
+			std::vector<std::vector<int128_t>> bounds(numAssets, std::vector<int128_t>(numAssets, 0));
+
+			for (size_t i = 1; i < numAssets; i++) {
+				size_t parent = gen() % i;
+				for (auto [from, to] : {std::make_pair(i, parent), std::make_pair(parent, i)}) {
+					if (gen() % 4 != 0) {
+						bounds[from][to] = ((int128_t) (1 + gen() % 1000000)) << 32;
+						dense.setUpperBound(from, to, bounds[from][to]);
+						flow.setUpperBound(from, to, bounds[from][to]);
+					}
+				}
+			}
+
+			dense.doSolve();
+			flow.doSolve();
+
+			checkPairFlowsMatch(dense, flow, numAssets);
+			for (size_t i = 0; i < numAssets; i++) {
+				for (size_t j = 0; j < numAssets; j++) {
+					if (i != j) {
+						REQUIRE(flow.getRowResult(i, j) == std::min(bounds[i][j], bounds[j][i]));
+					}
+				}
+			}
+		}
+	}
+
+	SECTION("directed cycle plus 2-cycles")
+	{
+		// same instance as in "simplex 3 asset"; the optimum is unique
+		auto assets = makeSimplexAssets(3);
+		SpeedexAssetRegistry registry(assets);
+
+		TradeMaximizingSolver dense(registry, TradeMaximizingSolver::Engine::DENSE_SIMPLEX);
+		TradeMaximizingSolver flow(registry, TradeMaximizingSolver::Engine::NETWORK_FLOW);
+
+		for (auto* solver : {&dense, &flow}) {
+			setSimplexAmount(assets[0], assets[1], *solver, 200);
+			setSimplexAmount(assets[1], assets[2], *solver, 100);
+			setSimplexAmount(assets[2], assets[0], *solver, 150);
+
+			setSimplexAmount(assets[1], assets[0], *solver, 100);
+			setSimplexAmount(assets[2], assets[1], *solver, 100);
+
+			solver->doSolve();
+		}
+
+		checkPairFlowsMatch(dense, flow, 3);
+		checkSimplexAmount(assets[0], assets[1], flow, 200);
+		checkSimplexAmount(assets[1], assets[0], flow, 100);
+		checkSimplexAmount(assets[1], assets[2], flow, 100);
+		checkSimplexAmount(assets[2], assets[0], flow, 100);
+	}
+}
+
+TEST_CASE("trade maximizing solver scaling bench", "[!hide][simplex-bench]")
+{
+	using clock = std::chrono::steady_clock;
+
+	auto ms = [] (clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count();
+	};
+
+	for (size_t numAssets : {10, 20, 50, 100, 200, 500}) {
+		auto assets = makeSimplexAssets(numAssets);
+		SpeedexAssetRegistry registry(assets);
+
+		std::vector<int128_t> bounds;
+		std::mt19937_64 gen(numAssets);
+		for (size_t i = 0; i < numAssets * numAssets; i++) {
+			bounds.push_back(((int128_t) (1 + gen() % 1000000000)) << 32);
+		}
+
+		auto run = [&] (TradeMaximizingSolver::Engine engine) {
+			auto start = clock::now();
+			TradeMaximizingSolver solver(registry, engine);
+			for (size_t i = 0; i < numAssets; i++) {
+				for (size_t j = 0; j < numAssets; j++) {
+					if (i != j) {
+						solver.setUpperBound(i, j, bounds[i * numAssets + j]);
+					}
+				}
+			}
+			solver.doSolve();
+			auto elapsed = clock::now() - start;
+			return std::make_pair(ms(elapsed), totalVolume(solver, numAssets));
+		};
+
+		auto [flowMs, flowVolume] = run(TradeMaximizingSolver::Engine::NETWORK_FLOW);
+
+		// the dense tableau is O(n^4): only run it where it finishes
+		if (numAssets <= TradeMaximizingSolver::DENSE_SIMPLEX_MAX_ASSETS) {
+			auto [denseMs, denseVolume] = run(TradeMaximizingSolver::Engine::DENSE_SIMPLEX);
+			REQUIRE(denseVolume == flowVolume);
+			std::printf("%zu assets: network flow %.2f ms dense simplex %.2f ms\n", numAssets, flowMs, denseMs);
+		} else {
+			std::printf("%zu assets: network flow %.2f ms\n", numAssets, flowMs);
+		}
+	}
+}
@@ -5,8 +5,12 @@
 namespace stellar {
 
 
-BatchSolution::BatchSolution(UnorderedMap<AssetPair, int128_t, AssetPairHash> const& tradeAmounts, std::map<Asset, uint64_t> const& prices)
+BatchSolution::BatchSolution(
+	UnorderedMap<AssetPair, int128_t, AssetPairHash> const& tradeAmounts,
+	SpeedexAssetRegistry const& registry,
+	std::vector<uint64_t> const& prices)
 	: mTradeAmountsTimesPrices(tradeAmounts)
+	, mRegistry(registry)
 	, mAssetPrices(prices)
 {}
 
@@ -17,8 +21,8 @@ BatchSolution::produceClearingTargets() const {
 	std::vector<OrderbookClearingTarget> out;
 
 	for (auto& [tradingPair, amount] : mTradeAmountsTimesPrices) {
-		uint64_t sellPrice = mAssetPrices.at(tradingPair.selling);
-		uint64_t buyPrice = mAssetPrices.at(tradingPair.buying);
+		uint64_t sellPrice = mAssetPrices.at(mRegistry.getIndex(tradingPair.selling));
+		uint64_t buyPrice = mAssetPrices.at(mRegistry.getIndex(tradingPair.buying));
 
 		out.emplace_back(tradingPair, sellPrice, buyPrice, amount);
 	}
@@ -31,11 +35,11 @@ BatchSolution::getValuationResults() const
 
 	std::vector<SpeedexClearingValuation> out;
 
-	for (auto const& [asset, price] : mAssetPrices)
+	for (auto idx : mRegistry.getIndicesInAssetOrder())
 	{
 		out.emplace_back();
-		out.back().asset = asset;
-		out.back().price = price;
+		out.back().asset = mRegistry.getAsset(idx);
+		out.back().price = mAssetPrices.at(idx);
 	}
 	return out;
 }
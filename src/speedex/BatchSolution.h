@@ -5,7 +5,8 @@
 #include "ledger/LedgerHashUtils.h"
 #include "util/XDROperators.h"
 #include "util/UnorderedMap.h"
-#include <map>
+#include "speedex/SpeedexAssetRegistry.h"
+#include <vector>
 
 #include "xdr/Stellar-ledger.h"
 
@@ -18,7 +19,8 @@ class BatchSolution {
 
 	UnorderedMap<AssetPair, int128_t, AssetPairHash> mTradeAmountsTimesPrices;
 
-	std::map<Asset, uint64_t> mAssetPrices;
+	SpeedexAssetRegistry const& mRegistry;
+	std::vector<uint64_t> mAssetPrices;
 
 	//Note different units than in IOCOffer precomputedTatonnementStats
 	//This is just (trade amount -- int64_t) * valuation (uint64_t)
@@ -26,7 +28,8 @@ public:
 
 	BatchSolution(
 		UnorderedMap<AssetPair, int128_t, AssetPairHash> const& tradeAmounts,
-		std::map<Asset, uint64_t> const& prices);
+		SpeedexAssetRegistry const& registry,
+		std::vector<uint64_t> const& prices);
 
 	std::vector<OrderbookClearingTarget>
 	produceClearingTargets() const;
@@ -0,0 +1,87 @@
+#include "speedex/ClearingDeltaBuffer.h"
+
+#include "ledger/LedgerTxn.h"
+#include "ledger/TrustLineWrapper.h"
+
+#include "transactions/TransactionUtils.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace stellar {
+
+void
+ClearingDeltaBuffer::add(AccountID const& account, Asset const& asset, int64_t amount)
+{
+	// zero amounts are kept: the entry is still touched
+	mDeltas.push_back(Delta {
+		.mAccount = account,
+		.mAsset = asset,
+		.mAmount = amount
+	});
+}
+
+void
+ClearingDeltaBuffer::merge(ClearingDeltaBuffer&& other)
+{
+	if (mDeltas.empty()) {
+		mDeltas = std::move(other.mDeltas);
+	} else {
+		mDeltas.insert(mDeltas.end(),
+			std::make_move_iterator(other.mDeltas.begin()),
+			std::make_move_iterator(other.mDeltas.end()));
+	}
+	other.mDeltas.clear();
+}
+
+void
+ClearingDeltaBuffer::apply(AbstractLedgerTxn& ltx)
+{
+	auto keyLT = [] (Delta const& lhs, Delta const& rhs) {
+		if (lhs.mAccount != rhs.mAccount) {
+			return lhs.mAccount < rhs.mAccount;
+		}
+		return lhs.mAsset < rhs.mAsset;
+	};
+	std::sort(mDeltas.begin(), mDeltas.end(), keyLT);
+
+	auto header = ltx.loadHeader();
+
+	auto doTransfer = [&] (AccountID const& accountID, Asset const& asset, int64_t amount) {
+		if (asset.type() == ASSET_TYPE_NATIVE) {
+			auto account = loadAccount(ltx, accountID);
+			if (!account) {
+				throw std::runtime_error("failed to find account");
+			}
+			if (!addBalance(header, account, amount)) {
+				throw std::runtime_error("fail to add xlm balance");
+			}
+		} else {
+			auto sourceLine = loadTrustLine(ltx, accountID, asset);
+			if (!sourceLine) {
+				throw std::runtime_error("failed to find trustline");
+			}
+			if (!sourceLine.addBalance(header, amount)) {
+				throw std::runtime_error("failed to add nonxlm balance");
+			}
+		}
+	};
+
+	for (size_t i = 0; i < mDeltas.size();) {
+		int128_t net = 0;
+		size_t j = i;
+		for (; j < mDeltas.size() && !keyLT(mDeltas[i], mDeltas[j]); j++) {
+			net += mDeltas[j].mAmount;
+		}
+		if (net > std::numeric_limits<int64_t>::max()
+			|| net < std::numeric_limits<int64_t>::min()) {
+			throw std::runtime_error("clearing delta overflow");
+		}
+		doTransfer(mDeltas[i].mAccount, mDeltas[i].mAsset, static_cast<int64_t>(net));
+		i = j;
+	}
+	mDeltas.clear();
+}
+
+} /* stellar */
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "xdr/Stellar-ledger-entries.h"
+
+#include "util/XDROperators.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stellar {
+
+class AbstractLedgerTxn;
+
+/*
+Balance changes produced by clearing speedex offers, buffered so that the
+per-offer fills of every trading pair can be computed off the ledger (and in
+parallel), then written in one pass.
+
+Each clearing task records into its own buffer; the buffers are then merged
+and applied.  Changes to the same (account, asset) are summed, and entries
+are applied in (account, asset) order, so the ledger writes do not depend on
+how the fills were partitioned across tasks, nor on the merge order.
+
+Every (account, asset) that received a change is loaded and recorded, even
+when the change (or the net) is zero, so the set of modified entries is the
+same as with one credit and one debit per offer.
+*/
+class ClearingDeltaBuffer {
+	using int128_t = __int128_t;
+
+	struct Delta {
+		AccountID mAccount;
+		Asset mAsset;
+		int128_t mAmount;
+	};
+
+	std::vector<Delta> mDeltas;
+
+public:
+
+	void add(AccountID const& account, Asset const& asset, int64_t amount);
+
+	void merge(ClearingDeltaBuffer&& other);
+
+	size_t size() const {
+		return mDeltas.size();
+	}
+
+	// Nets out changes to the same (account, asset) and applies the
+	// results to account balances and trustlines, including zero results.
+	// Throws if any balance change fails.
+	void apply(AbstractLedgerTxn& ltx);
+};
+
+} /* stellar */
@@ -4,54 +4,137 @@
 #include "speedex/LiquidityPoolSetFrame.h"
 
 #include "speedex/DemandUtils.h"
+#include "speedex/ParallelDemandQuery.h"
 
 #include "simplex/solver.h"
 
+#include "util/ForkJoinPool.h"
+
 namespace stellar
 {
 
-DemandOracle::DemandOracle(IOCOrderbookManager const& orderbooks, LiquidityPoolSetFrame const& liquidityPools)
-	: mOrderbooks(orderbooks)
+DemandOracle::DemandOracle(
+	SpeedexAssetRegistry const& registry,
+	IOCOrderbookManager const& orderbooks,
+	LiquidityPoolSetFrame const& liquidityPools,
+	ForkJoinPool* workers)
+	: mRegistry(registry)
+	, mOrderbooks(orderbooks)
 	, mLiquidityPools(liquidityPools)
-	{}
+	, mParallelQuery()
+	{
+		if (workers != nullptr && workers->numThreads() > 1)
+		{
+			mParallelQuery = std::make_unique<ParallelDemandQuery>(orderbooks, *workers);
+		}
+	}
+
+DemandOracle::~DemandOracle() {}
+
+void
+DemandOracle::demandQuery(std::vector<uint64_t> const& prices, uint8_t smoothMult, SupplyDemand& out,
+	DemandSlopes* slopes)
+{
+	out.reset(mRegistry.size());
+	if (slopes)
+	{
+		slopes->reset(mRegistry.size());
+	}
+	if (mParallelQuery)
+	{
+		mParallelQuery->demandQuery(prices, out, smoothMult, slopes);
+	} else
+	{
+		mOrderbooks.demandQuery(prices, out, smoothMult, slopes);
+	}
+	mLiquidityPools.demandQuery(prices, out, slopes);
+}
 
 SupplyDemand
-DemandOracle::demandQuery(std::map<Asset, uint64_t> const& prices, uint8_t smoothMult) const
+DemandOracle::demandQuery(std::vector<uint64_t> const& prices, uint8_t smoothMult)
 {
 	SupplyDemand sd;
-	mOrderbooks.demandQuery(prices, sd, smoothMult);
-	mLiquidityPools.demandQuery(prices, sd);
+	demandQuery(prices, smoothMult, sd);
 	return sd;
 }
 
 DemandOracle::int128_t
-DemandOracle::demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const
+DemandOracle::demandQueryOneAssetPair(index_t sellIdx, index_t buyIdx, std::vector<uint64_t> const& prices) const
 {
-	return mOrderbooks.demandQueryOneAssetPair(tradingPair, prices)
-		 + mLiquidityPools.demandQueryOneAssetPair(tradingPair, prices);
+	return mOrderbooks.demandQueryOneAssetPair(sellIdx, buyIdx, prices)
+		 + mLiquidityPools.demandQueryOneAssetPair(sellIdx, buyIdx, prices);
 }
 
 void
-DemandOracle::setSolverUpperBounds(TradeMaximizingSolver& solver, std::map<Asset, uint64_t> const& prices) const
+DemandOracle::setSolverUpperBounds(TradeMaximizingSolver& solver, std::vector<uint64_t> const& prices) const
+{
+	// asset order (not index order), so that solver rows are added in the
+	// same order regardless of the order of assets in the speedex config
+	auto const& order = mRegistry.getIndicesInAssetOrder();
+	for (auto sellIdx : order)
+	{
+		for (auto buyIdx : order)
+		{
+			if (buyIdx != sellIdx)
+			{
+				int128_t supply = demandQueryOneAssetPair(sellIdx, buyIdx, prices);
+				if (supply != 0)
+				{
+					solver.setUpperBound(sellIdx, buyIdx, supply);
+				}
+			}
+		}
+	}
+}
+
+bool
+DemandOracle::checkApproximateClearing(std::vector<uint64_t> const& prices, uint8_t taxRate) const
 {
-	for (auto const& [sellAsset, sellPrice] : prices)
+	struct PairBounds {
+		index_t mSellIdx, mBuyIdx;
+		int128_t mLowerBound;
+	};
+	std::vector<PairBounds> bounds;
+
+	TradeMaximizingSolver solver(mRegistry);
+
+	// same row order as setSolverUpperBounds
+	auto const& order = mRegistry.getIndicesInAssetOrder();
+	for (auto sellIdx : order)
 	{
-		for (auto const& [buyAsset, buyPrice] : prices)
+		for (auto buyIdx : order)
 		{
-			if (buyAsset != sellAsset)
+			if (buyIdx != sellIdx)
 			{
-				AssetPair tradingPair {
-					.selling = sellAsset,
-					.buying = buyAsset
-				};
-				int128_t supply = demandQueryOneAssetPair(tradingPair, prices);
+				int128_t supply = demandQueryOneAssetPair(sellIdx, buyIdx, prices);
 				if (supply != 0)
 				{
-					solver.setUpperBound(tradingPair, supply);
+					solver.setUpperBound(sellIdx, buyIdx, supply);
+					bounds.push_back(PairBounds {
+						.mSellIdx = sellIdx,
+						.mBuyIdx = buyIdx,
+						.mLowerBound = mOrderbooks.demandQueryOneAssetPair(sellIdx, buyIdx, prices, taxRate)
+					});
 				}
 			}
 		}
 	}
+
+	if (bounds.empty())
+	{
+		return true;
+	}
+
+	solver.doSolve();
+
+	for (auto const& pair : bounds)
+	{
+		if (solver.getRowResult(pair.mSellIdx, pair.mBuyIdx) < pair.mLowerBound)
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
 } /* stellar */
@@ -1,37 +1,72 @@
 #pragma once
 
-#include <map>
-#include "xdr/Stellar-ledger-entries.h"
+#include "speedex/SpeedexAssetRegistry.h"
 
 #include <cstdint>
-
-#include "ledger/AssetPair.h"
+#include <memory>
+#include <vector>
 
 namespace stellar
 {
 
+class ForkJoinPool;
 class IOCOrderbookManager;
 class LiquidityPoolSetFrame;
+struct DemandSlopes;
+class ParallelDemandQuery;
 struct SupplyDemand;
 class TradeMaximizingSolver;
 
 class DemandOracle {
 	using int128_t = __int128;
+	using index_t = SpeedexAssetRegistry::index_t;
 
+	SpeedexAssetRegistry const& mRegistry;
 	const IOCOrderbookManager& mOrderbooks;
 	const LiquidityPoolSetFrame& mLiquidityPools;
 
-	int128_t demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const;
+	// null when demand queries run serially
+	std::unique_ptr<ParallelDemandQuery> mParallelQuery;
+
+	int128_t demandQueryOneAssetPair(index_t sellIdx, index_t buyIdx, std::vector<uint64_t> const& prices) const;
 
 
 public:
 
-	DemandOracle(IOCOrderbookManager const& orderbooks, LiquidityPoolSetFrame const& liquidityPools);
+	// If workers is non-null and has more than one thread, orderbook demand
+	// queries are split across it.  Orderbooks must already be sealed
+	// against registry.
+	DemandOracle(
+		SpeedexAssetRegistry const& registry,
+		IOCOrderbookManager const& orderbooks,
+		LiquidityPoolSetFrame const& liquidityPools,
+		ForkJoinPool* workers = nullptr);
+	~DemandOracle();
+
+	DemandOracle(const DemandOracle&) = delete;
+	DemandOracle& operator=(const DemandOracle&) = delete;
+
+	SpeedexAssetRegistry const& getRegistry() const {
+		return mRegistry;
+	}
+
+	// overwrites out (and slopes, if non-null), reusing their allocations
+	void demandQuery(std::vector<uint64_t> const& prices, uint8_t smoothMult, SupplyDemand& out,
+		DemandSlopes* slopes = nullptr);
+
+	SupplyDemand demandQuery(std::vector<uint64_t> const& prices, uint8_t smoothMult);
+
+	void setSolverUpperBounds(TradeMaximizingSolver& solver, std::vector<uint64_t> const& prices) const;
 
-	SupplyDemand demandQuery(std::map<Asset, uint64_t> const& prices, uint8_t smoothMult) const;
+	/*
+	True if the market (approximately) clears at prices, with a 2^-taxRate fee.
 
-	void setSolverUpperBounds(TradeMaximizingSolver& solver, std::map<Asset, uint64_t> const& prices) const;
+	Upper bounds are set as in setSolverUpperBounds.  Every pair must then
+	trade, in the solver's solution, at least the orderbook supply that is in
+	the money by a 2^-taxRate margin (the demand smoothed with taxRate).
+	*/
+	bool checkApproximateClearing(std::vector<uint64_t> const& prices, uint8_t taxRate) const;
 };
 
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
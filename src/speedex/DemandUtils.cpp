@@ -3,22 +3,20 @@
 namespace stellar
 {
 
+SupplyDemand::SupplyDemand(size_t numAssets)
+	: mSupplyDemand(numAssets, {0, 0})
+	{}
+
 void
-SupplyDemand::addSupplyDemand(Asset const& sell, Asset const& buy, int128_t amount)
+SupplyDemand::reset(size_t numAssets)
 {
-	mSupplyDemand[sell].first += amount;
-	mSupplyDemand[buy].second += amount;
+	mSupplyDemand.assign(numAssets, {0, 0});
 }
+
 void
-SupplyDemand::addSupplyDemand(AssetPair const& tradingPair, int128_t amount) 
+DemandSlopes::reset(size_t numAssets)
 {
-	addSupplyDemand(tradingPair.selling, tradingPair.buying, amount);
-}
-
-SupplyDemand::int128_t
-SupplyDemand::getDelta(Asset const& asset) const {
-	auto const& [supply, demand] = mSupplyDemand.at(asset);
-	return demand - supply;
+	mDiagonal.assign(numAssets, 0);
 }
 
 TatonnementObjectiveFn 
@@ -27,10 +25,10 @@ SupplyDemand::getObjective() const
 	return TatonnementObjectiveFn(mSupplyDemand);
 }
 
-TatonnementObjectiveFn::TatonnementObjectiveFn(std::map<Asset, std::pair<int128_t, int128_t>> const& supplyDemands)
+TatonnementObjectiveFn::TatonnementObjectiveFn(std::vector<std::pair<int128_t, int128_t>> const& supplyDemands)
 	: value({0, 0})
 {
-	for (auto const& [_, sd] : supplyDemands)
+	for (auto const& sd : supplyDemands)
 	{
 		auto const& [supply, demand] = sd;
 		value += uint256_t::square(demand-supply);
@@ -54,4 +52,10 @@ TatonnementObjectiveFn::isBetterThan(TatonnementObjectiveFn const& other, uint8_
 	return compareL <= compareR;
 }
 
+double
+TatonnementObjectiveFn::toDouble() const
+{
+	return static_cast<double>(value.highbits) * 0x1.0p128 + static_cast<double>(value.lowbits);
+}
+
 } /* stellar */
\ No newline at end of file
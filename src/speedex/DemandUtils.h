@@ -2,31 +2,67 @@
 
 #include "speedex/uint256_t.h"
 
-#include "ledger/AssetPair.h"
-
+#include <cstddef>
 #include <cstdint>
-#include <map>
-
-#include "util/XDROperators.h"
+#include <utility>
+#include <vector>
 
 namespace stellar
 {
 
 class TatonnementObjectiveFn;
 
+// Indexed by SpeedexAssetRegistry::index_t
 struct SupplyDemand {
 	using int128_t = __int128;
 
 	// pairs are (supply, demand)
-	std::map<Asset, std::pair<int128_t, int128_t>> mSupplyDemand;
+	std::vector<std::pair<int128_t, int128_t>> mSupplyDemand;
+
+	SupplyDemand(size_t numAssets = 0);
 
-	void addSupplyDemand(Asset const& sell, Asset const& buy, int128_t amount);
-	void addSupplyDemand(AssetPair const& tradingPair, int128_t amount);
+	// zeroes all entries, keeping the allocation
+	void reset(size_t numAssets);
+
+	void addSupplyDemand(size_t sellIdx, size_t buyIdx, int128_t amount) {
+		mSupplyDemand[sellIdx].first += amount;
+		mSupplyDemand[buyIdx].second += amount;
+	}
 
 	TatonnementObjectiveFn getObjective() const;
 
-	int128_t getDelta(Asset const& asset) const;
+	int128_t getDelta(size_t assetIdx) const {
+		auto const& [supply, demand] = mSupplyDemand[assetIdx];
+		return demand - supply;
+	}
+
+	size_t numAssets() const {
+		return mSupplyDemand.size();
+	}
+};
+
+/*
+Negated diagonal of the Jacobian of excess demand (SupplyDemand::getDelta)
+with respect to log prices, in the same (value) units as SupplyDemand.
+
+Raising an asset's price raises the value of what its sellers offer (and so
+its supply), and lowers what is offered for it (and so its demand), so every
+entry is nonnegative.  Indexed by SpeedexAssetRegistry::index_t.
+*/
+struct DemandSlopes {
+	using int128_t = __int128;
+
+	std::vector<int128_t> mDiagonal;
+
+	// zeroes all entries, keeping the allocation
+	void reset(size_t numAssets);
 
+	// sellSlope is d(value sold)/d ln(sell price), buySlope is
+	// -d(value sold)/d ln(buy price)
+	void addSlopes(size_t sellIdx, size_t buyIdx, int128_t sellSlope, int128_t buySlope) {
+		mDiagonal[sellIdx] += sellSlope;
+		mDiagonal[buyIdx] += buySlope;
+	}
 };
 
 class TatonnementObjectiveFn
@@ -37,11 +73,14 @@ class TatonnementObjectiveFn
 
 public:
 
-	TatonnementObjectiveFn(std::map<Asset, std::pair<int128_t, int128_t>> const& excessDemands);
+	TatonnementObjectiveFn(std::vector<std::pair<int128_t, int128_t>> const& excessDemands);
 
 	// is self <= other * tolN/tolD?
 	bool isBetterThan(TatonnementObjectiveFn const& other, uint8_t tolN, uint8_t tolD) const;
+
+	// approximate, for reporting only
+	double toDouble() const;
 };
 
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
@@ -4,14 +4,18 @@
 
 #include "util/types.h"
 
+#include <algorithm>
+
 namespace stellar {
 
 IOCOrderbook::IOCOrderbook(AssetPair tradingPair) 
 	: mTradingPair(tradingPair)
+	, mOffers()
+	, mOffersSorted(true)
+	, mPriceLevels()
 	, mCleared(false)
 	{};
 
-
 void
 IOCOrderbook::throwIfCleared() {
 	if (mCleared) {
@@ -32,34 +36,269 @@ priceNEQ(Price const& p1, Price const& p2)
 	return ((uint64_t)p1.n) * ((uint64_t) p2.d) != ((uint64_t)p1.d) * ((uint64_t) p2.n);
 }
 
-void 
-IOCOrderbook::doPriceComputationPreprocessing() {
-	//std::printf("preprocess\n");
-	PriceCompStats stats = zeroStats;
-	mPrecomputedTatonnementData.clear();
-	for (auto& offer : mOffers) {
-		//intentionally starting with 0 at bot
-		if (priceNEQ(offer.mMinPrice, stats.marginalPrice))
+static bool
+priceLT(Price const& p1, Price const& p2)
+{
+	return ((uint64_t)p1.n) * ((uint64_t) p2.d) < ((uint64_t)p1.d) * ((uint64_t) p2.n);
+}
+
+bool priceLTE(Price const& p, uint64_t sellPrice, uint64_t buyPrice);
+
+void
+IOCOrderbook::PriceLevels::add(Price const& price, int64_t amount, int128_t amountTimesPrice)
+{
+	mFinalized = false;
+
+	if (mChunks.empty()) {
+		mChunks.emplace_back();
+	}
+
+	// first chunk whose last level is >= price, else the last chunk
+	auto chunkIter = std::partition_point(mChunks.begin(), mChunks.end() - 1,
+		[&price] (Chunk const& chunk) {
+			return priceLT(chunk.mPrices.back(), price);
+		});
+	auto& chunk = *chunkIter;
+
+	auto levelIter = std::partition_point(chunk.mPrices.begin(), chunk.mPrices.end(), 
+		[&price] (Price const& level) {
+			return priceLT(level, price);
+		});
+	size_t pos = levelIter - chunk.mPrices.begin();
+
+	if (levelIter == chunk.mPrices.end() || priceNEQ(*levelIter, price))
+	{
+		int64_t prevAmount = pos == 0 ? 0 : chunk.mCumulativeOfferedForSale[pos - 1];
+		int128_t prevTimesPrice = pos == 0 ? 0 : chunk.mCumulativeOfferedForSaleTimesPrice[pos - 1];
+
+		chunk.mPrices.insert(levelIter, price);
+		chunk.mCumulativeOfferedForSale.insert(chunk.mCumulativeOfferedForSale.begin() + pos, prevAmount);
+		chunk.mCumulativeOfferedForSaleTimesPrice.insert(chunk.mCumulativeOfferedForSaleTimesPrice.begin() + pos, prevTimesPrice);
+	}
+
+	for (size_t i = pos; i < chunk.mPrices.size(); i++)
+	{
+		chunk.mCumulativeOfferedForSale[i] += amount;
+		chunk.mCumulativeOfferedForSaleTimesPrice[i] += amountTimesPrice;
+	}
+
+	if (chunk.mPrices.size() > 2 * CHUNK_SIZE)
+	{
+		splitChunk(chunkIter - mChunks.begin());
+	}
+}
+
+void
+IOCOrderbook::PriceLevels::splitChunk(size_t chunkIdx)
+{
+	Chunk upper;
+	{
+		auto& lower = mChunks[chunkIdx];
+
+		int64_t baseAmount = lower.mCumulativeOfferedForSale[CHUNK_SIZE - 1];
+		int128_t baseTimesPrice = lower.mCumulativeOfferedForSaleTimesPrice[CHUNK_SIZE - 1];
+
+		upper.mPrices.assign(lower.mPrices.begin() + CHUNK_SIZE, lower.mPrices.end());
+		for (size_t i = CHUNK_SIZE; i < lower.mPrices.size(); i++)
 		{
-		//	std::printf("adding (%d / %d) %lld\n", stats.marginalPrice.n, stats.marginalPrice.d, stats.cumulativeOfferedForSale);
-			mPrecomputedTatonnementData.push_back(stats);
+			upper.mCumulativeOfferedForSale.push_back(lower.mCumulativeOfferedForSale[i] - baseAmount);
+			upper.mCumulativeOfferedForSaleTimesPrice.push_back(lower.mCumulativeOfferedForSaleTimesPrice[i] - baseTimesPrice);
 		}
-		stats.marginalPrice = offer.mMinPrice;
-		stats.cumulativeOfferedForSale += offer.mSellAmount;
 
-		int128_t offerTimesPrice = ((int128_t) offer.mSellAmount) * offer.mMinPrice.n;
-		offerTimesPrice <<= PriceCompStats::OFFERED_TIMES_PRICE_RADIX;
+		lower.mPrices.resize(CHUNK_SIZE);
+		lower.mCumulativeOfferedForSale.resize(CHUNK_SIZE);
+		lower.mCumulativeOfferedForSaleTimesPrice.resize(CHUNK_SIZE);
+	}
+	mChunks.insert(mChunks.begin() + chunkIdx + 1, std::move(upper));
+}
 
-		stats.cumulativeOfferedForSaleTimesPrice += offerTimesPrice / offer.mMinPrice.d;
+void
+IOCOrderbook::PriceLevels::merge(PriceLevels const& other)
+{
+	for (auto const& chunk : other.mChunks)
+	{
+		for (size_t i = 0; i < chunk.mPrices.size(); i++)
+		{
+			int64_t amount = chunk.mCumulativeOfferedForSale[i];
+			int128_t timesPrice = chunk.mCumulativeOfferedForSaleTimesPrice[i];
+			if (i > 0)
+			{
+				amount -= chunk.mCumulativeOfferedForSale[i - 1];
+				timesPrice -= chunk.mCumulativeOfferedForSaleTimesPrice[i - 1];
+			}
+			add(chunk.mPrices[i], amount, timesPrice);
+		}
+	}
+}
+
+// Fills tree (Eytzinger order, rooted at 1) from sorted, in order.
+// Returns the next unused index of sorted.
+static size_t
+fillSearchTree(std::vector<Price>& tree, std::vector<Price> const& sorted, size_t sortedIdx, size_t treeIdx)
+{
+	if (treeIdx >= tree.size()) {
+		return sortedIdx;
+	}
+	sortedIdx = fillSearchTree(tree, sorted, sortedIdx, 2 * treeIdx);
+	tree[treeIdx] = sorted[sortedIdx++];
+	return fillSearchTree(tree, sorted, sortedIdx, 2 * treeIdx + 1);
+}
+
+void
+IOCOrderbook::PriceLevels::finalize()
+{
+	mLevelPrices.clear();
+	mLevelOfferedForSale.clear();
+	mLevelOfferedForSaleTimesPrice.clear();
+
+	int64_t amount = 0;
+	int128_t timesPrice = 0;
+	for (auto const& chunk : mChunks)
+	{
+		for (size_t i = 0; i < chunk.mPrices.size(); i++)
+		{
+			mLevelPrices.push_back(chunk.mPrices[i]);
+			mLevelOfferedForSale.push_back(amount + chunk.mCumulativeOfferedForSale[i]);
+			mLevelOfferedForSaleTimesPrice.push_back(timesPrice + chunk.mCumulativeOfferedForSaleTimesPrice[i]);
+		}
+		amount += chunk.mCumulativeOfferedForSale.back();
+		timesPrice += chunk.mCumulativeOfferedForSaleTimesPrice.back();
+	}
 
+	// Pad to a complete tree (2^depth - 1 levels) with a price above every
+	// query price (n / 0), so that every descent takes exactly depth steps.
+	mSearchDepth = 0;
+	while (((size_t)1 << mSearchDepth) <= mLevelPrices.size()) {
+		mSearchDepth++;
 	}
+	Price sentinel;
+	sentinel.n = 1;
+	sentinel.d = 0;
 
-	mPrecomputedTatonnementData.push_back(stats);
+	std::vector<Price> padded = mLevelPrices;
+	padded.resize(((size_t)1 << mSearchDepth) - 1, sentinel);
+
+	mSearchTree.assign((size_t)1 << mSearchDepth, sentinel);
+	fillSearchTree(mSearchTree, padded, 0, 1);
+
+	mFinalized = true;
+}
+
+void
+IOCOrderbook::PriceLevels::throwIfNotFinalized() const
+{
+	if (!mFinalized)
+	{
+		throw std::logic_error("price levels not finalized");
+	}
+}
+
+IOCOrderbook::PriceCompStats
+IOCOrderbook::PriceLevels::statsAt(size_t numLevels) const
+{
+	// a zero buy price passes every level, including the padding
+	numLevels = std::min(numLevels, mLevelPrices.size());
+	if (numLevels == 0)
+	{
+		return zeroStats;
+	}
+	return PriceCompStats {
+		.marginalPrice = mLevelPrices[numLevels - 1],
+		.cumulativeOfferedForSale = mLevelOfferedForSale[numLevels - 1],
+		.cumulativeOfferedForSaleTimesPrice = mLevelOfferedForSaleTimesPrice[numLevels - 1]
+	};
+}
+
+/*
+Branch-free Eytzinger descent: at node k, step to 2k + (level <= query).
+After mSearchDepth steps (the tree is complete), k - 2^mSearchDepth
+(the path bits) is the number of levels <= the query.
+
+The prefetch pulls in the node's descendants three levels down (eight
+8-byte prices, one cache line), so the loads of later steps overlap.
+*/
+
+IOCOrderbook::PriceCompStats
+IOCOrderbook::PriceLevels::get(uint64_t sellPrice, uint64_t buyPrice) const
+{
+	throwIfNotFinalized();
+
+	const Price* tree = mSearchTree.data();
+	const size_t treeSize = mSearchTree.size();
+
+	size_t k = 1;
+	for (uint32_t i = 0; i < mSearchDepth; i++)
+	{
+		__builtin_prefetch(tree + std::min(8 * k, treeSize - 1));
+		k = 2 * k + priceLTE(tree[k], sellPrice, buyPrice);
+	}
+	return statsAt(k - ((size_t)1 << mSearchDepth));
+}
+
+std::pair<IOCOrderbook::PriceCompStats, IOCOrderbook::PriceCompStats>
+IOCOrderbook::PriceLevels::getPair(uint64_t lowSellPrice, uint64_t highSellPrice, uint64_t buyPrice) const
+{
+	throwIfNotFinalized();
+
+	const Price* tree = mSearchTree.data();
+	const size_t treeSize = mSearchTree.size();
+
+	// The two paths coincide until the first level between the two query
+	// prices, so they read the same nodes (and cache lines) until then.
+	size_t kLow = 1, kHigh = 1;
+	for (uint32_t i = 0; i < mSearchDepth; i++)
+	{
+		__builtin_prefetch(tree + std::min(8 * kLow, treeSize - 1));
+		__builtin_prefetch(tree + std::min(8 * kHigh, treeSize - 1));
+		kLow = 2 * kLow + priceLTE(tree[kLow], lowSellPrice, buyPrice);
+		kHigh = 2 * kHigh + priceLTE(tree[kHigh], highSellPrice, buyPrice);
+	}
+	return {
+		statsAt(kLow - ((size_t)1 << mSearchDepth)),
+		statsAt(kHigh - ((size_t)1 << mSearchDepth))
+	};
+}
+
+size_t
+IOCOrderbook::PriceLevels::numLevels() const
+{
+	size_t out = 0;
+	for (auto const& chunk : mChunks)
+	{
+		out += chunk.mPrices.size();
+	}
+	return out;
+}
+
+void
+IOCOrderbook::sortOffers() {
+	if (mOffersSorted) {
+		return;
+	}
+	std::sort(mOffers.begin(), mOffers.end(), 
+		[] (IOCOffer const& lhs, IOCOffer const& rhs) {
+			return lhs < rhs;
+		});
+	mOffersSorted = true;
+}
+
+void 
+IOCOrderbook::doPriceComputationPreprocessing() {
+	mPriceLevels.finalize();
 }
 
 void 
 IOCOrderbook::addOffer(IOCOffer offer) {
-	mOffers.insert(offer);
+	int128_t offerTimesPrice = ((int128_t) offer.mSellAmount) * offer.mMinPrice.n;
+	offerTimesPrice <<= PriceCompStats::OFFERED_TIMES_PRICE_RADIX;
+	offerTimesPrice /= offer.mMinPrice.d;
+
+	mPriceLevels.add(offer.mMinPrice, offer.mSellAmount, offerTimesPrice);
+
+	if (mOffersSorted && !mOffers.empty() && !(mOffers.back() < offer)) {
+		mOffersSorted = false;
+	}
+	mOffers.push_back(std::move(offer));
 }
 
 void
@@ -69,44 +308,49 @@ IOCOrderbook::commitChild(const IOCOrderbook& other) {
 	if (mTradingPair != other.mTradingPair) {
 		throw std::runtime_error("merge orderbooks trading pair mismatch!");
 	}
-	mOffers.insert(other.mOffers.begin(), other.mOffers.end());
-	mPrecomputedTatonnementData.clear();
+	// Sorting is deferred to clearing, so that a batch built from many
+	// small child commits is sorted once, not once per commit.
+	mOffers.insert(mOffers.end(), other.mOffers.begin(), other.mOffers.end());
+	mOffersSorted = false;
+	mPriceLevels.merge(other.mPriceLevels);
 }
 
-std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
-IOCOrderbook::clearOffers(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame)
+std::vector<SpeedexOfferClearingStatus>
+IOCOrderbook::clearOffers(OrderbookClearingTarget& target, ClearingDeltaBuffer& deltas)
 {
 	throwIfCleared();
-
-	auto sellStr = assetToString(mTradingPair.selling);
-	auto buyStr = assetToString(mTradingPair.buying);
-
-	std::printf("clearing trade pair sell %s buy %s\n", sellStr.c_str(), buyStr.c_str());
+	sortOffers();
 
 	std::vector<SpeedexOfferClearingStatus> out;
 
 	for (auto iter = mOffers.begin(); iter != mOffers.end(); iter++) {
 		if (!target.doneClearing()) {
 			// TODO adjust here if prioritizing full execution over trading at all
-			out.push_back(target.clearOffer(ltx, *iter));
+			out.push_back(target.clearOffer(*iter, deltas));
 		} else
 		{
 			break;
 		}
 	}
+	return out;
+}
+
+std::optional<SpeedexLiquidityPoolClearingStatus>
+IOCOrderbook::finishClearing(OrderbookClearingTarget& target, LiquidityPoolFrame* lpFrame)
+{
+	throwIfCleared();
 
 	std::optional<SpeedexLiquidityPoolClearingStatus> lpRes = std::nullopt;
 
-	if (!target.doneClearing() && lpFrame) {
-		std::printf("finishing with lp\n");
-		lpRes = target.finishWithLiquidityPool(ltx, lpFrame);
+	if (!target.doneClearing() && lpFrame && *lpFrame) {
+		lpRes = target.finishWithLiquidityPool(*lpFrame);
 	}
 	if (!target.doneClearing()) {
 		throw std::runtime_error("invalid trade amounts!");
 	}
 	mCleared = true;
 
-	return {out, lpRes};
+	return lpRes;
 }
 
 void
@@ -139,47 +383,12 @@ bool priceLTE(Price const& p, uint64_t sellPrice, uint64_t buyPrice) {
 
 IOCOrderbook::PriceCompStats 
 IOCOrderbook::getPriceCompStats(uint64_t sellPrice, uint64_t buyPrice) const {
+	return mPriceLevels.get(sellPrice, buyPrice);
+}
 
-
-	//for (auto const& stats : mPrecomputedTatonnementData)
-	//{
-	//	std::printf("marginal p (%d / %d) amount %ld\n", stats.marginalPrice.n, stats.marginalPrice.d, stats.cumulativeOfferedForSale);
-	//}
-
-	if (mPrecomputedTatonnementData.size() == 1)
-	{
-		return zeroStats;
-	}
-
-	size_t start = 1;
-	size_t end = mPrecomputedTatonnementData.size() - 1;
-
-	if (priceLTE(mPrecomputedTatonnementData[end].marginalPrice, sellPrice, buyPrice))
-	{
-	//	std::printf("larger than end\n");
-		return mPrecomputedTatonnementData[end];
-	}
-
-	//std::printf("start bin search\n");
-
-	while (true) {
-		size_t mid = (start + end) / 2;
-
-
-		//std::printf("start = %lu end = %lu mid= %lu \n", start, end, mid);
-
-		if (start == end)
-		{
-			return mPrecomputedTatonnementData[start - 1];
-		}
-
-		if (priceLTE(mPrecomputedTatonnementData[mid].marginalPrice, sellPrice, buyPrice))
-		{
-			start = mid + 1;
-		} else {
-			end = mid;
-		}
-	}
+std::pair<IOCOrderbook::PriceCompStats, IOCOrderbook::PriceCompStats>
+IOCOrderbook::getPriceCompStatsPair(uint64_t lowSellPrice, uint64_t highSellPrice, uint64_t buyPrice) const {
+	return mPriceLevels.getPair(lowSellPrice, highSellPrice, buyPrice);
 }
 
 uint64_t applySmoothMult(uint64_t sellPrice, uint8_t smoothMult) {
@@ -188,6 +397,12 @@ uint64_t applySmoothMult(uint64_t sellPrice, uint8_t smoothMult) {
 
 IOCOrderbook::int128_t 
 IOCOrderbook::cumulativeOfferedForSaleTimesPrice(uint64_t sellPrice, uint64_t buyPrice, uint8_t smoothMult) const
+{
+	return offeredForSaleWithSlopes(sellPrice, buyPrice, smoothMult).mValue;
+}
+
+IOCOrderbook::OfferedForSale
+IOCOrderbook::offeredForSaleWithSlopes(uint64_t sellPrice, uint64_t buyPrice, uint8_t smoothMult) const
 {
 
 	/*
@@ -253,8 +468,7 @@ IOCOrderbook::cumulativeOfferedForSaleTimesPrice(uint64_t sellPrice, uint64_t bu
 	auto partialExecSellPrice = sellPrice;
 	auto fullExecSellPrice = applySmoothMult(sellPrice, smoothMult);
 
-	auto partialExecStats = getPriceCompStats(partialExecSellPrice, buyPrice);
-	auto fullExecStats = getPriceCompStats(fullExecSellPrice, buyPrice);
+	auto [fullExecStats, partialExecStats] = getPriceCompStatsPair(fullExecSellPrice, partialExecSellPrice, buyPrice);
 
 	int64_t fullExecEndow = fullExecStats.cumulativeOfferedForSale;
 	int64_t partialExecEndow = partialExecStats.cumulativeOfferedForSale - fullExecEndow;
@@ -288,7 +502,25 @@ IOCOrderbook::cumulativeOfferedForSaleTimesPrice(uint64_t sellPrice, uint64_t bu
 
 	//std::printf("valueSoldFullExec %lf valueSoldPartialExec %lf\n", (double) valueSoldFullExec, (double) valueSoldPartialExec);
 
-	return valueSoldFullExec + valueSoldPartialExec;
+	/*
+	Between price levels, the value sold is
+
+		V = fullExecEndow * sellPrice
+		  + 2^{smoothMult} * (partialExecEndow * sellPrice - partialExecEndowTimesPrice * buyPrice),
+
+	so
+
+		dV / d ln(sellPrice) = fullExecEndow * sellPrice + 2^{smoothMult} * partialExecEndow * sellPrice
+		-dV / d ln(buyPrice) = 2^{smoothMult} * partialExecEndowTimesPrice * buyPrice
+
+	(V is continuous, so offers crossing band edges add nothing).  Both are
+	nonnegative, and the bounds above on the shifted intermediates apply.
+	*/
+	return OfferedForSale {
+		.mValue = valueSoldFullExec + valueSoldPartialExec,
+		.mSellPriceSlope = valueSoldFullExec + (partialAmountTimesSellPrice << smoothMult),
+		.mBuyPriceSlope = partialAmountTimesMinPriceTimesBuyPrice << smoothMult
+	};
 }
 
 
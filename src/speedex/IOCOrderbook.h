@@ -4,7 +4,7 @@
 
 #include "speedex/IOCOffer.h"
 
-#include <set>
+#include <utility>
 #include <vector>
 
 #include "speedex/OrderbookClearingTarget.h"
@@ -27,6 +27,7 @@ constexpr static Price zeroPrice() {
 }
 
 class AbstractLedgerTxn;
+class ClearingDeltaBuffer;
 
 class IOCOrderbook {
 
@@ -47,6 +48,76 @@ public:
 
 	};
 
+	/*
+	Cumulative PriceCompStats over the distinct price levels of an orderbook,
+	maintained as offers arrive (chunked prefix sums).
+
+	Levels are kept sorted in chunks of at most 2 * CHUNK_SIZE levels.  Each
+	chunk stores prefix sums over its own levels (struct-of-arrays, so the
+	binary searches only touch prices), so adding an offer costs
+	O(log(#levels) + CHUNK_SIZE).
+
+	finalize() flattens the chunks into a read-only search index, in
+	O(#levels): the level prices in Eytzinger (BFS) order, padded to a
+	complete tree, next to the prefix sums in sorted order.  Every lookup
+	is then a fixed-depth, branch-free descent from the root, whose path
+	bits are the rank of the result, and whose top levels (the hot part)
+	share cache lines across all queries.
+	*/
+	class PriceLevels {
+
+		constexpr static size_t CHUNK_SIZE = 64;
+
+		struct Chunk {
+			std::vector<Price> mPrices;
+			// inclusive prefix sums within the chunk
+			std::vector<int64_t> mCumulativeOfferedForSale;
+			std::vector<int128_t> mCumulativeOfferedForSaleTimesPrice;
+		};
+
+		std::vector<Chunk> mChunks;
+
+		// valid only when mFinalized.  mSearchTree[k] has children 2k and
+		// 2k+1 (index 0 is unused), and has 2^mSearchDepth entries.
+		std::vector<Price> mSearchTree;
+		uint32_t mSearchDepth = 0;
+
+		// inclusive prefix sums over all levels, in price order
+		std::vector<Price> mLevelPrices;
+		std::vector<int64_t> mLevelOfferedForSale;
+		std::vector<int128_t> mLevelOfferedForSaleTimesPrice;
+
+		bool mFinalized = true;
+
+		void splitChunk(size_t chunkIdx);
+
+		void throwIfNotFinalized() const;
+
+		// numLevels is the number of levels <= the query price
+		PriceCompStats statsAt(size_t numLevels) const;
+
+	public:
+
+		// amountTimesPrice has radix PriceCompStats::OFFERED_TIMES_PRICE_RADIX
+		void add(Price const& price, int64_t amount, int128_t amountTimesPrice);
+
+		// adds every level of other
+		void merge(PriceLevels const& other);
+
+		void finalize();
+
+		// stats of the highest level with price <= sellPrice / buyPrice.
+		// Must be finalized.
+		PriceCompStats get(uint64_t sellPrice, uint64_t buyPrice) const;
+
+		// get() at lowSellPrice / buyPrice and highSellPrice / buyPrice, in
+		// one (interleaved) descent.
+		std::pair<PriceCompStats, PriceCompStats>
+		getPair(uint64_t lowSellPrice, uint64_t highSellPrice, uint64_t buyPrice) const;
+
+		size_t numLevels() const;
+	};
+
 private:
 
 	constexpr static PriceCompStats zeroStats = PriceCompStats
@@ -58,37 +129,76 @@ private:
 
 
 	const AssetPair mTradingPair;
-	std::set<IOCOffer> mOffers; // sorted by IOCOffer::operator<=>
 
-	std::vector<PriceCompStats> mPrecomputedTatonnementData;
+	// Unsorted append buffer while the batch is open; sorted by
+	// IOCOffer::operator<=> before clearing.
+	std::vector<IOCOffer> mOffers;
+	bool mOffersSorted;
+
+	// kept up to date by addOffer and commitChild
+	PriceLevels mPriceLevels;
 
 	bool mCleared;
 
 	void throwIfCleared();
 	void throwIfNotCleared();
 
+	void sortOffers();
+
 
 
 
 public:
 	IOCOrderbook(AssetPair tradingPair);
 
+	// Builds the search index over the (incrementally maintained) price
+	// levels, so that getPriceCompStats can be called.  O(#levels).
 	void doPriceComputationPreprocessing();
 
 	//visible for testing
 	PriceCompStats getPriceCompStats(uint64_t sellPrice, uint64_t buyPrice) const;
 
+	// getPriceCompStats at both prices, sharing one search.
+	// Visible for testing.
+	std::pair<PriceCompStats, PriceCompStats>
+	getPriceCompStatsPair(uint64_t lowSellPrice, uint64_t highSellPrice, uint64_t buyPrice) const;
+
 	void addOffer(IOCOffer offer);
 
 	void commitChild(const IOCOrderbook& child);
 
-	std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
-	clearOffers(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame);
+	size_t numOffers() const {
+		return mOffers.size();
+	}
+
+	// Computes the fills of this orderbook's offers against target, in
+	// offer order, without touching the ledger.  Only touches this
+	// orderbook and target, so distinct pairs can be cleared concurrently.
+	std::vector<SpeedexOfferClearingStatus>
+	clearOffers(OrderbookClearingTarget& target, ClearingDeltaBuffer& deltas);
+
+	// Called after clearOffers: trades whatever remains of target against
+	// the liquidity pool (lpFrame may be null if the pair has none).
+	std::optional<SpeedexLiquidityPoolClearingStatus>
+	finishClearing(OrderbookClearingTarget& target, LiquidityPoolFrame* lpFrame);
 
 	void finish();
 
 	// output: radix 32 bits
 	int128_t cumulativeOfferedForSaleTimesPrice(uint64_t sellPrice, uint64_t buyPrice, uint8_t smoothMult) const;
+
+	struct OfferedForSale {
+		// cumulativeOfferedForSaleTimesPrice
+		int128_t mValue;
+		// d mValue / d ln(sellPrice)
+		int128_t mSellPriceSlope;
+		// -d mValue / d ln(buyPrice)
+		int128_t mBuyPriceSlope;
+	};
+
+	// cumulativeOfferedForSaleTimesPrice, plus its (local) derivatives with
+	// respect to log prices, for second order Tatonnement steps
+	OfferedForSale offeredForSaleWithSlopes(uint64_t sellPrice, uint64_t buyPrice, uint8_t smoothMult) const;
 };
 
 
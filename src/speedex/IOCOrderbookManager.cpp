@@ -10,8 +10,13 @@
 #include "util/XDROperators.h"
 #include "speedex/DemandUtils.h"
 
+#include "speedex/ClearingDeltaBuffer.h"
 #include "speedex/LiquidityPoolSetFrame.h"
 
+#include "util/ForkJoinPool.h"
+
+#include <algorithm>
+
 namespace stellar {
 
 void 
@@ -84,21 +89,49 @@ IOCOrderbookManager::addOffer(AssetPair const& assetPair, IOCOffer const& offer)
 
 void
 IOCOrderbookManager::clear() { // no offer unwinding here b/c only called when ltx rollsback
+	mSealedOrderbooks.clear();
+	mSealedPairTable.clear();
 	mOrderbooks.clear();
 }
 
 
-std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
-IOCOrderbookManager::clearOrderbook(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame) {
-	auto assetPair = target.getAssetPair();
-	return getOrCreateOrderbook(assetPair).clearOffers(ltx, target, lpFrame);
-}
-
 void
-IOCOrderbookManager::sealBatch() {
+IOCOrderbookManager::sealBatch(SpeedexAssetRegistry const& registry) {
 	throwIfSealed();
 	mSealed = true;
 	doPriceComputationPreprocessing();
+
+	mNumAssets = registry.size();
+	mSealedPairTable.assign(mNumAssets * mNumAssets, nullptr);
+
+	mSealedOrderbooks.clear();
+	for (auto const& [tradingPair, orderbook] : mOrderbooks)
+	{
+		auto sellIdx = registry.getIndex(tradingPair.selling);
+		auto buyIdx = registry.getIndex(tradingPair.buying);
+		mSealedOrderbooks.push_back(SealedOrderbook {
+			.mTradingPair = tradingPair,
+			.mOrderbook = &orderbook,
+			.mSellIdx = sellIdx,
+			.mBuyIdx = buyIdx
+		});
+		mSealedPairTable[sellIdx * mNumAssets + buyIdx] = &orderbook;
+	}
+	std::sort(mSealedOrderbooks.begin(), mSealedOrderbooks.end(),
+		[] (SealedOrderbook const& lhs, SealedOrderbook const& rhs) {
+			if (lhs.mSellIdx != rhs.mSellIdx)
+			{
+				return lhs.mSellIdx < rhs.mSellIdx;
+			}
+			return lhs.mBuyIdx < rhs.mBuyIdx;
+		});
+}
+
+std::vector<IOCOrderbookManager::SealedOrderbook> const&
+IOCOrderbookManager::getSealedOrderbooks() const
+{
+	throwIfNotSealed();
+	return mSealedOrderbooks;
 }
 
 void IOCOrderbookManager::returnToSource(AbstractLedgerTxn& ltx, Asset asset, int64_t amount) {
@@ -127,41 +160,65 @@ void IOCOrderbookManager::returnToSource(AbstractLedgerTxn& ltx, Asset asset, in
 	}
 }
 
-SpeedexResults 
-IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& solution, LiquidityPoolSetFrame& liquidityPools) {
-	throwIfNotSealed();
-	throwIfAlreadyCleared();
-
-	SpeedexResults results;
-
-	auto valuations = solution.getValuationResults();
-	results.valuations.insert(
-		results.valuations.end(),
-		valuations.begin(),
-		valuations.end());
-
-	auto orderbookTargets = solution.produceClearingTargets();
+ClearingDeltaBuffer
+IOCOrderbookManager::clearTargets(
+	std::vector<OrderbookClearingTarget>& orderbookTargets,
+	LiquidityPoolSetFrame& liquidityPools,
+	ForkJoinPool* workers,
+	SpeedexResults& results) {
 
 	for (auto const& target: orderbookTargets)
 	{
 		target.print();
 	}
 
-	for (auto& target : orderbookTargets) {
-		auto& lpFrame = liquidityPools.getFrame(target.getAssetPair());
-		auto [offerResults, lpResults] = clearOrderbook(ltx, target, lpFrame);
+	// Resolve orderbooks up front: getOrCreateOrderbook can modify
+	// mOrderbooks, which tasks below must not do.
+	std::vector<IOCOrderbook*> targetOrderbooks;
+	for (auto const& target : orderbookTargets) {
+		targetOrderbooks.push_back(&getOrCreateOrderbook(target.getAssetPair()));
+	}
+
+	// Each task touches only its own orderbook, target and output slots.
+	std::vector<std::vector<SpeedexOfferClearingStatus>> offerResults(orderbookTargets.size());
+	std::vector<ClearingDeltaBuffer> deltas(orderbookTargets.size());
+
+	auto clearOne = [&] (size_t i) {
+		offerResults[i] = targetOrderbooks[i]->clearOffers(orderbookTargets[i], deltas[i]);
+	};
+
+	if (workers) {
+		workers->parallelFor(orderbookTargets.size(), clearOne);
+	} else {
+		for (size_t i = 0; i < orderbookTargets.size(); i++) {
+			clearOne(i);
+		}
+	}
+
+	ClearingDeltaBuffer merged;
+	for (size_t i = 0; i < orderbookTargets.size(); i++) {
 		results.offerStatuses.insert(
 			results.offerStatuses.end(),
-			offerResults.begin(),
-			offerResults.end());
+			offerResults[i].begin(),
+			offerResults[i].end());
+		merged.merge(std::move(deltas[i]));
+
+		auto* lpFrame = liquidityPools.tryGetFrame(orderbookTargets[i].getAssetPair());
+		auto lpResults = targetOrderbooks[i]->finishClearing(orderbookTargets[i], lpFrame);
 		if (lpResults)
 			results.lpStatuses.push_back(*lpResults);
 	}
-	UnorderedMap<Asset, int64_t> roundingErrors;
 
 	for (auto& [_, orderbook] : mOrderbooks) {
 		orderbook.finish();
 	}
+	return merged;
+}
+
+UnorderedMap<Asset, int64_t>
+IOCOrderbookManager::computeRoundingErrors(std::vector<OrderbookClearingTarget> const& orderbookTargets) const {
+	UnorderedMap<Asset, int64_t> roundingErrors;
+
 	for (auto& target : orderbookTargets) {
 		auto assetPair = target.getAssetPair();
 
@@ -177,51 +234,114 @@ IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& sol
 		roundingErrors[assetPair.buying] -= target.getRealizedBuyAmount();
 	}
 
-	for (auto& [asset, roundingError] : roundingErrors) {
+	for (auto const& [_, roundingError] : roundingErrors) {
 		if (roundingError < 0) {
 			throw std::runtime_error("market paid out more than it received!");
 		}
-		returnToSource(ltx, asset, roundingError);
 	}
+	return roundingErrors;
+}
+
+void
+IOCOrderbookManager::finishBatch() {
+	mSealedOrderbooks.clear();
+	mSealedPairTable.clear();
 	mOrderbooks.clear();
 	mCleared = true;
+}
+
+SpeedexResults 
+IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& solution, LiquidityPoolSetFrame& liquidityPools,
+	ForkJoinPool* workers) {
+	throwIfNotSealed();
+	throwIfAlreadyCleared();
+
+	SpeedexResults results;
+
+	auto valuations = solution.getValuationResults();
+	results.valuations.insert(
+		results.valuations.end(),
+		valuations.begin(),
+		valuations.end());
+
+	auto orderbookTargets = solution.produceClearingTargets();
+
+	auto deltas = clearTargets(orderbookTargets, liquidityPools, workers, results);
+	deltas.apply(ltx);
+
+	for (auto& [asset, roundingError] : computeRoundingErrors(orderbookTargets)) {
+		returnToSource(ltx, asset, roundingError);
+	}
+	finishBatch();
 
 	//One would sort the results here, if we wanted to hash them.
 
 	return results;
 }
 
+SpeedexResults
+IOCOrderbookManager::clearSimBatch(const BatchSolution& solution, LiquidityPoolSetFrame& liquidityPools,
+	ForkJoinPool* workers) {
+	throwIfNotSealed();
+	throwIfAlreadyCleared();
+
+	SpeedexResults results;
+
+	auto valuations = solution.getValuationResults();
+	results.valuations.insert(
+		results.valuations.end(),
+		valuations.begin(),
+		valuations.end());
+
+	auto orderbookTargets = solution.produceClearingTargets();
+
+	// simulated accounts have no ledger state, so balance changes are dropped
+	clearTargets(orderbookTargets, liquidityPools, workers, results);
+	computeRoundingErrors(orderbookTargets);
+	finishBatch();
+
+	return results;
+}
+
 void 
 IOCOrderbookManager::demandQuery(
-	std::map<Asset, uint64_t> const& prices, 
+	std::vector<uint64_t> const& prices, 
 	SupplyDemand& supplyDemand,
-	uint8_t smoothMult) const
+	uint8_t smoothMult,
+	DemandSlopes* slopes) const
 {
-	for (auto const& [assetPair, orderbook] : mOrderbooks)
+	if (slopes)
 	{
-		auto sellPrice = prices.at(assetPair.selling);
-		auto buyPrice = prices.at(assetPair.buying);
-
-		auto tradeAmount = orderbook.cumulativeOfferedForSaleTimesPrice(sellPrice, buyPrice, smoothMult);
+		for (auto const& sealed : mSealedOrderbooks)
+		{
+			auto res = sealed.mOrderbook->offeredForSaleWithSlopes(
+				prices[sealed.mSellIdx], prices[sealed.mBuyIdx], smoothMult);
 
-		//std::printf("ob sell %s buy %s: %lf\n", 
-		//	assetToString(assetPair.selling).c_str(),
-		//	assetToString(assetPair.buying).c_str(),
-		//	(double) tradeAmount);
+			supplyDemand.addSupplyDemand(sealed.mSellIdx, sealed.mBuyIdx, res.mValue);
+			slopes->addSlopes(sealed.mSellIdx, sealed.mBuyIdx, res.mSellPriceSlope, res.mBuyPriceSlope);
+		}
+		return;
+	}
+	for (auto const& sealed : mSealedOrderbooks)
+	{
+		auto sellPrice = prices[sealed.mSellIdx];
+		auto buyPrice = prices[sealed.mBuyIdx];
 
+		auto tradeAmount = sealed.mOrderbook->cumulativeOfferedForSaleTimesPrice(sellPrice, buyPrice, smoothMult);
 
-		supplyDemand.addSupplyDemand(assetPair, tradeAmount);
+		supplyDemand.addSupplyDemand(sealed.mSellIdx, sealed.mBuyIdx, tradeAmount);
 	}
 }
 
 IOCOrderbookManager::int128_t 
-IOCOrderbookManager::demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const
+IOCOrderbookManager::demandQueryOneAssetPair(index_t sellIdx, index_t buyIdx, std::vector<uint64_t> const& prices, uint8_t smoothMult) const
 {
-	auto iter = mOrderbooks.find(tradingPair);
-	if (iter == mOrderbooks.end()) {
+	throwIfNotSealed();
+	auto const* orderbook = mSealedPairTable[sellIdx * mNumAssets + buyIdx];
+	if (orderbook == nullptr) {
 		return 0;
 	}
-	return iter->second.cumulativeOfferedForSaleTimesPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying), 0);
+	return orderbook->cumulativeOfferedForSaleTimesPrice(prices[sellIdx], prices[buyIdx], smoothMult);
 }
 
 } /* stellar */
@@ -4,6 +4,8 @@
 
 #include "speedex/IOCOrderbook.h"
 #include "speedex/BatchSolution.h"
+#include "speedex/ClearingDeltaBuffer.h"
+#include "speedex/SpeedexAssetRegistry.h"
 
 #include "util/UnorderedMap.h"
 #include <map>
@@ -14,21 +16,53 @@ namespace stellar {
 
 class AbstractLedgerTxn;
 class BatchClearingTarget;
+class ForkJoinPool;
 class OrderbookClearingTarget;
+struct DemandSlopes;
 struct SupplyDemand;
 class LiquidityPoolSetFrame;
 class LiquidityPoolFrame;
 
 class IOCOrderbookManager {
 	using int128_t = __int128_t;
+	using index_t = SpeedexAssetRegistry::index_t;
+
+public:
+
+	struct SealedOrderbook {
+		AssetPair mTradingPair;
+		IOCOrderbook const* mOrderbook;
+		index_t mSellIdx;
+		index_t mBuyIdx;
+	};
+
+private:
 
 	UnorderedMap<AssetPair, IOCOrderbook, AssetPairHash> mOrderbooks;
 
+	// populated by sealBatch, sorted by (selling, buying)
+	std::vector<SealedOrderbook> mSealedOrderbooks;
+	// numAssets * numAssets, indexed by sellIdx * numAssets + buyIdx
+	std::vector<IOCOrderbook const*> mSealedPairTable;
+	size_t mNumAssets;
+
 	bool mSealed;
 	bool mCleared;
 
-	std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
- 	clearOrderbook(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame);
+	// Fills every target's offers (across workers, if given), then finishes
+	// each against its liquidity pool.  Offer and pool statuses are appended
+	// to results in target order; the offers' balance changes are returned.
+	ClearingDeltaBuffer clearTargets(
+		std::vector<OrderbookClearingTarget>& orderbookTargets,
+		LiquidityPoolSetFrame& liquidityPools,
+		ForkJoinPool* workers,
+		SpeedexResults& results);
+
+	// throws if the market paid out more of any asset than it received
+	UnorderedMap<Asset, int64_t>
+	computeRoundingErrors(std::vector<OrderbookClearingTarget> const& orderbookTargets) const;
+
+	void finishBatch();
 
 	void throwIfSealed() const;
 	void throwIfNotSealed() const;
@@ -44,7 +78,7 @@ class IOCOrderbookManager {
 
 public:
 
-	IOCOrderbookManager() : mSealed(false), mCleared(false) {}
+	IOCOrderbookManager() : mNumAssets(0), mSealed(false), mCleared(false) {}
 
 	void addOffer(AssetPair const& assetPair, IOCOffer const& offer);
 
@@ -52,25 +86,41 @@ public:
 
 	void clear();
 
-	void sealBatch();
+	// every orderbook's assets must be in the registry
+	void sealBatch(SpeedexAssetRegistry const& registry);
 
+	// Offer fills are computed per trading pair (across workers, if given)
+	// into balance deltas, which are then applied to ltx in one pass.
+	// Results do not depend on workers.
 	SpeedexResults
-	clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools);
+	clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools,
+		ForkJoinPool* workers = nullptr);
 
 	size_t numOpenOrderbooks() const;
 
+	std::vector<SealedOrderbook> const&
+	getSealedOrderbooks() const;
+
+	// prices and supplyDemand are indexed by the registry given to sealBatch.
+	// If slopes is non-null, adds each orderbook's slopes into it.
 	void demandQuery(
-		std::map<Asset, uint64_t> const& prices, 
+		std::vector<uint64_t> const& prices, 
 		SupplyDemand& supplyDemand,
-		uint8_t smoothMult) const;
+		uint8_t smoothMult,
+		DemandSlopes* slopes = nullptr) const;
 
 	int128_t 
 	demandQueryOneAssetPair(
-		AssetPair const& tradingPair, 
-		std::map<Asset, uint64_t> const& prices) const; //smooth mult = 0
+		index_t sellIdx,
+		index_t buyIdx,
+		std::vector<uint64_t> const& prices,
+		uint8_t smoothMult = 0) const;
 
+	// clearBatch without a ledger, for offline simulations.  Liquidity
+	// pools are updated; offer balance changes are not recorded anywhere.
 	SpeedexResults
-	clearSimBatch(const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools);
+	clearSimBatch(const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools,
+		ForkJoinPool* workers = nullptr);
 };
 
 }
\ No newline at end of file
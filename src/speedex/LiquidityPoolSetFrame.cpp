@@ -5,6 +5,7 @@
 #include "speedex/DemandUtils.h"
 #include "speedex/sim_utils.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "util/types.h"
@@ -12,8 +13,10 @@
 namespace stellar
 {
 
-LiquidityPoolSetFrame::LiquidityPoolSetFrame(std::vector<Asset> const& assets, AbstractLedgerTxn& ltx)
+LiquidityPoolSetFrame::LiquidityPoolSetFrame(SpeedexAssetRegistry const& registry, AbstractLedgerTxn& ltx)
+	: mRegistry(registry)
 {
+	auto const& assets = registry.getAssets();
 	for (auto const& sellAsset : assets) {
 		for (auto const& buyAsset : assets) {
 			if (sellAsset < buyAsset) {
@@ -40,9 +43,11 @@ LiquidityPoolSetFrame::LiquidityPoolSetFrame(std::vector<Asset> const& assets, A
 			}
 		}
 	}
+	buildIndexedFrames();
 }
 
-LiquidityPoolSetFrame::LiquidityPoolSetFrame(SpeedexSimConfig const& sim)
+LiquidityPoolSetFrame::LiquidityPoolSetFrame(SpeedexAssetRegistry const& registry, SpeedexSimConfig const& sim)
+	: mRegistry(registry)
 {
 	for (auto const& ammconfig : sim.ammConfigs)
 	{
@@ -64,33 +69,63 @@ LiquidityPoolSetFrame::LiquidityPoolSetFrame(SpeedexSimConfig const& sim)
 			std::forward_as_tuple(p),
 			std::forward_as_tuple(*mBaseFrames.back(), p));
 	}
+	buildIndexedFrames();
 }
 
 void
-LiquidityPoolSetFrame::demandQuery(std::map<Asset, uint64_t> const& prices, SupplyDemand& supplyDemand) const
+LiquidityPoolSetFrame::buildIndexedFrames()
 {
+	mIndexedFrames.clear();
 	for (auto const& [tradingPair, lpFrame] : mLiquidityPools)
 	{
-		int128_t sellAmountTimesPrice = lpFrame.amountOfferedForSaleTimesSellPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying));
+		if (!lpFrame)
+		{
+			continue;
+		}
+		mIndexedFrames.push_back(IndexedFrame {
+			.mFrame = &lpFrame,
+			.mSellIdx = mRegistry.getIndex(tradingPair.selling),
+			.mBuyIdx = mRegistry.getIndex(tradingPair.buying)
+		});
+	}
+	std::sort(mIndexedFrames.begin(), mIndexedFrames.end(),
+		[] (IndexedFrame const& lhs, IndexedFrame const& rhs) {
+			if (lhs.mSellIdx != rhs.mSellIdx)
+			{
+				return lhs.mSellIdx < rhs.mSellIdx;
+			}
+			return lhs.mBuyIdx < rhs.mBuyIdx;
+		});
+}
 
-		//std::printf("lp sell %s buy %s: %lf %ld\n", 
-		//	assetToString(tradingPair.selling).c_str(),
-		//	assetToString(tradingPair.buying).c_str(),
-		//	(double) sellAmountTimesPrice,
-		//	(int64_t) sellAmountTimesPrice);
+void
+LiquidityPoolSetFrame::demandQuery(std::vector<uint64_t> const& prices, SupplyDemand& supplyDemand,
+	DemandSlopes* slopes) const
+{
+	for (auto const& indexed : mIndexedFrames)
+	{
+		int128_t sellAmountTimesPrice = indexed.mFrame->amountOfferedForSaleTimesSellPrice(prices[indexed.mSellIdx], prices[indexed.mBuyIdx]);
 
-		supplyDemand.addSupplyDemand(tradingPair, sellAmountTimesPrice);
+		supplyDemand.addSupplyDemand(indexed.mSellIdx, indexed.mBuyIdx, sellAmountTimesPrice);
+		if (slopes)
+		{
+			slopes->addSlopes(indexed.mSellIdx, indexed.mBuyIdx, sellAmountTimesPrice, 0);
+		}
 	}
 }
 
 LiquidityPoolSetFrame::int128_t
-LiquidityPoolSetFrame::demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const
+LiquidityPoolSetFrame::demandQueryOneAssetPair(index_t sellIdx, index_t buyIdx, std::vector<uint64_t> const& prices) const
 {
+	AssetPair tradingPair {
+		.selling = mRegistry.getAsset(sellIdx),
+		.buying = mRegistry.getAsset(buyIdx)
+	};
 	auto iter = mLiquidityPools.find(tradingPair);
 	if (iter == mLiquidityPools.end()) {
 		return 0;
 	}
-	return iter->second.amountOfferedForSaleTimesSellPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying));
+	return iter->second.amountOfferedForSaleTimesSellPrice(prices[sellIdx], prices[buyIdx]);
 }
 
 
@@ -99,5 +134,14 @@ LiquidityPoolSetFrame::getFrame(AssetPair const& tradingPair) {
 	return mLiquidityPools.at(tradingPair);
 }
 
+LiquidityPoolFrame*
+LiquidityPoolSetFrame::tryGetFrame(AssetPair const& tradingPair) {
+	auto iter = mLiquidityPools.find(tradingPair);
+	if (iter == mLiquidityPools.end()) {
+		return nullptr;
+	}
+	return &iter->second;
+}
+
 
 } /* stellar */
\ No newline at end of file
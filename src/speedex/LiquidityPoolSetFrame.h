@@ -3,6 +3,7 @@
 #include "ledger/AssetPair.h"
 #include "speedex/LiquidityPoolFrame.h"
 #include "speedex/LiquidityPoolFrameBase.h"
+#include "speedex/SpeedexAssetRegistry.h"
 
 #include "util/UnorderedMap.h"
 #include <map>
@@ -13,28 +14,53 @@ namespace stellar
 {
 
 class AbstractLedgerTxn;
+struct DemandSlopes;
 struct SupplyDemand;
 
 class LiquidityPoolSetFrame {
+	using int128_t = __int128;
+	using index_t = SpeedexAssetRegistry::index_t;
+
+	struct IndexedFrame {
+		LiquidityPoolFrame const* mFrame;
+		index_t mSellIdx;
+		index_t mBuyIdx;
+	};
+
+	SpeedexAssetRegistry const& mRegistry;
+
 	UnorderedMap<AssetPair, LiquidityPoolFrame, AssetPairHash> mLiquidityPools;
 
 	std::vector<std::unique_ptr<LiquidityPoolFrameBase>> mBaseFrames;
 
-	using int128_t = __int128;
+	// only pools that exist, in (sellIdx, buyIdx) order
+	std::vector<IndexedFrame> mIndexedFrames;
+
+	void buildIndexedFrames();
 
 public:
 
-	LiquidityPoolSetFrame(std::vector<Asset> const& assets, AbstractLedgerTxn& ltx);
-	LiquidityPoolSetFrame(SpeedexSimConfig const& sim);
+	LiquidityPoolSetFrame(SpeedexAssetRegistry const& registry, AbstractLedgerTxn& ltx);
+	LiquidityPoolSetFrame(SpeedexAssetRegistry const& registry, SpeedexSimConfig const& sim);
 
-	void demandQuery(std::map<Asset, uint64_t> const& prices, SupplyDemand& supplyDemand) const;
+	// prices and supplyDemand are indexed by the registry.  If slopes is
+	// non-null, each pool adds its value sold to its sell asset's slope:
+	// that is the slope at a fixed amount sold, so it ignores the pool's
+	// own price response.
+	void demandQuery(std::vector<uint64_t> const& prices, SupplyDemand& supplyDemand,
+		DemandSlopes* slopes = nullptr) const;
 
 	int128_t 
-	demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const;
+	demandQueryOneAssetPair(index_t sellIdx, index_t buyIdx, std::vector<uint64_t> const& prices) const;
 
 	LiquidityPoolFrame&
 	getFrame(AssetPair const& tradingPair);
 
+	// null if there is no frame for tradingPair (simulations only create
+	// frames for configured pools)
+	LiquidityPoolFrame*
+	tryGetFrame(AssetPair const& tradingPair);
+
 };
 
 } /* stellar */
\ No newline at end of file
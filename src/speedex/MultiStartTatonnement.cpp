@@ -0,0 +1,100 @@
+#include "speedex/MultiStartTatonnement.h"
+
+#include "speedex/DemandOracle.h"
+#include "speedex/DemandUtils.h"
+
+#include "util/ForkJoinPool.h"
+
+#include <stdexcept>
+
+namespace stellar
+{
+
+MultiStartTatonnement::MultiStartTatonnement(
+	SpeedexAssetRegistry const& registry,
+	IOCOrderbookManager const& orderbooks,
+	LiquidityPoolSetFrame const& liquidityPools,
+	ForkJoinPool* workers)
+	: mRegistry(registry)
+	, mOrderbooks(orderbooks)
+	, mLiquidityPools(liquidityPools)
+	, mWorkers(workers)
+	{}
+
+MultiStartTatonnement::Result
+MultiStartTatonnement::computePrices(
+	std::vector<TatonnementControlParams> const& presets,
+	std::vector<uint64_t>& prices,
+	std::optional<uint64_t> startingStepSize)
+{
+	if (presets.empty())
+	{
+		throw std::runtime_error("no tatonnement presets");
+	}
+
+	struct Instance {
+		std::vector<uint64_t> mPrices;
+		std::optional<TatonnementResult> mResult;
+		std::optional<TatonnementObjectiveFn> mObjective;
+	};
+
+	std::vector<Instance> instances(presets.size());
+
+	const uint8_t objectiveSmoothMult = presets.front().mSmoothMult;
+
+	auto runInstance = [&] (size_t i) {
+		auto& instance = instances[i];
+		instance.mPrices = prices;
+
+		// serial queries: the pool (if any) is busy running instances
+		DemandOracle demandOracle(mRegistry, mOrderbooks, mLiquidityPools);
+		TatonnementOracle oracle(demandOracle);
+
+		instance.mResult = oracle.computePrices(presets[i], instance.mPrices, 0, startingStepSize);
+		instance.mObjective = demandOracle.demandQuery(instance.mPrices, objectiveSmoothMult).getObjective();
+	};
+
+	if (mWorkers)
+	{
+		mWorkers->parallelFor(instances.size(), runInstance);
+	} else
+	{
+		for (size_t i = 0; i < instances.size(); i++)
+		{
+			runInstance(i);
+		}
+	}
+
+	auto isBetter = [] (Instance const& candidate, Instance const& best) -> bool {
+		auto const& candidateRes = *candidate.mResult;
+		auto const& bestRes = *best.mResult;
+		if (candidateRes.mConverged != bestRes.mConverged)
+		{
+			return candidateRes.mConverged;
+		}
+		if (candidateRes.mConverged)
+		{
+			return candidateRes.mRounds < bestRes.mRounds;
+		}
+		// strictly smaller objective
+		return !best.mObjective->isBetterThan(*candidate.mObjective, 1, 1);
+	};
+
+	size_t winner = 0;
+	for (size_t i = 1; i < instances.size(); i++)
+	{
+		if (isBetter(instances[i], instances[winner]))
+		{
+			winner = i;
+		}
+	}
+
+	prices = std::move(instances[winner].mPrices);
+
+	return Result {
+		.mWinningPreset = winner,
+		.mTatonnementResult = *instances[winner].mResult
+	};
+}
+
+} /* stellar */
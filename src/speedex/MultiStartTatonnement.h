@@ -0,0 +1,65 @@
+#pragma once
+
+#include "speedex/SpeedexAssetRegistry.h"
+#include "speedex/TatonnementControls.h"
+#include "speedex/TatonnementOracle.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+class ForkJoinPool;
+class IOCOrderbookManager;
+class LiquidityPoolSetFrame;
+
+/*
+Runs one Tatonnement instance per control parameter preset (in parallel, if
+given a ForkJoinPool), all from the same starting prices, and keeps the
+prices of one winner:
+
+	1. Of the instances that converged, the one that took the fewest rounds.
+	2. If none converged, the one whose final prices have the smallest
+	TatonnementObjectiveFn, measured with the first preset's smoothMult.
+
+Ties go to the lower preset index.  Each instance queries demand serially
+through its own DemandOracle, so the winner (and its prices) do not depend on
+thread scheduling, or on whether a pool is used at all.
+*/
+class MultiStartTatonnement {
+
+	SpeedexAssetRegistry const& mRegistry;
+	IOCOrderbookManager const& mOrderbooks;
+	LiquidityPoolSetFrame const& mLiquidityPools;
+
+	ForkJoinPool* mWorkers;
+
+public:
+
+	struct Result {
+		size_t mWinningPreset;
+		TatonnementResult mTatonnementResult;
+	};
+
+	// Orderbooks must already be sealed against registry.
+	MultiStartTatonnement(
+		SpeedexAssetRegistry const& registry,
+		IOCOrderbookManager const& orderbooks,
+		LiquidityPoolSetFrame const& liquidityPools,
+		ForkJoinPool* workers = nullptr);
+
+	MultiStartTatonnement(const MultiStartTatonnement&) = delete;
+	MultiStartTatonnement& operator=(const MultiStartTatonnement&) = delete;
+
+	// presets must be nonempty.  prices (indexed by registry) are the common
+	// starting point, and are overwritten with the winner's prices.
+	Result computePrices(
+		std::vector<TatonnementControlParams> const& presets,
+		std::vector<uint64_t>& prices,
+		std::optional<uint64_t> startingStepSize = std::nullopt);
+};
+
+} /* stellar */
@@ -1,12 +1,11 @@
 #include "speedex/OrderbookClearingTarget.h"
 
+#include "speedex/ClearingDeltaBuffer.h"
 #include "speedex/IOCOffer.h"
-#include "ledger/LedgerTxn.h"
+#include "speedex/LiquidityPoolFrame.h"
 
 #include "transactions/TransactionUtils.h"
 
-#include "ledger/TrustLineWrapper.h"
-
 #include "util/types.h"
 
 namespace stellar {
@@ -49,65 +48,35 @@ OrderbookClearingTarget::print() const
 }
 
 SpeedexOfferClearingStatus
-OrderbookClearingTarget::clearOffer(AbstractLedgerTxn& ltx, const IOCOffer& offer) {
+OrderbookClearingTarget::clearOffer(const IOCOffer& offer, ClearingDeltaBuffer& deltas) {
 
 	if (!checkPrice(offer)) {
 		throw std::logic_error("tried to clear offer with bad price!");
 	}
-	std::printf("clearing an offer with amount %lld sellPrice (%ld / %ld) \n", offer.mSellAmount, offer.mMinPrice.n, offer.mMinPrice.d);
 
 	int128_t offeredSellRealization = static_cast<int128_t>(offer.mSellAmount) * static_cast<int128_t>(mSellPrice);
 
-	//std::printf("offeredSellRealization (double %lf) %lld\n", (double) offeredSellRealization, (int64_t) offeredSellRealization);
-
 	int128_t curSellRealization = std::min(mTotalClearTarget - mRealizedClearTarget, offeredSellRealization);
 
 	mRealizedClearTarget += curSellRealization;
 
-	//std::printf("curSellRealization (double %lf) %lld\n", (double) curSellRealization, (int64_t) curSellRealization);
-
 	int64_t sellAmount = getSellAmount(curSellRealization);
 	int64_t buyAmount = getBuyAmount(curSellRealization);
 
-	//std::printf("sellAmount %lld buyAmount %lld\n", sellAmount, buyAmount);
-
 	mRealizedSellAmount += sellAmount;
 	mRealizedBuyAmount += buyAmount;
 
-	auto header = ltx.loadHeader();
-
-	auto doTransfer = [&] (Asset asset, int64_t amount) {
-		if (asset.type() == ASSET_TYPE_NATIVE) {
-			auto account = loadAccount(ltx, offer.mSourceAccount);
-			auto ok = addBalance(header, account, amount);
-			if (!ok) {
-				throw std::runtime_error("fail to add xlm balance");
-			}
-		} else {
-	        auto sourceLine = loadTrustLine(ltx, offer.mSourceAccount, asset);
-
-	        if (!sourceLine) {
-	        	throw std::runtime_error("failed to find trustline");
-	        }
-
-	        if (!sourceLine.addBalance(header, amount))
-	        {
-	            throw std::runtime_error("failed to add nonxlm balance");
-	        }
-		}
-	};
-
-	doTransfer(mTradingPair.buying, buyAmount);
+	deltas.add(offer.mSourceAccount, mTradingPair.buying, buyAmount);
 	//When creating the offer, we do not modify account balances.
 	//The correct approach might instead to be adjust an account's liabilities during offer
 	//creation instead.
-	doTransfer(mTradingPair.selling, -sellAmount);
+	deltas.add(offer.mSourceAccount, mTradingPair.selling, -sellAmount);
 
 	return offer.getClearingStatus(sellAmount, buyAmount, mTradingPair);
 }
 
 SpeedexLiquidityPoolClearingStatus
-OrderbookClearingTarget::finishWithLiquidityPool(AbstractLedgerTxn& ltx, LiquidityPoolFrame& lpFrame) {
+OrderbookClearingTarget::finishWithLiquidityPool(LiquidityPoolFrame& lpFrame) {
 	//std::printf("mTotalClearTarget (double %lf) %lld\n", (double) mTotalClearTarget, (int64_t) mTotalClearTarget);
 	//std::printf("mRealizedClearTarget (double %lf) %lld\n", (double) mRealizedClearTarget, (int64_t) mRealizedClearTarget);
 
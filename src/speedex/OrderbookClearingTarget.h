@@ -7,6 +7,7 @@
 namespace stellar {
 
 class AbstractLedgerTxn;
+class ClearingDeltaBuffer;
 struct IOCOffer;
 class LiquidityPoolFrame;
 
@@ -41,15 +42,17 @@ public:
 
 	OrderbookClearingTarget(AssetPair tradingPair, uint64_t sellPrice, uint64_t buyPrice, int128_t totalClearingTarget);
 
+	// Does not touch the ledger: the offer's balance changes are recorded
+	// in deltas, to be applied once every pair has been cleared.
 	SpeedexOfferClearingStatus
-	clearOffer(AbstractLedgerTxn& ltx, const IOCOffer& offer);
+	clearOffer(const IOCOffer& offer, ClearingDeltaBuffer& deltas);
 
 	AssetPair getAssetPair() const;
 
 	bool doneClearing() const;
 
 	SpeedexLiquidityPoolClearingStatus
-	finishWithLiquidityPool(AbstractLedgerTxn& ltx, LiquidityPoolFrame& lpFrame);
+	finishWithLiquidityPool(LiquidityPoolFrame& lpFrame);
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "speedex/ParallelDemandQuery.h"
+
+#include "speedex/DemandUtils.h"
+#include "speedex/IOCOrderbookManager.h"
+
+#include "util/ForkJoinPool.h"
+
+#include <algorithm>
+
+namespace stellar
+{
+
+// More chunks than threads, so that a few deep orderbooks do not leave
+// the rest of the pool idle.
+constexpr static size_t CHUNKS_PER_THREAD = 4;
+
+ParallelDemandQuery::ParallelDemandQuery(IOCOrderbookManager const& orderbooks, ForkJoinPool& pool)
+	: mOrderbooks(orderbooks)
+	, mPool(pool)
+	, mChunkBuffers()
+	{}
+
+size_t
+ParallelDemandQuery::numChunks() const
+{
+	auto numTasks = mOrderbooks.getSealedOrderbooks().size();
+	return std::max<size_t>(1, std::min(numTasks, mPool.numThreads() * CHUNKS_PER_THREAD));
+}
+
+void
+ParallelDemandQuery::demandQuery(
+	std::vector<uint64_t> const& prices,
+	SupplyDemand& supplyDemand,
+	uint8_t smoothMult,
+	DemandSlopes* slopes)
+{
+	auto const& tasks = mOrderbooks.getSealedOrderbooks();
+	const size_t numAssets = supplyDemand.numAssets();
+
+	mChunkBuffers.resize(numChunks());
+	const size_t chunks = mChunkBuffers.size();
+	if (slopes)
+	{
+		mChunkSlopes.resize(chunks);
+	}
+	const size_t tasksPerChunk = (tasks.size() + chunks - 1) / chunks;
+
+	mPool.parallelFor(chunks, [&] (size_t chunk) {
+		auto& buffer = mChunkBuffers[chunk];
+		buffer.reset(numAssets);
+
+		size_t begin = std::min(chunk * tasksPerChunk, tasks.size());
+		size_t end = std::min(begin + tasksPerChunk, tasks.size());
+
+		if (slopes)
+		{
+			auto& chunkSlopes = mChunkSlopes[chunk];
+			chunkSlopes.reset(numAssets);
+			for (size_t i = begin; i < end; i++)
+			{
+				auto const& task = tasks[i];
+				auto res = task.mOrderbook->offeredForSaleWithSlopes(
+					prices[task.mSellIdx], prices[task.mBuyIdx], smoothMult);
+				buffer.addSupplyDemand(task.mSellIdx, task.mBuyIdx, res.mValue);
+				chunkSlopes.addSlopes(task.mSellIdx, task.mBuyIdx, res.mSellPriceSlope, res.mBuyPriceSlope);
+			}
+			return;
+		}
+
+		for (size_t i = begin; i < end; i++)
+		{
+			auto const& task = tasks[i];
+			int128_t tradeAmount = task.mOrderbook->cumulativeOfferedForSaleTimesPrice(
+				prices[task.mSellIdx], prices[task.mBuyIdx], smoothMult);
+			buffer.addSupplyDemand(task.mSellIdx, task.mBuyIdx, tradeAmount);
+		}
+	});
+
+	for (auto const& buffer : mChunkBuffers)
+	{
+		for (size_t i = 0; i < numAssets; i++)
+		{
+			supplyDemand.mSupplyDemand[i].first += buffer.mSupplyDemand[i].first;
+			supplyDemand.mSupplyDemand[i].second += buffer.mSupplyDemand[i].second;
+		}
+	}
+	if (slopes)
+	{
+		for (size_t chunk = 0; chunk < chunks; chunk++)
+		{
+			for (size_t i = 0; i < numAssets; i++)
+			{
+				slopes->mDiagonal[i] += mChunkSlopes[chunk].mDiagonal[i];
+			}
+		}
+	}
+}
+
+} /* stellar */
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "speedex/DemandUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace stellar
+{
+
+class ForkJoinPool;
+class IOCOrderbookManager;
+
+/*
+Splits the sealed orderbooks of an IOCOrderbookManager across a ForkJoinPool.
+
+Each chunk of orderbooks accumulates into its own flat (supply, demand) array,
+indexed by SpeedexAssetRegistry index.  Chunks are then summed in chunk order
+into the output SupplyDemand.
+
+Every quantity involved is an exact int128 sum, so the result is bit-identical
+to IOCOrderbookManager::demandQuery regardless of how orderbooks are split.
+*/
+class ParallelDemandQuery {
+	using int128_t = __int128;
+
+	IOCOrderbookManager const& mOrderbooks;
+	ForkJoinPool& mPool;
+
+	std::vector<SupplyDemand> mChunkBuffers;
+	std::vector<DemandSlopes> mChunkSlopes;
+
+	size_t numChunks() const;
+
+public:
+
+	ParallelDemandQuery(IOCOrderbookManager const& orderbooks, ForkJoinPool& pool);
+
+	ParallelDemandQuery(const ParallelDemandQuery&) = delete;
+	ParallelDemandQuery& operator=(const ParallelDemandQuery&) = delete;
+
+	// adds into supplyDemand (and slopes, if non-null), which must already
+	// be sized to the registry
+	void demandQuery(
+		std::vector<uint64_t> const& prices,
+		SupplyDemand& supplyDemand,
+		uint8_t smoothMult,
+		DemandSlopes* slopes = nullptr);
+};
+
+} /* stellar */
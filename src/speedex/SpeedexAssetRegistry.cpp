@@ -0,0 +1,53 @@
+#include "speedex/SpeedexAssetRegistry.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace stellar
+{
+
+SpeedexAssetRegistry::SpeedexAssetRegistry(std::vector<Asset> const& assets)
+	: mAssets(assets)
+	, mIndices()
+{
+	if (mAssets.size() > MAX_ASSETS)
+	{
+		throw std::runtime_error("too many speedex assets");
+	}
+	for (size_t i = 0; i < mAssets.size(); i++)
+	{
+		if (!mIndices.emplace(mAssets[i], static_cast<index_t>(i)).second)
+		{
+			throw std::runtime_error("duplicate speedex asset");
+		}
+		mIndicesInAssetOrder.push_back(static_cast<index_t>(i));
+	}
+	std::sort(mIndicesInAssetOrder.begin(), mIndicesInAssetOrder.end(),
+		[this] (index_t lhs, index_t rhs) {
+			return mAssets[lhs] < mAssets[rhs];
+		});
+}
+
+SpeedexAssetRegistry::index_t
+SpeedexAssetRegistry::getIndex(Asset const& asset) const
+{
+	auto iter = mIndices.find(asset);
+	if (iter == mIndices.end())
+	{
+		throw std::runtime_error("asset not in speedex registry");
+	}
+	return iter->second;
+}
+
+std::optional<SpeedexAssetRegistry::index_t>
+SpeedexAssetRegistry::tryGetIndex(Asset const& asset) const
+{
+	auto iter = mIndices.find(asset);
+	if (iter == mIndices.end())
+	{
+		return std::nullopt;
+	}
+	return iter->second;
+}
+
+} /* stellar */
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "xdr/Stellar-ledger-entries.h"
+
+#include "ledger/AssetPair.h"
+#include "ledger/LedgerHashUtils.h"
+
+#include "util/UnorderedMap.h"
+#include "util/XDROperators.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+/*
+Dense numbering of the assets traded in one speedex batch.
+
+Built once per batch (from the SpeedexConfigEntry asset list, in config
+order), and shared by the Tatonnement oracle, the orderbooks, the liquidity
+pool set and the trade maximizing solver, so that the inner loops of price
+computation index flat vectors instead of searching maps keyed on Asset.
+*/
+class SpeedexAssetRegistry {
+
+public:
+	using index_t = uint16_t;
+
+	constexpr static size_t MAX_ASSETS = UINT16_MAX;
+
+private:
+
+	std::vector<Asset> mAssets;
+	UnorderedMap<Asset, index_t> mIndices;
+	// indices sorted by Asset::operator<, i.e. std::map<Asset, ...> order
+	std::vector<index_t> mIndicesInAssetOrder;
+
+public:
+
+	SpeedexAssetRegistry(std::vector<Asset> const& assets);
+
+	size_t size() const {
+		return mAssets.size();
+	}
+
+	std::vector<Asset> const& getAssets() const {
+		return mAssets;
+	}
+
+	Asset const& getAsset(index_t idx) const {
+		return mAssets.at(idx);
+	}
+
+	std::vector<index_t> const& getIndicesInAssetOrder() const {
+		return mIndicesInAssetOrder;
+	}
+
+	// throws if asset is not registered
+	index_t getIndex(Asset const& asset) const;
+
+	std::optional<index_t> tryGetIndex(Asset const& asset) const;
+};
+
+} /* stellar */
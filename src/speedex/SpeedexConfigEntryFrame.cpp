@@ -1,5 +1,6 @@
 #include "speedex/SpeedexConfigEntryFrame.h"
 
+#include "crypto/SHA.h"
 #include "util/XDROperators.h"
 
 namespace stellar {
@@ -39,7 +40,7 @@ SpeedexConfigSnapshotFrame::getAssets() const
 }
 
 TatonnementControlParams
-SpeedexConfigSnapshotFrame::getControls() const
+SpeedexConfigSnapshotFrame::getControls()
 {
 	return TatonnementControlParams
     {
@@ -49,19 +50,78 @@ SpeedexConfigSnapshotFrame::getControls() const
         .mStepUp = 45,
         .mStepDown = 25,
         .mStepSizeRadix = 5,
-        .mStepRadix = 65
+        .mStepRadix = 65,
+        .mWarmStart = true,
+        .mConvergenceCheckInterval = 10,
+        .mMultiStart = false
     };
 }
 
-std::map<Asset, uint64_t>
+std::vector<TatonnementControlParams>
+SpeedexConfigSnapshotFrame::getControlPresets()
+{
+	auto base = getControls();
+	if (!base.mMultiStart)
+	{
+		return {base};
+	}
+
+	std::vector<TatonnementControlParams> presets(4, base);
+
+	// cautious steps
+	presets[1].mStepUp = 40;
+	presets[1].mStepDown = 20;
+
+	// aggressive steps
+	presets[2].mStepUp = 56;
+	presets[2].mStepDown = 28;
+
+	// coarser demand smoothing
+	presets[3].mSmoothMult = 5;
+
+	return presets;
+}
+
+SpeedexAssetRegistry
+SpeedexConfigSnapshotFrame::getAssetRegistry() const
+{
+	return SpeedexAssetRegistry(getAssets());
+}
+
+std::vector<uint64_t>
 SpeedexConfigSnapshotFrame::getStartingPrices() const
 {
-	std::map<Asset, uint64_t> prices;
-	for (auto const& asset : getAssets())
+	return getStartingPrices(getAssets().size());
+}
+
+std::vector<uint64_t>
+SpeedexConfigSnapshotFrame::getStartingPrices(size_t numAssets)
+{
+	return std::vector<uint64_t>(numAssets, 0x100000000);
+}
+
+std::optional<SpeedexWarmStart>
+SpeedexConfigSnapshotFrame::getWarmStart() const
+{
+	auto const& config = mSpeedexConfig->data.speedexConfig();
+	if (config.ext.v() != 1)
+	{
+		return std::nullopt;
+	}
+	auto const& warmStart = config.ext.warmStart();
+	// asset list changed since the warm start was recorded
+	if (warmStart.prices.size() != config.speedexAssets.size() ||
+		warmStart.assetsHash != hashAssets(config.speedexAssets))
 	{
-		prices[asset] = 0x100000000;
+		return std::nullopt;
 	}
-	return prices;
+	return warmStart;
+}
+
+Hash
+SpeedexConfigSnapshotFrame::hashAssets(xdr::xvector<Asset> const& assets)
+{
+	return xdrSha256(assets);
 }
 
 } /* stellar */
\ No newline at end of file
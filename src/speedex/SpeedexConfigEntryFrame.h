@@ -3,11 +3,13 @@
 #include "xdr/Stellar-ledger-entries.h"
 #include "ledger/AssetPair.h"
 
+#include "speedex/SpeedexAssetRegistry.h"
 #include "speedex/TatonnementControls.h"
 
 #include "util/XDROperators.h"
 
 #include <memory>
+#include <optional>
 
 namespace stellar {
 
@@ -16,6 +18,13 @@ class SpeedexConfigSnapshotFrame {
 
 public:
 
+	// Warm starts are only written to the config entry from this protocol on.
+	static constexpr uint32_t WARM_START_PROTOCOL_VERSION = 18;
+
+	// Tatonnement may stop early on approximate clearing only from this
+	// protocol on.  Earlier ledgers always run the full mMaxRounds.
+	static constexpr uint32_t CONVERGENCE_CHECK_PROTOCOL_VERSION = 18;
+
 	SpeedexConfigSnapshotFrame(std::shared_ptr<const LedgerEntry> config);
 
 	operator bool() const {
@@ -26,9 +35,30 @@ public:
 
 	std::vector<Asset> getAssets() const;
 
-	TatonnementControlParams getControls() const;
+	// Hardcoded (not read from the ledger entry), so static; offline
+	// simulations use the same controls as the network.  These are the
+	// controls of the latest protocol; runSpeedex clears
+	// mConvergenceCheckInterval below CONVERGENCE_CHECK_PROTOCOL_VERSION.
+	static TatonnementControlParams getControls();
+
+	// Presets for MultiStartTatonnement.  The first is getControls(), and it
+	// is the only one unless getControls().mMultiStart is set.  A single
+	// preset means multi-start is disabled.
+	static std::vector<TatonnementControlParams> getControlPresets();
+
+	SpeedexAssetRegistry getAssetRegistry() const;
+
+	// indexed by getAssetRegistry()
+	std::vector<uint64_t> getStartingPrices() const;
+
+	static std::vector<uint64_t> getStartingPrices(size_t numAssets);
+
+	// The final Tatonnement state of the previous batch, if one was recorded
+	// for the current asset list.  Prices are indexed by getAssetRegistry().
+	std::optional<SpeedexWarmStart> getWarmStart() const;
 
-	std::map<Asset, uint64_t> getStartingPrices() const;
+	// SpeedexWarmStart::assetsHash of an asset list.
+	static Hash hashAssets(xdr::xvector<Asset> const& assets);
 };
 
 
@@ -2,6 +2,9 @@
 
 #include "speedex/DemandUtils.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace stellar
 {
 
@@ -12,7 +15,9 @@ TatonnementControlParamsWrapper::TatonnementControlParamsWrapper(
 	, kPriceMin(1)
 	, kPriceMax(UINT64_MAX >> (mParams.mSmoothMult + 1))
 	, kMinStepSize((1llu) << (mParams.mStepSizeRadix + 1))
-	, kStartingStepSize(kMinStepSize)
+	, kMaxStepSize(usesSlopes() ? (1llu) << NEWTON_STEP_RADIX : UINT64_MAX)
+	// Newton steps start out undamped
+	, kStartingStepSize(usesSlopes() ? kMaxStepSize : kMinStepSize)
 	{};
 
 void
@@ -27,6 +32,14 @@ TatonnementControlParamsWrapper::done() const
 	return mRoundNumber >= mParams.mMaxRounds;
 }
 
+bool
+TatonnementControlParamsWrapper::acceptStep()
+{
+	mAcceptedSteps ++;
+	return convergenceCheckEnabled() 
+		&& (mAcceptedSteps % mParams.mConvergenceCheckInterval == 0);
+}
+
 uint64_t 
 TatonnementControlParamsWrapper::stepUp(uint64_t step) const
 {
@@ -35,7 +48,7 @@ TatonnementControlParamsWrapper::stepUp(uint64_t step) const
 		//overflow
 		return step;
 	}
-	return out;
+	return std::min(out, kMaxStepSize);
 }
 
 uint64_t 
@@ -50,6 +63,15 @@ TatonnementControlParamsWrapper::stepDown(uint64_t step) const
 	return out >> mParams.mStepSizeRadix;
 }
 
+uint64_t
+TatonnementControlParamsWrapper::imposeStepBounds(uint64_t step) const
+{
+	if (step < kMinStepSize) {
+		return kMinStepSize;
+	}
+	return std::min(step, kMaxStepSize);
+}
+
 uint64_t 
 TatonnementControlParamsWrapper::imposePriceBounds(uint64_t candidate) const {
 	if (candidate > kPriceMax) {
@@ -106,17 +128,88 @@ TatonnementControlParamsWrapper::setTrialPrice(uint64_t curPrice, int128_t const
 
 
 
-std::map<Asset, uint64_t>
+static int
+bitLength(unsigned __int128 value)
+{
+	uint64_t high = value >> 64;
+	if (high != 0) {
+		return 128 - __builtin_clzll(high);
+	}
+	uint64_t low = value;
+	return low == 0 ? 0 : 64 - __builtin_clzll(low);
+}
+
+uint64_t
+TatonnementControlParamsWrapper::setNewtonTrialPrice(uint64_t curPrice, int128_t const& demand, int128_t const& slope, uint64_t stepSize) const
+{
+	/*
+
+	Newton step on asset i's own market, in log prices:
+
+	ln p -> ln p + Z / D,   with Z = demand, D = slope = -dZ / d ln p >= 0
+
+	applied (to first order) as p -> p * (1 + fraction), with
+
+	fraction = (Z / D) * stepSize / 2^NEWTON_STEP_RADIX
+
+	computed with radix NEWTON_STEP_RADIX and capped to [-1/2, 1].  D == 0
+	(nothing on offer near current prices) takes the largest move.
+
+	*/
+
+	constexpr uint128_t fullFraction = ((uint128_t) 1) << NEWTON_STEP_RADIX;
+
+	if (demand == 0) {
+		return imposePriceBounds(curPrice);
+	}
+
+	uint128_t unsignedDemand = demand > 0 ? demand : -demand;
+	uint128_t unsignedSlope = slope > 0 ? slope : 0;
+
+	uint128_t fraction = fullFraction;
+	if (unsignedDemand < unsignedSlope) {
+		// unsignedDemand << NEWTON_STEP_RADIX must not overflow
+		int shift = std::max(0, bitLength(unsignedSlope) - (127 - NEWTON_STEP_RADIX));
+		fraction = ((unsignedDemand >> shift) << NEWTON_STEP_RADIX) / (unsignedSlope >> shift);
+	}
+
+	// stepSize <= kMaxStepSize == fullFraction, so this can't overflow
+	fraction = (fraction * stepSize) >> NEWTON_STEP_RADIX;
+
+	uint64_t delta;
+	if (demand > 0) {
+		delta = (((uint128_t) curPrice) * std::min(fraction, fullFraction)) >> NEWTON_STEP_RADIX;
+		uint64_t candidateOut = curPrice + delta;
+		if (candidateOut < curPrice) {
+			candidateOut = UINT64_MAX;
+		}
+		return imposePriceBounds(candidateOut);
+	}
+	delta = (((uint128_t) curPrice) * std::min(fraction, fullFraction >> 1)) >> NEWTON_STEP_RADIX;
+	return imposePriceBounds(curPrice - delta);
+}
+
+void
 TatonnementControlParamsWrapper::setTrialPrices(
-	std::map<Asset, uint64_t> const& curPrices, SupplyDemand const& demands, uint64_t stepSize) const
+	std::vector<uint64_t> const& curPrices, SupplyDemand const& demands, DemandSlopes const* slopes,
+	uint64_t stepSize, std::vector<uint64_t>& pricesOut) const
 {
-	std::map<Asset, uint64_t> pricesOut;
-	for (auto const& [asset, curPrice] : curPrices)
+	pricesOut.resize(curPrices.size());
+	if (usesSlopes())
+	{
+		if (!slopes) {
+			throw std::logic_error("newton step without demand slopes");
+		}
+		for (size_t i = 0; i < curPrices.size(); i++)
+		{
+			pricesOut[i] = setNewtonTrialPrice(curPrices[i], demands.getDelta(i), slopes->mDiagonal[i], stepSize);
+		}
+		return;
+	}
+	for (size_t i = 0; i < curPrices.size(); i++)
 	{
-		pricesOut[asset] = setTrialPrice(curPrice, demands.getDelta(asset), stepSize);
+		pricesOut[i] = setTrialPrice(curPrices[i], demands.getDelta(i), stepSize);
 	}
-
-	return pricesOut;
 }
 
 
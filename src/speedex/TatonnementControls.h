@@ -1,8 +1,8 @@
 #pragma once
 
 #include <compare>
-#include <map>
 #include <cstdint>
+#include <vector>
 
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-ledger-entries.h"
@@ -14,6 +14,18 @@
 namespace stellar
 {
 
+enum class TatonnementStepRule : uint8_t
+{
+	// p_i -> p_i * (1 + stepSize * Z_i / 2^mStepRadix), for excess demand Z_i
+	GRADIENT,
+
+	// p_i -> p_i * (1 + (stepSize / 2^NEWTON_STEP_RADIX) * Z_i / D_i), where
+	// D_i is the diagonal of the excess demand Jacobian w.r.t. log prices
+	// (DemandSlopes).  A full step (stepSize == 2^NEWTON_STEP_RADIX) solves
+	// each asset's linearized market on its own.
+	DIAGONAL_NEWTON
+};
+
 struct TatonnementControlParams
 {
 	uint8_t mTaxRate, mSmoothMult;
@@ -24,8 +36,30 @@ struct TatonnementControlParams
 	uint8_t mStepUp, mStepDown, mStepSizeRadix;
 
 	uint8_t mStepRadix;
+
+	// Start from the previous batch's clearing prices and step size
+	// (SpeedexConfigEntry::ext.warmStart, recorded from
+	// SpeedexConfigSnapshotFrame::WARM_START_PROTOCOL_VERSION on) instead
+	// of the configured defaults.
+	bool mWarmStart = false;
+
+	// Stop early once DemandOracle::checkApproximateClearing passes (with
+	// mTaxRate).  Checked at the starting prices and then every
+	// mConvergenceCheckInterval accepted steps.  0 disables the check.
+	uint32_t mConvergenceCheckInterval = 0;
+
+	// mStepRadix only applies to GRADIENT steps; the step size bounds and
+	// mStepUp/mStepDown/mStepSizeRadix apply to both.
+	TatonnementStepRule mStepRule = TatonnementStepRule::GRADIENT;
+
+	// Run MultiStartTatonnement over SpeedexConfigSnapshotFrame's presets
+	// instead of a single instance.  It changes the clearing prices, so like
+	// the other controls it must be the same on every node, and can't depend
+	// on a node's thread count.
+	bool mMultiStart = false;
 };
 
+struct DemandSlopes;
 struct SupplyDemand;
 
 class TatonnementControlParamsWrapper
@@ -34,6 +68,7 @@ class TatonnementControlParamsWrapper
 
 
 	uint32_t mRoundNumber = 0;
+	uint32_t mAcceptedSteps = 0;
 
 	using int128_t = __int128;
 	using uint128_t = unsigned __int128;
@@ -45,15 +80,31 @@ public:
 	const uint64_t kPriceMin;
 	const uint64_t kPriceMax;
 
+	// radix of DIAGONAL_NEWTON step sizes
+	constexpr static uint8_t NEWTON_STEP_RADIX = 32;
+
 	const uint64_t kMinStepSize;
+	// a full Newton step for DIAGONAL_NEWTON, otherwise unbounded
+	const uint64_t kMaxStepSize;
 	const uint64_t kStartingStepSize;
 
 	uint64_t stepUp(uint64_t step) const;
 	uint64_t stepDown(uint64_t step) const;
 
+	// clamps step sizes to [kMinStepSize, kMaxStepSize]
+	uint64_t imposeStepBounds(uint64_t step) const;
+
 	void incrementRound();
 	bool done() const;
 
+	// counts accepted steps, and returns true if the convergence check
+	// is due after this one
+	bool acceptStep();
+
+	bool convergenceCheckEnabled() const {
+		return mParams.mConvergenceCheckInterval > 0;
+	}
+
 	uint8_t smoothMult() const {
 		return mParams.mSmoothMult;
 	}
@@ -61,11 +112,23 @@ public:
 		return mParams.mTaxRate;
 	}
 
+	// true if trial prices need DemandSlopes
+	bool usesSlopes() const {
+		return mParams.mStepRule == TatonnementStepRule::DIAGONAL_NEWTON;
+	}
+
 	//todo relativizers?
 	uint64_t setTrialPrice(uint64_t curPrice, int128_t const& demand, uint64_t stepSize) const;
 
-	std::map<Asset, uint64_t>
-	setTrialPrices(std::map<Asset, uint64_t> const& curPrices, SupplyDemand const& demands, uint64_t stepSize) const;
+	// DIAGONAL_NEWTON step: moves by at most a doubling or a halving
+	uint64_t setNewtonTrialPrice(uint64_t curPrice, int128_t const& demand, int128_t const& slope, uint64_t stepSize) const;
+
+	// prices are indexed by SpeedexAssetRegistry index; pricesOut is
+	// overwritten.  slopes (for the same prices as demands) must be
+	// non-null if usesSlopes().
+	void
+	setTrialPrices(std::vector<uint64_t> const& curPrices, SupplyDemand const& demands, DemandSlopes const* slopes,
+		uint64_t stepSize, std::vector<uint64_t>& pricesOut) const;
 
 	uint64_t imposePriceBounds(uint64_t candidatePrice) const;
 
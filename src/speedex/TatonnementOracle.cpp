@@ -1,50 +1,86 @@
 #include "speedex/TatonnementOracle.h"
 
-#include "speedex/IOCOrderbookManager.h"
-#include "speedex/LiquidityPoolSetFrame.h"
-
 #include "util/types.h"
 
 #include "speedex/DemandOracle.h"
 #include "speedex/DemandUtils.h"
 
+#include <algorithm>
+#include <utility>
+
 
 namespace stellar
 {
 
-TatonnementOracle::TatonnementOracle(DemandOracle const& demandOracle)
+TatonnementOracle::TatonnementOracle(DemandOracle& demandOracle)
 	: mDemandOracle(demandOracle)
 {}
 
-void 
-TatonnementOracle::computePrices(TatonnementControlParams const& params, std::map<Asset, uint64_t>& prices, const uint32_t printFrequency)
+TatonnementResult 
+TatonnementOracle::computePrices(
+	TatonnementControlParams const& params, 
+	std::vector<uint64_t>& prices, 
+	const uint32_t printFrequency,
+	std::optional<uint64_t> startingStepSize)
 {
 	TatonnementControlParamsWrapper controlParams(params);
 
-	SupplyDemand baselineDemand = mDemandOracle.demandQuery(prices, controlParams.smoothMult());
+	auto const& registry = mDemandOracle.getRegistry();
+
+	// Buffers are allocated once and swapped, so the round loop itself
+	// does not allocate.
+	SupplyDemand baselineDemand, trialDemand;
+	std::vector<uint64_t> trialPrices(prices.size());
+
+	// only maintained for second order steps
+	DemandSlopes baselineSlopes, trialSlopes;
+	DemandSlopes* baselineSlopesPtr = controlParams.usesSlopes() ? &baselineSlopes : nullptr;
+	DemandSlopes* trialSlopesPtr = controlParams.usesSlopes() ? &trialSlopes : nullptr;
+
+	// warm-started prices come from the previous batch, which might have
+	// used different bounds
+	for (auto& price : prices)
+	{
+		price = controlParams.imposePriceBounds(price);
+	}
+
+	mDemandOracle.demandQuery(prices, controlParams.smoothMult(), baselineDemand, baselineSlopesPtr);
 
 	TatonnementObjectiveFn baselineObjective = baselineDemand.getObjective();
 
-	uint64_t stepSize = controlParams.kStartingStepSize;
+	uint64_t stepSize = controlParams.imposeStepBounds(
+		startingStepSize.value_or(controlParams.kStartingStepSize));
 
-	while (!controlParams.done()) {
+	auto checkConvergence = [&] () -> bool {
+		return mDemandOracle.checkApproximateClearing(prices, controlParams.taxRate());
+	};
+
+	bool converged = controlParams.convergenceCheckEnabled() && checkConvergence();
+
+	while (!converged && !controlParams.done()) {
 
 		controlParams.incrementRound();
 
-		std::map<Asset, uint64_t> trialPrices = controlParams.setTrialPrices(prices, baselineDemand, stepSize);
+		controlParams.setTrialPrices(prices, baselineDemand, baselineSlopesPtr, stepSize, trialPrices);
 
-		auto trialDemand = mDemandOracle.demandQuery(trialPrices, controlParams.smoothMult());
+		mDemandOracle.demandQuery(trialPrices, controlParams.smoothMult(), trialDemand, trialSlopesPtr);
 
 		TatonnementObjectiveFn trialObjective = trialDemand.getObjective();
 
 		if (trialObjective.isBetterThan(baselineObjective, 1, 100) || stepSize < controlParams.kMinStepSize)
 		{
-			prices = trialPrices;
+			std::swap(prices, trialPrices);
+			std::swap(baselineDemand, trialDemand);
+			std::swap(baselineSlopes, trialSlopes);
 
-			baselineDemand = trialDemand;
 			baselineObjective = trialObjective;
 
 			stepSize = controlParams.stepUp(std::max(stepSize, controlParams.kMinStepSize));
+
+			if (controlParams.acceptStep())
+			{
+				converged = checkConvergence();
+			}
 		} else {
 			stepSize = controlParams.stepDown(stepSize);
 		}
@@ -52,14 +88,21 @@ TatonnementOracle::computePrices(TatonnementControlParams const& params, std::ma
 		if (printFrequency > 0 && controlParams.getRoundNumber() % printFrequency == 0)
 		{
 			std::printf("TATONNEMENT STEP: step size: %llu round number: %lu\n", stepSize, controlParams.getRoundNumber());
-			for (auto const& [asset, price] : prices)
+			for (auto idx : registry.getIndicesInAssetOrder())
 			{
-				int128_t demand = baselineDemand.getDelta(asset);
-				auto str = assetToString(asset);
-				std::printf("TATONNEMENT: %s\t%15llu\t%lf\n", str.c_str(), price, (double)demand);
+				int128_t demand = baselineDemand.getDelta(idx);
+				auto str = assetToString(registry.getAsset(idx));
+				std::printf("TATONNEMENT: %s\t%15llu\t%lf\n", str.c_str(), prices[idx], (double) demand);
 			}
 		}
 	}
+
+	return TatonnementResult
+	{
+		.mRounds = controlParams.getRoundNumber(),
+		.mFinalStepSize = stepSize,
+		.mConverged = converged
+	};
 }
 
 
@@ -1,41 +1,44 @@
 #pragma once
 #include "speedex/TatonnementControls.h"
 
-#include "xdr/Stellar-types.h"
-#include "xdr/Stellar-ledger-entries.h"
-
-#include "util/XDROperators.h"
-
-#include "ledger/LedgerHashUtils.h"
-
-#include  <cstdint>
+#include <cstdint>
+#include <optional>
+#include <vector>
 
 #include "speedex/DemandOracle.h"
 
 namespace stellar
 {
 
-class IOCOrderbookManager;
-class LiquidityPoolSetFrame;
+struct TatonnementResult
+{
+	uint32_t mRounds;
+	uint64_t mFinalStepSize;
+	// false if the round limit was reached first
+	bool mConverged;
+};
 
 class TatonnementOracle {
 
 	using int128_t = __int128;
 
-	DemandOracle mDemandOracle;
-
-	void demandQuery(std::map<Asset, uint64_t> const& prices, std::map<Asset, int128_t>& demands, uint8_t taxRate, uint8_t smoothMult) const;
+	DemandOracle& mDemandOracle;
 
 public:
 
-	TatonnementOracle(DemandOracle const& demandOracle);
+	TatonnementOracle(DemandOracle& demandOracle);
 
 	TatonnementOracle(const TatonnementOracle&) = delete;
 	TatonnementOracle& operator=(const TatonnementOracle&) = delete;
 
-	//map, not UnorderedMap, for deterministic ordering
+	//prices are indexed by the demand oracle's SpeedexAssetRegistry
 	//caller's responsibility to initialize starting prices
-	void computePrices(TatonnementControlParams const& params, std::map<Asset, uint64_t>& prices, const uint32_t printFrequency = 0);
+	//startingStepSize defaults to TatonnementControlParamsWrapper::kStartingStepSize
+	TatonnementResult computePrices(
+		TatonnementControlParams const& params, 
+		std::vector<uint64_t>& prices, 
+		const uint32_t printFrequency = 0,
+		std::optional<uint64_t> startingStepSize = std::nullopt);
 };
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
@@ -1,5 +1,16 @@
 #include "speedex/sim_utils.h"
 
+#include "util/types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/format.h>
+
 namespace stellar {
 
 Asset makeSimAsset(AssetCode12 const& code)
@@ -11,4 +22,97 @@ Asset makeSimAsset(AssetCode12 const& code)
     return out;
 }
 
+namespace {
+
+// std::mt19937_64's output is fixed by the standard, but the standard
+// distributions are not, so draws are computed by hand from raw output.
+class SimRandom {
+	std::mt19937_64 mEngine;
+
+public:
+	SimRandom(uint64_t seed) : mEngine(seed) {}
+
+	// uniform in [0, 1)
+	double fraction() {
+		return static_cast<double>(mEngine() >> 11) * 0x1.0p-53;
+	}
+
+	// uniform in [lo, hi]
+	int64_t range(int64_t lo, int64_t hi) {
+		uint64_t span = static_cast<uint64_t>(hi - lo) + 1;
+		return lo + static_cast<int64_t>(mEngine() % span);
+	}
+};
+
+constexpr static int32_t SIM_PRICE_DENOM = 1 << 20;
+
+Price toSimPrice(double rate) {
+	Price p;
+	p.d = SIM_PRICE_DENOM;
+	double n = std::round(rate * SIM_PRICE_DENOM);
+	p.n = static_cast<int32_t>(std::clamp(n, 1.0, static_cast<double>(std::numeric_limits<int32_t>::max())));
+	return p;
+}
+
+} /* anonymous namespace */
+
+SpeedexSimulation generateSpeedexSim(SpeedexSimGenParams const& params)
+{
+	if (params.mNumAssets < 2) {
+		throw std::runtime_error("need at least two assets");
+	}
+	if (params.mPriceDispersion < 0 || params.mMaxOfferAmount <= 0 || params.mAmmReserve < 0) {
+		throw std::runtime_error("invalid sim parameters");
+	}
+
+	SimRandom rand(params.mSeed);
+
+	SpeedexSimulation sim;
+
+	std::vector<double> valuations;
+	for (uint32_t i = 0; i < params.mNumAssets; i++) {
+		AssetCode12 code;
+		strToAssetCode(code, fmt::format("A{}", i));
+		sim.config.assets.push_back(code);
+		valuations.push_back(std::exp(rand.fraction() * std::log(100.0)));
+	}
+
+	uint64_t offerID = 0;
+	for (uint32_t sell = 0; sell < params.mNumAssets; sell++) {
+		for (uint32_t buy = 0; buy < params.mNumAssets; buy++) {
+			if (sell == buy) {
+				continue;
+			}
+			double rate = valuations[sell] / valuations[buy];
+			for (uint32_t k = 0; k < params.mOffersPerPair; k++) {
+				double dispersion = params.mPriceDispersion * (2 * rand.fraction() - 1);
+
+				SpeedexOffer offer;
+				offer.offerID = offerID++;
+				offer.minPrice = toSimPrice(rate * std::exp(dispersion));
+				offer.selling = sim.config.assets[sell];
+				offer.buying = sim.config.assets[buy];
+				offer.amount = rand.range(1, params.mMaxOfferAmount);
+				sim.offers.push_back(offer);
+			}
+		}
+	}
+
+	if (params.mAmmReserve > 0) {
+		for (uint32_t a = 0; a < params.mNumAssets; a++) {
+			for (uint32_t b = a + 1; b < params.mNumAssets; b++) {
+				AMMConfig amm;
+				amm.assetA = sim.config.assets[a];
+				amm.assetB = sim.config.assets[b];
+				amm.amountA = params.mAmmReserve;
+				amm.amountB = std::max<int64_t>(1,
+					std::llround(params.mAmmReserve * valuations[a] / valuations[b]));
+				sim.config.ammConfigs.push_back(amm);
+			}
+		}
+	}
+
+	return sim;
+}
+
 } /* stellar */
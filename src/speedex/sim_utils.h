@@ -1,9 +1,34 @@
 #pragma once
 
 #include "xdr/Stellar-ledger-entries.h"
+#include "xdr/speedex-sim.h"
+
+#include <cstdint>
 
 namespace stellar {
 
 Asset makeSimAsset(AssetCode12 const& code);
 
+/*
+Parameters for a synthetic speedex-sim input.
+
+Each asset gets a hidden valuation, drawn log-uniformly from [1, 100].  Every
+ordered pair of assets gets mOffersPerPair offers, whose limit prices are the
+pair's exchange rate (ratio of valuations) times a factor drawn
+log-uniformly from [e^-mPriceDispersion, e^mPriceDispersion].  With
+mAmmReserve > 0, every unordered pair also gets a pool, priced at the
+exchange rate, holding mAmmReserve units of its first asset.
+*/
+struct SpeedexSimGenParams {
+	uint32_t mNumAssets = 10;
+	uint32_t mOffersPerPair = 100;
+	double mPriceDispersion = 0.1;
+	int64_t mMaxOfferAmount = 1000000;
+	int64_t mAmmReserve = 0;
+	uint64_t mSeed = 0;
+};
+
+// Output depends only on params (not on the platform's standard library).
+SpeedexSimulation generateSpeedexSim(SpeedexSimGenParams const& params);
+
 } /* stellar */
@@ -2,8 +2,12 @@
 
 #include "ledger/LedgerTxn.h"
 #include "simplex/solver.h"
+#include "speedex/BatchSolution.h"
 #include "speedex/DemandOracle.h"
+#include "speedex/DemandUtils.h"
+#include "speedex/IOCOrderbookManager.h"
 #include "speedex/LiquidityPoolSetFrame.h"
+#include "speedex/MultiStartTatonnement.h"
 #include "speedex/TatonnementControls.h"
 #include "speedex/TatonnementOracle.h"
 #include "speedex/SpeedexConfigEntryFrame.h"
@@ -11,50 +15,142 @@
 
 #include "transactions/TransactionUtils.h"
 
+#include "util/AllocationCounter.h"
 #include "util/XDROperators.h"
 
+#include "lib/json/json.h"
+
+#include <chrono>
+#include <optional>
+
 namespace stellar 
 {
 
+// Record the final Tatonnement state in the config entry, so that every
+// node warm starts the next batch from the same (ledger) state.  Earlier
+// protocols keep the config entry as it was.
+static void
+storeWarmStart(AbstractLedgerTxn& ltx, std::vector<uint64_t> const& prices, uint64_t stepSize)
+{
+    if (ltx.loadHeader().current().ledgerVersion <
+        SpeedexConfigSnapshotFrame::WARM_START_PROTOCOL_VERSION)
+    {
+        return;
+    }
+    auto configEntry = loadSpeedexConfig(ltx);
+    if (!configEntry)
+    {
+        return;
+    }
+    auto& config = configEntry.current().data.speedexConfig();
+    config.ext.v(1);
+    auto& warmStart = config.ext.warmStart();
+    warmStart.assetsHash =
+        SpeedexConfigSnapshotFrame::hashAssets(config.speedexAssets);
+    warmStart.prices.assign(prices.begin(), prices.end());
+    warmStart.stepSize = stepSize;
+}
+
+// Multi-start Tatonnement if there is more than one preset, otherwise a
+// single run of presets.front() on demandOracle.
+static MultiStartTatonnement::Result
+computeClearingPrices(SpeedexAssetRegistry const& registry,
+                      IOCOrderbookManager const& orderbooks,
+                      LiquidityPoolSetFrame const& liquidityPools,
+                      DemandOracle& demandOracle,
+                      std::vector<TatonnementControlParams> const& presets,
+                      std::vector<uint64_t>& prices,
+                      std::optional<uint64_t> startingStepSize,
+                      SpeedexRuntimeOptions const& options,
+                      uint32_t printFrequency)
+{
+    if (presets.size() > 1)
+    {
+        MultiStartTatonnement multiStart(registry, orderbooks, liquidityPools,
+                                         options.mTatonnementWorkers);
+        return multiStart.computePrices(presets, prices, startingStepSize);
+    }
+    TatonnementOracle oracle(demandOracle);
+    return MultiStartTatonnement::Result{
+        .mWinningPreset = 0,
+        .mTatonnementResult = oracle.computePrices(
+            presets.front(), prices, printFrequency, startingStepSize)};
+}
+
 SpeedexResults
-runSpeedex(AbstractLedgerTxn& ltx)
+runSpeedex(AbstractLedgerTxn& ltx, SpeedexRuntimeOptions const& options, SpeedexRunStats* stats)
 {
 
     bool printDiagnostics = true;
-    auto& speedexOrderbooks = ltx.getSpeedexIOCOffers();
-    speedexOrderbooks.sealBatch();
 
     auto speedexConfig = loadSpeedexConfigSnapshot(ltx);
+    auto registry = speedexConfig.getAssetRegistry();
 
-    LiquidityPoolSetFrame liquidityPools(speedexConfig.getAssets(), ltx);
+    auto& speedexOrderbooks = ltx.getSpeedexIOCOffers();
+    speedexOrderbooks.sealBatch(registry);
 
-    DemandOracle demandOracle(speedexOrderbooks, liquidityPools);
+    LiquidityPoolSetFrame liquidityPools(registry, ltx);
 
-    TatonnementOracle oracle(demandOracle);
+    DemandOracle demandOracle(registry, speedexOrderbooks, liquidityPools, options.mDemandQueryWorkers);
 
     TatonnementControlParams controls = speedexConfig.getControls();
+    auto presets = speedexConfig.getControlPresets();
+    if (ltx.loadHeader().current().ledgerVersion <
+        SpeedexConfigSnapshotFrame::CONVERGENCE_CHECK_PROTOCOL_VERSION)
+    {
+        // stopping early changes the clearing prices of earlier ledgers
+        controls.mConvergenceCheckInterval = 0;
+        for (auto& preset : presets)
+        {
+            preset.mConvergenceCheckInterval = 0;
+        }
+    }
     auto prices = speedexConfig.getStartingPrices();
+    std::optional<uint64_t> startingStepSize;
 
-    oracle.computePrices(controls, prices, printDiagnostics ? 1 : 0);
+    auto warmStart = controls.mWarmStart ? speedexConfig.getWarmStart() : std::nullopt;
+    if (warmStart)
+    {
+        prices.assign(warmStart->prices.begin(), warmStart->prices.end());
+        startingStepSize = warmStart->stepSize;
+    }
+
+    auto [winningPreset, tatonnementResult] = computeClearingPrices(
+        registry, speedexOrderbooks, liquidityPools, demandOracle, presets,
+        prices, startingStepSize, options, printDiagnostics ? 1 : 0);
+
+    if (controls.mWarmStart && registry.size() > 0)
+    {
+        storeWarmStart(ltx, prices, tatonnementResult.mFinalStepSize);
+    }
+
+    if (stats)
+    {
+        stats->mTatonnementRounds = tatonnementResult.mRounds;
+        stats->mWarmStarted = warmStart.has_value();
+        stats->mTatonnementConverged = tatonnementResult.mConverged;
+        stats->mTatonnementPreset = winningPreset;
+    }
 
     if (printDiagnostics)
     {
         std::printf("PRICES\n");
-        for (auto const& [asset, price] : prices)
+        for (auto idx : registry.getIndicesInAssetOrder())
         {
-            std::printf("%llu\n", price);
+            std::printf("%llu\n", prices[idx]);
         }
     }
 
-    TradeMaximizingSolver solver(speedexConfig.getAssets());
+    TradeMaximizingSolver solver(registry);
 
     demandOracle.setSolverUpperBounds(solver, prices);
 
     solver.doSolve();
 
-    BatchSolution solution(solver.getSolution(), prices);
+    BatchSolution solution(solver.getSolution(), registry, prices);
 
-    return speedexOrderbooks.clearBatch(ltx, solution, liquidityPools);
+    return speedexOrderbooks.clearBatch(ltx, solution, liquidityPools,
+                                        options.mClearingWorkers);
 }
 
 SpeedexConfigEntry
@@ -85,10 +181,13 @@ void checkSimOffer(SpeedexOffer const& offer, SpeedexConfigEntry const& config)
     if (!validAsset(offer.buying)) {
         throw std::runtime_error("invalid asset");
     }
+    if (offer.selling == offer.buying) {
+        throw std::runtime_error("offer sells and buys the same asset");
+    }
     if (offer.amount <= 0) {
         throw std::runtime_error("invalid offer amount");
     }
-    if (offer.minPrice.d == 0) {
+    if (offer.minPrice.n <= 0 || offer.minPrice.d <= 0) {
         throw std::runtime_error("invalid price");
     }
 }
@@ -111,55 +210,163 @@ std::pair<AssetPair, IOCOffer> makeOffer(SpeedexOffer const& offer, uint64_t idn
     return {pair, offer_out};
 }
 
-IOCOrderbookManager
-makeOrderbooks(SpeedexSimulation const& sim)
+void
+makeOrderbooks(SpeedexSimulation const& sim, IOCOrderbookManager& manager)
 {
-    IOCOrderbookManager manager;
     auto const& offers = sim.offers;
     for (auto i = 0u; i < offers.size(); i++) {
         auto [pair, offer] = makeOffer(offers[i], i);
         manager.addOffer(pair, offer);
     }
-    return manager;
 }
 
-void
-runSpeedexSim(SpeedexSimulation const& sim)
+namespace
+{
+
+class SimStageTimer
 {
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point mStart;
+    uint64_t mStartAllocations;
+
+  public:
+    SimStageTimer()
+        : mStart(clock::now()), mStartAllocations(getAllocationCount())
+    {
+    }
+
+    void
+    finish(SpeedexSimStageStats& stage)
+    {
+        std::chrono::duration<double> elapsed = clock::now() - mStart;
+        stage.mSeconds = elapsed.count();
+        stage.mAllocations = getAllocationCount() - mStartAllocations;
+    }
+};
+
+Json::Value
+stageToJson(SpeedexSimStageStats const& stage)
+{
+    Json::Value out;
+    out["seconds"] = stage.mSeconds;
+    if (allocationCountingEnabled())
+    {
+        out["allocations"] = Json::UInt64(stage.mAllocations);
+    }
+    else
+    {
+        out["allocations"] = Json::Value::null;
+    }
+    return out;
+}
+
+}
+
+Json::Value
+SpeedexSimStats::toJson() const
+{
+    Json::Value out;
+    out["assets"] = Json::UInt64(mNumAssets);
+    out["offers"] = Json::UInt64(mNumOffers);
+    out["liquidity_pools"] = Json::UInt64(mNumLiquidityPools);
+
+    auto& stages = out["stages"];
+    stages["preprocessing"] = stageToJson(mPreprocessing);
+    stages["tatonnement"] = stageToJson(mTatonnement);
+    stages["simplex"] = stageToJson(mSimplex);
+    stages["clearing"] = stageToJson(mClearing);
+
+    auto& tatonnement = out["tatonnement"];
+    tatonnement["rounds"] = mTatonnementRounds;
+    tatonnement["converged"] = mTatonnementConverged;
+    tatonnement["preset"] = Json::UInt64(mTatonnementPreset);
+
+    auto& objectives = out["objectives"];
+    objectives["tatonnement"] = mTatonnementObjective;
+    objectives["trade_value"] = mTradeValue;
+
+    auto& cleared = out["cleared"];
+    cleared["offers"] = Json::UInt64(mOffersCleared);
+    cleared["liquidity_pools"] = Json::UInt64(mLiquidityPoolsCleared);
+    return out;
+}
+
+SpeedexResults
+runSpeedexSim(SpeedexSimulation const& sim, SpeedexRuntimeOptions const& options, SpeedexSimStats* stats)
+{
+    SpeedexSimStats localStats;
+    auto& out = stats ? *stats : localStats;
+
+    out.mNumAssets = sim.config.assets.size();
+    out.mNumOffers = sim.offers.size();
+    out.mNumLiquidityPools = sim.config.ammConfigs.size();
+
+    SimStageTimer preprocessing;
+
     SpeedexConfigEntry speedexConfig = makeConfigSim(sim);
     checkSimOffers(sim, speedexConfig);
 
-    auto orderbooks = makeOrderbooks(sim);
+    SpeedexAssetRegistry registry(speedexConfig.speedexAssets);
 
-    LiquidityPoolSetFrame lps(sim);
+    IOCOrderbookManager orderbooks;
+    makeOrderbooks(sim, orderbooks);
+    orderbooks.sealBatch(registry);
 
-    DemandOracle demandOracle(speedexOrderbooks, liquidityPools);
+    LiquidityPoolSetFrame liquidityPools(registry, sim.config);
 
-    TatonnementOracle oracle(demandOracle);
+    preprocessing.finish(out.mPreprocessing);
 
-    TatonnementControlParams controls = speedexConfig.getControls();
-    auto prices = speedexConfig.getStartingPrices();
+    SimStageTimer tatonnement;
 
-    oracle.computePrices(controls, prices, printDiagnostics ? 1 : 0);
+    DemandOracle demandOracle(registry, orderbooks, liquidityPools, options.mDemandQueryWorkers);
 
-    if (printDiagnostics)
-    {
-        std::printf("PRICES\n");
-        for (auto const& [asset, price] : prices)
-        {
-            std::printf("%llu\n", price);
-        }
-    }
+    auto presets = SpeedexConfigSnapshotFrame::getControlPresets();
+    auto prices = SpeedexConfigSnapshotFrame::getStartingPrices(registry.size());
+
+    auto [winningPreset, tatonnementResult] = computeClearingPrices(
+        registry, orderbooks, liquidityPools, demandOracle, presets,
+        prices, std::nullopt, options, 0);
+
+    tatonnement.finish(out.mTatonnement);
+
+    out.mTatonnementRounds = tatonnementResult.mRounds;
+    out.mTatonnementConverged = tatonnementResult.mConverged;
+    out.mTatonnementPreset = winningPreset;
+    out.mTatonnementObjective = demandOracle.demandQuery(
+        prices, presets[winningPreset].mSmoothMult).getObjective().toDouble();
 
-    TradeMaximizingSolver solver(speedexConfig.getAssets());
+    SimStageTimer simplex;
+
+    TradeMaximizingSolver solver(registry);
 
     demandOracle.setSolverUpperBounds(solver, prices);
 
     solver.doSolve();
 
-    BatchSolution solution(solver.getSolution(), prices);
+    auto tradeAmounts = solver.getSolution();
+
+    simplex.finish(out.mSimplex);
+
+    __int128_t tradeValue = 0;
+    for (auto const& [_, amount] : tradeAmounts)
+    {
+        tradeValue += amount;
+    }
+    out.mTradeValue = static_cast<double>(tradeValue);
+
+    SimStageTimer clearing;
+
+    BatchSolution solution(tradeAmounts, registry, prices);
+
+    auto res = orderbooks.clearSimBatch(solution, liquidityPools, options.mClearingWorkers);
+
+    clearing.finish(out.mClearing);
+
+    out.mOffersCleared = res.offerStatuses.size();
+    out.mLiquidityPoolsCleared = res.lpStatuses.size();
 
-    return orderbooks.clearSimBatch(solution, liquidityPools);
+    return res;
 }
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
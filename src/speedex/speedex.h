@@ -3,12 +3,85 @@
 #include "xdr/Stellar-ledger.h"
 #include "xdr/speedex-sim.h"
 
+namespace Json
+{
+class Value;
+}
+
 namespace stellar
 {
 
 class AbstractLedgerTxn;
+class ForkJoinPool;
+
+struct SpeedexRuntimeOptions
+{
+    // Optional pool for parallel demand queries.  Does not affect results.
+    ForkJoinPool* mDemandQueryWorkers = nullptr;
+
+    // Optional pool for running multi-start Tatonnement presets
+    // concurrently.  Does not affect results.  May be the same pool as
+    // mDemandQueryWorkers.
+    ForkJoinPool* mTatonnementWorkers = nullptr;
+
+    // Optional pool for computing per-pair offer fills concurrently.  Does
+    // not affect results.
+    ForkJoinPool* mClearingWorkers = nullptr;
+};
+
+struct SpeedexRunStats
+{
+    uint32_t mTatonnementRounds = 0;
+    bool mWarmStarted = false;
+    bool mTatonnementConverged = false;
+    // index into SpeedexConfigSnapshotFrame::getControlPresets()
+    size_t mTatonnementPreset = 0;
+};
 
 SpeedexResults
-runSpeedex(AbstractLedgerTxn& ltx);
+runSpeedex(AbstractLedgerTxn& ltx, SpeedexRuntimeOptions const& options = {},
+           SpeedexRunStats* stats = nullptr);
+
+struct SpeedexSimStageStats
+{
+    double mSeconds = 0;
+    // 0 unless built with --enable-allocation-counting
+    uint64_t mAllocations = 0;
+};
+
+struct SpeedexSimStats
+{
+    size_t mNumAssets = 0;
+    size_t mNumOffers = 0;
+    size_t mNumLiquidityPools = 0;
+
+    // building and sealing orderbooks and pools
+    SpeedexSimStageStats mPreprocessing;
+    SpeedexSimStageStats mTatonnement;
+    SpeedexSimStageStats mSimplex;
+    SpeedexSimStageStats mClearing;
+
+    uint32_t mTatonnementRounds = 0;
+    bool mTatonnementConverged = false;
+    size_t mTatonnementPreset = 0;
+
+    // sum of squared excess demands at the final prices (with the winning
+    // preset's smoothing), i.e. the Tatonnement objective
+    double mTatonnementObjective = 0;
+    // the trade maximizing solver's objective: sum over pairs of the amount
+    // sold times its price
+    double mTradeValue = 0;
+
+    size_t mOffersCleared = 0;
+    size_t mLiquidityPoolsCleared = 0;
+
+    Json::Value toJson() const;
+};
+
+// Runs a batch from a serialized simulation, without a ledger: same
+// preprocessing, Tatonnement controls, solver and clearing as runSpeedex.
+SpeedexResults runSpeedexSim(SpeedexSimulation const& sim,
+                             SpeedexRuntimeOptions const& options = {},
+                             SpeedexSimStats* stats = nullptr);
 
 } /* stellar */
\ No newline at end of file
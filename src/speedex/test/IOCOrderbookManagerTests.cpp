@@ -3,6 +3,8 @@
 #include "speedex/IOCOffer.h"
 #include "speedex/IOCOrderbookManager.h"
 #include "speedex/DemandUtils.h"
+#include "speedex/ParallelDemandQuery.h"
+#include "speedex/SpeedexAssetRegistry.h"
 
 #include "ledger/AssetPair.h"
 
@@ -14,6 +16,8 @@
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-ledger-entries.h"
 
+#include "util/ForkJoinPool.h"
+
 #include <map>
 
 using namespace stellar;
@@ -58,6 +62,7 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 	using int128_t = __int128_t;
 
 	auto assets = makeAssets(2);
+	SpeedexAssetRegistry registry(assets);
 	IOCOrderbookManager manager;
 
 	int64_t amount = 10000;
@@ -66,61 +71,61 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 	{
 		addOffer(manager, 300, 100, amount, assets[0], assets[1], 1);
 
-		manager.sealBatch();
+		manager.sealBatch(registry);
 
-		std::map<Asset, uint64_t> prices;
+		std::vector<uint64_t> prices(assets.size());
 
-		SupplyDemand sd1;
+		SupplyDemand sd1(assets.size());
 
-		prices[assets[0]] = 400;
-		prices[assets[1]] = 100;
+		prices[0] = 400;
+		prices[1] = 100;
 		manager.demandQuery(prices, sd1, 0);
-		REQUIRE(sd1.getDelta(assets[0]) == -400 * amount);
-		REQUIRE(sd1.getDelta(assets[1]) == 400 * amount);
+		REQUIRE(sd1.getDelta(0) == -400 * amount);
+		REQUIRE(sd1.getDelta(1) == 400 * amount);
 
-		prices[assets[0]] = 400;
-		prices[assets[1]] = 100;
+		prices[0] = 400;
+		prices[1] = 100;
 
-		SupplyDemand sd2;
+		SupplyDemand sd2(assets.size());
 		manager.demandQuery(prices, sd2, 1);
-		REQUIRE(sd2.getDelta(assets[0]) == -200 * amount);
-		REQUIRE(sd2.getDelta(assets[1]) == 200 * amount);
+		REQUIRE(sd2.getDelta(0) == -200 * amount);
+		REQUIRE(sd2.getDelta(1) == 200 * amount);
 	}
 	SECTION("both directions, same price")
 	{
 		addOffer(manager, 300, 100, amount, assets[0], assets[1], 1);
 		addOffer(manager, 100, 300, 3*amount, assets[1], assets[0], 2);
 
-		manager.sealBatch();
+		manager.sealBatch(registry);
 
-		std::map<Asset, uint64_t> prices;
+		std::vector<uint64_t> prices(assets.size());
 
-		SupplyDemand sd;
+		SupplyDemand sd(assets.size());
 
 		SECTION("eq")
 		{
-			prices[assets[0]] = 300;
-			prices[assets[1]] = 100;
+			prices[0] = 300;
+			prices[1] = 100;
 			manager.demandQuery(prices, sd, 0);
-			REQUIRE(sd.getDelta(assets[0]) == 0);
-			REQUIRE(sd.getDelta(assets[1]) == 0);
+			REQUIRE(sd.getDelta(0) == 0);
+			REQUIRE(sd.getDelta(1) == 0);
 		}
 		SECTION("above eq")
 		{
-			prices[assets[0]] = 400;
-			prices[assets[1]] = 100;
+			prices[0] = 400;
+			prices[1] = 100;
 			manager.demandQuery(prices, sd, 0);
-			REQUIRE(sd.getDelta(assets[0]) == -400 * amount);
-			REQUIRE(sd.getDelta(assets[1]) == 400 * amount);
+			REQUIRE(sd.getDelta(0) == -400 * amount);
+			REQUIRE(sd.getDelta(1) == 400 * amount);
 		}
 
 		SECTION("below eq")
 		{
-			prices[assets[0]] = 200;
-			prices[assets[1]] = 100;
+			prices[0] = 200;
+			prices[1] = 100;
 			manager.demandQuery(prices, sd, 0);
-			REQUIRE(sd.getDelta(assets[0]) == 100 * 3 * amount);
-			REQUIRE(sd.getDelta(assets[1]) == -100 * 3 * amount);
+			REQUIRE(sd.getDelta(0) == 100 * 3 * amount);
+			REQUIRE(sd.getDelta(1) == -100 * 3 * amount);
 		}
 	}
 
@@ -129,62 +134,111 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 		addOffer(manager, 100, 300, amount, assets[0], assets[1], 1);
 		addOffer(manager, 100, 300, amount, assets[1], assets[0], 2);
 
-		manager.sealBatch();
+		manager.sealBatch(registry);
 
-		std::map<Asset, uint64_t> prices;
+		std::vector<uint64_t> prices(assets.size());
 
-		SupplyDemand sd1;
+		SupplyDemand sd1(assets.size());
 
-		prices[assets[0]] = 100;
-		prices[assets[1]] = 100;
+		prices[0] = 100;
+		prices[1] = 100;
 		manager.demandQuery(prices, sd1, 0);
-		REQUIRE(sd1.getDelta(assets[0]) == 0);
-		REQUIRE(sd1.getDelta(assets[1]) == 0);
+		REQUIRE(sd1.getDelta(0) == 0);
+		REQUIRE(sd1.getDelta(1) == 0);
 
 
-		prices[assets[0]] = 500;
-		prices[assets[1]] = 100;
+		prices[0] = 500;
+		prices[1] = 100;
 
-		SupplyDemand sd2;
+		SupplyDemand sd2(assets.size());
 		manager.demandQuery(prices, sd2, 0);
-		REQUIRE(sd2.getDelta(assets[0]) == -500 * amount);
-		REQUIRE(sd2.getDelta(assets[1]) == 500 * amount);
+		REQUIRE(sd2.getDelta(0) == -500 * amount);
+		REQUIRE(sd2.getDelta(1) == 500 * amount);
 	}
 
 	/*SECTION("tax one offer")
 	{
 		addOffer(manager, 100, 100, amount, assets[0], assets[1], 1);
 
-		manager.sealBatch();
+		manager.sealBatch(registry);
 
-		std::map<Asset, uint64_t> prices;
+		std::vector<uint64_t> prices(assets.size());
 
-		SupplyDemand sd;
+		SupplyDemand sd(assets.size());
 
-		prices[assets[0]] = 200;
-		prices[assets[1]] = 100;
+		prices[0] = 200;
+		prices[1] = 100;
 		SECTION("smooth 0")
 		{
 			manager.demandQuery(prices, sd, 0, 0);
-			REQUIRE(sd.getDelta(assets[0]) == -200 * amount);
-			REQUIRE(sd.getDelta(assets[1]) == 200 * amount);
+			REQUIRE(sd.getDelta(0) == -200 * amount);
+			REQUIRE(sd.getDelta(1) == 200 * amount);
 		}
 		SECTION("smooth 1")
 		{
 			manager.demandQuery(prices, demands, 1, 0);
-			REQUIRE(sd.getDelta(assets[0]) == -200 * amount);
-			REQUIRE(sd.getDelta(assets[1]) == 100 * amount);
+			REQUIRE(sd.getDelta(0) == -200 * amount);
+			REQUIRE(sd.getDelta(1) == 100 * amount);
 		}
 
 		SECTION("smooth 2")
 		{
 			manager.demandQuery(prices, demands, 2, 0);
-			REQUIRE(sd.getDelta(assets[0]) == -200 * amount);
-			REQUIRE(sd.getDelta(assets[1]) == 150 * amount);
+			REQUIRE(sd.getDelta(0) == -200 * amount);
+			REQUIRE(sd.getDelta(1) == 150 * amount);
 		}
 
 	}*/
 
 }
 
+TEST_CASE("parallel demand query matches serial", "[speedex]")
+{
+	auto assets = makeAssets(6);
+	SpeedexAssetRegistry registry(assets);
+	IOCOrderbookManager manager;
+
+	uint64_t idx = 0;
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		for (size_t j = 0; j < assets.size(); j++)
+		{
+			if (i == j) continue;
+			for (int32_t k = 0; k < 20; k++)
+			{
+				addOffer(manager, 50 + 7 * k + i, 100 + j, 1000 + 13 * k, assets[i], assets[j], idx++);
+			}
+		}
+	}
+
+	manager.sealBatch(registry);
+
+	ForkJoinPool pool(4);
+	ParallelDemandQuery parallelQuery(manager, pool);
+
+	std::vector<uint64_t> prices(assets.size());
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		prices[i] = 1000 + 97 * i;
+	}
 
+	for (uint8_t smoothMult = 0; smoothMult < 8; smoothMult++)
+	{
+		SupplyDemand serial(assets.size()), parallel(assets.size());
+		manager.demandQuery(prices, serial, smoothMult);
+		parallelQuery.demandQuery(prices, parallel, smoothMult);
+
+		REQUIRE(serial.mSupplyDemand == parallel.mSupplyDemand);
+
+		SupplyDemand serialWithSlopes(assets.size()), parallelWithSlopes(assets.size());
+		DemandSlopes serialSlopes, parallelSlopes;
+		serialSlopes.reset(assets.size());
+		parallelSlopes.reset(assets.size());
+		manager.demandQuery(prices, serialWithSlopes, smoothMult, &serialSlopes);
+		parallelQuery.demandQuery(prices, parallelWithSlopes, smoothMult, &parallelSlopes);
+
+		REQUIRE(serialWithSlopes.mSupplyDemand == serial.mSupplyDemand);
+		REQUIRE(parallelWithSlopes.mSupplyDemand == serial.mSupplyDemand);
+		REQUIRE(serialSlopes.mDiagonal == parallelSlopes.mDiagonal);
+	}
+}
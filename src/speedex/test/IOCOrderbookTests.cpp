@@ -10,6 +10,12 @@
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-ledger-entries.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+
 using namespace stellar;
 using namespace stellar::txtest;
 
@@ -134,6 +140,42 @@ TEST_CASE("demand query", "[speedex]")
 	REQUIRE(orderbook.cumulativeOfferedForSaleTimesPrice(400, 100, 1) == 200 * amount);
 }
 
+TEST_CASE("offered for sale slopes", "[speedex]")
+{
+	IOCOrderbook orderbook(genericAssetPair());
+
+	int64_t amount = 10000;
+
+	addOffer(orderbook, 300, 100, amount, 1);
+
+	orderbook.doPriceComputationPreprocessing();
+
+	SECTION("no execution")
+	{
+		auto res = orderbook.offeredForSaleWithSlopes(299, 100, 2);
+		REQUIRE(res.mValue == 0);
+		REQUIRE(res.mSellPriceSlope == 0);
+		REQUIRE(res.mBuyPriceSlope == 0);
+	}
+	SECTION("partial execution")
+	{
+		// value = 4 * amount * (sellPrice - 3 * buyPrice)
+		auto res = orderbook.offeredForSaleWithSlopes(350, 100, 2);
+		REQUIRE(res.mValue == 200 * amount);
+		REQUIRE(res.mValue == orderbook.cumulativeOfferedForSaleTimesPrice(350, 100, 2));
+		REQUIRE(res.mSellPriceSlope == 4 * 350 * amount);
+		REQUIRE(res.mBuyPriceSlope == 4 * 300 * amount);
+	}
+	SECTION("full execution")
+	{
+		// value = amount * sellPrice
+		auto res = orderbook.offeredForSaleWithSlopes(400, 100, 2);
+		REQUIRE(res.mValue == 400 * amount);
+		REQUIRE(res.mSellPriceSlope == 400 * amount);
+		REQUIRE(res.mBuyPriceSlope == 0);
+	}
+}
+
 TEST_CASE("attempt overflow demand query", "[speedex]")
 {
 	IOCOrderbook orderbook(genericAssetPair());
@@ -158,3 +200,306 @@ TEST_CASE("attempt overflow demand query", "[speedex]")
 	REQUIRE(orderbook.cumulativeOfferedForSaleTimesPrice(UINT64_MAX>>2, (UINT64_MAX / INT32_MAX) >> 2, 1) == 0);
 }
 
+
+TEST_CASE("out of order offers sorted at preprocessing", "[speedex]")
+{
+	IOCOrderbook orderbook(genericAssetPair());
+	IOCOrderbook child(genericAssetPair());
+
+	int64_t amount = 100;
+
+	addOffer(orderbook, 300, 100, amount, 1);
+	addOffer(orderbook, 100, 100, amount, 2);
+	addOffer(child, 200, 100, amount, 3);
+	// same price level as an offer already in the parent
+	addOffer(child, 100, 100, amount, 4);
+
+	orderbook.commitChild(child);
+	orderbook.doPriceComputationPreprocessing();
+
+	REQUIRE(orderbook.numOffers() == 4);
+
+	REQUIRE(orderbook.getPriceCompStats(99, 100).cumulativeOfferedForSale == 0);
+	REQUIRE(orderbook.getPriceCompStats(100, 100).cumulativeOfferedForSale == 2 * amount);
+	REQUIRE(orderbook.getPriceCompStats(250, 100).cumulativeOfferedForSale == 3 * amount);
+	REQUIRE(orderbook.getPriceCompStats(300, 100).cumulativeOfferedForSale == 4 * amount);
+}
+
+namespace
+{
+
+// The std::set + array-of-structs layout that IOCOrderbook used previously,
+// kept here only as a baseline for the tests and benchmark below.
+struct ReferenceOrderbook
+{
+	std::set<IOCOffer> mOffers;
+	std::vector<IOCOrderbook::PriceCompStats> mStats;
+
+	void preprocess()
+	{
+		IOCOrderbook::PriceCompStats stats {
+			.marginalPrice = zeroPrice(),
+			.cumulativeOfferedForSale = 0,
+			.cumulativeOfferedForSaleTimesPrice = 0
+		};
+		mStats.clear();
+		for (auto const& offer : mOffers)
+		{
+			if (((uint64_t)offer.mMinPrice.n) * ((uint64_t)stats.marginalPrice.d)
+				!= ((uint64_t)offer.mMinPrice.d) * ((uint64_t)stats.marginalPrice.n))
+			{
+				mStats.push_back(stats);
+				stats.marginalPrice = offer.mMinPrice;
+			}
+			stats.cumulativeOfferedForSale += offer.mSellAmount;
+			stats.cumulativeOfferedForSaleTimesPrice
+				+= (((int128_t)offer.mSellAmount) * ((int128_t)offer.mMinPrice.n)
+					<< IOCOrderbook::PriceCompStats::OFFERED_TIMES_PRICE_RADIX) / ((int128_t)offer.mMinPrice.d);
+		}
+		mStats.push_back(stats);
+	}
+
+	int64_t cumulativeOfferedForSale(uint64_t sellPrice, uint64_t buyPrice) const
+	{
+		// first entry whose marginal price exceeds sellPrice/buyPrice
+		auto it = std::upper_bound(mStats.begin() + 1, mStats.end(), 0,
+			[&] (int, IOCOrderbook::PriceCompStats const& s) {
+				return ((int128_t)s.marginalPrice.n) * ((int128_t)buyPrice)
+					> ((int128_t)s.marginalPrice.d) * ((int128_t)sellPrice);
+			});
+		return (it - 1)->cumulativeOfferedForSale;
+	}
+};
+
+} // namespace
+
+TEST_CASE("incremental price levels match full preprocessing", "[speedex]")
+{
+	AccountID acct = getAccount("blah").getPublicKey();
+
+	std::mt19937_64 gen(0);
+	std::uniform_int_distribution<int32_t> numeratorDist(1, 1000);
+	std::uniform_int_distribution<int32_t> denominatorDist(1, 7);
+	std::uniform_int_distribution<int64_t> amountDist(1, 1000000);
+
+	IOCOrderbook orderbook(genericAssetPair());
+	ReferenceOrderbook reference;
+
+	// several children, so that merges and chunk splits both happen
+	for (size_t child = 0; child < 4; child++)
+	{
+		IOCOrderbook childOrderbook(genericAssetPair());
+		for (size_t i = 0; i < 1000; i++)
+		{
+			Price p;
+			p.n = numeratorDist(gen);
+			p.d = denominatorDist(gen);
+			IOCOffer offer(amountDist(gen), p, acct, child * 1000 + i, 0);
+			childOrderbook.addOffer(offer);
+			reference.mOffers.insert(offer);
+		}
+		orderbook.commitChild(childOrderbook);
+	}
+
+	orderbook.doPriceComputationPreprocessing();
+	reference.preprocess();
+
+	for (uint64_t sellPrice = 0; sellPrice < 8000; sellPrice += 7)
+	{
+		REQUIRE(orderbook.getPriceCompStats(sellPrice, 7).cumulativeOfferedForSale
+			== reference.cumulativeOfferedForSale(sellPrice, 7));
+	}
+}
+
+TEST_CASE("IOCOrderbook layout bench", "[!hide][speedex-bench]")
+{
+	using clock = std::chrono::steady_clock;
+
+	AccountID acct = getAccount("blah").getPublicKey();
+
+	for (size_t numOffers : {10000, 100000, 1000000})
+	{
+		std::mt19937_64 gen(numOffers);
+		std::uniform_int_distribution<int32_t> priceDist(1, 1000000);
+		std::uniform_int_distribution<int64_t> amountDist(1, 1000000);
+
+		std::vector<IOCOffer> offers;
+		offers.reserve(numOffers);
+		for (size_t i = 0; i < numOffers; i++)
+		{
+			Price p;
+			p.n = priceDist(gen);
+			p.d = 1000;
+			offers.emplace_back(amountDist(gen), p, acct, i, 0);
+		}
+
+		const size_t numQueries = 1000000;
+		std::vector<uint64_t> queries;
+		queries.reserve(numQueries);
+		for (size_t i = 0; i < numQueries; i++)
+		{
+			queries.push_back(priceDist(gen));
+		}
+
+		auto start = clock::now();
+		IOCOrderbook orderbook(genericAssetPair());
+		for (auto const& offer : offers)
+		{
+			orderbook.addOffer(offer);
+		}
+		orderbook.doPriceComputationPreprocessing();
+		auto flatBuild = clock::now() - start;
+
+		start = clock::now();
+		ReferenceOrderbook reference;
+		for (auto const& offer : offers)
+		{
+			reference.mOffers.insert(offer);
+		}
+		reference.preprocess();
+		auto referenceBuild = clock::now() - start;
+
+		int64_t flatSum = 0, referenceSum = 0;
+
+		start = clock::now();
+		for (auto q : queries)
+		{
+			flatSum += orderbook.getPriceCompStats(q, 1000).cumulativeOfferedForSale;
+		}
+		auto flatQuery = clock::now() - start;
+
+		start = clock::now();
+		for (auto q : queries)
+		{
+			referenceSum += reference.cumulativeOfferedForSale(q, 1000);
+		}
+		auto referenceQuery = clock::now() - start;
+
+		REQUIRE(flatSum == referenceSum);
+
+		auto ms = [] (clock::duration d) {
+			return std::chrono::duration<double, std::milli>(d).count();
+		};
+
+		std::printf("%zu offers: build flat %.2f ms set %.2f ms; "
+			"%zu queries flat %.2f ms set+aos %.2f ms\n",
+			numOffers, ms(flatBuild), ms(referenceBuild),
+			numQueries, ms(flatQuery), ms(referenceQuery));
+	}
+}
+
+TEST_CASE("fused price comp stats lookup", "[speedex]")
+{
+	AccountID acct = getAccount("blah").getPublicKey();
+
+	std::mt19937_64 gen(1);
+	std::uniform_int_distribution<int32_t> numeratorDist(1, 1000);
+	std::uniform_int_distribution<int32_t> denominatorDist(1, 7);
+	std::uniform_int_distribution<int64_t> amountDist(1, 1000000);
+
+	// sizes around complete trees, to exercise the padding
+	for (size_t numOffers : {0, 1, 2, 3, 7, 8, 100, 1000})
+	{
+		IOCOrderbook orderbook(genericAssetPair());
+		for (size_t i = 0; i < numOffers; i++)
+		{
+			Price p;
+			p.n = numeratorDist(gen);
+			p.d = denominatorDist(gen);
+			orderbook.addOffer(IOCOffer(amountDist(gen), p, acct, i, 0));
+		}
+		orderbook.doPriceComputationPreprocessing();
+
+		auto sameStats = [] (IOCOrderbook::PriceCompStats const& lhs, IOCOrderbook::PriceCompStats const& rhs) {
+			return lhs.cumulativeOfferedForSale == rhs.cumulativeOfferedForSale
+				&& lhs.cumulativeOfferedForSaleTimesPrice == rhs.cumulativeOfferedForSaleTimesPrice;
+		};
+
+		for (uint64_t buyPrice : {0, 1, 7})
+		{
+			for (uint64_t sellPrice = 0; sellPrice < 8000; sellPrice += 13)
+			{
+				uint64_t lowSellPrice = sellPrice - (sellPrice >> 3);
+				auto [low, high] = orderbook.getPriceCompStatsPair(lowSellPrice, sellPrice, buyPrice);
+				REQUIRE(sameStats(low, orderbook.getPriceCompStats(lowSellPrice, buyPrice)));
+				REQUIRE(sameStats(high, orderbook.getPriceCompStats(sellPrice, buyPrice)));
+			}
+		}
+
+		// a zero buy price passes every level
+		REQUIRE(orderbook.getPriceCompStats(0, 0).cumulativeOfferedForSale
+			== orderbook.getPriceCompStats(UINT64_MAX, 1).cumulativeOfferedForSale);
+	}
+}
+
+TEST_CASE("getPriceCompStats per-call bench", "[!hide][speedex-bench]")
+{
+	using clock = std::chrono::steady_clock;
+
+	AccountID acct = getAccount("blah").getPublicKey();
+
+	for (size_t numOffers : {100, 10000, 1000000})
+	{
+		std::mt19937_64 gen(numOffers);
+		std::uniform_int_distribution<int32_t> priceDist(1, 1000000);
+		std::uniform_int_distribution<int64_t> amountDist(1, 1000000);
+
+		IOCOrderbook orderbook(genericAssetPair());
+		for (size_t i = 0; i < numOffers; i++)
+		{
+			Price p;
+			p.n = priceDist(gen);
+			p.d = 1000;
+			orderbook.addOffer(IOCOffer(amountDist(gen), p, acct, i, 0));
+		}
+		orderbook.doPriceComputationPreprocessing();
+
+		const size_t numQueries = 1000000;
+		std::vector<uint64_t> queries;
+		queries.reserve(numQueries);
+		for (size_t i = 0; i < numQueries; i++)
+		{
+			queries.push_back(priceDist(gen));
+		}
+
+		// smoothMult 7, as in the network controls
+		constexpr uint8_t smoothMult = 7;
+
+		int64_t singleSum = 0, pairSum = 0;
+
+		auto start = clock::now();
+		for (auto q : queries)
+		{
+			singleSum += orderbook.getPriceCompStats(q, 1000).cumulativeOfferedForSale;
+			singleSum += orderbook.getPriceCompStats(q - (q >> smoothMult), 1000).cumulativeOfferedForSale;
+		}
+		auto singleTime = clock::now() - start;
+
+		start = clock::now();
+		for (auto q : queries)
+		{
+			auto [low, high] = orderbook.getPriceCompStatsPair(q - (q >> smoothMult), q, 1000);
+			pairSum += low.cumulativeOfferedForSale + high.cumulativeOfferedForSale;
+		}
+		auto pairTime = clock::now() - start;
+
+		int128_t valueSum = 0;
+		start = clock::now();
+		for (auto q : queries)
+		{
+			valueSum += orderbook.cumulativeOfferedForSaleTimesPrice(q, 1000, smoothMult);
+		}
+		auto valueTime = clock::now() - start;
+
+		REQUIRE(singleSum == pairSum);
+		REQUIRE(valueSum >= 0);
+
+		auto nsPerCall = [numQueries] (clock::duration d) {
+			return std::chrono::duration<double, std::nano>(d).count() / numQueries;
+		};
+
+		std::printf("%zu offers: two lookups %.1f ns, fused pair %.1f ns, "
+			"cumulativeOfferedForSaleTimesPrice %.1f ns per call\n",
+			numOffers, nsPerCall(singleTime), nsPerCall(pairTime), nsPerCall(valueTime));
+	}
+}
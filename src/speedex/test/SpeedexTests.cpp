@@ -3,10 +3,19 @@
 #include "speedex/test/TatonnementTestUtils.h"
 
 #include "ledger/LedgerTxn.h"
+#include "ledger/TrustLineWrapper.h"
 
 #include "main/Application.h"
 #include "main/Config.h"
 
+#include "speedex/ClearingDeltaBuffer.h"
+#include "speedex/DemandOracle.h"
+#include "speedex/IOCOffer.h"
+#include "speedex/LiquidityPoolSetFrame.h"
+#include "speedex/OrderbookClearingTarget.h"
+#include "speedex/SpeedexConfigEntryFrame.h"
+#include "speedex/TatonnementOracle.h"
+#include "speedex/sim_utils.h"
 #include "speedex/speedex.h"
 
 #include "test/TestAccount.h"
@@ -16,6 +25,10 @@
 
 #include "transactions/TransactionUtils.h"
 
+#include "util/ForkJoinPool.h"
+
+#include <optional>
+
 using namespace stellar;
 using namespace stellar::txtest;
 
@@ -230,3 +243,272 @@ TEST_CASE("orderbook against lp", "[speedex]")
 		REQUIRE((bool) !lpRes);
 	} 
 }
+
+TEST_CASE("parallel offer clearing matches serial", "[speedex]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+
+    auto issuer = getIssuanceLimitedAccount(root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+
+    auto assets = makeAssets(3, issuer);
+
+    std::vector<TestAccount> traders;
+    for (auto i = 0; i < 3; i++)
+    {
+    	traders.push_back(root.create(fmt::format("trader{}", i), app -> getLedgerManager().getLastMinBalance(10)));
+    	setNonIssuerTrustlines(traders.back(), assets);
+    	fundTrader(traders.back(), issuer, assets);
+    }
+
+    {
+	    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+		setSpeedexAssets(ltx, assets);
+
+		ltx.commit();
+	}
+
+	// every trader trades every pair, so most (account, asset) balances
+	// are touched by several pairs
+	auto clear = [&] (ForkJoinPool* workers) {
+		LedgerTxn ltx(app -> getLedgerTxnRoot());
+
+		for (size_t t = 0; t < traders.size(); t++) {
+			auto acct = traders[t].getPublicKey();
+			for (int32_t i = 91; i <= 110; i++) {
+				addOffer(ltx, acct, 2*i + t, 100, 100, assets[0], assets[1], i);
+				addOffer(ltx, acct, 3*i, 100 + t, 200, assets[1], assets[2], i + 100);
+				addOffer(ltx, acct, i, 600, 600 + 10 * t, assets[2], assets[0], i + 200);
+			}
+		}
+
+		SpeedexRuntimeOptions options;
+		options.mClearingWorkers = workers;
+		auto res = runSpeedex(ltx, options);
+
+		std::vector<int64_t> balances;
+		for (auto& trader : traders) {
+			for (auto const& asset : assets) {
+				balances.push_back(loadTrustLine(ltx, trader.getPublicKey(), asset).getBalance());
+			}
+		}
+		// ltx rolls back, so each run starts from the same state
+		return std::make_pair(res, balances);
+	};
+
+	auto [serialRes, serialBalances] = clear(nullptr);
+
+	ForkJoinPool pool(4);
+	auto [parallelRes, parallelBalances] = clear(&pool);
+
+	REQUIRE(serialRes.offerStatuses.size() > 0);
+	REQUIRE(serialRes == parallelRes);
+	REQUIRE(serialBalances == parallelBalances);
+}
+
+TEST_CASE("speedex clearing touches entries with zero balance changes", "[speedex]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+
+    auto issuer = getIssuanceLimitedAccount(root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+
+    auto trader = root.create("trader", app -> getLedgerManager().getLastMinBalance(10));
+
+    auto assets = makeAssets(2, issuer);
+
+    setNonIssuerTrustlines(trader, assets);
+
+    fundTrader(trader, issuer, assets);
+
+    auto acct = trader.getPublicKey();
+
+	LedgerTxn ltx(app -> getLedgerTxnRoot());
+	auto ledgerSeq = ++ltx.loadHeader().current().ledgerSeq;
+
+	auto lastModified = [&] (Asset const& asset) {
+		return ltx.load(trustlineKey(acct, asset)).current().lastModifiedLedgerSeq;
+	};
+	auto balance = [&] (Asset const& asset) {
+		return loadTrustLine(ltx, acct, asset).getBalance();
+	};
+
+	REQUIRE(lastModified(assets[0]) < ledgerSeq);
+	REQUIRE(lastModified(assets[1]) < ledgerSeq);
+	auto startBalance = balance(assets[1]);
+
+	SECTION("fill rounds the buy amount to zero")
+	{
+		AssetPair tradingPair {
+			.selling = assets[0],
+			.buying = assets[1]
+		};
+		// one unit sold at a price of 1/10 buys nothing
+		OrderbookClearingTarget target(tradingPair, 1, 10, 1);
+		IOCOffer offer(1, Price{1, 10}, acct, 1, 0);
+
+		{
+			LedgerTxn ltxInner(ltx);
+			ClearingDeltaBuffer deltas;
+			auto status = target.clearOffer(offer, deltas);
+			REQUIRE(status.soldAmount == 1);
+			REQUIRE(status.boughtAmount == 0);
+			deltas.apply(ltxInner);
+			ltxInner.commit();
+		}
+
+		REQUIRE(lastModified(assets[0]) == ledgerSeq);
+		REQUIRE(lastModified(assets[1]) == ledgerSeq);
+		REQUIRE(balance(assets[1]) == startBalance);
+	}
+
+	SECTION("changes net to zero across pairs")
+	{
+		{
+			LedgerTxn ltxInner(ltx);
+			ClearingDeltaBuffer deltas;
+			deltas.add(acct, assets[1], 5);
+			deltas.add(acct, assets[1], -5);
+			deltas.apply(ltxInner);
+			ltxInner.commit();
+		}
+
+		REQUIRE(lastModified(assets[0]) < ledgerSeq);
+		REQUIRE(lastModified(assets[1]) == ledgerSeq);
+		REQUIRE(balance(assets[1]) == startBalance);
+	}
+}
+
+TEST_CASE("speedex runs every tatonnement round before protocol 18", "[speedex]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+
+    auto issuer = getIssuanceLimitedAccount(root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+
+    auto trader = root.create("trader", app -> getLedgerManager().getLastMinBalance(10));
+
+    auto assets = makeAssets(3, issuer);
+
+    setNonIssuerTrustlines(trader, assets);
+
+    fundTrader(trader, issuer, assets);
+
+    {
+	    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+		setSpeedexAssets(ltx, assets);
+
+		ltx.commit();
+	}
+
+	auto addOffers = [&] (AbstractLedgerTxn& ltx) {
+		auto acct = trader.getPublicKey();
+		for (int32_t i = 91; i <= 110; i++) {
+			addOffer(ltx, acct, 2*i, 100, 100, assets[0], assets[1], i);
+			addOffer(ltx, acct, 3*i, 100, 200, assets[1], assets[2], i + 100);
+			addOffer(ltx, acct, i, 600, 600, assets[2], assets[0], i + 200);
+		}
+	};
+
+	// the network controls would stop early
+	auto controls = SpeedexConfigSnapshotFrame::getControls();
+	REQUIRE(controls.mConvergenceCheckInterval > 0);
+	controls.mConvergenceCheckInterval = 0;
+
+	std::vector<uint64_t> expectedPrices;
+	std::optional<SpeedexAssetRegistry> registry;
+	{
+		LedgerTxn ltx(app -> getLedgerTxnRoot());
+		addOffers(ltx);
+
+		auto speedexConfig = loadSpeedexConfigSnapshot(ltx);
+		registry.emplace(speedexConfig.getAssetRegistry());
+
+		auto& orderbooks = ltx.getSpeedexIOCOffers();
+		orderbooks.sealBatch(*registry);
+
+		LiquidityPoolSetFrame lpFrame(*registry, ltx);
+		DemandOracle demandOracle(*registry, orderbooks, lpFrame);
+		TatonnementOracle oracle(demandOracle);
+
+		expectedPrices = speedexConfig.getStartingPrices();
+		auto res = oracle.computePrices(controls, expectedPrices);
+		REQUIRE(res.mRounds == controls.mMaxRounds);
+	}
+
+	LedgerTxn ltx(app -> getLedgerTxnRoot());
+	addOffers(ltx);
+
+	SpeedexRunStats stats;
+	auto res = runSpeedex(ltx, {}, &stats);
+
+	REQUIRE(stats.mTatonnementRounds == controls.mMaxRounds);
+	REQUIRE(!stats.mWarmStarted);
+
+	REQUIRE(res.valuations.size() == assets.size());
+	for (auto const& valuation : res.valuations) {
+		REQUIRE(valuation.price == expectedPrices.at(registry->getIndex(valuation.asset)));
+	}
+}
+
+TEST_CASE("speedex sim driver", "[speedex]")
+{
+	SpeedexSimGenParams params;
+	params.mNumAssets = 4;
+	params.mOffersPerPair = 25;
+	params.mPriceDispersion = 0.2;
+	params.mAmmReserve = 1000000;
+	params.mSeed = 7;
+
+	auto sim = generateSpeedexSim(params);
+
+	REQUIRE(sim.config.assets.size() == 4);
+	REQUIRE(sim.offers.size() == 4 * 3 * 25);
+	REQUIRE(sim.config.ammConfigs.size() == 6);
+
+	SECTION("generator is deterministic")
+	{
+		REQUIRE(generateSpeedexSim(params) == sim);
+		params.mSeed++;
+		REQUIRE(!(generateSpeedexSim(params) == sim));
+	}
+
+	SECTION("runs without a ledger")
+	{
+		SpeedexSimStats serialStats;
+		auto serialRes = runSpeedexSim(sim, {}, &serialStats);
+
+		REQUIRE(serialStats.mNumOffers == sim.offers.size());
+		REQUIRE(serialStats.mTatonnementRounds > 0);
+		REQUIRE(serialStats.mOffersCleared == serialRes.offerStatuses.size());
+		REQUIRE(serialStats.mOffersCleared > 0);
+		REQUIRE(serialStats.mTradeValue > 0);
+
+		ForkJoinPool pool(4);
+		SpeedexRuntimeOptions options;
+		options.mDemandQueryWorkers = &pool;
+		options.mTatonnementWorkers = &pool;
+		options.mClearingWorkers = &pool;
+
+		SpeedexSimStats parallelStats;
+		auto parallelRes = runSpeedexSim(sim, options, &parallelStats);
+
+		REQUIRE(serialRes == parallelRes);
+		REQUIRE(serialStats.mTatonnementRounds == parallelStats.mTatonnementRounds);
+		REQUIRE(serialStats.mTradeValue == parallelStats.mTradeValue);
+	}
+}
@@ -2,6 +2,8 @@
 #include "speedex/TatonnementControls.h"
 
 #include "speedex/DemandUtils.h"
+#include "speedex/SpeedexAssetRegistry.h"
+#include "speedex/SpeedexConfigEntryFrame.h"
 
 #include "test/TxTests.h"
 
@@ -35,12 +37,12 @@ TEST_CASE("objective function", "[speedex]")
 {
 	using int128_t = __int128;
 
-	SupplyDemand demands1, demands2;
-
 	auto assets = makeAssets(10);
 
-	demands1.mSupplyDemand[assets[0]] = {10000, 0};
-	demands2.mSupplyDemand[assets[0]] = {10001, 0};
+	SupplyDemand demands1(assets.size()), demands2(assets.size());
+
+	demands1.mSupplyDemand[0] = {10000, 0};
+	demands2.mSupplyDemand[0] = {10001, 0};
 
 	TatonnementObjectiveFn obj1 = demands1.getObjective(), obj2 = demands2.getObjective();
 
@@ -90,3 +92,167 @@ TEST_CASE("price adjust", "[speedex]")
 
 	REQUIRE(wrapper.setTrialPrice(startingPrice, demand, 0) > 0);
 }
+
+TEST_CASE("newton price adjust", "[speedex]")
+{
+	using int128_t = __int128;
+
+	TatonnementControlParams params;
+	params.mSmoothMult = 5;
+	params.mStepSizeRadix = 5;
+	params.mStepRule = TatonnementStepRule::DIAGONAL_NEWTON;
+
+	TatonnementControlParamsWrapper wrapper(params);
+	REQUIRE(wrapper.usesSlopes());
+
+	const uint64_t fullStep = wrapper.kMaxStepSize;
+	REQUIRE(fullStep == (1llu) << TatonnementControlParamsWrapper::NEWTON_STEP_RADIX);
+
+	const int128_t slope = 1000;
+
+	SECTION("full step")
+	{
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, 500, slope, fullStep) == 1500);
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, -250, slope, fullStep) == 750);
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, 0, slope, fullStep) == 1000);
+	}
+	SECTION("damped step")
+	{
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, 500, slope, fullStep / 2) == 1250);
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, -500, slope, fullStep / 2) == 750);
+	}
+	SECTION("moves are capped")
+	{
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, 5000, slope, fullStep) == 2000);
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, -5000, slope, fullStep) == 500);
+	}
+	SECTION("flat market")
+	{
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, 1, 0, fullStep) == 2000);
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, -1, 0, fullStep) == 500);
+	}
+	SECTION("large values")
+	{
+		int128_t bigSlope = ((int128_t)1) << 120;
+		REQUIRE(wrapper.setNewtonTrialPrice(1000, bigSlope / 2, bigSlope, fullStep) == 1500);
+	}
+	SECTION("trial prices need slopes")
+	{
+		SupplyDemand demands(1);
+		std::vector<uint64_t> out;
+		REQUIRE_THROWS(wrapper.setTrialPrices({1000}, demands, nullptr, fullStep, out));
+
+		DemandSlopes slopes;
+		slopes.reset(1);
+		slopes.mDiagonal[0] = slope;
+		wrapper.setTrialPrices({1000}, demands, &slopes, fullStep, out);
+		REQUIRE(out == std::vector<uint64_t>({1000}));
+	}
+}
+
+TEST_CASE("asset registry", "[speedex]")
+{
+	auto assets = makeAssets(5);
+	std::vector<Asset> shuffled = {assets[3], assets[0], assets[4], assets[2], assets[1]};
+
+	SpeedexAssetRegistry registry(shuffled);
+
+	REQUIRE(registry.size() == 5);
+	for (size_t i = 0; i < shuffled.size(); i++)
+	{
+		REQUIRE(registry.getIndex(shuffled[i]) == i);
+		REQUIRE(registry.getAsset(i) == shuffled[i]);
+	}
+
+	auto const& order = registry.getIndicesInAssetOrder();
+	for (size_t i = 1; i < order.size(); i++)
+	{
+		REQUIRE(registry.getAsset(order[i-1]) < registry.getAsset(order[i]));
+	}
+
+	REQUIRE(!registry.tryGetIndex(makeAssets(6).back()));
+	REQUIRE_THROWS(SpeedexAssetRegistry({assets[0], assets[0]}));
+}
+
+TEST_CASE("speedex warm start", "[speedex]")
+{
+	auto assets = makeAssets(3);
+
+	auto entry = std::make_shared<LedgerEntry>();
+	entry->data.type(SPEEDEX_CONFIG);
+	auto& config = entry->data.speedexConfig();
+	config.speedexAssets.assign(assets.begin(), assets.end());
+
+	SECTION("none recorded")
+	{
+		SpeedexConfigSnapshotFrame frame(entry);
+		REQUIRE(!frame.getWarmStart());
+	}
+
+	auto record = [&](xdr::xvector<Asset> const& recordedAssets) {
+		config.ext.v(1);
+		auto& warmStart = config.ext.warmStart();
+		warmStart.assetsHash =
+			SpeedexConfigSnapshotFrame::hashAssets(recordedAssets);
+		warmStart.prices.assign({100, 200, 300});
+		warmStart.prices.resize(recordedAssets.size());
+		warmStart.stepSize = 1000;
+	};
+
+	SECTION("recorded")
+	{
+		record(config.speedexAssets);
+
+		SpeedexConfigSnapshotFrame frame(entry);
+		auto warmStart = frame.getWarmStart();
+		REQUIRE(warmStart);
+		REQUIRE(warmStart->prices[1] == 200);
+		REQUIRE(warmStart->stepSize == 1000);
+	}
+
+	SECTION("asset list changed")
+	{
+		record(xdr::xvector<Asset>(assets.begin(), assets.begin() + 2));
+
+		SpeedexConfigSnapshotFrame frame(entry);
+		REQUIRE(!frame.getWarmStart());
+	}
+
+	SECTION("asset list replaced by one of the same length")
+	{
+		record(config.speedexAssets);
+		std::swap(config.speedexAssets[0], config.speedexAssets[1]);
+
+		SpeedexConfigSnapshotFrame frame(entry);
+		REQUIRE(!frame.getWarmStart());
+	}
+}
+
+TEST_CASE("step bounds", "[speedex]")
+{
+	TatonnementControlParams params;
+	params.mSmoothMult = 5;
+	params.mStepSizeRadix = 5;
+
+	TatonnementControlParamsWrapper wrapper(params);
+
+	REQUIRE(wrapper.imposeStepBounds(0) == wrapper.kMinStepSize);
+	REQUIRE(wrapper.imposeStepBounds(wrapper.kMinStepSize + 1) == wrapper.kMinStepSize + 1);
+}
+
+TEST_CASE("newton step bounds", "[speedex]")
+{
+	TatonnementControlParams params;
+	params.mSmoothMult = 5;
+	params.mStepSizeRadix = 5;
+	params.mStepUp = 45;
+	params.mStepDown = 25;
+	params.mStepRule = TatonnementStepRule::DIAGONAL_NEWTON;
+
+	TatonnementControlParamsWrapper wrapper(params);
+
+	REQUIRE(wrapper.kStartingStepSize == wrapper.kMaxStepSize);
+	REQUIRE(wrapper.imposeStepBounds(wrapper.kMaxStepSize + 1) == wrapper.kMaxStepSize);
+	REQUIRE(wrapper.stepUp(wrapper.kMaxStepSize) == wrapper.kMaxStepSize);
+	REQUIRE(wrapper.stepDown(wrapper.kMaxStepSize) < wrapper.kMaxStepSize);
+}
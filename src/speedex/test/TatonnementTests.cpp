@@ -8,6 +8,10 @@
 #include "speedex/TatonnementControls.h"
 
 #include "speedex/LiquidityPoolSetFrame.h"
+#include "speedex/MultiStartTatonnement.h"
+#include "speedex/SpeedexAssetRegistry.h"
+#include "speedex/SpeedexConfigEntryFrame.h"
+#include "speedex/sim_utils.h"
 
 #include "ledger/AssetPair.h"
 #include "ledger/LedgerTxn.h"
@@ -19,9 +23,13 @@
 
 #include "transactions/TransactionUtils.h"
 
+#include "util/ForkJoinPool.h"
+
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-ledger-entries.h"
 
+#include <chrono>
+#include <cstdio>
 #include <map>
 
 #include "speedex/test/TatonnementTestUtils.h"
@@ -39,8 +47,10 @@ TEST_CASE("small 2-asset tatonnement run", "[speedex][tatonnement]")
     LedgerTxn ltx(app->getLedgerTxnRoot());
 
 	auto assets = makeAssets(2);
+	SpeedexAssetRegistry registry(assets);
 
-	LiquidityPoolSetFrame lpFrame({}, ltx);
+	// no pools exist for these assets
+	LiquidityPoolSetFrame lpFrame(registry, ltx);
 
 
 	auto acct = getAccount("blah").getPublicKey();
@@ -51,7 +61,7 @@ TEST_CASE("small 2-asset tatonnement run", "[speedex][tatonnement]")
 
 	auto& manager = ltx.getSpeedexIOCOffers();
 
-	manager.sealBatch();
+	manager.sealBatch(registry);
 
 	TatonnementControlParams controls
 	{
@@ -64,17 +74,17 @@ TEST_CASE("small 2-asset tatonnement run", "[speedex][tatonnement]")
 		.mStepRadix = 65
 	};
 
-	DemandOracle demandOracle(manager, lpFrame);
+	DemandOracle demandOracle(registry, manager, lpFrame);
 
 	TatonnementOracle oracle(demandOracle);
 
-	std::map<Asset, uint64_t> prices;
-	prices[assets[0]] = 100000;
-	prices[assets[1]] = 100;
+	std::vector<uint64_t> prices(assets.size());
+	prices[0] = 100000;
+	prices[1] = 100;
 
 	oracle.computePrices(controls, prices, 1);
 
-	std::printf("%llu %llu\n", prices[assets[0]], prices[assets[1]]);
+	std::printf("%llu %llu\n", prices[0], prices[1]);
 }
 
 TEST_CASE("trade offers against a liquidity pool", "[speedex][tatonnement]")
@@ -96,10 +106,11 @@ TEST_CASE("trade offers against a liquidity pool", "[speedex][tatonnement]")
 		addOffer(ltx, acct, i, 100, 1000, assets[0], assets[1], i);
 	}
 
-	LiquidityPoolSetFrame lpFrame(assets, ltx);
+	SpeedexAssetRegistry registry(assets);
+	LiquidityPoolSetFrame lpFrame(registry, ltx);
 
 	auto& manager = ltx.getSpeedexIOCOffers();
-	manager.sealBatch();
+	manager.sealBatch(registry);
 
 	TatonnementControlParams controls
 	{
@@ -112,17 +123,275 @@ TEST_CASE("trade offers against a liquidity pool", "[speedex][tatonnement]")
 		.mStepRadix = 65
 	};
 
-	DemandOracle demandOracle(manager, lpFrame);
+	DemandOracle demandOracle(registry, manager, lpFrame);
 
 	TatonnementOracle oracle(demandOracle);
 
-	std::map<Asset, uint64_t> prices;
-	prices[assets[0]] = 100000;
-	prices[assets[1]] = 100;
+	std::vector<uint64_t> prices(assets.size());
+	prices[0] = 100000;
+	prices[1] = 100;
 
 	oracle.computePrices(controls, prices, 1);
 
-	std::printf("%llu %llu\n", prices[assets[0]], prices[assets[1]]);
+	std::printf("%llu %llu\n", prices[0], prices[1]);
+}
+
+
+
+TEST_CASE("tatonnement stops at clearing prices", "[speedex][tatonnement]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+	auto assets = makeAssets(2);
+	SpeedexAssetRegistry registry(assets);
+
+	LiquidityPoolSetFrame lpFrame(registry, ltx);
+
+	auto acct = getAccount("blah").getPublicKey();
+	for (int32_t i = 90; i < 110; i++) {
+		addOffer(ltx, acct, i, 100, 1000, assets[0], assets[1], i);
+		addOffer(ltx, acct, i, 100, 1000, assets[1], assets[0], i+100);
+	}
+
+	auto& manager = ltx.getSpeedexIOCOffers();
+	manager.sealBatch(registry);
+
+	TatonnementControlParams controls
+	{
+		.mTaxRate = 5,
+		.mSmoothMult = 5,
+		.mMaxRounds = 1000,
+		.mStepUp = 45,
+		.mStepDown = 25,
+		.mStepSizeRadix = 5,
+		.mStepRadix = 65,
+		.mConvergenceCheckInterval = 1
+	};
+
+	DemandOracle demandOracle(registry, manager, lpFrame);
+	TatonnementOracle oracle(demandOracle);
+
+	SECTION("clearing check")
+	{
+		REQUIRE(demandOracle.checkApproximateClearing({100, 100}, controls.mTaxRate));
+		// nobody sells asset 1 at this price
+		REQUIRE(!demandOracle.checkApproximateClearing({100000, 100}, controls.mTaxRate));
+	}
+
+	SECTION("start at equilibrium")
+	{
+		std::vector<uint64_t> prices = {100, 100};
+		auto res = oracle.computePrices(controls, prices);
+		REQUIRE(res.mConverged);
+		REQUIRE(res.mRounds == 0);
+		REQUIRE(prices == std::vector<uint64_t>({100, 100}));
+	}
+
+	SECTION("no check")
+	{
+		controls.mConvergenceCheckInterval = 0;
+		std::vector<uint64_t> prices = {100, 100};
+		auto res = oracle.computePrices(controls, prices);
+		REQUIRE(!res.mConverged);
+		REQUIRE(res.mRounds == controls.mMaxRounds);
+	}
+}
+
+TEST_CASE("newton tatonnement", "[speedex][tatonnement]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+	auto assets = makeAssets(2);
+
+	SECTION("offers only")
+	{
+	}
+	SECTION("with a liquidity pool")
+	{
+		createLiquidityPool(assets[0], assets[1], 100000, 100000, ltx);
+	}
+
+	SpeedexAssetRegistry registry(assets);
+	LiquidityPoolSetFrame lpFrame(registry, ltx);
+
+	auto acct = getAccount("blah").getPublicKey();
+	for (int32_t i = 90; i < 110; i++) {
+		addOffer(ltx, acct, i, 100, 1000, assets[0], assets[1], i);
+		addOffer(ltx, acct, i, 100, 1000, assets[1], assets[0], i+100);
+	}
+
+	auto& manager = ltx.getSpeedexIOCOffers();
+	manager.sealBatch(registry);
+
+	TatonnementControlParams controls
+	{
+		.mTaxRate = 5,
+		.mSmoothMult = 5,
+		.mMaxRounds = 1000,
+		.mStepUp = 45,
+		.mStepDown = 25,
+		.mStepSizeRadix = 5,
+		.mStepRadix = 65,
+		.mConvergenceCheckInterval = 1,
+		.mStepRule = TatonnementStepRule::DIAGONAL_NEWTON
+	};
+
+	DemandOracle demandOracle(registry, manager, lpFrame);
+	TatonnementOracle oracle(demandOracle);
+
+	std::vector<uint64_t> prices = {100000, 100};
+	auto res = oracle.computePrices(controls, prices);
+
+	REQUIRE(res.mConverged);
+	REQUIRE(demandOracle.checkApproximateClearing(prices, controls.mTaxRate));
+
+	// deterministic
+	std::vector<uint64_t> again = {100000, 100};
+	auto res2 = oracle.computePrices(controls, again);
+	REQUIRE(res2.mRounds == res.mRounds);
+	REQUIRE(again == prices);
 }
 
+TEST_CASE("tatonnement step rule bench", "[!hide][speedex-bench]")
+{
+	for (size_t numAssets : {10, 50, 100})
+	{
+		SpeedexSimGenParams params;
+		params.mNumAssets = numAssets;
+		params.mOffersPerPair = 20;
+		params.mPriceDispersion = 0.2;
+		params.mSeed = 1;
+
+		auto sim = generateSpeedexSim(params);
+
+		std::vector<Asset> assets;
+		for (auto const& code : sim.config.assets)
+		{
+			assets.push_back(makeSimAsset(code));
+		}
+		SpeedexAssetRegistry registry(assets);
+
+		IOCOrderbookManager manager;
+		for (size_t i = 0; i < sim.offers.size(); i++)
+		{
+			auto const& offer = sim.offers[i];
+			AssetPair pair {
+				.selling = makeSimAsset(offer.selling),
+				.buying = makeSimAsset(offer.buying)
+			};
+			manager.addOffer(pair, IOCOffer(offer.amount, offer.minPrice, AccountID{}, i, 0));
+		}
+		manager.sealBatch(registry);
+
+		LiquidityPoolSetFrame lpFrame(registry, sim.config);
+		DemandOracle demandOracle(registry, manager, lpFrame);
+		TatonnementOracle oracle(demandOracle);
+
+		for (auto rule : {TatonnementStepRule::GRADIENT, TatonnementStepRule::DIAGONAL_NEWTON})
+		{
+			auto controls = SpeedexConfigSnapshotFrame::getControls();
+			controls.mStepRule = rule;
+
+			auto prices = SpeedexConfigSnapshotFrame::getStartingPrices(numAssets);
+
+			auto start = std::chrono::steady_clock::now();
+			auto res = oracle.computePrices(controls, prices);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			std::printf("assets %zu %s: rounds %u converged %d time %lf\n",
+				numAssets,
+				rule == TatonnementStepRule::GRADIENT ? "gradient" : "newton",
+				res.mRounds,
+				res.mConverged ? 1 : 0,
+				elapsed.count());
+		}
+	}
+}
 
+TEST_CASE("multi-start tatonnement", "[speedex][tatonnement]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+	auto assets = makeAssets(3);
+	SpeedexAssetRegistry registry(assets);
+
+	LiquidityPoolSetFrame lpFrame(registry, ltx);
+
+	auto acct = getAccount("blah").getPublicKey();
+	uint64_t idx = 0;
+	for (size_t sell = 0; sell < assets.size(); sell++) {
+		for (size_t buy = 0; buy < assets.size(); buy++) {
+			if (sell == buy) continue;
+			for (int32_t i = 90; i < 110; i++) {
+				addOffer(ltx, acct, i + static_cast<int32_t>(sell), 100 + static_cast<int32_t>(buy), 1000, assets[sell], assets[buy], idx++);
+			}
+		}
+	}
+
+	auto& manager = ltx.getSpeedexIOCOffers();
+	manager.sealBatch(registry);
+
+	TatonnementControlParams base
+	{
+		.mTaxRate = 5,
+		.mSmoothMult = 5,
+		.mMaxRounds = 200,
+		.mStepUp = 45,
+		.mStepDown = 25,
+		.mStepSizeRadix = 5,
+		.mStepRadix = 65,
+		.mConvergenceCheckInterval = 5
+	};
+
+	std::vector<TatonnementControlParams> presets(3, base);
+	presets[1].mStepUp = 40;
+	presets[1].mStepDown = 20;
+	presets[2].mStepUp = 56;
+	presets[2].mStepDown = 28;
+
+	const std::vector<uint64_t> startingPrices = {100000, 100, 1000};
+
+	MultiStartTatonnement serial(registry, manager, lpFrame);
+	std::vector<uint64_t> serialPrices = startingPrices;
+	auto serialRes = serial.computePrices(presets, serialPrices);
+
+	ForkJoinPool pool(3);
+	MultiStartTatonnement parallel(registry, manager, lpFrame, &pool);
+	std::vector<uint64_t> parallelPrices = startingPrices;
+	auto parallelRes = parallel.computePrices(presets, parallelPrices);
+
+	REQUIRE(serialRes.mWinningPreset == parallelRes.mWinningPreset);
+	REQUIRE(serialRes.mTatonnementResult.mRounds == parallelRes.mTatonnementResult.mRounds);
+	REQUIRE(serialPrices == parallelPrices);
+
+	// the winner is one of the single-preset runs
+	DemandOracle demandOracle(registry, manager, lpFrame);
+	TatonnementOracle oracle(demandOracle);
+	std::vector<uint64_t> winnerPrices = startingPrices;
+	oracle.computePrices(presets[serialRes.mWinningPreset], winnerPrices);
+	REQUIRE(winnerPrices == serialPrices);
+}
+
+TEST_CASE("multi-start tatonnement is opt-in", "[speedex][tatonnement]")
+{
+	auto controls = SpeedexConfigSnapshotFrame::getControls();
+	auto presets = SpeedexConfigSnapshotFrame::getControlPresets();
+	// every ledger close would otherwise run several Tatonnements
+	REQUIRE(!controls.mMultiStart);
+	REQUIRE(presets.size() == 1);
+	REQUIRE(presets.front().mStepUp == controls.mStepUp);
+	REQUIRE(presets.front().mStepDown == controls.mStepDown);
+	REQUIRE(presets.front().mSmoothMult == controls.mSmoothMult);
+}
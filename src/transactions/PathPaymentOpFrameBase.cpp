@@ -7,6 +7,7 @@
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
 #include "ledger/TrustLineWrapper.h"
+#include "transactions/TransactionFrame.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/XDROperators.h"
@@ -200,6 +201,41 @@ PathPaymentOpFrameBase::updateSourceBalance(AbstractLedgerTxn& ltx,
     return true;
 }
 
+bool
+PathPaymentOpFrameBase::tryCommutativeCredit(AbstractLedgerTxn& ltx,
+                                             LedgerKey const& key,
+                                             int64_t amount)
+{
+    auto header = ltx.loadHeader();
+    if (header.current().ledgerVersion < 10)
+    {
+        return false;
+    }
+
+    int64_t maxReceive = 0;
+    {
+        auto entry = ltx.loadWithoutRecord(key);
+        if (!entry)
+        {
+            return false;
+        }
+        auto const& le = entry.current();
+        if (le.data.type() == TRUSTLINE && !isCommutativeTxEnabledTrustLine(le))
+        {
+            return false;
+        }
+        maxReceive = getMaxAmountReceive(header, le);
+    }
+
+    // same check as addBalance, which reports the failure
+    if (amount > maxReceive)
+    {
+        return false;
+    }
+    ltx.addCommutativeBalanceDelta(key, amount);
+    return true;
+}
+
 bool
 PathPaymentOpFrameBase::updateDestBalance(AbstractLedgerTxn& ltx,
                                           int64_t amount,
@@ -210,6 +246,12 @@ PathPaymentOpFrameBase::updateDestBalance(AbstractLedgerTxn& ltx,
 
     if (asset.type() == ASSET_TYPE_NATIVE)
     {
+        if (mParentTx.isCommutativeTransaction() &&
+            tryCommutativeCredit(ltx, accountKey(destID), amount))
+        {
+            return true;
+        }
+
         auto destination = stellar::loadAccount(ltx, destID);
         if (!addBalance(ltx.loadHeader(), destination, amount))
         {
@@ -231,6 +273,12 @@ PathPaymentOpFrameBase::updateDestBalance(AbstractLedgerTxn& ltx,
             return false;
         }
 
+        if (mParentTx.isCommutativeTransaction() &&
+            tryCommutativeCredit(ltx, trustlineKey(destID, asset), amount))
+        {
+            return true;
+        }
+
         auto destLine = stellar::loadTrustLine(ltx, destID, asset);
         if (!destLine)
         {
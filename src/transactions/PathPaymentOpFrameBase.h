@@ -28,6 +28,15 @@ class PathPaymentOpFrameBase : public OperationFrame
     bool updateDestBalance(AbstractLedgerTxn& ltx, int64_t amount,
                            bool bypassIssuerCheck);
 
+    // Commutative payments often all credit the same few entries (an
+    // exchange, an anchor), so their credits are recorded as balance deltas
+    // (see AbstractLedgerTxn::addCommutativeBalanceDelta) instead of copying
+    // the entry through every nested LedgerTxn. Returns false, changing
+    // nothing, if the credit must take the regular path: the entry is
+    // missing or not commutative, or the credit would fail.
+    bool tryCommutativeCredit(AbstractLedgerTxn& ltx, LedgerKey const& key,
+                              int64_t amount);
+
     bool checkIssuer(AbstractLedgerTxn& ltx, Asset const& asset);
 
   public:
@@ -0,0 +1,160 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/AllocationCounter.h"
+
+#ifdef ALLOCATION_COUNTING_ENABLED
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace stellar
+{
+
+#ifdef ALLOCATION_COUNTING_ENABLED
+
+static std::atomic<uint64_t> gAllocationCount{0};
+
+static void*
+countedAlloc(std::size_t size)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void*
+countedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc requires size to be a multiple of the alignment
+    size = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, size == 0 ? alignment : size);
+}
+
+bool
+allocationCountingEnabled()
+{
+    return true;
+}
+
+uint64_t
+getAllocationCount()
+{
+    return gAllocationCount.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool
+allocationCountingEnabled()
+{
+    return false;
+}
+
+uint64_t
+getAllocationCount()
+{
+    return 0;
+}
+
+#endif
+}
+
+#ifdef ALLOCATION_COUNTING_ENABLED
+
+void*
+operator new(std::size_t size)
+{
+    if (void* p = stellar::countedAlloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void*
+operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return stellar::countedAlloc(size);
+}
+
+void*
+operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return stellar::countedAlloc(size);
+}
+
+void*
+operator new(std::size_t size, std::align_val_t align)
+{
+    if (void* p = stellar::countedAlignedAlloc(size, align))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t align)
+{
+    return operator new(size, align);
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+#endif
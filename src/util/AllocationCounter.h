@@ -0,0 +1,19 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstdint>
+
+namespace stellar
+{
+
+// Process-wide count of calls to the global operator new, for offline
+// benchmarks. Counting replaces the global allocation functions, so it is
+// only compiled in when configured with --enable-allocation-counting;
+// otherwise allocationCountingEnabled() is false and the count stays 0.
+bool allocationCountingEnabled();
+
+uint64_t getAllocationCount();
+}
@@ -0,0 +1,190 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BlockCompression.h"
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace stellar
+{
+
+namespace
+{
+size_t const kMinMatch = 4;
+// As in LZ4, the last kLastLiterals bytes are always literals and no match
+// starts in the last kMatchFindLimit bytes.
+size_t const kLastLiterals = 5;
+size_t const kMatchFindLimit = 12;
+size_t const kMaxOffset = 0xffff;
+int const kHashBits = 12;
+
+uint32_t
+read32(char const* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t
+hashOf(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// Lengths of 15 or more spill over the token nibble into bytes of 255 ended
+// by a smaller byte.
+void
+putLength(size_t len, std::vector<char>& out)
+{
+    for (; len >= 255; len -= 255)
+    {
+        out.push_back(static_cast<char>(255));
+    }
+    out.push_back(static_cast<char>(len));
+}
+
+void
+putSequence(char const* literals, size_t litLen, size_t offset,
+            size_t matchLen, std::vector<char>& out)
+{
+    size_t const mlCode = matchLen == 0 ? 0 : matchLen - kMinMatch;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(litLen, 15) << 4) |
+                                         std::min<size_t>(mlCode, 15));
+    out.push_back(static_cast<char>(token));
+    if (litLen >= 15)
+    {
+        putLength(litLen - 15, out);
+    }
+    out.insert(out.end(), literals, literals + litLen);
+    if (matchLen == 0)
+    {
+        return;
+    }
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (mlCode >= 15)
+    {
+        putLength(mlCode - 15, out);
+    }
+}
+
+bool
+getLength(char const* src, size_t size, size_t& ip, size_t& len)
+{
+    uint8_t b;
+    do
+    {
+        if (ip >= size)
+        {
+            return false;
+        }
+        b = static_cast<uint8_t>(src[ip++]);
+        len += b;
+    } while (b == 255);
+    return true;
+}
+}
+
+void
+lzCompressBlock(char const* src, size_t size, std::vector<char>& out)
+{
+    ZoneScoped;
+    size_t anchor = 0;
+    if (size > kMatchFindLimit)
+    {
+        // Positions are stored plus one, so that zero means none.
+        std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+        size_t const matchStartLimit = size - kMatchFindLimit;
+        size_t const matchEndLimit = size - kLastLiterals;
+        size_t ip = 0;
+        while (ip < matchStartLimit)
+        {
+            uint32_t seq = read32(src + ip);
+            uint32_t& slot = table[hashOf(seq)];
+            size_t ref = slot;
+            slot = static_cast<uint32_t>(ip + 1);
+            if (ref == 0 || ip - (ref - 1) > kMaxOffset ||
+                read32(src + ref - 1) != seq)
+            {
+                ++ip;
+                continue;
+            }
+            --ref;
+            size_t len = kMinMatch;
+            while (ip + len < matchEndLimit && src[ref + len] == src[ip + len])
+            {
+                ++len;
+            }
+            putSequence(src + anchor, ip - anchor, ip - ref, len, out);
+            ip += len;
+            anchor = ip;
+        }
+    }
+    putSequence(src + anchor, size - anchor, 0, 0, out);
+}
+
+bool
+lzDecompressBlock(char const* src, size_t size, char* dst, size_t rawSize)
+{
+    ZoneScoped;
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < size)
+    {
+        uint8_t token = static_cast<uint8_t>(src[ip++]);
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !getLength(src, size, ip, litLen))
+        {
+            return false;
+        }
+        if (litLen > size - ip || litLen > rawSize - op)
+        {
+            return false;
+        }
+        std::memcpy(dst + op, src + ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == size)
+        {
+            // The last sequence has no match
+            break;
+        }
+
+        if (size - ip < 2)
+        {
+            return false;
+        }
+        size_t offset = static_cast<uint8_t>(src[ip]) |
+                        (static_cast<size_t>(static_cast<uint8_t>(src[ip + 1]))
+                         << 8);
+        ip += 2;
+        if (offset == 0 || offset > op)
+        {
+            return false;
+        }
+        size_t matchLen = token & 0xf;
+        if (matchLen == 15 && !getLength(src, size, ip, matchLen))
+        {
+            return false;
+        }
+        matchLen += kMinMatch;
+        if (matchLen > rawSize - op)
+        {
+            return false;
+        }
+        // Matches may overlap their own output, so copy bytewise.
+        char const* from = dst + op - offset;
+        for (size_t i = 0; i < matchLen; ++i)
+        {
+            dst[op + i] = from[i];
+        }
+        op += matchLen;
+    }
+    return op == rawSize;
+}
+}
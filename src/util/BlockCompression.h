@@ -0,0 +1,27 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstddef>
+#include <vector>
+
+namespace stellar
+{
+
+// A small, fast LZ77 codec for blocks of a few tens of kilobytes, using the
+// LZ4 block format: a sequence of (token, literals, 16-bit match offset,
+// match length) groups, the last of which only holds literals. It trades
+// compression ratio for speed, which suits data that is compressed once per
+// merge and decompressed on every read, such as bucket files.
+
+// Appends the compressed form of the size bytes at src to out.
+void lzCompressBlock(char const* src, size_t size, std::vector<char>& out);
+
+// Decompresses the size bytes at src, which must decompress to exactly
+// rawSize bytes, into dst. Returns false if the input is malformed; never
+// reads or writes out of bounds.
+bool lzDecompressBlock(char const* src, size_t size, char* dst,
+                       size_t rawSize);
+}
@@ -0,0 +1,122 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/ForkJoinPool.h"
+
+namespace stellar
+{
+
+ForkJoinPool::ForkJoinPool(size_t numThreads)
+{
+    for (size_t i = 1; i < numThreads; ++i)
+    {
+        mThreads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ForkJoinPool::~ForkJoinPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShutdown = true;
+    }
+    mWorkReady.notify_all();
+    for (auto& t : mThreads)
+    {
+        t.join();
+    }
+}
+
+void
+ForkJoinPool::runTasks()
+{
+    while (true)
+    {
+        size_t i = mNextTask.fetch_add(1, std::memory_order_relaxed);
+        if (i >= mNumTasks)
+        {
+            return;
+        }
+        try
+        {
+            (*mTask)(i);
+        }
+        catch (...)
+        {
+            mErrors[i] = std::current_exception();
+        }
+    }
+}
+
+void
+ForkJoinPool::workerLoop()
+{
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkReady.wait(lock, [&]() {
+                return mShutdown || mGeneration != seenGeneration;
+            });
+            if (mShutdown)
+            {
+                return;
+            }
+            seenGeneration = mGeneration;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--mBusyWorkers == 0)
+            {
+                mWorkDone.notify_one();
+            }
+        }
+    }
+}
+
+void
+ForkJoinPool::parallelFor(size_t numTasks,
+                          std::function<void(size_t)> const& fn)
+{
+    if (mThreads.empty() || numTasks <= 1)
+    {
+        for (size_t i = 0; i < numTasks; ++i)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &fn;
+        mNumTasks = numTasks;
+        mNextTask.store(0, std::memory_order_relaxed);
+        mErrors.assign(numTasks, nullptr);
+        mBusyWorkers = mThreads.size();
+        ++mGeneration;
+    }
+    mWorkReady.notify_all();
+
+    runTasks();
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkDone.wait(lock, [&]() { return mBusyWorkers == 0; });
+        mTask = nullptr;
+    }
+
+    for (auto const& err : mErrors)
+    {
+        if (err)
+        {
+            std::rethrow_exception(err);
+        }
+    }
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stellar
+{
+
+// A small fork-join pool for data-parallel loops on the critical path of
+// ledger close (as opposed to the Application worker io_context, which runs
+// long-lived, independent background jobs).
+//
+// parallelFor(n, fn) runs fn(0) .. fn(n-1) across the pool's threads and the
+// calling thread, and returns once every task has finished. Tasks are handed
+// out dynamically, so callers that need deterministic results must make each
+// task write only to state owned by its task index and combine the per-task
+// results themselves, in index order, after parallelFor returns.
+//
+// If any task throws, the exception of the lowest-indexed failing task is
+// rethrown on the calling thread once all tasks have finished.
+//
+// parallelFor is not reentrant: it must not be called concurrently, nor from
+// inside a task running on the same pool.
+class ForkJoinPool : public NonMovableOrCopyable
+{
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkReady;
+    std::condition_variable mWorkDone;
+
+    std::function<void(size_t)> const* mTask{nullptr};
+    size_t mNumTasks{0};
+    std::atomic<size_t> mNextTask{0};
+    std::vector<std::exception_ptr> mErrors;
+
+    size_t mBusyWorkers{0};
+    uint64_t mGeneration{0};
+    bool mShutdown{false};
+
+    void workerLoop();
+    void runTasks();
+
+  public:
+    // numThreads counts the calling thread, so a pool of size 1 spawns no
+    // threads and runs everything inline.
+    explicit ForkJoinPool(size_t numThreads);
+    ~ForkJoinPool();
+
+    size_t
+    numThreads() const
+    {
+        return mThreads.size() + 1;
+    }
+
+    void parallelFor(size_t numTasks, std::function<void(size_t)> const& fn);
+};
+}
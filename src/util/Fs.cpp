@@ -136,10 +136,71 @@ durableRename(std::string const& src, std::string const& dst,
     return true;
 }
 
+MappedFile::MappedFile(std::string const& path, Access access)
+{
+    ZoneScoped;
+    HANDLE h = ::CreateFileA(path.c_str(), GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                             OPEN_EXISTING,
+                             access == Access::SEQUENTIAL
+                                 ? FILE_FLAG_SEQUENTIAL_SCAN
+                                 : FILE_FLAG_RANDOM_ACCESS,
+                             NULL);
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        FileSystemException::failWithGetLastError(
+            std::string("fs::MappedFile() failed on CreateFile(\"") + path +
+            std::string("\"): "));
+    }
+    LARGE_INTEGER sz;
+    if (!::GetFileSizeEx(h, &sz))
+    {
+        ::CloseHandle(h);
+        FileSystemException::failWithGetLastError(
+            "fs::MappedFile() failed on GetFileSizeEx(): ");
+    }
+    mSize = static_cast<size_t>(sz.QuadPart);
+    if (mSize > 0)
+    {
+        mMapping = ::CreateFileMappingA(h, NULL, PAGE_READONLY, 0, 0, NULL);
+        ::CloseHandle(h);
+        if (mMapping == NULL)
+        {
+            FileSystemException::failWithGetLastError(
+                "fs::MappedFile() failed on CreateFileMapping(): ");
+        }
+        mData = static_cast<char const*>(
+            ::MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        if (mData == nullptr)
+        {
+            ::CloseHandle(mMapping);
+            FileSystemException::failWithGetLastError(
+                "fs::MappedFile() failed on MapViewOfFile(): ");
+        }
+    }
+    else
+    {
+        ::CloseHandle(h);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        ::UnmapViewOfFile(mData);
+    }
+    if (mMapping != NULL)
+    {
+        ::CloseHandle(mMapping);
+    }
+}
+
 #else
 #include <cerrno>
 #include <fcntl.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -272,6 +333,56 @@ durableRename(std::string const& src, std::string const& dst,
     }
     return true;
 }
+
+MappedFile::MappedFile(std::string const& path, Access access)
+{
+    ZoneScoped;
+    int fd;
+    while ((fd = ::open(path.c_str(), O_RDONLY)) == -1)
+    {
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        FileSystemException::failWithErrno(
+            std::string("fs::MappedFile(\"") + path + "\") failed: ");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        FileSystemException::failWithErrno(
+            std::string("fs::MappedFile() failed to stat ") + path + ": ");
+    }
+    mSize = static_cast<size_t>(st.st_size);
+    if (mSize > 0)
+    {
+        void* p = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            FileSystemException::failWithErrno(
+                std::string("fs::MappedFile() failed to map ") + path + ": ");
+        }
+        // Only a hint, so failures are ignored.
+        ::madvise(p, mSize,
+                  access == Access::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+        mData = static_cast<char const*>(p);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        ::munmap(const_cast<char*>(mData), mSize);
+    }
+}
 #endif
 
 namespace stdfs = std::filesystem;
@@ -89,6 +89,43 @@ size_t size(std::ifstream& ifs);
 
 size_t size(std::string const& path);
 
+// A read-only mapping of a whole file into memory, with a hint to the kernel
+// about how it will be read (madvise on POSIX, the file's access flags on
+// Win32). Throws FileSystemException if the file can't be mapped. Empty files
+// map to a null data() with size() 0.
+class MappedFile
+{
+    char const* mData{nullptr};
+    size_t mSize{0};
+#ifdef _WIN32
+    HANDLE mMapping{NULL};
+#endif
+
+  public:
+    enum class Access
+    {
+        SEQUENTIAL,
+        RANDOM
+    };
+
+    MappedFile(std::string const& path, Access access);
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    char const*
+    data() const
+    {
+        return mData;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+};
+
 ////
 // Utility functions for constructing path names
 ////
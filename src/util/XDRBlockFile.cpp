@@ -0,0 +1,339 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/XDRBlockFile.h"
+#include "util/BlockCompression.h"
+#include "util/GlobalChecks.h"
+#include "util/siphash.h"
+#include <Tracy.hpp>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace stellar
+{
+
+namespace
+{
+// Checksums only guard against corruption, so they use a fixed key.
+uint8_t const kChecksumKey[16] = {'s', 't', 'e', 'l', 'l', 'a', 'r', '-',
+                                  'b', 'l', 'o', 'c', 'k', 's', 0,   1};
+
+void
+put32(std::vector<char>& out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+void
+put64(std::vector<char>& out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+uint32_t
+get32(char const* p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i)
+    {
+        v = (v << 8) | static_cast<uint8_t>(p[i]);
+    }
+    return v;
+}
+
+uint64_t
+get64(char const* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        v = (v << 8) | static_cast<uint8_t>(p[i]);
+    }
+    return v;
+}
+
+void
+putMagic(std::vector<char>& out)
+{
+    out.insert(out.end(), std::begin(XDRBlockFileFormat::kMagic),
+               std::end(XDRBlockFileFormat::kMagic));
+    put32(out, XDRBlockFileFormat::kVersion);
+}
+
+bool
+hasMagic(char const* p)
+{
+    return std::memcmp(p, XDRBlockFileFormat::kMagic,
+                       sizeof(XDRBlockFileFormat::kMagic)) == 0 &&
+           get32(p + sizeof(XDRBlockFileFormat::kMagic)) ==
+               XDRBlockFileFormat::kVersion;
+}
+
+[[noreturn]] void
+malformed(std::string const& what)
+{
+    throw std::runtime_error("malformed XDR block file: " + what);
+}
+}
+
+uint64_t
+XDRBlockFileFormat::checksum(char const* data, size_t size)
+{
+    SipHash24 hasher(kChecksumKey);
+    hasher.update(reinterpret_cast<uint8_t const*>(data), size);
+    return hasher.digest();
+}
+
+bool
+XDRBlockFileFormat::isBlockFile(char const* data, size_t size)
+{
+    return size >= sizeof(kMagic) &&
+           std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+XDRBlockFileReader::XDRBlockFileReader(char const* data, size_t size)
+    : mData(data), mSize(size)
+{
+    ZoneScoped;
+    using F = XDRBlockFileFormat;
+    if (size < F::kHeaderSize + F::kFooterSize || !hasMagic(data))
+    {
+        malformed("bad header");
+    }
+    char const* footer = data + size - F::kFooterSize;
+    if (!hasMagic(footer + 32))
+    {
+        malformed("bad footer");
+    }
+    uint64_t indexOffset = get64(footer);
+    uint64_t blockCount = get64(footer + 8);
+    mLogicalSize = get64(footer + 16);
+    uint64_t indexChecksum = get64(footer + 24);
+
+    uint64_t indexEnd = size - F::kFooterSize;
+    if (indexOffset < F::kHeaderSize || indexOffset > indexEnd ||
+        blockCount != (indexEnd - indexOffset) / F::kIndexEntrySize ||
+        (indexEnd - indexOffset) % F::kIndexEntrySize != 0)
+    {
+        malformed("bad index bounds");
+    }
+    if (F::checksum(data + indexOffset, indexEnd - indexOffset) !=
+        indexChecksum)
+    {
+        malformed("index checksum mismatch");
+    }
+
+    uint64_t logical = 0;
+    uint64_t fileOffset = F::kHeaderSize;
+    mBlocks.reserve(blockCount);
+    for (uint64_t i = 0; i < blockCount; ++i)
+    {
+        char const* p = data + indexOffset + i * F::kIndexEntrySize;
+        F::Block b;
+        b.mLogicalOffset = get64(p);
+        b.mFileOffset = get64(p + 8);
+        b.mRawSize = get32(p + 16);
+        b.mStoredSize = get32(p + 20);
+        b.mCodec = get32(p + 24);
+        b.mChecksum = get64(p + 32);
+        if (b.mLogicalOffset != logical || b.mFileOffset != fileOffset ||
+            b.mStoredSize > indexOffset - fileOffset || b.mRawSize == 0 ||
+            (b.mCodec != F::STORED && b.mCodec != F::LZ) ||
+            (b.mCodec == F::STORED && b.mStoredSize != b.mRawSize))
+        {
+            malformed(fmt::format("bad index entry {}", i));
+        }
+        logical += b.mRawSize;
+        fileOffset += b.mStoredSize;
+        mBlocks.emplace_back(b);
+    }
+    if (logical != mLogicalSize || fileOffset != indexOffset)
+    {
+        malformed("index doesn't cover the file");
+    }
+}
+
+uint64_t
+XDRBlockFileReader::logicalSize() const
+{
+    return mLogicalSize;
+}
+
+size_t
+XDRBlockFileReader::blockCount() const
+{
+    return mBlocks.size();
+}
+
+XDRBlockFileFormat::Block const&
+XDRBlockFileReader::getBlock(size_t i) const
+{
+    return mBlocks.at(i);
+}
+
+size_t
+XDRBlockFileReader::findBlock(uint64_t pos) const
+{
+    releaseAssert(pos < mLogicalSize);
+    auto it = std::upper_bound(
+        mBlocks.begin(), mBlocks.end(), pos,
+        [](uint64_t p, XDRBlockFileFormat::Block const& b) {
+            return p < b.mLogicalOffset;
+        });
+    return std::distance(mBlocks.begin(), it) - 1;
+}
+
+void
+XDRBlockFileReader::readBlock(size_t i, std::vector<char>& out) const
+{
+    ZoneScoped;
+    auto const& b = mBlocks.at(i);
+    char const* stored = mData + b.mFileOffset;
+    if (XDRBlockFileFormat::checksum(stored, b.mStoredSize) != b.mChecksum)
+    {
+        malformed(fmt::format("checksum mismatch in block {}", i));
+    }
+    out.resize(b.mRawSize);
+    if (b.mCodec == XDRBlockFileFormat::STORED)
+    {
+        std::memcpy(out.data(), stored, b.mRawSize);
+    }
+    else if (!lzDecompressBlock(stored, b.mStoredSize, out.data(),
+                                b.mRawSize))
+    {
+        malformed(fmt::format("undecodable block {}", i));
+    }
+}
+
+XDRBlockFileWriter::XDRBlockFileWriter(
+    size_t blockSize, std::function<void(char const*, size_t)> sink)
+    : mBlockSize(blockSize), mSink(std::move(sink))
+{
+    releaseAssert(mBlockSize > 0);
+    std::vector<char> header;
+    putMagic(header);
+    emit(header.data(), header.size());
+}
+
+void
+XDRBlockFileWriter::emit(char const* data, size_t size)
+{
+    mSink(data, size);
+    mFileOffset += size;
+}
+
+void
+XDRBlockFileWriter::writeBlock(size_t size)
+{
+    ZoneScoped;
+    releaseAssert(size <= mBlock.size());
+    releaseAssert(size <= std::numeric_limits<uint32_t>::max());
+    XDRBlockFileFormat::Block b;
+    b.mLogicalOffset = mLogicalSize;
+    b.mFileOffset = mFileOffset;
+    b.mRawSize = static_cast<uint32_t>(size);
+
+    mStored.clear();
+    lzCompressBlock(mBlock.data(), size, mStored);
+    char const* stored = mBlock.data();
+    if (mStored.size() < size)
+    {
+        b.mCodec = XDRBlockFileFormat::LZ;
+        stored = mStored.data();
+        b.mStoredSize = static_cast<uint32_t>(mStored.size());
+    }
+    else
+    {
+        b.mCodec = XDRBlockFileFormat::STORED;
+        b.mStoredSize = b.mRawSize;
+    }
+    b.mChecksum = XDRBlockFileFormat::checksum(stored, b.mStoredSize);
+    emit(stored, b.mStoredSize);
+    mIndex.emplace_back(b);
+
+    mLogicalSize += size;
+    mBlock.erase(mBlock.begin(), mBlock.begin() + size);
+    mNextRecord -= size;
+}
+
+void
+XDRBlockFileWriter::write(char const* data, size_t size)
+{
+    mBlock.insert(mBlock.end(), data, data + size);
+    for (;;)
+    {
+        if (mNextRecord >= mBlockSize && mNextRecord <= mBlock.size())
+        {
+            writeBlock(mNextRecord);
+            continue;
+        }
+        if (mNextRecord + 4 > mBlock.size())
+        {
+            break;
+        }
+        // Record marks are 4 bytes of big-endian size with the high bit set.
+        auto p = reinterpret_cast<uint8_t const*>(mBlock.data() + mNextRecord);
+        uint32_t sz = (static_cast<uint32_t>(p[0] & 0x7f) << 24) |
+                      (static_cast<uint32_t>(p[1]) << 16) |
+                      (static_cast<uint32_t>(p[2]) << 8) |
+                      static_cast<uint32_t>(p[3]);
+        mNextRecord += 4 + sz;
+    }
+}
+
+void
+XDRBlockFileWriter::finish()
+{
+    ZoneScoped;
+    if (mNextRecord != mBlock.size())
+    {
+        throw std::runtime_error(
+            "XDR block file ends in the middle of a record");
+    }
+    if (!mBlock.empty())
+    {
+        writeBlock(mBlock.size());
+    }
+
+    std::vector<char> index;
+    index.reserve(mIndex.size() * XDRBlockFileFormat::kIndexEntrySize);
+    for (auto const& b : mIndex)
+    {
+        put64(index, b.mLogicalOffset);
+        put64(index, b.mFileOffset);
+        put32(index, b.mRawSize);
+        put32(index, b.mStoredSize);
+        put32(index, b.mCodec);
+        put32(index, 0);
+        put64(index, b.mChecksum);
+    }
+    uint64_t indexOffset = mFileOffset;
+    emit(index.data(), index.size());
+
+    std::vector<char> footer;
+    put64(footer, indexOffset);
+    put64(footer, mIndex.size());
+    put64(footer, mLogicalSize);
+    put64(footer, XDRBlockFileFormat::checksum(index.data(), index.size()));
+    putMagic(footer);
+    emit(footer.data(), footer.size());
+}
+
+uint64_t
+XDRBlockFileWriter::logicalSize() const
+{
+    return mLogicalSize;
+}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * An XDR block file holds a stream of XDR records, as written by
+ * XDROutputFileStream (the "logical" stream), cut into blocks that are
+ * compressed separately. Its layout is:
+ *
+ *   header:  magic | version
+ *   blocks:  the stored bytes of each block, back to back
+ *   index:   for each block, its logical offset, file offset, raw size,
+ *            stored size, codec and checksum
+ *   footer:  index offset | block count | logical size | index checksum |
+ *            magic | version
+ *
+ * All integers are little-endian. Blocks only hold whole records, so every
+ * block start is a restart point: decoding can start at any block without
+ * looking at the ones before it, and the logical offset of any record maps
+ * to its block through the index. The stored bytes of each block, and the
+ * index, carry a SipHash-2-4 checksum that is checked before decoding them.
+ *
+ * The magic starts with a byte whose high bit is clear, while XDR record
+ * marks always have it set, so block files can be told apart from plain XDR
+ * files by their first bytes.
+ */
+struct XDRBlockFileFormat
+{
+    static constexpr char kMagic[4] = {'X', 'B', 'L', 'K'};
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 8;
+    static constexpr size_t kIndexEntrySize = 40;
+    static constexpr size_t kFooterSize = 40;
+
+    enum Codec : uint32_t
+    {
+        STORED = 0,
+        LZ = 1
+    };
+
+    struct Block
+    {
+        uint64_t mLogicalOffset{0};
+        uint64_t mFileOffset{0};
+        uint32_t mRawSize{0};
+        uint32_t mStoredSize{0};
+        uint32_t mCodec{STORED};
+        uint64_t mChecksum{0};
+    };
+
+    static uint64_t checksum(char const* data, size_t size);
+
+    // Whether the size bytes at data start like a block file.
+    static bool isBlockFile(char const* data, size_t size);
+};
+
+// Reads the blocks of a block file held in memory, e.g. mapped.
+class XDRBlockFileReader
+{
+    char const* const mData;
+    size_t const mSize;
+    std::vector<XDRBlockFileFormat::Block> mBlocks;
+    uint64_t mLogicalSize{0};
+
+  public:
+    // Reads and checks the index of the block file in [data, data + size).
+    // Throws if it is malformed.
+    XDRBlockFileReader(char const* data, size_t size);
+
+    uint64_t logicalSize() const;
+    size_t blockCount() const;
+    XDRBlockFileFormat::Block const& getBlock(size_t i) const;
+
+    // Returns the block holding logical offset pos, which must be less than
+    // logicalSize().
+    size_t findBlock(uint64_t pos) const;
+
+    // Decodes block i into out. Throws if the block is corrupt.
+    void readBlock(size_t i, std::vector<char>& out) const;
+};
+
+// Encodes a logical stream of XDR records into a block file, passing the
+// encoded bytes to a sink as they are produced.
+class XDRBlockFileWriter
+{
+    size_t const mBlockSize;
+    std::function<void(char const*, size_t)> const mSink;
+
+    // Raw bytes of the current block, which may end with part of a record;
+    // mNextRecord is the offset in mBlock of the next record mark to parse.
+    std::vector<char> mBlock;
+    size_t mNextRecord{0};
+    std::vector<char> mStored;
+
+    std::vector<XDRBlockFileFormat::Block> mIndex;
+    uint64_t mLogicalSize{0};
+    uint64_t mFileOffset{0};
+
+    void emit(char const* data, size_t size);
+    void writeBlock(size_t size);
+
+  public:
+    // Writes the header. Blocks are cut at the first record boundary at or
+    // past blockSize bytes.
+    XDRBlockFileWriter(size_t blockSize,
+                       std::function<void(char const*, size_t)> sink);
+
+    // Adds bytes of the logical stream; they need not end on a record
+    // boundary.
+    void write(char const* data, size_t size);
+
+    // Writes the last block, the index and the footer. Throws if the
+    // logical stream ends in the middle of a record.
+    void finish();
+
+    uint64_t logicalSize() const;
+};
+}
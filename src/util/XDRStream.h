@@ -10,10 +10,14 @@
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/NonCopyable.h"
+#include "util/XDRBlockFile.h"
 #include "xdrpp/marshal.h"
 #include <Tracy.hpp>
 
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #ifdef _WIN32
@@ -84,6 +88,16 @@ class XDRInputFileStream
         return mIn.tellg();
     }
 
+    // Moves to offset pos, which must be the start of a record (or the end of
+    // the file), clearing any end-of-file state.
+    void
+    seek(size_t pos)
+    {
+        ZoneScoped;
+        mIn.clear();
+        mIn.seekg(pos);
+    }
+
     template <typename T>
     bool
     readOne(T& out)
@@ -124,6 +138,177 @@ class XDRInputFileStream
     }
 };
 
+/**
+ * Like XDRInputFileStream, but maps the whole file into memory and decodes
+ * records straight from the mapping, without reading them into a buffer
+ * first. Meant for bucket files, which are read often and in full.
+ *
+ * XDR block files (see XDRBlockFile.h) are read transparently, one decoded
+ * block at a time; positions and sizes are then those of the logical
+ * stream of records, so they don't depend on the format of the file.
+ */
+class XDRInputMappedFileStream
+{
+    std::unique_ptr<fs::MappedFile> mFile;
+    size_t mPos{0};
+    bool mGood{false};
+    std::vector<char> mBuf;
+
+    std::unique_ptr<XDRBlockFileReader> mBlocks;
+    std::vector<char> mBlockBuf;
+    size_t mBlock{0};
+    bool mBlockLoaded{false};
+
+  public:
+    void
+    close()
+    {
+        mBlocks.reset();
+        mBlockLoaded = false;
+        mFile.reset();
+        mPos = 0;
+        mGood = false;
+    }
+
+    void
+    open(std::string const& filename,
+         fs::MappedFile::Access access = fs::MappedFile::Access::SEQUENTIAL)
+    {
+        ZoneScoped;
+        mFile = std::make_unique<fs::MappedFile>(filename, access);
+        mBlocks.reset();
+        mBlockLoaded = false;
+        if (XDRBlockFileFormat::isBlockFile(mFile->data(), mFile->size()))
+        {
+            mBlocks = std::make_unique<XDRBlockFileReader>(mFile->data(),
+                                                           mFile->size());
+        }
+        mPos = 0;
+        mGood = true;
+    }
+
+    operator bool() const
+    {
+        return mGood;
+    }
+
+    bool
+    isBlockFile() const
+    {
+        return mBlocks != nullptr;
+    }
+
+    size_t
+    size() const
+    {
+        if (mBlocks)
+        {
+            return mBlocks->logicalSize();
+        }
+        return mFile ? mFile->size() : 0;
+    }
+
+    size_t
+    pos() const
+    {
+        return mPos;
+    }
+
+    void
+    seek(size_t pos)
+    {
+        releaseAssertOrThrow(mFile && pos <= size());
+        mPos = pos;
+        mGood = true;
+    }
+
+    template <typename T>
+    bool
+    readOne(T& out)
+    {
+        ZoneScoped;
+        if (!mGood || mPos >= size())
+        {
+            mGood = false;
+            return false;
+        }
+        // Records never span blocks, so each one is read from a single
+        // contiguous range: the mapping, or the decoded block.
+        char const* data;
+        size_t avail;
+        if (mBlocks)
+        {
+            size_t block = mBlocks->findBlock(mPos);
+            if (!mBlockLoaded || block != mBlock)
+            {
+                mBlockLoaded = false;
+                mBlocks->readBlock(block, mBlockBuf);
+                mBlock = block;
+                mBlockLoaded = true;
+            }
+            size_t offset = mPos - mBlocks->getBlock(block).mLogicalOffset;
+            data = mBlockBuf.data() + offset;
+            avail = mBlockBuf.size() - offset;
+        }
+        else
+        {
+            data = mFile->data() + mPos;
+            avail = mFile->size() - mPos;
+        }
+        if (avail < 4)
+        {
+            mGood = false;
+            return false;
+        }
+        auto p = reinterpret_cast<uint8_t const*>(data);
+        uint32_t sz = (static_cast<uint32_t>(p[0] & 0x7f) << 24) |
+                      (static_cast<uint32_t>(p[1]) << 16) |
+                      (static_cast<uint32_t>(p[2]) << 8) |
+                      static_cast<uint32_t>(p[3]);
+        if (sz > avail - 4)
+        {
+            mGood = false;
+            throw xdr::xdr_runtime_error("malformed XDR file");
+        }
+        data += 4;
+        // XDR records are 4-byte multiples, so records are aligned as xdrpp
+        // expects in well-formed files; anything else is decoded from a copy.
+        if (reinterpret_cast<uintptr_t>(data) % 4 != 0)
+        {
+            mBuf.assign(data, data + sz);
+            data = mBuf.data();
+        }
+        xdr::xdr_get g(data, data + sz);
+        xdr::xdr_argpack_archive(g, out);
+        mPos += sz + 4;
+        return true;
+    }
+
+    // Passes the whole logical stream of records to f, in chunks, whatever
+    // the current position; e.g. to hash a bucket file or to write it out in
+    // the plain format.
+    void
+    readContents(std::function<void(char const*, size_t)> const& f)
+    {
+        ZoneScoped;
+        releaseAssertOrThrow(mFile);
+        if (!mBlocks)
+        {
+            if (mFile->size() > 0)
+            {
+                f(mFile->data(), mFile->size());
+            }
+            return;
+        }
+        std::vector<char> buf;
+        for (size_t i = 0; i < mBlocks->blockCount(); ++i)
+        {
+            mBlocks->readBlock(i, buf);
+            f(buf.data(), buf.size());
+        }
+    }
+};
+
 // XDROutputFileStream needs access to a file descriptor to do fsync, so we use
 // asio's synchronous stream types here rather than fstreams.
 class XDROutputFileStream
@@ -307,12 +492,27 @@ class XDROutputFileStream
         xdr::xdr_put p(mBuf.data() + 4, mBuf.data() + 4 + sz);
         xdr_argpack_archive(p, t);
 
-        size_t const to_write = sz + 4;
+        writeBytes(mBuf.data(), sz + 4, hasher, bytesPut);
+    }
+
+    // Writes size bytes of already-serialized records, e.g. copied from
+    // another file written by this class.
+    void
+    writeBytes(char const* data, size_t size, SHA256* hasher = nullptr,
+               size_t* bytesPut = nullptr)
+    {
+        ZoneScoped;
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputFileStream::writeBytes() on non-open stream");
+        }
+
         size_t written = 0;
-        while (written < to_write)
+        while (written < size)
         {
             asio::error_code ec;
-            auto buf = asio::buffer(mBuf.data() + written, to_write - written);
+            auto buf = asio::buffer(data + written, size - written);
 #ifdef _WIN32
             // Calling asio::write_at on the asio::posix::stream_descriptor
             // will not even compile; so this one bit has to also be platform
@@ -339,18 +539,129 @@ class XDROutputFileStream
                 {
                     FileSystemException::failWith(
                         std::string(
-                            "XDROutputFileStream::writeOne() failed: ") +
+                            "XDROutputFileStream::writeBytes() failed: ") +
                         ec.message());
                 }
             }
         }
         if (hasher)
         {
-            hasher->add(ByteSlice(mBuf.data(), sz + 4));
+            hasher->add(ByteSlice(data, size));
+        }
+        if (bytesPut)
+        {
+            *bytesPut += size;
+        }
+    }
+};
+
+// Writes XDR records like XDROutputFileStream, in the XDR block file format
+// (see XDRBlockFile.h) if it is given a block size, and in the plain format
+// otherwise. Hashes and byte counts are those of the logical stream of
+// records, so they are the same in both formats.
+class XDROutputBlockFileStream : public NonMovableOrCopyable
+{
+    XDROutputFileStream mOut;
+    size_t const mBlockSize;
+    std::unique_ptr<XDRBlockFileWriter> mWriter;
+    std::vector<char> mBuf;
+
+  public:
+    XDROutputBlockFileStream(asio::io_context& ctx, bool fsyncOnClose,
+                             size_t blockSize)
+        : mOut(ctx, fsyncOnClose), mBlockSize(blockSize)
+    {
+    }
+
+    ~XDROutputBlockFileStream()
+    {
+        // Only close() completes a block file; this leaves the file without
+        // its index if it wasn't closed, e.g. after an error.
+        if (isOpen())
+        {
+            mWriter.reset();
+            mOut.close();
+        }
+    }
+
+    bool
+    isOpen()
+    {
+        return mOut.isOpen();
+    }
+
+    void
+    open(std::string const& filename)
+    {
+        ZoneScoped;
+        mOut.open(filename);
+        if (mBlockSize > 0)
+        {
+            mWriter = std::make_unique<XDRBlockFileWriter>(
+                mBlockSize, [this](char const* data, size_t size) {
+                    mOut.writeBytes(data, size);
+                });
+        }
+    }
+
+    void
+    close()
+    {
+        ZoneScoped;
+        if (mWriter && isOpen())
+        {
+            auto writer = std::move(mWriter);
+            writer->finish();
+        }
+        mOut.close();
+    }
+
+    template <typename T>
+    void
+    writeOne(T const& t, SHA256* hasher = nullptr, size_t* bytesPut = nullptr)
+    {
+        ZoneScoped;
+        uint32_t sz = (uint32_t)xdr::xdr_size(t);
+        releaseAssertOrThrow(sz < 0x80000000);
+        if (mBuf.size() < sz + 4)
+        {
+            mBuf.resize(sz + 4);
+        }
+        mBuf[0] = static_cast<char>((sz >> 24) & 0xFF) | '\x80';
+        mBuf[1] = static_cast<char>((sz >> 16) & 0xFF);
+        mBuf[2] = static_cast<char>((sz >> 8) & 0xFF);
+        mBuf[3] = static_cast<char>(sz & 0xFF);
+        xdr::xdr_put p(mBuf.data() + 4, mBuf.data() + 4 + sz);
+        xdr_argpack_archive(p, t);
+
+        writeBytes(mBuf.data(), sz + 4, hasher, bytesPut);
+    }
+
+    // Writes size bytes of already-serialized records of the logical
+    // stream; they need not end on a record boundary.
+    void
+    writeBytes(char const* data, size_t size, SHA256* hasher = nullptr,
+               size_t* bytesPut = nullptr)
+    {
+        ZoneScoped;
+        if (!mWriter)
+        {
+            mOut.writeBytes(data, size, hasher, bytesPut);
+            return;
+        }
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputBlockFileStream::writeBytes() on non-open stream");
+        }
+        mWriter->write(data, size);
+        if (hasher)
+        {
+            hasher->add(ByteSlice(data, size));
         }
         if (bytesPut)
         {
-            *bytesPut += (sz + 4);
+            *bytesPut += size;
         }
     }
 };
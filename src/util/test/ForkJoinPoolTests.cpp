@@ -0,0 +1,57 @@
+// Copyright 2022 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/ForkJoinPool.h"
+
+#include "lib/catch.hpp"
+
+#include <numeric>
+#include <stdexcept>
+
+using namespace stellar;
+
+TEST_CASE("fork join pool runs every task once", "[forkjoinpool]")
+{
+    for (size_t threads : {1, 2, 8})
+    {
+        ForkJoinPool pool(threads);
+        REQUIRE(pool.numThreads() == threads);
+        for (size_t round = 0; round < 50; ++round)
+        {
+            std::vector<size_t> out(round, 0);
+            pool.parallelFor(out.size(), [&](size_t i) { out[i] += i + 1; });
+            for (size_t i = 0; i < out.size(); ++i)
+            {
+                REQUIRE(out[i] == i + 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("fork join pool rethrows lowest failing task", "[forkjoinpool]")
+{
+    ForkJoinPool pool(4);
+    std::vector<int> ran(64, 0);
+    try
+    {
+        pool.parallelFor(ran.size(), [&](size_t i) {
+            ran[i] = 1;
+            if (i == 17 || i == 40)
+            {
+                throw std::runtime_error(std::to_string(i));
+            }
+        });
+        FAIL("expected exception");
+    }
+    catch (std::runtime_error const& e)
+    {
+        REQUIRE(std::string(e.what()) == "17");
+    }
+    REQUIRE(std::accumulate(ran.begin(), ran.end(), 0) == 64);
+
+    // pool remains usable
+    std::vector<int> again(8, 0);
+    pool.parallelFor(again.size(), [&](size_t i) { again[i] = 1; });
+    REQUIRE(std::accumulate(again.begin(), again.end(), 0) == 8);
+}
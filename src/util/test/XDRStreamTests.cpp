@@ -6,11 +6,16 @@
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
 #include "test/test.h"
+#include "util/BlockCompression.h"
+#include "util/Fs.h"
 #include "util/Logging.h"
+#include "util/Math.h"
 #include "util/XDRStream.h"
 #include <fmt/format.h>
 
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 
 using namespace stellar;
 
@@ -44,6 +49,243 @@ TEST_CASE("XDROutputFileStream fail modes", "[xdrstream]")
     }
 }
 
+TEST_CASE("XDRInputMappedFileStream reads XDR files", "[xdrstream]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig(0);
+    fs::mkpath(cfg.BUCKET_DIR_PATH);
+    auto filename = fmt::format("{}/mapped.xdr", cfg.BUCKET_DIR_PATH);
+
+    auto ledgerEntries = LedgerTestUtils::generateValidLedgerEntries(100);
+    auto bucketEntries =
+        Bucket::convertToBucketEntry(false, {}, ledgerEntries, {});
+    std::vector<size_t> offsets;
+    {
+        XDROutputFileStream out(clock.getIOContext(), /*doFsync=*/false);
+        out.open(filename);
+        size_t bytes = 0;
+        for (auto const& e : bucketEntries)
+        {
+            offsets.emplace_back(bytes);
+            out.writeOne(e, nullptr, &bytes);
+        }
+        out.close();
+    }
+
+    XDRInputMappedFileStream in;
+    in.open(filename);
+    REQUIRE(in.size() == fs::size(filename));
+
+    SECTION("reads all records in order")
+    {
+        BucketEntry be;
+        for (size_t i = 0; i < bucketEntries.size(); ++i)
+        {
+            REQUIRE(in.pos() == offsets[i]);
+            REQUIRE(in.readOne(be));
+            REQUIRE(be == bucketEntries[i]);
+        }
+        REQUIRE(in.pos() == in.size());
+        REQUIRE(!in.readOne(be));
+        REQUIRE(!in);
+    }
+    SECTION("seeks to records")
+    {
+        BucketEntry be;
+        for (size_t i : {size_t(50), size_t(3), size_t(99)})
+        {
+            in.seek(offsets[i]);
+            REQUIRE(in.readOne(be));
+            REQUIRE(be == bucketEntries[i]);
+        }
+        REQUIRE(!in.readOne(be));
+        in.seek(0);
+        REQUIRE(in.readOne(be));
+        REQUIRE(be == bucketEntries[0]);
+    }
+    SECTION("throws on truncated records")
+    {
+        in.close();
+        std::filesystem::resize_file(filename, offsets.back() + 8);
+        in.open(filename);
+        in.seek(offsets.back());
+        BucketEntry be;
+        REQUIRE_THROWS_AS(in.readOne(be), xdr::xdr_runtime_error);
+    }
+    SECTION("reads empty files")
+    {
+        in.close();
+        std::filesystem::resize_file(filename, 0);
+        in.open(filename);
+        BucketEntry be;
+        REQUIRE(in.size() == 0);
+        REQUIRE(!in.readOne(be));
+    }
+    in.close();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("lzCompressBlock round trips", "[xdrstream]")
+{
+    auto check = [](std::string const& raw) {
+        std::vector<char> compressed;
+        lzCompressBlock(raw.data(), raw.size(), compressed);
+        std::string back(raw.size(), '\0');
+        REQUIRE(lzDecompressBlock(compressed.data(), compressed.size(),
+                                  back.data(), back.size()));
+        REQUIRE(back == raw);
+        // Truncated input and wrong sizes are rejected
+        if (compressed.size() > 1)
+        {
+            REQUIRE(!lzDecompressBlock(compressed.data(),
+                                       compressed.size() - 1, back.data(),
+                                       back.size()));
+        }
+        std::string longer(raw.size() + 1, '\0');
+        REQUIRE(!lzDecompressBlock(compressed.data(), compressed.size(),
+                                   longer.data(), longer.size()));
+        return compressed.size();
+    };
+
+    check("");
+    check("abc");
+    std::string repetitive;
+    for (int i = 0; i < 1000; ++i)
+    {
+        repetitive += fmt::format("entry {} of 1000;", i % 17);
+    }
+    REQUIRE(check(repetitive) < repetitive.size() / 4);
+    std::string random;
+    for (int i = 0; i < 5000; ++i)
+    {
+        random.push_back(static_cast<char>(rand_uniform<int>(0, 255)));
+    }
+    check(random);
+}
+
+TEST_CASE("XDR block files read like plain XDR files", "[xdrstream]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig(0);
+    fs::mkpath(cfg.BUCKET_DIR_PATH);
+    auto plainFile = fmt::format("{}/plain.xdr", cfg.BUCKET_DIR_PATH);
+    auto blockFile = fmt::format("{}/blocks.xdr", cfg.BUCKET_DIR_PATH);
+
+    auto ledgerEntries = LedgerTestUtils::generateValidLedgerEntries(200);
+    auto bucketEntries =
+        Bucket::convertToBucketEntry(false, {}, ledgerEntries, {});
+    std::vector<size_t> offsets;
+    SHA256 plainHasher, blockHasher;
+    {
+        XDROutputFileStream plain(clock.getIOContext(), /*doFsync=*/false);
+        XDROutputBlockFileStream blocks(clock.getIOContext(),
+                                        /*doFsync=*/false,
+                                        /*blockSize=*/1024);
+        plain.open(plainFile);
+        blocks.open(blockFile);
+        size_t plainBytes = 0;
+        size_t blockBytes = 0;
+        for (size_t i = 0; i < bucketEntries.size(); ++i)
+        {
+            offsets.emplace_back(plainBytes);
+            plain.writeOne(bucketEntries[i], &plainHasher, &plainBytes);
+            if (i % 2 == 0)
+            {
+                blocks.writeOne(bucketEntries[i], &blockHasher, &blockBytes);
+            }
+            else
+            {
+                // Serialized records split at arbitrary points, as when
+                // copying a file
+                auto bytes = xdr::xdr_to_opaque(bucketEntries[i]);
+                std::vector<char> record(4);
+                record[0] = static_cast<char>((bytes.size() >> 24) | 0x80);
+                record[1] = static_cast<char>(bytes.size() >> 16);
+                record[2] = static_cast<char>(bytes.size() >> 8);
+                record[3] = static_cast<char>(bytes.size());
+                record.insert(record.end(), bytes.begin(), bytes.end());
+                size_t half = record.size() / 2;
+                blocks.writeBytes(record.data(), half, &blockHasher,
+                                  &blockBytes);
+                blocks.writeBytes(record.data() + half, record.size() - half,
+                                  &blockHasher, &blockBytes);
+            }
+        }
+        REQUIRE(plainBytes == blockBytes);
+        plain.close();
+        blocks.close();
+    }
+    REQUIRE(plainHasher.finish() == blockHasher.finish());
+
+    XDRInputMappedFileStream in;
+    in.open(blockFile);
+    REQUIRE(in.isBlockFile());
+    REQUIRE(in.size() == fs::size(plainFile));
+
+    SECTION("reads all records in order")
+    {
+        BucketEntry be;
+        for (size_t i = 0; i < bucketEntries.size(); ++i)
+        {
+            REQUIRE(in.pos() == offsets[i]);
+            REQUIRE(in.readOne(be));
+            REQUIRE(be == bucketEntries[i]);
+        }
+        REQUIRE(in.pos() == in.size());
+        REQUIRE(!in.readOne(be));
+    }
+    SECTION("seeks to records")
+    {
+        BucketEntry be;
+        for (size_t i : {size_t(150), size_t(3), size_t(199), size_t(4)})
+        {
+            in.seek(offsets[i]);
+            REQUIRE(in.readOne(be));
+            REQUIRE(be == bucketEntries[i]);
+        }
+    }
+    SECTION("reads the plain contents")
+    {
+        SHA256 hasher;
+        in.readContents([&](char const* data, size_t size) {
+            hasher.add(ByteSlice(data, size));
+        });
+        SHA256 expected;
+        XDRInputMappedFileStream plainIn;
+        plainIn.open(plainFile);
+        plainIn.readContents([&](char const* data, size_t size) {
+            expected.add(ByteSlice(data, size));
+        });
+        REQUIRE(hasher.finish() == expected.finish());
+    }
+    SECTION("detects corrupt blocks")
+    {
+        in.close();
+        {
+            std::fstream f(blockFile, std::ios::in | std::ios::out |
+                                          std::ios::binary);
+            f.seekg(XDRBlockFileFormat::kHeaderSize + 10);
+            char c;
+            f.read(&c, 1);
+            f.seekp(XDRBlockFileFormat::kHeaderSize + 10);
+            c ^= 0x20;
+            f.write(&c, 1);
+        }
+        in.open(blockFile);
+        BucketEntry be;
+        REQUIRE_THROWS_AS(in.readOne(be), std::runtime_error);
+    }
+    SECTION("detects truncated files")
+    {
+        in.close();
+        std::filesystem::resize_file(blockFile, fs::size(blockFile) - 1);
+        REQUIRE_THROWS_AS(in.open(blockFile), std::runtime_error);
+    }
+    in.close();
+    std::remove(plainFile.c_str());
+    std::remove(blockFile.c_str());
+}
+
 TEST_CASE("XDROutputFileStream fsync bench", "[!hide][xdrstream][bench]")
 {
     VirtualClock clock;
@@ -497,9 +497,29 @@ struct LiquidityPoolEntry
     body;
 };
 
+// Final Tatonnement state of the most recent speedex batch.
+// prices are indexed in speedexAssets order.
+struct SpeedexWarmStart
+{
+    Hash assetsHash; // SHA-256 of the XDR of speedexAssets when written
+    uint64 prices<>;
+    uint64 stepSize;
+};
+
 struct SpeedexConfigEntry
 {
     Asset speedexAssets<>;  
+
+    union switch (int v)
+    {
+    case 0:
+        void;
+    case 1:
+        // written by each batch from protocol 18, read by the next one
+        // when Tatonnement warm starts are enabled
+        SpeedexWarmStart warmStart;
+    }
+    ext;
 };
 
 struct LedgerEntryExtensionV1